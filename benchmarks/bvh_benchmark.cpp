@@ -0,0 +1,128 @@
+// Compares every BVH builder/optimizer combination available through BuildOptions on a given mesh.
+// For each combination the build time, SAH cost and closest-hit tracing throughput are reported.
+//
+// Usage: bvh_benchmark <mesh.obj> [num_rays]
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+#include "bvh/single_ray_traverser.hpp"
+#include "bvh/primitive_intersectors.hpp"
+#include "bvh/triangle.hpp"
+
+#include "model_loaders/obj.hpp"
+
+#include "acceleration/build_bvh.hpp"
+#include "acceleration/refit.hpp"
+
+using Scalar = double;
+
+// Rays start on a sphere surrounding the mesh and aim at random points inside its bounding box:
+std::vector<bvh::Ray<Scalar>> generate_rays(const bvh::BoundingBox<Scalar> &bbox, size_t num_rays) {
+    std::mt19937 eng(42);
+    std::uniform_real_distribution<Scalar> dist(0.0, 1.0);
+
+    auto center = bbox.center();
+    auto radius = bvh::length(bbox.diagonal());
+
+    std::vector<bvh::Ray<Scalar>> rays;
+    rays.reserve(num_rays);
+    for (size_t i = 0; i < num_rays; ++i) {
+        Scalar z   = 2*dist(eng) - 1;
+        Scalar phi = 2*M_PI*dist(eng);
+        Scalar r   = std::sqrt(std::max(Scalar(0), 1 - z*z));
+        auto origin = center + radius*bvh::Vector3<Scalar>(r*std::cos(phi), r*std::sin(phi), z);
+        auto target = bbox.min + bvh::Vector3<Scalar>(dist(eng), dist(eng), dist(eng))*bbox.diagonal();
+        rays.emplace_back(origin, bvh::normalize(target - origin));
+    }
+    return rays;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <mesh.obj> [num_rays]\n";
+        return 1;
+    }
+    size_t num_rays = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+    auto triangles = obj::load_from_file<Scalar>(argv[1]);
+    if (triangles.empty()) {
+        std::cerr << "No triangles loaded from " << argv[1] << "\n";
+        return 1;
+    }
+
+    auto global_bbox = bvh::BoundingBox<Scalar>::empty();
+    for (auto &tri : triangles) {
+        global_bbox.extend(tri.bounding_box());
+    }
+    auto rays = generate_rays(global_bbox, num_rays);
+
+    struct Result {
+        std::string name;
+        double build_time;
+        Scalar sah_cost;
+        size_t node_count;
+        double mrays;
+    };
+    std::vector<Result> results;
+
+    std::vector<BuilderType> builders = {
+        BuilderType::SweepSah,
+        BuilderType::BinnedSah,
+        BuilderType::LocallyOrderedClustering,
+        BuilderType::LinearBvh,
+        BuilderType::SpatialSplit
+    };
+
+    for (auto builder : builders) {
+        for (bool optimize : {false, true}) {
+            BuildOptions options;
+            options.builder = builder;
+            options.optimize = optimize;
+
+            bvh::Bvh<Scalar> bvh;
+            auto statistics = build_bvh(bvh, triangles, options);
+
+            bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> intersector(bvh, triangles.data());
+            bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh);
+
+            size_t hits = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            #pragma omp parallel for reduction(+: hits) schedule(dynamic, 1024)
+            for (size_t i = 0; i < rays.size(); ++i) {
+                if (traverser.traverse(rays[i], intersector)) {
+                    hits++;
+                }
+            }
+            auto stop = std::chrono::high_resolution_clock::now();
+            double trace_time = std::chrono::duration<double>(stop - start).count();
+
+            results.push_back({builder_name(builder) + (optimize ? " + reinsertion" : ""),
+                               statistics.build_time, statistics.sah_cost, statistics.node_count, rays.size()/trace_time/1e6});
+        }
+    }
+
+    std::cout << "\n" << triangles.size() << " triangles, " << rays.size() << " rays\n\n";
+    std::cout << std::left << std::setw(48) << "Configuration"
+              << std::right << std::setw(12) << "Build (s)"
+              << std::setw(12) << "SAH cost"
+              << std::setw(12) << "Nodes"
+              << std::setw(12) << "Mrays/s" << "\n";
+    for (auto &result : results) {
+        std::cout << std::left << std::setw(48) << result.name
+                  << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(3) << result.build_time
+                  << std::setw(12) << std::setprecision(2) << result.sah_cost
+                  << std::setw(12) << result.node_count
+                  << std::setw(12) << std::setprecision(2) << result.mrays << "\n";
+    }
+
+    return 0;
+}
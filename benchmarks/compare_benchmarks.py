@@ -0,0 +1,57 @@
+"""
+Compare two result files written by throughput_benchmark, such as runs of two commits on the same machine.
+For every benchmark of every scene present in both, the times are compared as a speedup of the new run
+over the baseline, and any benchmark slower than the threshold is reported as a regression.
+
+Usage: python compare_benchmarks.py baseline.json new.json [--threshold 0.1]
+
+Exits with status 1 if any benchmark regressed, so that it can be used as a check.
+"""
+import argparse
+import json
+import sys
+
+def load_results(path: str):
+    with open(path) as file:
+        data = json.load(file)
+    return data, {(result["scene"], result["benchmark"]): result for result in data["results"]}
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Compare two throughput_benchmark result files")
+    parser.add_argument("baseline", help="Results of the baseline run")
+    parser.add_argument("new", help="Results of the run to compare against the baseline")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="Fraction by which a benchmark may slow down before it is a regression")
+    args = parser.parse_args()
+
+    baseline_data, baseline = load_results(args.baseline)
+    new_data, new = load_results(args.new)
+    for key in ("threads", "scale"):
+        if baseline_data.get(key) != new_data.get(key):
+            print("Warning: the runs differ in {} ({} and {})".format(key, baseline_data.get(key), new_data.get(key)))
+
+    print("{:<14}{:<24}{:>12}{:>12}{:>10}".format("Scene", "Benchmark", "Base (s)", "New (s)", "Speedup"))
+    regressions = []
+    for key, result in baseline.items():
+        if key not in new:
+            continue
+        base_seconds = result["seconds"]
+        new_seconds = new[key]["seconds"]
+        speedup = base_seconds/new_seconds if new_seconds > 0 else float("inf")
+        regressed = new_seconds > (1 + args.threshold)*base_seconds
+        if regressed:
+            regressions.append(key)
+        print("{:<14}{:<24}{:>12.4f}{:>12.4f}{:>9.2f}x{}".format(key[0], key[1], base_seconds, new_seconds, speedup,
+                                                                 "  REGRESSION" if regressed else ""))
+
+    missing = [key for key in baseline if key not in new] + [key for key in new if key not in baseline]
+    for scene, benchmark in missing:
+        print("Only in one run: {} {}".format(scene, benchmark))
+
+    if regressions:
+        print("\n{} benchmark(s) slower by more than {:.0f}%".format(len(regressions), 100*args.threshold))
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+// Compares the convergence of the path tracing integrators available through Integrator.  A mesh
+// (and optionally a backdrop mesh behind it) is lit by a large area light and rendered by each
+// integrator at increasing sample counts.  Every render is compared against a high sample count
+// reference produced by the same integrator, so the relative RMSE measures noise only, and the
+// time and samples per pixel needed by each integrator to reach the same noise are reported.
+//
+// Usage: convergence_benchmark <mesh.obj> [backdrop.obj] [reference_samples]
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+#include "bvh/triangle.hpp"
+
+#include "rigid_body.hpp"
+#include "cameras/camera.hpp"
+#include "cameras/simple_camera.hpp"
+#include "lights/light_variant.hpp"
+#include "rendering_dynamic/entity.hpp"
+#include "acceleration/acceleration_structure.hpp"
+#include "do_render.hpp"
+
+using Scalar = double;
+
+// RMSE of the RGB channels of image relative to reference, divided by the mean of the reference:
+double relative_rmse(const std::vector<float> &image, const std::vector<float> &reference) {
+    double squared_error = 0;
+    double mean = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < image.size(); i += 4) {
+        for (size_t c = 0; c < 3; ++c) {
+            double error = image[i + c] - reference[i + c];
+            squared_error += error*error;
+            mean += reference[i + c];
+            count++;
+        }
+    }
+    mean /= count;
+    return std::sqrt(squared_error/count) / std::max(mean, 1e-12);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <mesh.obj> [backdrop.obj] [reference_samples]\n";
+        return 1;
+    }
+    int reference_samples = argc > 3 ? std::stoi(argv[3]) : 256;
+    int num_bounces = 3;
+
+    // Scene: the mesh, and an optional backdrop behind it to provide indirect illumination:
+    std::vector<Entity<Scalar>*> entities;
+    entities.push_back(new Entity<Scalar>(argv[1], "obj", true, Color(0.8f)));
+    auto bbox = bvh::BoundingBox<Scalar>::empty();
+    for (auto &tri : entities[0]->triangles) {
+        bbox.extend(tri.bounding_box());
+    }
+    auto center = bbox.center();
+    Scalar radius = bvh::length(bbox.diagonal())/2;
+    if (argc > 2) {
+        auto backdrop = new Entity<Scalar>(argv[2], "obj", false, Color(0.5f));
+        backdrop->set_position(center + bvh::Vector3<Scalar>(0, 0, 1.5*radius));
+        entities.push_back(backdrop);
+    }
+    AccelerationStructure<Scalar> scene(entities, BuildOptions());
+
+    // Camera looking down +z at the mesh, and a large area light between it and the camera:
+    Scalar resolution[2] = {128, 128};
+    Scalar sensor_size[2] = {2, 2};
+    std::unique_ptr<Camera<Scalar>> camera = std::make_unique<SimpleCamera<Scalar>>(Scalar(2.5), resolution, sensor_size, true);
+    camera->set_position(center - bvh::Vector3<Scalar>(0, 0, 3*radius));
+
+    Scalar light_size[2] = {radius, radius};
+    AreaLight<Scalar> light(Scalar(10)*radius*radius, light_size);
+    light.set_position(center + bvh::Vector3<Scalar>(-radius, -radius, -1.5*radius));
+    std::vector<LightVariant<Scalar>> lights = {light};
+
+    struct Result {
+        std::string integrator;
+        int samples;
+        double time;
+        double rmse;
+    };
+    std::vector<Result> results;
+
+    std::vector<std::pair<std::string, Integrator>> integrators = {
+        {"unidirectional", Integrator::Unidirectional},
+        {"mis", Integrator::MIS}
+    };
+
+    for (auto &[name, integrator] : integrators) {
+        auto reference = render_radiance(camera, lights, scene, reference_samples, reference_samples, Scalar(-1),
+                                         num_bounces, integrator, 0, 1);
+
+        for (int samples = 1; samples <= 64; samples *= 2) {
+            auto start = std::chrono::high_resolution_clock::now();
+            auto image = render_radiance(camera, lights, scene, samples, samples, Scalar(-1),
+                                         num_bounces, integrator, 0, 1000 + samples);
+            auto stop = std::chrono::high_resolution_clock::now();
+            results.push_back({name, samples, std::chrono::duration<double>(stop - start).count(), relative_rmse(image, reference)});
+        }
+    }
+
+    std::cout << "\n" << scene.triangles.size() << " triangles, " << num_bounces << " bounces, "
+              << reference_samples << " reference samples per pixel\n\n";
+    std::cout << std::left << std::setw(20) << "Integrator"
+              << std::right << std::setw(12) << "Samples"
+              << std::setw(12) << "Time (s)"
+              << std::setw(16) << "Relative RMSE" << "\n";
+    for (auto &result : results) {
+        std::cout << std::left << std::setw(20) << result.integrator
+                  << std::right << std::fixed
+                  << std::setw(12) << result.samples
+                  << std::setw(12) << std::setprecision(3) << result.time
+                  << std::setw(16) << std::setprecision(4) << result.rmse << "\n";
+    }
+
+    // Noise target: the unidirectional integrator at 16 samples per pixel.  Report the first
+    // sample count (and its time) at which each integrator reaches it:
+    double target = 0;
+    for (auto &result : results) {
+        if (result.integrator == "unidirectional" && result.samples == 16) {
+            target = result.rmse;
+        }
+    }
+    std::cout << "\nTo reach a relative RMSE of " << std::setprecision(4) << target << ":\n";
+    for (auto &[name, integrator] : integrators) {
+        auto reached = std::find_if(results.begin(), results.end(), [&, &name = name](const Result &result) {
+            return result.integrator == name && result.rmse <= target;
+        });
+        std::cout << "    " << std::left << std::setw(16) << name;
+        if (reached != results.end()) {
+            std::cout << reached->samples << " samples per pixel in " << std::setprecision(3) << reached->time << " s\n";
+        }
+        else {
+            std::cout << "not reached within 64 samples per pixel\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Compares shadow ray throughput of the generic any-hit traversal (SingleRayTraverser with an
+// AnyPrimitiveIntersector) against the specialized OcclusionTraverser on a given mesh.  Shadow
+// rays start just off of random points on the surface of the mesh and end at random points on a
+// sphere of lights surrounding it, so that both occluded and unoccluded rays are traced.
+//
+// Usage: occlusion_benchmark <mesh.obj> [num_rays]
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+#include "bvh/single_ray_traverser.hpp"
+#include "bvh/primitive_intersectors.hpp"
+#include "bvh/triangle.hpp"
+
+#include "model_loaders/obj.hpp"
+
+#include "acceleration/build_bvh.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+
+using Scalar = double;
+
+std::vector<bvh::Ray<Scalar>> generate_shadow_rays(const std::vector<bvh::Triangle<Scalar>> &triangles,
+                                                   const bvh::BoundingBox<Scalar> &bbox, size_t num_rays) {
+    std::mt19937 eng(42);
+    std::uniform_real_distribution<Scalar> dist(0.0, 1.0);
+    std::uniform_int_distribution<size_t> pick(0, triangles.size() - 1);
+
+    auto center = bbox.center();
+    auto radius = bvh::length(bbox.diagonal());
+
+    std::vector<bvh::Ray<Scalar>> rays;
+    rays.reserve(num_rays);
+    for (size_t i = 0; i < num_rays; ++i) {
+        auto &tri = triangles[pick(eng)];
+        Scalar u = dist(eng);
+        Scalar v = dist(eng);
+        if (u + v > 1) {
+            u = 1 - u;
+            v = 1 - v;
+        }
+        auto normal = bvh::normalize(tri.n);
+        auto side = dist(eng) < 0.5 ? Scalar(1) : Scalar(-1);
+        auto origin = u*tri.p1() + v*tri.p2() + (1-u-v)*tri.p0 + side*Scalar(1e-4)*radius*normal;
+
+        Scalar z   = 2*dist(eng) - 1;
+        Scalar phi = 2*M_PI*dist(eng);
+        Scalar r   = std::sqrt(std::max(Scalar(0), 1 - z*z));
+        auto light = center + radius*bvh::Vector3<Scalar>(r*std::cos(phi), r*std::sin(phi), z);
+        rays.emplace_back(origin, bvh::normalize(light - origin), 0, bvh::length(light - origin));
+    }
+    return rays;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <mesh.obj> [num_rays]\n";
+        return 1;
+    }
+    size_t num_rays = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+    auto triangles = obj::load_from_file<Scalar>(argv[1]);
+    if (triangles.empty()) {
+        std::cerr << "No triangles loaded from " << argv[1] << "\n";
+        return 1;
+    }
+
+    bvh::Bvh<Scalar> bvh;
+    auto statistics = build_bvh(bvh, triangles, BuildOptions());
+
+    auto global_bbox = bvh::BoundingBox<Scalar>::empty();
+    for (auto &tri : triangles) {
+        global_bbox.extend(tri.bounding_box());
+    }
+    auto rays = generate_shadow_rays(triangles, global_bbox, num_rays);
+
+    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_intersector(bvh, triangles.data());
+    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh);
+    ScenePrimitives<Scalar> primitives(bvh, triangles);
+    OcclusionTraverser<Scalar> occlusion_traverser(bvh, primitives);
+
+    std::vector<uint8_t> any_hit_result(rays.size());
+    std::vector<uint8_t> occlusion_result(rays.size());
+
+    // Take the best of a few runs of each method:
+    double any_hit_time = 1e30;
+    double occlusion_time = 1e30;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (size_t i = 0; i < rays.size(); ++i) {
+            any_hit_result[i] = traverser.traverse(rays[i], any_intersector).has_value();
+        }
+        auto stop = std::chrono::high_resolution_clock::now();
+        any_hit_time = std::min(any_hit_time, std::chrono::duration<double>(stop - start).count());
+
+        start = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for (size_t i = 0; i < rays.size(); ++i) {
+            occlusion_result[i] = occlusion_traverser.occluded(rays[i]);
+        }
+        stop = std::chrono::high_resolution_clock::now();
+        occlusion_time = std::min(occlusion_time, std::chrono::duration<double>(stop - start).count());
+    }
+
+    size_t occluded = std::count(occlusion_result.begin(), occlusion_result.end(), 1);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        mismatches += any_hit_result[i] != occlusion_result[i];
+    }
+
+    std::cout << "\n" << triangles.size() << " triangles (" << statistics.builder << "), " << rays.size() << " shadow rays, "
+              << std::fixed << std::setprecision(1) << 100.0*occluded/rays.size() << "% occluded\n\n";
+    std::cout << std::left << std::setw(40) << "Method"
+              << std::right << std::setw(12) << "Time (s)"
+              << std::setw(12) << "Mrays/s" << "\n";
+    std::cout << std::left << std::setw(40) << "SingleRayTraverser + any-hit"
+              << std::right << std::setprecision(3) << std::setw(12) << any_hit_time
+              << std::setprecision(2) << std::setw(12) << rays.size()/any_hit_time/1e6 << "\n";
+    std::cout << std::left << std::setw(40) << "OcclusionTraverser"
+              << std::right << std::setprecision(3) << std::setw(12) << occlusion_time
+              << std::setprecision(2) << std::setw(12) << rays.size()/occlusion_time/1e6 << "\n";
+    std::cout << "\nSpeedup: " << any_hit_time/occlusion_time << "x, " << mismatches << " mismatched results\n";
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,512 @@
+// Measures ray tracing throughput on procedural scenes, so that changes to the builders, traversers
+// and renderers can be compared across commits without any external models.  Three scenes are
+// generated: a soup of overlapping spheres, an asteroid-like icosphere displaced by noise and a
+// digital elevation model traced as a heightfield.  For each scene the following are timed, taking
+// the best of a few runs after an untimed one that also counts the rays traced:
+//
+//   build        flattening the entities and building the BVH
+//   primary      closest hits of one camera ray per pixel
+//   shadow       visibility of a point light from every primary hit
+//   incoherent   closest hits of random directions leaving every primary hit
+//   render       do_render() at 4 samples per pixel and 2 bounces with the unidirectional
+//                integrator, and render_mis_wavefront with the wavefront MIS renderer
+//   *_pass       intersection, instance, normal, traversal cost and measurement passes
+//   batch_lidar  do_batch_lidar() from lidars spread around the scene
+//
+// Results are printed as a table and written as JSON, which compare_benchmarks.py compares between
+// two runs.  scale multiplies the primitive and ray counts (1 by default).
+//
+// Usage: throughput_benchmark [results.json] [scale] [repeats]
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+#include "bvh/triangle.hpp"
+
+#include "rigid_body.hpp"
+#include "cameras/camera.hpp"
+#include "cameras/simple_camera.hpp"
+#include "lidars/lidar.hpp"
+#include "lidars/simple_lidar.hpp"
+#include "lights/light_variant.hpp"
+#include "rendering_dynamic/entity.hpp"
+#include "acceleration/acceleration_structure.hpp"
+#include "path_tracing/ray_offset.hpp"
+#include "do_render.hpp"
+#include "do_lidar.hpp"
+#include "passes.hpp"
+#include "statistics.hpp"
+
+using Scalar = double;
+using Vector3 = bvh::Vector3<Scalar>;
+
+// Smooth value noise in [-1, 1] from hashed values on the integer lattice:
+Scalar lattice_value(int x, int y, int z) {
+    uint32_t h = uint32_t(x)*73856093u ^ uint32_t(y)*19349663u ^ uint32_t(z)*83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return Scalar(h & 0xffffff)/Scalar(0x7fffff) - 1;
+}
+
+Scalar value_noise(const Vector3 &p) {
+    int x = (int) std::floor(p[0]), y = (int) std::floor(p[1]), z = (int) std::floor(p[2]);
+    Scalar f[3] = {p[0] - x, p[1] - y, p[2] - z};
+    for (auto &t : f) {
+        t = t*t*(3 - 2*t);
+    }
+    Scalar value = 0;
+    for (int corner = 0; corner < 8; ++corner) {
+        int dx = corner & 1, dy = (corner >> 1) & 1, dz = corner >> 2;
+        Scalar weight = (dx ? f[0] : 1 - f[0]) * (dy ? f[1] : 1 - f[1]) * (dz ? f[2] : 1 - f[2]);
+        value += weight*lattice_value(x + dx, y + dy, z + dz);
+    }
+    return value;
+}
+
+// Octaves of value noise, each at twice the frequency and half the amplitude of the one before:
+Scalar fbm(Vector3 p, int octaves) {
+    Scalar value = 0;
+    Scalar amplitude = 0.5;
+    for (int octave = 0; octave < octaves; ++octave) {
+        value += amplitude*value_noise(p);
+        p = Scalar(2)*p;
+        amplitude *= 0.5;
+    }
+    return value;
+}
+
+using Face = std::array<uint32_t, 3>;
+
+void write_obj(const std::string &path, const std::vector<Vector3> &vertices, const std::vector<Face> &faces) {
+    std::ofstream file(path);
+    file << std::setprecision(9);
+    for (auto &v : vertices) {
+        file << "v " << v[0] << " " << v[1] << " " << v[2] << "\n";
+    }
+    for (auto &f : faces) {
+        file << "f " << f[0] + 1 << " " << f[1] + 1 << " " << f[2] + 1 << "\n";
+    }
+}
+
+std::string temporary_path(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Overlapping UV spheres of random sizes scattered through a cube of side 2 about the origin.  The
+// overlap puts many bounding boxes over every point, which is hard on the BVH:
+Entity<Scalar>* sphere_soup(double scale) {
+    const int rings = 16;
+    const int segments = 32;
+    size_t num_spheres = std::max<size_t>(1, (size_t) std::lround(200*scale));
+
+    std::mt19937 eng(1);
+    std::uniform_real_distribution<Scalar> position(-0.85, 0.85);
+    std::uniform_real_distribution<Scalar> size(0.05, 0.15);
+
+    std::vector<Vector3> vertices;
+    std::vector<Face> faces;
+    for (size_t s = 0; s < num_spheres; ++s) {
+        Vector3 center(position(eng), position(eng), position(eng));
+        Scalar radius = size(eng);
+        uint32_t base = (uint32_t) vertices.size();
+        for (int r = 0; r <= rings; ++r) {
+            Scalar theta = M_PI*r/rings;
+            for (int k = 0; k < segments; ++k) {
+                Scalar phi = 2*M_PI*k/segments;
+                vertices.push_back(center + radius*Vector3(std::sin(theta)*std::cos(phi), std::sin(theta)*std::sin(phi), std::cos(theta)));
+            }
+        }
+        for (int r = 0; r < rings; ++r) {
+            for (int k = 0; k < segments; ++k) {
+                uint32_t i00 = base + r*segments + k;
+                uint32_t i01 = base + r*segments + (k + 1) % segments;
+                uint32_t i10 = i00 + segments;
+                uint32_t i11 = i01 + segments;
+                if (r > 0) {
+                    faces.push_back({i00, i01, i11});
+                }
+                if (r < rings - 1) {
+                    faces.push_back({i00, i11, i10});
+                }
+            }
+        }
+    }
+
+    auto path = temporary_path("crt_benchmark_sphere_soup.obj");
+    write_obj(path, vertices, faces);
+    return new Entity<Scalar>(path, "obj", false, Color(0.8f));
+}
+
+// Subdivided icosahedron of unit radius, its vertices pushed in and out by noise into a lumpy,
+// asteroid-like body.  Each level of subdivision has four times the triangles of the one before:
+Entity<Scalar>* asteroid(double scale) {
+    int levels = std::clamp((int) std::lround(7 + std::log(scale)/std::log(4.0)), 1, 9);
+
+    Scalar t = (1 + std::sqrt(Scalar(5)))/2;
+    std::vector<Vector3> vertices = {
+        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+    };
+    for (auto &v : vertices) {
+        v = bvh::normalize(v);
+    }
+    std::vector<Face> faces = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+    };
+
+    for (int level = 0; level < levels; ++level) {
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+        auto midpoint = [&] (uint32_t a, uint32_t b) {
+            auto key = std::make_pair(std::min(a, b), std::max(a, b));
+            auto found = midpoints.find(key);
+            if (found != midpoints.end()) {
+                return found->second;
+            }
+            uint32_t index = (uint32_t) vertices.size();
+            vertices.push_back(bvh::normalize(vertices[a] + vertices[b]));
+            midpoints.emplace(key, index);
+            return index;
+        };
+        std::vector<Face> subdivided;
+        subdivided.reserve(4*faces.size());
+        for (auto &f : faces) {
+            uint32_t a = midpoint(f[0], f[1]);
+            uint32_t b = midpoint(f[1], f[2]);
+            uint32_t c = midpoint(f[2], f[0]);
+            subdivided.push_back({f[0], a, c});
+            subdivided.push_back({f[1], b, a});
+            subdivided.push_back({f[2], c, b});
+            subdivided.push_back({a, b, c});
+        }
+        faces.swap(subdivided);
+    }
+
+    for (auto &v : vertices) {
+        v = (Scalar(0.8) + Scalar(0.4)*fbm(Scalar(2)*v + Vector3(10, 20, 30), 8))*v;
+    }
+
+    auto path = temporary_path("crt_benchmark_asteroid.obj");
+    write_obj(path, vertices, faces);
+    return new Entity<Scalar>(path, "obj", true, Color(0.6f));
+}
+
+// Rolling terrain covering 2 by 2 about the origin, facing a camera that looks down +z:
+Entity<Scalar>* dem(double scale, size_t &posts) {
+    size_t side = (size_t) std::lround(1024*std::sqrt(scale)) + 1;
+    posts = side*side;
+    Scalar spacing = Scalar(2)/(side - 1);
+
+    std::vector<float> heights(side*side);
+    #pragma omp parallel for
+    for (size_t row = 0; row < side; ++row) {
+        for (size_t col = 0; col < side; ++col) {
+            heights[row*side + col] = (float) (0.3*fbm(Vector3(2*col*spacing, 2*row*spacing, 0.5), 10));
+        }
+    }
+    auto raster = HeightfieldRaster::from_vector(heights, side, side, spacing, spacing);
+
+    auto entity = new Entity<Scalar>(raster, true, Color(0.7f));
+    Scalar rotation[3][3] = {{1, 0, 0}, {0, -1, 0}, {0, 0, -1}};
+    entity->set_rotation(rotation);
+    entity->set_position(Vector3(-1, 1, 0));
+    return entity;
+}
+
+struct BenchmarkScene {
+    std::string name;
+    std::vector<Entity<Scalar>*> entities;
+    size_t heightfield_posts = 0;
+};
+
+struct Result {
+    std::string scene;
+    std::string benchmark;
+    double seconds;
+    uint64_t rays;
+    uint64_t node_visits;
+    uint64_t primitive_tests;
+};
+
+// Run benchmark once, untimed, to count the rays it traces and warm up the caches, and then
+// repeats times, returning the best time:
+Result run_benchmark(const std::string &scene, const std::string &benchmark, int repeats,
+                     const std::function<void(RenderStatistics*)> &run) {
+    RenderStatistics statistics;
+    run(&statistics);
+
+    double best = 1e30;
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+        auto start = std::chrono::high_resolution_clock::now();
+        run(nullptr);
+        auto stop = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(stop - start).count());
+    }
+    uint64_t rays = statistics.camera_rays + statistics.secondary_rays + statistics.shadow_rays + statistics.lidar_rays;
+    return {scene, benchmark, best, rays, statistics.node_visits, statistics.primitive_tests};
+}
+
+// Rays traced directly through a traverser, with their counts collected like those of a render.  Their
+// results are written to a volatile sink, so that no intersection can be optimized away:
+void trace_closest(const ClosestHitTraverser<Scalar> &traverser, const std::vector<bvh::Ray<Scalar>> &rays,
+                   RenderStatistics *statistics) {
+    StatisticsCollector collector(statistics);
+    Scalar distance_sum = 0;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(+: distance_sum)
+    for (size_t i = 0; i < rays.size(); ++i) {
+        if (auto hit = traverser.traverse(rays[i])) {
+            distance_sum += hit->intersection.t;
+        }
+    }
+    collector.finish(0);
+    volatile Scalar sink = distance_sum;
+    (void) sink;
+}
+
+void trace_occlusion(const OcclusionTraverser<Scalar> &traverser, const std::vector<bvh::Ray<Scalar>> &rays,
+                     RenderStatistics *statistics) {
+    StatisticsCollector collector(statistics);
+    size_t occluded = 0;
+    #pragma omp parallel for schedule(dynamic, 1024) reduction(+: occluded)
+    for (size_t i = 0; i < rays.size(); ++i) {
+        occluded += traverser.occluded(rays[i]);
+    }
+    collector.finish(0);
+    volatile size_t sink = occluded;
+    (void) sink;
+}
+
+std::vector<Result> benchmark_scene(BenchmarkScene &scene, double scale, int repeats) {
+    std::vector<Result> results;
+    auto &name = scene.name;
+
+    std::unique_ptr<AccelerationStructure<Scalar>> built;
+    results.push_back(run_benchmark(name, "build", repeats, [&] (RenderStatistics*) {
+        built = std::make_unique<AccelerationStructure<Scalar>>(scene.entities, BuildOptions());
+    }));
+    auto &accel = *built;
+
+    Scalar side = std::max<Scalar>(16, std::round(512*std::sqrt(scale)));
+    Scalar resolution[2] = {side, side};
+    Scalar sensor_size[2] = {2, 2};
+    std::unique_ptr<Camera<Scalar>> camera = std::make_unique<SimpleCamera<Scalar>>(Scalar(3), resolution, sensor_size, true);
+    camera->set_position(Vector3(0, 0, -3.6));
+    camera->prepare();
+
+    Vector3 light_position(-2, -2, -4);
+    PointLight<Scalar> light(Scalar(30));
+    light.set_position(light_position);
+    std::vector<LightVariant<Scalar>> lights = {light};
+
+    auto &primitives = accel.primitives;
+    ClosestHitTraverser<Scalar> closest_traverser(accel.bvh, primitives);
+    OcclusionTraverser<Scalar> occlusion_traverser(accel.bvh, primitives);
+
+    // Camera rays, then shadow and incoherent rays leaving the surface wherever they hit:
+    std::vector<bvh::Ray<Scalar>> primary_rays;
+    for (size_t j = 0; j < (size_t) side; ++j) {
+        for (size_t i = 0; i < (size_t) side; ++i) {
+            primary_rays.push_back(camera->sample_ray(i, j, 0.5));
+        }
+    }
+    std::vector<bvh::Ray<Scalar>> shadow_rays;
+    std::vector<bvh::Ray<Scalar>> incoherent_rays;
+    std::mt19937 eng(7);
+    std::uniform_real_distribution<Scalar> dist(0.0, 1.0);
+    for (auto &ray : primary_rays) {
+        auto hit = closest_traverser.traverse(ray);
+        if (!hit) {
+            continue;
+        }
+        auto surface = primitives.surface_point(*hit, ray, true);
+        auto outward = -surface.normal;
+        auto origin = offset_ray_origin(surface.point, outward);
+
+        auto to_light = light_position - origin;
+        shadow_rays.emplace_back(origin, bvh::normalize(to_light), 0, bvh::length(to_light));
+
+        // Uniform direction on the hemisphere around the outward normal:
+        Scalar z   = 2*dist(eng) - 1;
+        Scalar phi = 2*M_PI*dist(eng);
+        Scalar r   = std::sqrt(std::max(Scalar(0), 1 - z*z));
+        Vector3 direction(r*std::cos(phi), r*std::sin(phi), z);
+        if (bvh::dot(direction, outward) < 0) {
+            direction = -direction;
+        }
+        incoherent_rays.emplace_back(origin, direction);
+    }
+
+    results.push_back(run_benchmark(name, "primary", repeats, [&] (RenderStatistics *statistics) {
+        trace_closest(closest_traverser, primary_rays, statistics);
+    }));
+    results.push_back(run_benchmark(name, "shadow", repeats, [&] (RenderStatistics *statistics) {
+        trace_occlusion(occlusion_traverser, shadow_rays, statistics);
+    }));
+    results.push_back(run_benchmark(name, "incoherent", repeats, [&] (RenderStatistics *statistics) {
+        trace_closest(closest_traverser, incoherent_rays, statistics);
+    }));
+
+    results.push_back(run_benchmark(name, "render", repeats, [&] (RenderStatistics *statistics) {
+        do_render<Scalar>(camera, lights, accel, 4, 4, Scalar(-1), 2, Integrator::Unidirectional, 0, false, nullptr, statistics);
+    }));
+    results.push_back(run_benchmark(name, "render_mis_wavefront", repeats, [&] (RenderStatistics *statistics) {
+        do_render<Scalar>(camera, lights, accel, 4, 4, Scalar(-1), 2, Integrator::MIS, 0, true, nullptr, statistics);
+    }));
+
+    results.push_back(run_benchmark(name, "intersection_pass", repeats, [&] (RenderStatistics *statistics) {
+        get_inetersections(camera, accel, statistics);
+    }));
+    results.push_back(run_benchmark(name, "instance_pass", repeats, [&] (RenderStatistics *statistics) {
+        get_instances(camera, accel, statistics);
+    }));
+    results.push_back(run_benchmark(name, "normal_pass", repeats, [&] (RenderStatistics *statistics) {
+        get_normals(camera, accel, statistics);
+    }));
+    results.push_back(run_benchmark(name, "traversal_cost_pass", repeats, [&] (RenderStatistics *statistics) {
+        get_traversal_costs(camera, accel, statistics);
+    }));
+    results.push_back(run_benchmark(name, "measurement_pass", repeats, [&] (RenderStatistics *statistics) {
+        get_measurements(camera, accel, lights, statistics);
+    }));
+
+    // Lidars spread over a sphere around the scene, each pointing at its center:
+    size_t num_lidars = std::clamp<size_t>((size_t) std::lround(20000*scale), 1, 100000);
+    std::vector<Vector3> positions;
+    auto rotations = std::make_unique<Scalar[][3][100000]>(3);
+    for (size_t k = 0; k < num_lidars; ++k) {
+        Scalar z   = 2*dist(eng) - 1;
+        Scalar phi = 2*M_PI*dist(eng);
+        Scalar r   = std::sqrt(std::max(Scalar(0), 1 - z*z));
+        Vector3 position = Scalar(4)*Vector3(r*std::cos(phi), r*std::sin(phi), z);
+
+        // Rows of the rotation: any frame whose third axis (the beam) points at the origin:
+        Vector3 beam = bvh::normalize(-position);
+        Vector3 helper = std::abs(beam[0]) < 0.9 ? Vector3(1, 0, 0) : Vector3(0, 1, 0);
+        Vector3 x = bvh::normalize(bvh::cross(helper, beam));
+        Vector3 y = bvh::cross(beam, x);
+        Vector3 axes[3] = {x, y, beam};
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                rotations[i][j][k] = axes[i][j];
+            }
+        }
+        positions.push_back(position);
+    }
+    std::unique_ptr<Lidar<Scalar>> lidar = std::make_unique<SimpleLidar<Scalar>>(true);
+    lidar->batch_set_pose(positions, rotations.get());
+    results.push_back(run_benchmark(name, "batch_lidar", repeats, [&] (RenderStatistics *statistics) {
+        do_batch_lidar(lidar, accel, 1, statistics);
+    }));
+
+    return results;
+}
+
+void write_json(const std::string &path, const std::vector<BenchmarkScene> &scenes,
+                const std::vector<size_t> &triangles, const std::vector<Result> &results,
+                int threads, double scale, int repeats) {
+    std::ofstream file(path);
+    file << std::setprecision(9);
+    file << "{\n  \"threads\": " << threads << ",\n  \"scale\": " << scale << ",\n  \"repeats\": " << repeats << ",\n";
+    file << "  \"scenes\": [\n";
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        file << "    {\"name\": \"" << scenes[i].name << "\", \"triangles\": " << triangles[i]
+             << ", \"heightfield_posts\": " << scenes[i].heightfield_posts << "}" << (i + 1 < scenes.size() ? ",\n" : "\n");
+    }
+    file << "  ],\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto &result = results[i];
+        double mrays = result.rays/result.seconds/1e6;
+        file << "    {\"scene\": \"" << result.scene << "\", \"benchmark\": \"" << result.benchmark
+             << "\", \"seconds\": " << result.seconds << ", \"rays\": " << result.rays
+             << ", \"mrays_per_second\": " << mrays
+             << ", \"node_visits_per_ray\": " << (result.rays ? double(result.node_visits)/result.rays : 0.0)
+             << ", \"primitive_tests_per_ray\": " << (result.rays ? double(result.primitive_tests)/result.rays : 0.0)
+             << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    if (!file) {
+        std::cerr << "Failed to write " << path << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string output = argc > 1 ? argv[1] : "throughput_benchmark.json";
+    double scale = argc > 2 ? std::stod(argv[2]) : 1.0;
+    int repeats = argc > 3 ? std::max(1, std::stoi(argv[3])) : 3;
+    if (scale <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [results.json] [scale] [repeats]\n";
+        return 1;
+    }
+
+    int threads = 1;
+    #ifdef _OPENMP
+        threads = omp_get_max_threads();
+    #endif
+
+    std::vector<BenchmarkScene> scenes(3);
+    scenes[0].name = "sphere_soup";
+    scenes[0].entities = {sphere_soup(scale)};
+    scenes[1].name = "asteroid";
+    scenes[1].entities = {asteroid(scale)};
+    scenes[2].name = "dem";
+    scenes[2].entities = {dem(scale, scenes[2].heightfield_posts)};
+
+    std::vector<Result> results;
+    std::vector<size_t> triangles;
+    for (auto &scene : scenes) {
+        for (size_t i = 0; i < scene.entities.size(); ++i) {
+            scene.entities[i]->set_id((uint32_t) i + 1);
+        }
+        size_t count = 0;
+        for (auto entity : scene.entities) {
+            count += entity->triangles.size();
+        }
+        triangles.push_back(count);
+
+        auto scene_results = benchmark_scene(scene, scale, repeats);
+        results.insert(results.end(), scene_results.begin(), scene_results.end());
+    }
+
+    std::cout << "\n" << threads << " threads, scale " << scale << ", best of " << repeats << " runs\n";
+    for (size_t i = 0; i < scenes.size(); ++i) {
+        std::cout << "    " << scenes[i].name << ": " << triangles[i] << " triangles, "
+                  << scenes[i].heightfield_posts << " heightfield posts\n";
+    }
+    std::cout << "\n" << std::left << std::setw(14) << "Scene"
+              << std::setw(24) << "Benchmark"
+              << std::right << std::setw(12) << "Time (s)"
+              << std::setw(12) << "Mrays/s"
+              << std::setw(12) << "Nodes/ray"
+              << std::setw(12) << "Prims/ray" << "\n";
+    for (auto &result : results) {
+        std::cout << std::left << std::setw(14) << result.scene
+                  << std::setw(24) << result.benchmark
+                  << std::right << std::fixed
+                  << std::setw(12) << std::setprecision(4) << result.seconds
+                  << std::setw(12) << std::setprecision(2) << result.rays/result.seconds/1e6
+                  << std::setw(12) << std::setprecision(1) << (result.rays ? double(result.node_visits)/result.rays : 0.0)
+                  << std::setw(12) << std::setprecision(1) << (result.rays ? double(result.primitive_tests)/result.rays : 0.0) << "\n";
+    }
+
+    write_json(output, scenes, triangles, results, threads, scale, repeats);
+    std::cout << "\nResults written to " << output << "\n";
+
+    return 0;
+}
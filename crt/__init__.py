@@ -1,5 +1,6 @@
 from .rigid_body import RigidBody
-from .entity import Entity
-from .body_fixed import BodyFixedGroup, BodyFixedEntity
+from .entity import Entity, Ellipsoid, Sphere, Heightfield
+from .body_fixed import BodyFixedGroup, BodyFixedEntity, BodyFixedEllipsoid, BodyFixedSphere, BodyFixedHeightfield
 
-__all__ = ['Entity', 'RigidBody','BodyFixedGroup', 'BodyFixedEntity']
\ No newline at end of file
+__all__ = ['Entity', 'Ellipsoid', 'Sphere', 'Heightfield', 'RigidBody','BodyFixedGroup', 'BodyFixedEntity',
+           'BodyFixedEllipsoid', 'BodyFixedSphere', 'BodyFixedHeightfield']
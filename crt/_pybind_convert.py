@@ -1,9 +1,12 @@
-from crt.lights import PointLight, AreaLight
+from crt.lights import PointLight, AreaLight, SunLight
 from crt import Entity
+from crt.acceleration import BuildOptions
+from crt.sensors import SensorModel
 
 def valid_light(light):
     return (type(light) == PointLight) or \
-           (type(light) == AreaLight)
+           (type(light) == AreaLight) or \
+           (type(light) == SunLight)
 
 def validate_lights(lights):
     err_msg = """error"""
@@ -31,4 +34,21 @@ def validate_entities(entities):
         assert(type(entities) == Entity, err_msg)
         entities_cpp.append(entities._cpp)
 
-    return entities_cpp
\ No newline at end of file
+    return entities_cpp
+
+def validate_build_options(build_options):
+    err_msg = """build_options must be a BuildOptions object"""
+
+    if build_options is None:
+        build_options = BuildOptions()
+    assert(type(build_options) == BuildOptions), err_msg
+
+    return build_options._cpp
+def validate_sensor(sensor):
+    err_msg = """sensor must be a SensorModel object"""
+
+    if sensor is None:
+        return None
+    assert(type(sensor) == SensorModel), err_msg
+
+    return sensor._cpp
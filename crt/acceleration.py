@@ -0,0 +1,80 @@
+import _crt
+
+_BUILDERS = {
+    "sweep_sah": _crt.BuilderType.SweepSah,
+    "binned_sah": _crt.BuilderType.BinnedSah,
+    "locally_ordered_clustering": _crt.BuilderType.LocallyOrderedClustering,
+    "linear": _crt.BuilderType.LinearBvh,
+    "spatial_split": _crt.BuilderType.SpatialSplit
+}
+
+class BuildOptions:
+    """
+    The :class:`BuildOptions` class controls how bounding volume heirarchies are built.  The defaults
+    give the highest quality heirarchy, which is best suited to static :class:`~.body_fixed.BodyFixedGroup`
+    objects.  Dynamic scenes that are rebuilt for every frame may be faster overall with the
+    :code:`"linear"` builder.
+
+    :param builder: BVH construction algorithm.  One of :code:`"sweep_sah"`, :code:`"binned_sah"`,
+                    :code:`"locally_ordered_clustering"`, :code:`"linear"` or :code:`"spatial_split"`
+                    |default| :code:`"sweep_sah"`
+    :type builder: str, optional
+    :param optimize: Flag to run the parallel reinsertion optimizer after building |default| :code:`True`
+    :type optimize: bool, optional
+    :param optimize_layout: Flag to reorder the nodes in memory for faster traversal |default| :code:`True`
+    :type optimize_layout: bool, optional
+    :param max_leaf_size: Largest number of primitives in a leaf (top-down builders only) |default| :code:`16`
+    :type max_leaf_size: int, optional
+    :param split_factor: Additional references the spatial split builder may create, as a fraction of
+                         the number of primitives |default| :code:`0.3`
+    :type split_factor: float, optional
+    :param traversal_cost: Cost of visiting a node relative to testing one triangle, used by the surface
+                           area heuristic.  Larger values give fewer, larger leaves |default| :code:`1.0`
+    :type traversal_cost: float, optional
+    """
+    def __init__(self, builder: str="sweep_sah", optimize: bool=True, optimize_layout: bool=True,
+                 max_leaf_size: int=16, split_factor: float=0.3, traversal_cost: float=1.0):
+
+        err_msg = "builder must be one of: " + ", ".join(_BUILDERS.keys())
+        assert(builder in _BUILDERS), err_msg
+
+        self.builder = builder
+        """
+        BVH construction algorithm (:code:`str`)
+        """
+
+        self.optimize = optimize
+        """
+        Flag to run the parallel reinsertion optimizer after building (:code:`bool`)
+        """
+
+        self.optimize_layout = optimize_layout
+        """
+        Flag to reorder the nodes in memory for faster traversal (:code:`bool`)
+        """
+
+        self.max_leaf_size = max_leaf_size
+        """
+        Largest number of primitives in a leaf (:code:`int`)
+        """
+
+        self.traversal_cost = traversal_cost
+        """
+        Cost of visiting a node relative to testing one triangle (:code:`float`)
+        """
+
+        self.split_factor = split_factor
+        """
+        Additional references the spatial split builder may create (:code:`float`)
+        """
+
+        self._cpp = _crt.BuildOptions()
+        """
+        Corresponding C++ BuildOptions object
+        """
+        self._cpp.builder = _BUILDERS[builder]
+        self._cpp.optimize = optimize
+        self._cpp.optimize_layout = optimize_layout
+        self._cpp.max_leaf_size = max_leaf_size
+        self._cpp.traversal_cost = traversal_cost
+        self._cpp.split_factor = split_factor
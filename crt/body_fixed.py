@@ -8,6 +8,12 @@ from crt.lights import Light
 from crt.lidars import Lidar
 
 from crt.rigid_body import RigidBody
+from crt.acceleration import BuildOptions
+from crt.sensors import SensorModel
+
+from crt.statistics import _new_statistics, _with_statistics
+from crt._pybind_convert import validate_build_options, validate_sensor
+from crt._validate_values import validate_position, validate_rotation
 
 class BodyFixedEntity(RigidBody):
     """
@@ -21,9 +27,14 @@ class BodyFixedEntity(RigidBody):
     :type geometry_type: str, optional
     :param smooth_shading: Flag to enable smooth shading via vertex normal interpolation |default| :code:`False`
     :type smooth_shading: bool, optional
+    :param texture_path: Path to an albedo texture, mapped using the texture coordinates of the geometry.  Either a
+        PNG image, or a tiled :code:`.crtt` texture (see :func:`crt.textures.bake_tiled_texture`) which is streamed
+        from disk.  If provided, this replaces :code:`color`.  Textures are shared between all entities using the
+        same path, and are filtered from the mip level matching the area a pixel covers |default| :code:`None`
+    :type texture_path: str, optional
     """
     def __init__(self, geometry_path: str, color: ArrayLike =[1,1,1], geometry_type: str="obj",
-                 smooth_shading: bool=False, **kwargs):
+                 smooth_shading: bool=False, texture_path: str=None, **kwargs):
         super(BodyFixedEntity, self).__init__(**kwargs)
         
         self.geometry_path = geometry_path
@@ -46,7 +57,13 @@ class BodyFixedEntity(RigidBody):
         Flag to enable smooth shading via vertex normal interpolation (:code:`bool`)
         """
 
-        self._cpp = _crt.BodyFixedEntity(self.geometry_path, self.geometry_type, self.smooth_shading, self.color)
+        self.texture_path = texture_path
+        """
+        Path to the albedo texture, if any (:code:`str`)
+        """
+
+        self._cpp = _crt.BodyFixedEntity(self.geometry_path, self.geometry_type, self.smooth_shading, self.color,
+                                         self.texture_path or "")
         """
         Corresponding C++ Entity object
         """
@@ -54,6 +71,153 @@ class BodyFixedEntity(RigidBody):
         self.set_pose(self.position, self.rotation)
         self.set_scale(self.scale)
 
+    def generate_lods(self, max_levels: int=8, min_triangles: int=1000, cache_path: str=None):
+        """
+        Simplify the mesh into a chain of levels of detail, each with about a quarter of the triangles of the one before.
+        For every image, the coarsest level whose geometric error projects to no more than the tolerance set by
+        :meth:`set_lod_tolerance` is traced, so that the cost of building and tracing the scene follows the size of the
+        entity in the image rather than the size of its mesh.  Simplification is done with quadric error metrics, and keeps
+        texture seams and open boundaries in place.  The levels are generated when the entity is added to a
+        :class:`BodyFixedGroup`.
+
+        :param max_levels: Largest number of levels to generate |default| :code:`8`
+        :type max_levels: int, optional
+        :param min_triangles: Fewest triangles a level may have |default| :code:`1000`
+        :type min_triangles: int, optional
+        :param cache_path: Path of a file caching the levels.  Levels are read from it when it was written for the
+            same mesh, and are generated and written to it otherwise |default| :code:`None`
+        :type cache_path: str, optional
+        """
+        self._cpp.generate_lods(max_levels, min_triangles, cache_path or "")
+
+    def add_lod(self, geometry_path: str, error: float=0, geometry_type: str="obj"):
+        """
+        Add a level of detail loaded from a file, coarser than any already added, as an alternative to
+        :meth:`generate_lods` for meshes simplified by other tools.
+
+        :param geometry_path: Path to the simplified mesh geometry
+        :type geometry_path: str
+        :param error: Largest distance between the simplified and the full mesh, in the units of the mesh.  If not
+            positive, half the mean edge length of the simplified mesh is used |default| :code:`0`
+        :type error: float, optional
+        :param geometry_type: The format of the mesh geometry provided |default| :code:`"obj"`
+        :type geometry_type: str, optional
+        """
+        self._cpp.add_lod(geometry_path, geometry_type, error)
+
+    def set_lod_tolerance(self, lod_tolerance: float):
+        """
+        Set the largest error, in pixels, that a level of detail may show in an image |default| :code:`1`
+
+        :param lod_tolerance: Projected error allowed, in pixels
+        :type lod_tolerance: float
+        """
+        self._cpp.set_lod_tolerance(lod_tolerance)
+
+
+class BodyFixedEllipsoid(BodyFixedEntity):
+    """
+    The :class:`BodyFixedEllipsoid` class is an analytic triaxial ellipsoid for use in a :class:`BodyFixedGroup`,
+    see :class:`crt.Ellipsoid`
+
+    :param radii: Radii of the ellipsoid along its own x, y, and z axes
+    :type radii: ArrayLike
+    :param color: The RGB color code of the geometry |default| :code:`[1,1,1]`
+    :type color: ArrayLike, optional
+    :param texture_path: Path to an equirectangular albedo texture |default| :code:`None`
+    :type texture_path: str, optional
+    """
+    def __init__(self, radii: ArrayLike, color: ArrayLike =[1,1,1], texture_path: str=None, **kwargs):
+        super(BodyFixedEntity, self).__init__(**kwargs)
+
+        self.radii = radii
+        """
+        Radii of the ellipsoid along its x, y, and z axes (:code:`ArrayLike`)
+        """
+
+        self.geometry_path = None
+        self.geometry_type = "ellipsoid"
+        self.color = color
+        self.smooth_shading = True
+        self.texture_path = texture_path
+
+        self._cpp = _crt.BodyFixedEntity([float(r) for r in self.radii], self.color, self.texture_path or "")
+        """
+        Corresponding C++ Entity object
+        """
+
+        self.set_pose(self.position, self.rotation)
+        self.set_scale(self.scale)
+
+
+class BodyFixedSphere(BodyFixedEllipsoid):
+    """
+    The :class:`BodyFixedSphere` class is an analytic sphere for use in a :class:`BodyFixedGroup`, see
+    :class:`crt.Sphere`
+
+    :param radius: Radius of the sphere
+    :type radius: float
+    :param color: The RGB color code of the geometry |default| :code:`[1,1,1]`
+    :type color: ArrayLike, optional
+    :param texture_path: Path to an equirectangular albedo texture |default| :code:`None`
+    :type texture_path: str, optional
+    """
+    def __init__(self, radius: float, color: ArrayLike =[1,1,1], texture_path: str=None, **kwargs):
+        super(BodyFixedSphere, self).__init__([radius, radius, radius], color=color, texture_path=texture_path, **kwargs)
+
+        self.radius = radius
+        """
+        Radius of the sphere (:code:`float`)
+        """
+
+
+class BodyFixedHeightfield(BodyFixedEntity):
+    """
+    The :class:`BodyFixedHeightfield` class is a terrain given as a raster of heights for use in a
+    :class:`BodyFixedGroup`, see :class:`crt.Heightfield`
+
+    :param heights: Heights of the posts, as an array of shape :code:`(rows, cols)`.  A C-contiguous
+        :code:`float32` array (such as a :code:`numpy.memmap`) is traced in place without being copied
+    :type heights: ArrayLike
+    :param spacing: Distance between neighboring posts along the columns and the rows |default| :code:`[1,1]`
+    :type spacing: ArrayLike, optional
+    :param color: The RGB color code of the geometry |default| :code:`[1,1,1]`
+    :type color: ArrayLike, optional
+    :param smooth_shading: Flag to enable smooth shading via interpolated post normals |default| :code:`True`
+    :type smooth_shading: bool, optional
+    :param texture_path: Path to an albedo texture covering the whole raster, with its first row at the top of
+        the image |default| :code:`None`
+    :type texture_path: str, optional
+    """
+    def __init__(self, heights: ArrayLike, spacing: ArrayLike=[1,1], color: ArrayLike =[1,1,1],
+                 smooth_shading: bool=True, texture_path: str=None, **kwargs):
+        super(BodyFixedEntity, self).__init__(**kwargs)
+
+        self.heights = heights
+        """
+        Heights of the posts (:code:`ArrayLike`)
+        """
+
+        self.spacing = spacing
+        """
+        Distance between neighboring posts along the columns and the rows (:code:`ArrayLike`)
+        """
+
+        self.geometry_path = None
+        self.geometry_type = "heightfield"
+        self.color = color
+        self.smooth_shading = smooth_shading
+        self.texture_path = texture_path
+
+        self._cpp = _crt.BodyFixedEntity(self.heights, [float(s) for s in self.spacing], self.smooth_shading,
+                                         self.color, self.texture_path or "")
+        """
+        Corresponding C++ Entity object
+        """
+
+        self.set_pose(self.position, self.rotation)
+        self.set_scale(self.scale)
+
 
 class BodyFixedGroup(RigidBody):
     """
@@ -62,9 +226,11 @@ class BodyFixedGroup(RigidBody):
 
     :param entities: BodyFixedEntity/Entities against which ray tracing is performed
     :type entities: Union[BodyFixedEntity, List[BodyFixedEntity], Tuple[BodyFixedEntity,...]]
+    :param build_options: Options for building the cached Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
     """
     def __init__(self, entities: Union[BodyFixedEntity, List[BodyFixedEntity], Tuple[BodyFixedEntity,...]],
-                 **kwargs):       
+                 build_options: BuildOptions=None, **kwargs):       
         super(BodyFixedGroup, self).__init__(**kwargs)
 
         err_msg = """error"""
@@ -73,17 +239,108 @@ class BodyFixedGroup(RigidBody):
         entities_cpp = []
         if (type(entities) == list) or (type(entities) == tuple):
             for entity in entities:
-                assert(type(entity) == BodyFixedEntity, err_msg)
+                assert isinstance(entity, BodyFixedEntity), err_msg
                 entities_cpp.append(entity._cpp)
         else:
-            assert(type(entities) == BodyFixedEntity, err_msg)
+            assert isinstance(entities, BodyFixedEntity), err_msg
             entities_cpp.append(entities._cpp)
 
-        self._cpp = _crt.BodyFixedGroup(entities_cpp)
+        self._cpp = _crt.BodyFixedGroup(entities_cpp, validate_build_options(build_options))
         """
         Corresponding C++ BodyFixedGroup object
         """
 
+        self.end_position = None
+        """
+        Position of the group at the end of a camera's exposure, or :code:`None` if it does not move
+        (:code:`numpy.ndarray` of shape :code:`(3,)`)
+        """
+
+        self.end_rotation = None
+        """
+        Rotation of the group at the end of a camera's exposure, or :code:`None` if it does not move
+        (:code:`numpy.ndarray` of shape :code:`(3,3)`)
+        """
+
+    def set_motion(self, end_position: ArrayLike=None, end_rotation: ArrayLike=None):
+        """
+        Move the group while an image is exposed, from its current pose to an end pose, over the same time as
+        the motion of the camera (see :meth:`~.cameras.Camera.set_motion` and :meth:`~.cameras.Camera.set_shutter`).
+        Rays are traced in the frame of the group, so its motion is applied to each ray as a motion of the camera
+        relative to it, and the cached bounding volume heirarchy is used as it is.  Lights keep their pose at the
+        start of the exposure.  Calling this without arguments stops the group from moving.
+
+        :param end_position: Position at the end of the motion |default| :code:`position`
+        :type end_position: ArrayLike, optional
+        :param end_rotation: Rotation at the end of the motion |default| :code:`rotation`
+        :type end_rotation: ArrayLike, optional
+        """
+        if end_position is None and end_rotation is None:
+            self.end_position = None
+            self.end_rotation = None
+            return
+        self.end_position = validate_position(self.position if end_position is None else end_position)
+        self.end_rotation = validate_rotation(self.rotation if end_rotation is None else end_rotation)
+
+    def _transform_motion_to_body(self, camera: Camera):
+        # The end pose of the camera relative to the end pose of the group:
+        if camera.end_position is None and self.end_position is None:
+            camera._cpp.clear_motion()
+            return
+        end_position = camera.position if camera.end_position is None else camera.end_position
+        end_rotation = camera.rotation if camera.end_rotation is None else camera.end_rotation
+        body_position = self.position if self.end_position is None else self.end_position
+        body_rotation = self.rotation if self.end_rotation is None else self.end_rotation
+        relative_position = self.scale*np.matmul(body_rotation, end_position - body_position)
+        relative_rotation = np.matmul(body_rotation, end_rotation.T).T
+        camera._cpp.set_motion(relative_position, relative_rotation)
+
+    def update_vertices(self, entity_id: int, vertices: ArrayLike):
+        """
+        Move the vertices of one of the grouped entities and refit the cached bounding volume heirarchy
+        in place, rather than rebuilding it from scratch.  If the refitted heirarchy has degraded too far
+        (see :meth:`set_rebuild_threshold`) it is automatically rebuilt.
+
+        :param entity_id: Id of the entity to update.  Entities are numbered from :code:`1` in the order
+                          they were provided to the group
+        :type entity_id: int
+        :param vertices: New vertex positions expressed in the entity's own frame, given as three points per
+                         triangle in the order the triangles were loaded (:code:`numpy.ndarray` of shape 
+                         :code:`(num_triangles,3,3)`)
+        :type vertices: ArrayLike
+        """
+        self._cpp.update_vertices(entity_id, np.asarray(vertices, dtype=np.float64))
+
+    def set_rebuild_threshold(self, rebuild_threshold: float):
+        """
+        Set the growth in SAH cost, relative to the last full build, after which :meth:`update_vertices`
+        rebuilds the bounding volume heirarchy instead of refitting it |default| :code:`1.5`
+
+        :param rebuild_threshold: Ratio of refitted SAH cost to built SAH cost that triggers a rebuild
+        :type rebuild_threshold: float
+        """
+        self._cpp.set_rebuild_threshold(rebuild_threshold)
+
+    def get_build_statistics(self) -> dict:
+        """
+        Get statistics describing the most recent full build of the bounding volume heirarchy
+
+        :return: Dictionary with the :code:`builder` used, the :code:`triangle_count`, :code:`ellipsoid_count`,
+            :code:`heightfield_count`, :code:`node_count` and :code:`reference_count` of the hierarchy, its :code:`sah_cost`, and the :code:`flatten_time`
+            and :code:`build_time` in seconds
+        :rtype: dict
+        """
+        stats = self._cpp.get_build_statistics()
+        return {"builder": stats.builder,
+                "triangle_count": stats.triangle_count,
+                "ellipsoid_count": stats.ellipsoid_count,
+                "heightfield_count": stats.heightfield_count,
+                "node_count": stats.node_count,
+                "reference_count": stats.reference_count,
+                "sah_cost": stats.sah_cost,
+                "flatten_time": stats.flatten_time,
+                "build_time": stats.build_time}
+
     def transform_to_body(self, position: ArrayLike, rotation: ArrayLike) -> Tuple[np.ndarray, np.ndarray]:
         """
         Transform provided position and rotation into the body fixed frame
@@ -105,7 +362,10 @@ class BodyFixedGroup(RigidBody):
     #     return position, rotation
 
     def render(self, camera: Camera, lights: Union[Light, List[Light], Tuple[Light,...]],
-              min_samples: int=1, max_samples: int=1, noise_threshold: float=1., num_bounces: int=1) -> np.ndarray:
+              min_samples: int=1, max_samples: int=1, noise_threshold: float=1., num_bounces: int=1,
+              integrator: str="unidirectional", light_samples: int=None,
+              wavefront: bool=False, return_measurements: bool=False,
+              sensor: SensorModel=None, return_statistics: bool=False) -> Union[np.ndarray, tuple]:
         """
         Render a scene with a set of grouped body fixed entities.
 
@@ -121,10 +381,31 @@ class BodyFixedGroup(RigidBody):
         :type noise_threshold: float, optional
         :param num_bounces: Number of ray bounces |default| :code:`1`
         :type num_bounces: int, optional
-        :return: Rendered image
-        :rtype: np.ndarray
+        :param integrator: Path tracing algorithm, either :code:`"unidirectional"` or :code:`"mis"` (next event estimation
+                           with multiple importance sampling) |default| :code:`"unidirectional"`
+        :type integrator: str, optional
+        :param light_samples: Number of lights selected at each path vertex by importance sampling a light hierarchy.  If
+                              :code:`None`, every light is sampled at every vertex |default| :code:`None`
+        :type light_samples: int, optional
+        :param wavefront: Trace paths one bounce at a time in batches, sorting rays and grouping shading by material,
+                          for better memory coherence in renders with several bounces |default| :code:`False`
+        :type wavefront: bool, optional
+        :param return_measurements: Flag to also return the measurements of each entity in the image, computed while
+                                    it is traced (see :meth:`measurement_pass`).  Centroids are weighted by the
+                                    rendered brightness |default| :code:`False`
+        :type return_measurements: bool, optional
+        :param sensor: Sensor recording the rendered radiance.  If :code:`None`, the image is returned as 8 bit RGBA
+                       pixels |default| :code:`None`
+        :type sensor: SensorModel, optional
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
+        :return: Rendered image, in digital numbers of the sensor if one is given.  If :code:`return_measurements` is
+                 set to :code:`True`, then a list of measurements is returned as a second output.
+        :rtype: Union[np.ndarray, Tuple(np.ndarray, List[dict])]
         """
         # Transform camera into BodyFixedGroupd frame:
+        self._transform_motion_to_body(camera)
         relative_position, relative_rotation = self.transform_to_body(camera.position, camera.rotation)
         camera.set_pose(relative_position, relative_rotation)
 
@@ -139,17 +420,100 @@ class BodyFixedGroup(RigidBody):
             lights.set_pose(relative_position, relative_rotation)
             lights_cpp.append(lights._cpp)
 
+        stats = _new_statistics(return_statistics)
         image = self._cpp.render(camera._cpp, lights_cpp,
-                                 min_samples, max_samples, noise_threshold, num_bounces)
-        return image
+                                 min_samples, max_samples, noise_threshold, num_bounces, integrator,
+                                 light_samples or 0, wavefront, return_measurements, validate_sensor(sensor), stats)
+        return _with_statistics(image, stats)
+
+    def render_batch(self, cameras: Union[Camera, List[Camera], Tuple[Camera,...]],
+                     lights: Union[Light, List[Light], Tuple[Light,...]],
+                     positions: ArrayLike=None, rotations: ArrayLike=None,
+                     min_samples: int=1, max_samples: int=1, noise_threshold: float=1., num_bounces: int=1,
+                     integrator: str="unidirectional", light_samples: int=None,
+                     wavefront: bool=False, return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, dict]]:
+        """
+        Render a sequence of images of the grouped body fixed entities in a single call.  The frames are traced
+        together against the cached bounding volume heirarchy, with the work of all of them shared between threads,
+        which avoids the per call overhead of :meth:`render` and keeps every core busy even for small images.
+
+        :param cameras: Either a list of cameras, one per frame, or a single camera to be placed at each of the poses
+                        given by :code:`positions` and :code:`rotations`.  All cameras must have the same resolution
+        :type cameras: Union[Camera, List[Camera], Tuple[Camera,...]]
+        :param lights: Light(s) to be used for rendering
+        :type lights: Union[Light, List[Light], Tuple[Light,...]]
+        :param positions: Camera position of every frame (:code:`numpy.ndarray` of shape :code:`(N,3)`), used with a
+                          single camera |default| :code:`None`
+        :type positions: ArrayLike, optional
+        :param rotations: Camera rotation of every frame (:code:`numpy.ndarray` of shape :code:`(N,3,3)`), used with a
+                          single camera |default| :code:`None`
+        :type rotations: ArrayLike, optional
+        :param min_samples: Minimum number of ray samples per pixel |default| :code:`1`
+        :type min_samples: int, optional
+        :param max_samples: Maximum number of ray samples per pixel |default| :code:`1`
+        :type max_samples: int, optional
+        :param noise_threshold: Pixel noise threshold for adaptive sampling |default| :code:`1`
+        :type noise_threshold: float, optional
+        :param num_bounces: Number of ray bounces |default| :code:`1`
+        :type num_bounces: int, optional
+        :param integrator: Path tracing algorithm, either :code:`"unidirectional"` or :code:`"mis"` |default|
+                           :code:`"unidirectional"`
+        :type integrator: str, optional
+        :param light_samples: Number of lights selected at each path vertex by importance sampling a light hierarchy.  If
+                              :code:`None`, every light is sampled at every vertex |default| :code:`None`
+        :type light_samples: int, optional
+        :param wavefront: Trace each frame with the wavefront renderer, see :meth:`render` |default| :code:`False`
+        :type wavefront: bool, optional
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
+        :return: Rendered images (:code:`numpy.ndarray` of shape :code:`(N,H,W,4)`), each traced without motion
+        :rtype: Union[np.ndarray, Tuple(np.ndarray, dict)]
+        """
+        if isinstance(cameras, Camera):
+            if positions is None or rotations is None:
+                raise ValueError("positions and rotations are required when rendering a batch with a single camera")
+            camera_list = [cameras]
+            positions = np.asarray(positions, dtype=np.float64).reshape(-1, 3)
+            rotations = np.asarray(rotations, dtype=np.float64).reshape(-1, 3, 3)
+        else:
+            camera_list = list(cameras)
+            positions = np.array([camera.position for camera in camera_list], dtype=np.float64).reshape(-1, 3)
+            rotations = np.array([camera.rotation for camera in camera_list], dtype=np.float64).reshape(-1, 3, 3)
+        if len(positions) != len(rotations):
+            raise ValueError("positions and rotations must describe the same number of frames")
+
+        # Transform camera poses into BodyFixedGroup frame:
+        relative_positions = np.empty_like(positions)
+        relative_rotations = np.empty_like(rotations)
+        for k in range(len(positions)):
+            relative_positions[k], relative_rotations[k] = self.transform_to_body(positions[k], rotations[k])
 
-    def simulate_lidar(self, lidar: Lidar, num_rays: int=1):
+        lights_cpp = []
+        if (type(lights) is list) or (type(lights) is tuple):
+            for light in lights:
+                relative_position, relative_rotation = self.transform_to_body(light.position, light.rotation)
+                light.set_pose(relative_position, relative_rotation)
+                lights_cpp.append(light._cpp)
+        else:
+            relative_position, relative_rotation = self.transform_to_body(lights.position, lights.rotation)
+            lights.set_pose(relative_position, relative_rotation)
+            lights_cpp.append(lights._cpp)
+
+        stats = _new_statistics(return_statistics)
+        images = self._cpp.render_batch([camera._cpp for camera in camera_list], relative_positions, relative_rotations,
+                                        lights_cpp, min_samples, max_samples, noise_threshold, num_bounces, integrator,
+                                        light_samples or 0, wavefront, stats)
+        return _with_statistics(images, stats)
+
+    def simulate_lidar(self, lidar: Lidar, num_rays: int=1, return_statistics: bool=False):
         relative_position, relative_rotation = self.transform_to_body(lidar.position, lidar.rotation)
         lidar.set_pose(relative_position, relative_rotation)
-        distance = self._cpp.simulate_lidar(lidar._cpp, num_rays)
-        return distance
+        stats = _new_statistics(return_statistics)
+        distance = self._cpp.simulate_lidar(lidar._cpp, num_rays, stats)
+        return _with_statistics(distance, stats)
 
-    def batch_simulate_lidar(self, lidar: Lidar, num_rays: int=1):
+    def batch_simulate_lidar(self, lidar: Lidar, num_rays: int=1, return_statistics: bool=False):
         positions = lidar.batch_positions
         rotations = lidar.batch_rotations
         relative_positions = np.zeros(positions.shape)
@@ -158,11 +522,12 @@ class BodyFixedGroup(RigidBody):
             relative_positions[idx,:], relative_rotations[:,:,idx] = self.transform_to_body(positions[idx,:], rotations[:,:,idx])
         lidar.batch_set_pose(relative_positions, relative_rotations)
 
-        distances = self._cpp.batch_simulate_lidar(lidar._cpp, num_rays)
-        return distances
+        stats = _new_statistics(return_statistics)
+        distances = self._cpp.batch_simulate_lidar(lidar._cpp, num_rays, stats)
+        return _with_statistics(distances, stats)
 
     def normal_pass(self, camera: Camera, 
-                    return_image: bool = False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+                    return_image: bool = False, return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
         """
         Perform a normal pass with body fixed entities
 
@@ -170,22 +535,27 @@ class BodyFixedGroup(RigidBody):
         :type camera: Camera
         :param return_image: Flag to return an image representation of the intersected normals |default| :code:`False`
         :type return_image: bool, optional
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
         :return: An array of the intersected normals.  If :code:`return_image` is set to :code:`True`, then an image
                 where the normal XYZ values are represented using RGB color values is returned as a second output.
         :rtype: Union[np.ndarray, Tuple(np.ndarray, np.ndarray)]
         """
         # Transform camera into BodyFixedGroup frame:
+        self._transform_motion_to_body(camera)
         relative_position, relative_rotation = self.transform_to_body(camera.position, camera.rotation)
         camera.set_pose(relative_position, relative_rotation)
 
-        normals = self._cpp.normal_pass(camera._cpp)
+        stats = _new_statistics(return_statistics)
+        normals = self._cpp.normal_pass(camera._cpp, stats)
         if return_image:
             image = 255*np.abs(normals)
-            return normals, image
-        return normals
+            return _with_statistics((normals, image), stats)
+        return _with_statistics(normals, stats)
 
     def intersection_pass(self, camera: Camera,
-                          return_image: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+                          return_image: bool=False, return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
         """
         Perform a normal pass with body fixed entities
 
@@ -193,25 +563,30 @@ class BodyFixedGroup(RigidBody):
         :type camera: Camera
         :param return_image: Flag to return an image representation of the intersection depth |default| :code:`False`
         :type return_image: bool, optional
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
         :return: An array of the intersected points.  If :code:`return_image` is set to :code:`True`, then an image
                 where the distance to each intersected point is represented via pixel intensity is returned 
                 as a second output.
         :rtype: Union[np.ndarray, Tuple(np.ndarray, np.ndarray)]
         """
         # Transform camera into BodyFixedGroup frame:
+        self._transform_motion_to_body(camera)
         relative_position, relative_rotation = self.transform_to_body(camera.position, camera.rotation)
         camera.set_pose(relative_position, relative_rotation)
 
-        intersections = self._cpp.intersection_pass(camera._cpp)
+        stats = _new_statistics(return_statistics)
+        intersections = self._cpp.intersection_pass(camera._cpp, stats)
         if return_image:
             image = np.sqrt(intersections[:,:,0]**2 + intersections[:,:,1]**2 + intersections[:,:,2]**2)
             image = image - np.min(image)
             image = 255*image/np.max(image)
-            return intersections, image
-        return intersections
+            return _with_statistics((intersections, image), stats)
+        return _with_statistics(intersections, stats)
 
     def instance_pass(self, camera: Camera, 
-                      return_image: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+                      return_image: bool=False, return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
         """
         Perform an instance segmentation pass with body fixed entities
 
@@ -219,16 +594,21 @@ class BodyFixedGroup(RigidBody):
         :type camera: Camera
         :param return_image: Flag to return an image representation of the instances |default| :code:`False`
         :type return_image: bool, optional
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
         :return: An array unique id codes for each unique entity intersected.  If :code:`return_image` is set 
                 to :code:`True`, then an image where each unique id is represented with a unique RGB color 
                 is returned as a second output.
         :rtype: Union[np.ndarray, Tuple(np.ndarray, np.ndarray)]
         """
         # Transform camera into BodyFixedGroup frame:
+        self._transform_motion_to_body(camera)
         relative_position, relative_rotation = self.transform_to_body(camera.position, camera.rotation)
         camera.set_pose(relative_position, relative_rotation)
 
-        instances = self._cpp.instance_pass(camera._cpp)
+        stats = _new_statistics(return_statistics)
+        instances = self._cpp.instance_pass(camera._cpp, stats)
         if return_image:
             unique_ids = np.unique(instances)
             colors = np.random.randint(0, high=255, size=(3,unique_ids.size))
@@ -236,5 +616,70 @@ class BodyFixedGroup(RigidBody):
             for idx, id in enumerate(unique_ids):
                 mask = instances == id
                 image[mask,:] = colors[:,idx]
-            return instances, image
-        return instances
\ No newline at end of file
+            return _with_statistics((instances, image), stats)
+        return _with_statistics(instances, stats)
+
+    def traversal_cost_pass(self, camera: Camera,
+                            return_image: bool=False, return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+        """
+        Perform a traversal cost pass with body fixed entities, counting the nodes of the cached bounding volume
+        heirarchy visited and the primitives tested by the camera ray of every pixel.
+        See :func:`crt.rendering.traversal_cost_pass`.
+
+        :param camera: Camera model to be used for generating rays
+        :type camera: Camera
+        :param return_image: Flag to return a heatmap of the total cost, with the costliest pixel at 255 |default| :code:`False`
+        :type return_image: bool, optional
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
+        :return: An array of shape (rows, cols, 2) of the number of nodes visited and primitives tested by each
+                pixel.  If :code:`return_image` is set to :code:`True`, then the heatmap is returned as a second output.
+        :rtype: Union[np.ndarray, Tuple(np.ndarray, np.ndarray)]
+        """
+        # Transform camera into BodyFixedGroup frame:
+        self._transform_motion_to_body(camera)
+        relative_position, relative_rotation = self.transform_to_body(camera.position, camera.rotation)
+        camera.set_pose(relative_position, relative_rotation)
+
+        stats = _new_statistics(return_statistics)
+        costs = self._cpp.traversal_cost_pass(camera._cpp, stats)
+        if return_image:
+            image = costs.sum(axis=2).astype(np.float64)
+            image = 255*image/max(np.max(image), 1)
+            return _with_statistics((costs, image), stats)
+        return _with_statistics(costs, stats)
+
+    def measurement_pass(self, camera: Camera,
+                         lights: Union[Light, List[Light], Tuple[Light,...]],
+                         return_statistics: bool=False) -> Union[List[dict], Tuple[List[dict], dict]]:
+        """
+        Measure each body fixed entity seen by a camera, for optical navigation, without rendering an image.
+        See :func:`crt.rendering.measurement_pass` for the contents of each measurement.
+
+        :param camera: Camera model to be used for generating rays
+        :type camera: Camera
+        :param lights: Light(s) deciding which pixels are lit
+        :type lights: Union[Light, List[Light], Tuple[Light,...]]
+        :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                                  output (see :mod:`crt.statistics`) |default| :code:`False`
+        :type return_statistics: bool, optional
+        :return: Measurements of each entity, in order of id
+        :rtype: Union[List[dict], Tuple(List[dict], dict)]
+        """
+        # Transform camera and lights into BodyFixedGroup frame:
+        self._transform_motion_to_body(camera)
+        relative_position, relative_rotation = self.transform_to_body(camera.position, camera.rotation)
+        camera.set_pose(relative_position, relative_rotation)
+
+        if not ((type(lights) is list) or (type(lights) is tuple)):
+            lights = [lights]
+        lights_cpp = []
+        for light in lights:
+            relative_position, relative_rotation = self.transform_to_body(light.position, light.rotation)
+            light.set_pose(relative_position, relative_rotation)
+            lights_cpp.append(light._cpp)
+
+        stats = _new_statistics(return_statistics)
+        measurements = self._cpp.measurement_pass(camera._cpp, lights_cpp, stats)
+        return _with_statistics(measurements, stats)
@@ -3,16 +3,68 @@ from abc import ABC, abstractmethod
 
 import _crt
 from crt.rigid_body import RigidBody
+from crt._validate_values import validate_position, validate_rotation
 from numpy.typing import ArrayLike
 
 class Camera(ABC):
     """
     The :class:`Camera` abstract base class 
     """
+
+    end_position = None
+    """
+    Position of the camera at the end of the exposure, or :code:`None` if it does not move
+    (:code:`numpy.ndarray` of shape :code:`(3,)`)
+    """
+
+    end_rotation = None
+    """
+    Rotation of the camera at the end of the exposure, or :code:`None` if it does not move
+    (:code:`numpy.ndarray` of shape :code:`(3,3)`)
+    """
+
     @abstractmethod
     def get_fov(self, degrees=True):
         return
 
+    def set_motion(self, end_position: ArrayLike=None, end_rotation: ArrayLike=None):
+        """
+        Move the camera while an image is exposed, from its current pose to an end pose (along a straight
+        line and the shortest rotation between them), for motion blur and rolling shutter effects (see
+        :meth:`set_shutter`).  Calling this without arguments stops the camera from moving.
+
+        :param end_position: Position at the end of the motion |default| :code:`position`
+        :type end_position: ArrayLike, optional
+        :param end_rotation: Rotation at the end of the motion |default| :code:`rotation`
+        :type end_rotation: ArrayLike, optional
+        """
+        if end_position is None and end_rotation is None:
+            self.end_position = None
+            self.end_rotation = None
+            self._cpp.clear_motion()
+            return
+        self.end_position = validate_position(self.position if end_position is None else end_position)
+        self.end_rotation = validate_rotation(self.rotation if end_rotation is None else end_rotation)
+        self._cpp.set_motion(self.end_position, self.end_rotation)
+
+    def set_shutter(self, exposure: float, readout: float=0.):
+        """
+        Set the shutter of a moving camera, or of a camera watching moving entities (see :meth:`set_motion` and
+        :meth:`~.entity.Entity.set_motion`).  Both times are fractions of the time they take to reach their end
+        poses.  Each row of the image is exposed for :code:`exposure`,
+        and row :code:`v` starts its exposure at :code:`readout*v/resolution[1]`, so that a nonzero
+        readout models a rolling shutter.  Samples of a pixel are spread over its exposure, which blurs
+        moving objects; with a single sample per pixel, rays are traced at the middle of the exposure.
+        Motion is only defined up to the end poses, so both times must be non-negative, and the last row must
+        end its exposure by then: :code:`exposure + readout <= 1`.
+
+        :param exposure: Exposure time of each row
+        :type exposure: float
+        :param readout: Time between the start of the exposure of the first and last rows |default| :code:`0`
+        :type readout: float, optional
+        """
+        self._cpp.set_shutter(exposure, readout)
+
 
 class SimpleCamera(RigidBody, Camera):
     """
@@ -68,4 +120,85 @@ class SimpleCamera(RigidBody, Camera):
         else:
             return 2*np.arctan2(self.sensor_size/2, 2*self.focal_length)
     
-        
\ No newline at end of file
+        
+
+class DistortedCamera(RigidBody, Camera):
+    """
+    The :class:`DistortedCamera` class is a pinhole camera with Brown-Conrady lens distortion.  Distortion
+    is applied to normalized image coordinates :math:`(x, y)`, with :math:`x` to the right and :math:`y` down
+    the image in units of the focal length, as most calibration tools do:
+
+    .. math::
+
+        x_d = x(1 + k_1 r^2 + k_2 r^4 + k_3 r^6) + 2 p_1 x y + p_2 (r^2 + 2 x^2)
+
+        y_d = y(1 + k_1 r^2 + k_2 r^4 + k_3 r^6) + p_1 (r^2 + 2 y^2) + 2 p_2 x y
+
+    The undistorted direction of every pixel corner is computed once for each set of intrinsics and shared
+    by all cameras with them, so that rays cost no more to generate than those of a :class:`SimpleCamera`.
+
+    :param focal_length: Focal length of the camera
+    :type focal_length: float
+    :param resolution: Resolution of camera
+    :type resolution: ArrayLike
+    :param sensor_size: Size of the camera's sensor
+    :type sensor_size: ArrayLike
+    :param radial_coefficients: Radial distortion coefficients :math:`(k_1, k_2, k_3)` |default| :code:`(0, 0, 0)`
+    :type radial_coefficients: ArrayLike, optional
+    :param tangential_coefficients: Tangential distortion coefficients :math:`(p_1, p_2)` |default| :code:`(0, 0)`
+    :type tangential_coefficients: ArrayLike, optional
+    :param z_positive: Flag for if the camera's boresight is aligned with positive z-axis |default| :code:`False`
+    :type z_positive: bool, optional
+    """
+    def __init__(self, focal_length: float, resolution: ArrayLike, sensor_size: ArrayLike,
+                 radial_coefficients: ArrayLike=(0, 0, 0), tangential_coefficients: ArrayLike=(0, 0),
+                 z_positive: bool=False, **kwargs):
+
+        super(DistortedCamera, self).__init__(**kwargs)
+
+        self.focal_length = focal_length
+        """
+        Focal length of the camera (:code:`float`)
+        """
+
+        self.resolution   = resolution
+        """
+        Resolution of the camera (:code:`numpy.array` of shape :code:`(2,)`)
+        """
+
+        self.sensor_size  = sensor_size
+        """
+        Sensor size of the camera (:code:`numpy.array` of shape :code:`(2,)`)
+        """
+
+        self.radial_coefficients = np.asarray(radial_coefficients, dtype=float)
+        """
+        Radial distortion coefficients :math:`(k_1, k_2, k_3)` (:code:`numpy.array` of shape :code:`(3,)`)
+        """
+
+        self.tangential_coefficients = np.asarray(tangential_coefficients, dtype=float)
+        """
+        Tangential distortion coefficients :math:`(p_1, p_2)` (:code:`numpy.array` of shape :code:`(2,)`)
+        """
+
+        self._cpp = _crt.DistortedCamera(focal_length, list(resolution), list(sensor_size), z_positive,
+                                         list(self.radial_coefficients), list(self.tangential_coefficients))
+        """
+        Corresponding C++ DistortedCamera object
+        """
+
+        self.set_pose(self.position, self.rotation)
+
+    def get_fov(self, degrees: bool=True) -> np.ndarray:
+        """
+        Calculate and return the angular field of view of the camera without its distortion
+
+        :param degrees: Flag for if the returned field of view has units of degrees |default| :code:`True`
+        :type degrees: bool, optional
+        :return: The calculated angular field of view(s)
+        :rtype: np.ndarray
+        """
+        if degrees:
+            return np.rad2deg(2*np.arctan2(self.sensor_size/2, 2*self.focal_length))
+        else:
+            return 2*np.arctan2(self.sensor_size/2, 2*self.focal_length)
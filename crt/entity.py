@@ -4,6 +4,7 @@ import numpy as np
 from numpy.typing import ArrayLike
 
 from crt.rigid_body import RigidBody
+from crt._validate_values import validate_position, validate_rotation
 
 class Entity(RigidBody):
     """
@@ -17,9 +18,27 @@ class Entity(RigidBody):
     :type geometry_type: str, optional
     :param smooth_shading: Flag to enable smooth shading via vertex normal interpolation |default| :code:`False`
     :type smooth_shading: bool, optional
+    :param texture_path: Path to an albedo texture, mapped using the texture coordinates of the geometry.  Either a
+        PNG image, or a tiled :code:`.crtt` texture (see :func:`crt.textures.bake_tiled_texture`) which is streamed
+        from disk.  If provided, this replaces :code:`color`.  Textures are shared between all entities using the
+        same path, and are filtered from the mip level matching the area a pixel covers |default| :code:`None`
+    :type texture_path: str, optional
     """
+
+    end_position = None
+    """
+    Position of the entity at the end of a camera's exposure, or :code:`None` if it does not move
+    (:code:`numpy.ndarray` of shape :code:`(3,)`)
+    """
+
+    end_rotation = None
+    """
+    Rotation of the entity at the end of a camera's exposure, or :code:`None` if it does not move
+    (:code:`numpy.ndarray` of shape :code:`(3,3)`)
+    """
+
     def __init__(self,geometry_path: str, color: ArrayLike =[1,1,1], geometry_type: str="obj", 
-                 smooth_shading: bool=False, **kwargs):
+                 smooth_shading: bool=False, texture_path: str=None, **kwargs):
         super(Entity, self).__init__(**kwargs)
 
         self.geometry_path = geometry_path
@@ -42,10 +61,189 @@ class Entity(RigidBody):
         Flag to enable smooth shading via vertex normal interpolation (:code:`bool`)
         """
 
-        self._cpp = _crt.Entity(self.geometry_path, self.geometry_type, self.smooth_shading, self.color)
+        self.texture_path = texture_path
+        """
+        Path to the albedo texture, if any (:code:`str`)
+        """
+
+        self._cpp = _crt.Entity(self.geometry_path, self.geometry_type, self.smooth_shading, self.color,
+                                self.texture_path or "")
+        """
+        Corresponding C++ Entity object
+        """
+
+        self.set_pose(self.position,self.rotation)
+        self.set_scale(self.scale)
+
+    def generate_lods(self, max_levels: int=8, min_triangles: int=1000, cache_path: str=None):
+        """
+        Simplify the mesh into a chain of levels of detail, each with about a quarter of the triangles of the one before.
+        For every image, the coarsest level whose geometric error projects to no more than the tolerance set by
+        :meth:`set_lod_tolerance` is traced, so that the cost of building and tracing the scene follows the size of the
+        entity in the image rather than the size of its mesh.  Simplification is done with quadric error metrics, and keeps
+        texture seams and open boundaries in place.
+
+        :param max_levels: Largest number of levels to generate |default| :code:`8`
+        :type max_levels: int, optional
+        :param min_triangles: Fewest triangles a level may have |default| :code:`1000`
+        :type min_triangles: int, optional
+        :param cache_path: Path of a file caching the levels.  Levels are read from it when it was written for the
+            same mesh, and are generated and written to it otherwise |default| :code:`None`
+        :type cache_path: str, optional
+        """
+        self._cpp.generate_lods(max_levels, min_triangles, cache_path or "")
+
+    def add_lod(self, geometry_path: str, error: float=0, geometry_type: str="obj"):
+        """
+        Add a level of detail loaded from a file, coarser than any already added, as an alternative to
+        :meth:`generate_lods` for meshes simplified by other tools.
+
+        :param geometry_path: Path to the simplified mesh geometry
+        :type geometry_path: str
+        :param error: Largest distance between the simplified and the full mesh, in the units of the mesh.  If not
+            positive, half the mean edge length of the simplified mesh is used |default| :code:`0`
+        :type error: float, optional
+        :param geometry_type: The format of the mesh geometry provided |default| :code:`"obj"`
+        :type geometry_type: str, optional
+        """
+        self._cpp.add_lod(geometry_path, geometry_type, error)
+
+    def set_lod_tolerance(self, lod_tolerance: float):
+        """
+        Set the largest error, in pixels, that a level of detail may show in an image |default| :code:`1`
+
+        :param lod_tolerance: Projected error allowed, in pixels
+        :type lod_tolerance: float
+        """
+        self._cpp.set_lod_tolerance(lod_tolerance)
+
+    def set_motion(self, end_position: ArrayLike=None, end_rotation: ArrayLike=None):
+        """
+        Move the entity while an image is exposed, from its current pose to an end pose (along a straight line
+        and the shortest rotation between them), on the same clock as the motion of the camera (see
+        :meth:`~.cameras.Camera.set_shutter`, which must give a nonzero exposure or readout for the entity to blur).
+        Each ray meets the entity where it is at the time the ray is taken, so that moving entities are blurred
+        and distorted by a rolling shutter even when the camera does not move, and their shadows move with them.
+        The bounding volume hierarchy bounds the entity over its whole motion, so fast motions trace more slowly.
+        Calling this without arguments stops the entity from moving.
+
+        :param end_position: Position at the end of the motion |default| :code:`position`
+        :type end_position: ArrayLike, optional
+        :param end_rotation: Rotation at the end of the motion |default| :code:`rotation`
+        :type end_rotation: ArrayLike, optional
+        """
+        if end_position is None and end_rotation is None:
+            self.end_position = None
+            self.end_rotation = None
+            self._cpp.clear_motion()
+            return
+        self.end_position = validate_position(self.position if end_position is None else end_position)
+        self.end_rotation = validate_rotation(self.rotation if end_rotation is None else end_rotation)
+        self._cpp.set_motion(self.end_position, self.end_rotation)
+
+class Ellipsoid(Entity):
+    """
+    The :class:`Ellipsoid` class is an analytic triaxial ellipsoid, intersected exactly rather than through a
+    tessellated mesh.  It shares the bounding volume heirarchy of a scene with any mesh entities, and stays smooth
+    and free of faceting however close the camera gets.
+
+    :param radii: Radii of the ellipsoid along its own x, y, and z axes
+    :type radii: ArrayLike
+    :param color: The RGB color code of the geometry |default| :code:`[1,1,1]`
+    :type color: ArrayLike, optional
+    :param texture_path: Path to an albedo texture, mapped by longitude (about the z axis) and latitude so that an
+        equirectangular map covers the whole body.  Either a PNG image, or a tiled :code:`.crtt` texture.  If
+        provided, this replaces :code:`color` |default| :code:`None`
+    :type texture_path: str, optional
+    """
+    def __init__(self, radii: ArrayLike, color: ArrayLike =[1,1,1], texture_path: str=None, **kwargs):
+        super(Entity, self).__init__(**kwargs)
+
+        self.radii = radii
+        """
+        Radii of the ellipsoid along its x, y, and z axes (:code:`ArrayLike`)
+        """
+
+        self.geometry_path = None
+        self.geometry_type = "ellipsoid"
+        self.color = color
+        self.smooth_shading = True
+        self.texture_path = texture_path
+
+        self._cpp = _crt.Entity([float(r) for r in self.radii], self.color, self.texture_path or "")
+        """
+        Corresponding C++ Entity object
+        """
+
+        self.set_pose(self.position,self.rotation)
+        self.set_scale(self.scale)
+
+
+class Sphere(Ellipsoid):
+    """
+    The :class:`Sphere` class is an analytic sphere, see :class:`Ellipsoid`
+
+    :param radius: Radius of the sphere
+    :type radius: float
+    :param color: The RGB color code of the geometry |default| :code:`[1,1,1]`
+    :type color: ArrayLike, optional
+    :param texture_path: Path to an equirectangular albedo texture |default| :code:`None`
+    :type texture_path: str, optional
+    """
+    def __init__(self, radius: float, color: ArrayLike =[1,1,1], texture_path: str=None, **kwargs):
+        super(Sphere, self).__init__([radius, radius, radius], color=color, texture_path=texture_path, **kwargs)
+
+        self.radius = radius
+        """
+        Radius of the sphere (:code:`float`)
+        """
+
+
+class Heightfield(Entity):
+    """
+    The :class:`Heightfield` class is a terrain given as a raster of heights, such as a digital elevation model.
+    The raster is traced through an implicit min/max quadtree and is never converted into triangles, so it only
+    needs a little more memory than the heights themselves.  Post :code:`(row, col)` lies at
+    :code:`(col*spacing[0], row*spacing[1], heights[row, col])` in the frame of the entity.
+
+    :param heights: Heights of the posts, as an array of shape :code:`(rows, cols)`.  A C-contiguous
+        :code:`float32` array (such as a :code:`numpy.memmap`) is traced in place without being copied
+    :type heights: ArrayLike
+    :param spacing: Distance between neighboring posts along the columns and the rows |default| :code:`[1,1]`
+    :type spacing: ArrayLike, optional
+    :param color: The RGB color code of the geometry |default| :code:`[1,1,1]`
+    :type color: ArrayLike, optional
+    :param smooth_shading: Flag to enable smooth shading via interpolated post normals |default| :code:`True`
+    :type smooth_shading: bool, optional
+    :param texture_path: Path to an albedo texture covering the whole raster, with its first row at the top of
+        the image |default| :code:`None`
+    :type texture_path: str, optional
+    """
+    def __init__(self, heights: ArrayLike, spacing: ArrayLike=[1,1], color: ArrayLike =[1,1,1],
+                 smooth_shading: bool=True, texture_path: str=None, **kwargs):
+        super(Entity, self).__init__(**kwargs)
+
+        self.heights = heights
+        """
+        Heights of the posts (:code:`ArrayLike`)
+        """
+
+        self.spacing = spacing
+        """
+        Distance between neighboring posts along the columns and the rows (:code:`ArrayLike`)
+        """
+
+        self.geometry_path = None
+        self.geometry_type = "heightfield"
+        self.color = color
+        self.smooth_shading = smooth_shading
+        self.texture_path = texture_path
+
+        self._cpp = _crt.Entity(self.heights, [float(s) for s in self.spacing], self.smooth_shading, self.color,
+                                self.texture_path or "")
         """
         Corresponding C++ Entity object
         """
 
         self.set_pose(self.position,self.rotation)
-        self.set_scale(self.scale)
\ No newline at end of file
+        self.set_scale(self.scale)
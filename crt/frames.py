@@ -0,0 +1,126 @@
+import _crt
+import numpy as np
+
+from typing import List
+from numpy.typing import ArrayLike
+
+def _validate_frame(image: ArrayLike) -> np.ndarray:
+    image = np.asarray(image)
+    if image.dtype == np.float64:
+        image = image.astype(np.float32)
+    err_msg = "frames must be uint8, uint16 or float32 arrays"
+    assert(image.dtype in (np.uint8, np.uint16, np.float32)), err_msg
+    assert(image.ndim in (2, 3)), "frames must have the shape (rows, cols) or (rows, cols, channels)"
+    return image
+
+def write_frame(path: str, image: ArrayLike):
+    """
+    Write a single image to disk, in the format given by the extension of :code:`path`:
+
+    - :code:`.png`: 8 bit (:code:`uint8`) or 16 bit (:code:`uint16`) PNG with 1 to 4 channels
+    - :code:`.npy`: NumPy array file, readable with :func:`numpy.load`
+    - :code:`.raw`: the bare pixel values, row by row, in native byte order
+
+    :param path: Path of the file to write
+    :type path: str
+    :param image: Image of shape (rows, cols) or (rows, cols, channels), of type :code:`uint8`, :code:`uint16` or
+                  :code:`float32` (:code:`float64` images are converted to :code:`float32`)
+    :type image: ArrayLike
+    """
+    _crt.write_frame(path, _validate_frame(image))
+
+class FrameWriter:
+    """
+    The :class:`FrameWriter` class encodes and writes images on a pool of background threads, so that a sequence
+    can keep rendering while earlier frames are compressed and saved.  Frames are written in the formats of
+    :func:`write_frame`.  Images are copied when they are handed over, and the frames waiting to be written
+    hold at most :code:`max_queued_bytes` of pixels: :meth:`write` waits for room beyond that, so memory stays
+    bounded however far rendering runs ahead of the disk.
+
+    Errors met while writing a frame are raised by the next call to :meth:`write` or :meth:`flush`.  Used as a
+    context manager, every frame is written by the end of the :code:`with` block::
+
+        with FrameWriter() as writer:
+            for idx, position in enumerate(positions):
+                camera.set_position(position)
+                writer.write("frame_{:04d}.png".format(idx), group.render(camera, light))
+
+    :param threads: Number of threads encoding and writing frames |default| :code:`2`
+    :type threads: int, optional
+    :param max_queued_bytes: Largest size of the frames waiting to be written |default| :code:`256*2**20`
+    :type max_queued_bytes: int, optional
+    """
+    def __init__(self, threads: int=2, max_queued_bytes: int=256*2**20):
+        assert(threads >= 1), "threads must be at least 1"
+
+        self.threads = threads
+        """
+        Number of threads encoding and writing frames (:code:`int`)
+        """
+
+        self.max_queued_bytes = max_queued_bytes
+        """
+        Largest size of the frames waiting to be written (:code:`int`)
+        """
+
+        self._cpp = _crt.FrameWriter(threads, max_queued_bytes)
+        """
+        Corresponding C++ FrameWriter object
+        """
+
+    def write(self, path: str, image: ArrayLike):
+        """
+        Queue an image to be written to :code:`path`, waiting only if too many frames are already queued
+
+        :param path: Path of the file to write
+        :type path: str
+        :param image: Image of shape (rows, cols) or (rows, cols, channels), of type :code:`uint8`, :code:`uint16`
+                      or :code:`float32`
+        :type image: ArrayLike
+        """
+        self._cpp.write(path, _validate_frame(image))
+
+    def flush(self):
+        """
+        Wait for every frame queued so far to be written
+        """
+        self._cpp.flush()
+
+    def pending(self) -> int:
+        """
+        Number of frames queued or being written
+
+        :return: Number of frames not yet written
+        :rtype: int
+        """
+        return self._cpp.pending()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.flush()
+
+def write_frames(images: ArrayLike, path_format: str, threads: int=2, max_queued_bytes: int=256*2**20) -> List[str]:
+    """
+    Write a sequence of images, such as those returned by :meth:`~.body_fixed.BodyFixedGroup.render_batch`, on
+    background threads (see :class:`FrameWriter`)
+
+    :param images: Images, along the first axis
+    :type images: ArrayLike
+    :param path_format: Path of each frame, formatted with its index, such as :code:`"frame_{:04d}.png"`
+    :type path_format: str
+    :param threads: Number of threads encoding and writing frames |default| :code:`2`
+    :type threads: int, optional
+    :param max_queued_bytes: Largest size of the frames waiting to be written |default| :code:`256*2**20`
+    :type max_queued_bytes: int, optional
+    :return: Paths of the frames written
+    :rtype: List[str]
+    """
+    paths = []
+    with FrameWriter(threads, max_queued_bytes) as writer:
+        for idx, image in enumerate(images):
+            path = path_format.format(idx)
+            writer.write(path, image)
+            paths.append(path)
+    return paths
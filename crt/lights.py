@@ -65,4 +65,37 @@ class AreaLight(RigidBody, Light):
         Corresponding C++ AreaLight object
         """
 
-        self.set_pose(self.position, self.rotation)
\ No newline at end of file
+        self.set_pose(self.position, self.rotation)
+
+class SunLight(RigidBody, Light):
+    """
+    The :class:`SunLight` class models a light source at infinite distance, such as the Sun.  The light
+    lies in the direction of its :attr:`position`, as seen from the origin of the scene, so its position 
+    can be set directly from SPICE ephemerides.  Its intensity is the irradiance delivered to a surface 
+    facing the light, and does not fall off with distance.
+
+    :param intensity: Irradiance of the light source at normal incidence
+    :type intensity: float
+    :param angular_radius: Angular radius of the solar disk in radians.  A value of :code:`0` makes the light 
+                           purely directional (producing perfectly sharp shadows) |default| :code:`0.004653`
+    :type angular_radius: float, optional
+    """
+    def __init__(self, intensity: float, angular_radius: float=0.004653, **kwargs):
+        super(SunLight, self).__init__(**kwargs)
+
+        self.intensity = intensity
+        """
+        Irradiance of the light source at normal incidence (:code:`float`)
+        """
+
+        self.angular_radius = angular_radius
+        """
+        Angular radius of the solar disk in radians (:code:`float`)
+        """
+
+        self._cpp = _crt.SunLight(self.intensity, self.angular_radius)
+        """
+        Corresponding C++ SunLight object
+        """
+
+        self.set_pose(self.position, self.rotation)
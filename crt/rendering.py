@@ -7,11 +7,18 @@ from crt.cameras import Camera
 from crt.lights import Light
 from crt.lidars import Lidar
 
-from crt._pybind_convert import validate_lights, validate_entities
+from crt.acceleration import BuildOptions
+from crt.sensors import SensorModel
+
+from crt.statistics import _new_statistics, _with_statistics
+from crt._pybind_convert import validate_lights, validate_entities, validate_build_options, validate_sensor
 
 def render(camera: Camera, lights: Union[Light, List[Light], Tuple[Light,...]],
            entities: Union[Entity, List[Entity], Tuple[Entity,...]], 
-           min_samples: int=1, max_samples: int=1, noise_threshold: float=1., num_bounces: int=1) -> np.ndarray:
+           min_samples: int=1, max_samples: int=1, noise_threshold: float=1., num_bounces: int=1,
+           build_options: BuildOptions=None, integrator: str="unidirectional", light_samples: int=None,
+           wavefront: bool=False, return_measurements: bool=False,
+           sensor: SensorModel=None, return_statistics: bool=False) -> Union[np.ndarray, tuple]:
     """
     Render a scene with dynamic entities.  Prior to rendering, a Bounding Volume Heirarchy will be built
     from scratch for the entire scene
@@ -30,29 +37,59 @@ def render(camera: Camera, lights: Union[Light, List[Light], Tuple[Light,...]],
     :type noise_threshold: float, optional
     :param num_bounces: Number of ray bounces |default| :code:`1`
     :type num_bounces: int, optional
-    :return: Rendered image
-    :rtype: np.ndarray
+    :param build_options: Options for building the Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
+    :param integrator: Path tracing algorithm, either :code:`"unidirectional"` or :code:`"mis"` (next event estimation
+                       with multiple importance sampling) |default| :code:`"unidirectional"`
+    :type integrator: str, optional
+    :param light_samples: Number of lights selected at each path vertex by importance sampling a light hierarchy.  If
+                          :code:`None`, every light is sampled at every vertex |default| :code:`None`
+    :type light_samples: int, optional
+    :param wavefront: Trace paths one bounce at a time in batches, sorting rays and grouping shading by material,
+                      for better memory coherence in renders with several bounces |default| :code:`False`
+    :type wavefront: bool, optional
+    :param return_measurements: Flag to also return the measurements of each entity in the image, computed while
+                                it is traced (see :func:`measurement_pass`).  Centroids are weighted by the
+                                rendered brightness |default| :code:`False`
+    :type return_measurements: bool, optional
+    :param sensor: Sensor recording the rendered radiance.  If :code:`None`, the image is returned as 8 bit RGBA
+                   pixels |default| :code:`None`
+    :type sensor: SensorModel, optional
+    :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                              output (see :mod:`crt.statistics`) |default| :code:`False`
+    :type return_statistics: bool, optional
+    :return: Rendered image, in digital numbers of the sensor if one is given.  If :code:`return_measurements` is
+             set to :code:`True`, then a list of measurements is returned as a second output.
+    :rtype: Union[np.ndarray, Tuple(np.ndarray, List[dict]), Tuple(np.ndarray, dict), Tuple(np.ndarray, List[dict], dict)]
     """
     lights_cpp = validate_lights(lights)
 
     entities_cpp = validate_entities(entities)
 
+    build_options_cpp = validate_build_options(build_options)
+
+    stats = _new_statistics(return_statistics)
     image = _crt.render(camera._cpp, lights_cpp, entities_cpp,
-                        min_samples, max_samples, noise_threshold, num_bounces)
-    return image
+                        min_samples, max_samples, noise_threshold, num_bounces, build_options_cpp, integrator,
+                        light_samples or 0, wavefront, return_measurements, validate_sensor(sensor), stats)
+    return _with_statistics(image, stats)
 
 def simulate_lidar(lidar: Lidar, entities: Union[Entity, List[Entity], Tuple[Entity,...]],
-                   num_rays: int=1):
+                   num_rays: int=1, build_options: BuildOptions=None, return_statistics: bool=False):
 
     entities_cpp = validate_entities(entities)
 
-    distance = _crt.simulate_lidar(lidar._cpp, entities_cpp, num_rays)
+    build_options_cpp = validate_build_options(build_options)
+
+    stats = _new_statistics(return_statistics)
+    distance = _crt.simulate_lidar(lidar._cpp, entities_cpp, num_rays, build_options_cpp, stats)
 
-    return distance
+    return _with_statistics(distance, stats)
 
 
 def normal_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[Entity,...]],
-                return_image: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+                return_image: bool=False, build_options: BuildOptions=None,
+                return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
                 
     """
     Perform a normal pass with dynamic entities
@@ -63,6 +100,11 @@ def normal_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[Enti
     :type entities: Union[Entity, List[Entity], Tuple[Entity,...]]
     :param return_image: Flag to return an image representation of the intersected normals |default| :code:`False`
     :type return_image: bool, optional
+    :param build_options: Options for building the Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
+    :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                              output (see :mod:`crt.statistics`) |default| :code:`False`
+    :type return_statistics: bool, optional
     :return: An array of the intersected normals.  If :code:`return_image` is set to :code:`True`, then an image
              where the normal XYZ values are represented using RGB color values is returned as a second output.
     :rtype: Union[np.ndarray, Tuple(np.ndarray, np.ndarray)]
@@ -71,16 +113,20 @@ def normal_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[Enti
     for entity in entities:
         entities_cpp.append(entity._cpp)
 
-    normals = _crt.normal_pass(camera._cpp, entities_cpp)
+    build_options_cpp = validate_build_options(build_options)
+
+    stats = _new_statistics(return_statistics)
+    normals = _crt.normal_pass(camera._cpp, entities_cpp, build_options_cpp, stats)
 
     if return_image:
         image = 255*np.abs(normals)
-        return normals, image
+        return _with_statistics((normals, image), stats)
 
-    return normals
+    return _with_statistics(normals, stats)
 
 def intersection_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[Entity,...]],
-                      return_image: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+                      return_image: bool=False, build_options: BuildOptions=None,
+                      return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
     """
     Perform a normal pass with dynamic entities
 
@@ -90,6 +136,11 @@ def intersection_pass(camera: Camera, entities: Union[Entity, List[Entity], Tupl
     :type entities: Union[Entity, List[Entity], Tuple[Entity,...]]
     :param return_image: Flag to return an image representation of the intersection depth |default| :code:`False`
     :type return_image: bool, optional
+    :param build_options: Options for building the Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
+    :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                              output (see :mod:`crt.statistics`) |default| :code:`False`
+    :type return_statistics: bool, optional
     :return: An array of the intersected points.  If :code:`return_image` is set to :code:`True`, then an image
              where the distance to each intersected point is represented via pixel intensity is returned 
              as a second output.
@@ -99,18 +150,22 @@ def intersection_pass(camera: Camera, entities: Union[Entity, List[Entity], Tupl
     for entity in entities:
         entities_cpp.append(entity._cpp)
 
-    intersections = _crt.intersection_pass(camera._cpp, entities_cpp)
+    build_options_cpp = validate_build_options(build_options)
+
+    stats = _new_statistics(return_statistics)
+    intersections = _crt.intersection_pass(camera._cpp, entities_cpp, build_options_cpp, stats)
 
     if return_image:
         image = np.sqrt(intersections[:,:,0]**2 + intersections[:,:,1]**2 + intersections[:,:,2]**2)
         image = image - np.min(image)
         image = 255*image/np.max(image)
-        return intersections, image
+        return _with_statistics((intersections, image), stats)
 
-    return intersections
+    return _with_statistics(intersections, stats)
 
 def instance_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[Entity,...]], 
-                  return_image: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+                  return_image: bool=False, build_options: BuildOptions=None,
+                  return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
     """
     Perform an instance segmentation pass with dynamic entities
 
@@ -120,6 +175,11 @@ def instance_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[En
     :type entities: Union[Entity, List[Entity], Tuple[Entity,...]]
     :param return_image: Flag to return an image representation of the instances |default| :code:`False`
     :type return_image: bool, optional
+    :param build_options: Options for building the Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
+    :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                              output (see :mod:`crt.statistics`) |default| :code:`False`
+    :type return_statistics: bool, optional
     :return: An array unique id codes for each unique entity intersected.  If :code:`return_image` is set 
              to :code:`True`, then an image where each unique id is represented with a unique RGB color 
              is returned as a second output.
@@ -130,7 +190,10 @@ def instance_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[En
     for entity in entities:
         entities_cpp.append(entity._cpp)
 
-    instances = _crt.instance_pass(camera._cpp, entities_cpp)
+    build_options_cpp = validate_build_options(build_options)
+
+    stats = _new_statistics(return_statistics)
+    instances = _crt.instance_pass(camera._cpp, entities_cpp, build_options_cpp, stats)
     
     if return_image:
         unique_ids = np.unique(instances)
@@ -139,6 +202,86 @@ def instance_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[En
         for idx, id in enumerate(unique_ids):
             mask = instances == id
             image[mask,:] = colors[:,idx]
-        return instances, image
+        return _with_statistics((instances, image), stats)
+
+    return _with_statistics(instances, stats)
+
+def traversal_cost_pass(camera: Camera, entities: Union[Entity, List[Entity], Tuple[Entity,...]],
+                        return_image: bool=False, build_options: BuildOptions=None,
+                        return_statistics: bool=False) -> Union[np.ndarray, Tuple[np.ndarray, np.ndarray]]:
+    """
+    Perform a traversal cost pass with dynamic entities, counting for the camera ray of every pixel the nodes
+    of the Bounding Volume Heirarchy it visits and the primitives it tests.  Inside a heightfield, the quadtree
+    nodes and cells visited count as nodes and the triangles tested as primitives.  Regions that are expensive
+    to trace, such as long thin triangles, overlapping entities or terrain seen at grazing angles, stand out in
+    the result, which helps to tune shape models and :class:`~.acceleration.BuildOptions`
+
+    :param camera: Camera model to be used for generating rays
+    :type camera: Camera
+    :param entities: Entity/Entities against which ray tracing is performed
+    :type entities: Union[Entity, List[Entity], Tuple[Entity,...]]
+    :param return_image: Flag to return a heatmap of the total cost, with the costliest pixel at 255 |default| :code:`False`
+    :type return_image: bool, optional
+    :param build_options: Options for building the Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
+    :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                              output (see :mod:`crt.statistics`) |default| :code:`False`
+    :type return_statistics: bool, optional
+    :return: An array of shape (rows, cols, 2) of the number of nodes visited and primitives tested by each pixel.
+             If :code:`return_image` is set to :code:`True`, then the heatmap is returned as a second output.
+    :rtype: Union[np.ndarray, Tuple(np.ndarray, np.ndarray)]
+    """
+    entities_cpp = validate_entities(entities)
+
+    build_options_cpp = validate_build_options(build_options)
+
+    stats = _new_statistics(return_statistics)
+    costs = _crt.traversal_cost_pass(camera._cpp, entities_cpp, build_options_cpp, stats)
+
+    if return_image:
+        image = costs.sum(axis=2).astype(np.float64)
+        image = 255*image/max(np.max(image), 1)
+        return _with_statistics((costs, image), stats)
+
+    return _with_statistics(costs, stats)
+
+def measurement_pass(camera: Camera, lights: Union[Light, List[Light], Tuple[Light,...]],
+                     entities: Union[Entity, List[Entity], Tuple[Entity,...]],
+                     build_options: BuildOptions=None, return_statistics: bool=False) -> Union[List[dict], Tuple[List[dict], dict]]:
+    """
+    Measure each entity seen by a camera, for optical navigation, without rendering an image.  Every entity
+    is described by a dictionary with the keys:
+
+    - :code:`id`: id of the entity, as reported by :func:`instance_pass`
+    - :code:`pixel_count`: number of pixels covered by the entity
+    - :code:`brightness`: sum of the pixel weights (here 1 per pixel)
+    - :code:`centroid`: weighted mean (column, row) of the entity's pixels
+    - :code:`bounding_box`: (min column, min row, max column, max row) of the entity's pixels
+    - :code:`limb`: (N,2) array of (column, row) pixels next to another entity or the background
+    - :code:`terminator`: (N,2) array of (column, row) lit pixels next to unlit pixels of the same entity
+
+    A pixel is lit when the center of any light is above the surface and unoccluded.
+
+    :param camera: Camera model to be used for generating rays
+    :type camera: Camera
+    :param lights: Light(s) deciding which pixels are lit
+    :type lights: Union[Light, List[Light], Tuple[Light,...]]
+    :param entities: Entity/Entities against which ray tracing is performed
+    :type entities: Union[Entity, List[Entity], Tuple[Entity,...]]
+    :param build_options: Options for building the Bounding Volume Heirarchy |default| :code:`BuildOptions()`
+    :type build_options: BuildOptions, optional
+    :param return_statistics: Flag to also return the statistics of the call as a dictionary, as the last
+                              output (see :mod:`crt.statistics`) |default| :code:`False`
+    :type return_statistics: bool, optional
+    :return: Measurements of each entity, in order of id
+    :rtype: Union[List[dict], Tuple(List[dict], dict)]
+    """
+    lights_cpp = validate_lights(lights)
+
+    entities_cpp = validate_entities(entities)
+
+    build_options_cpp = validate_build_options(build_options)
 
-    return instances
\ No newline at end of file
+    stats = _new_statistics(return_statistics)
+    measurements = _crt.measurement_pass(camera._cpp, lights_cpp, entities_cpp, build_options_cpp, stats)
+    return _with_statistics(measurements, stats)
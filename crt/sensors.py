@@ -0,0 +1,140 @@
+import _crt
+import numpy as np
+
+from numpy.typing import ArrayLike
+
+class SensorModel:
+    """
+    The :class:`SensorModel` class describes the detector that records a rendered image.  When given to
+    :func:`~.rendering.render` or :meth:`~.body_fixed.BodyFixedGroup.render`, the rendered radiance is blurred
+    by the point spread function, converted to photo-electrons with shot noise, dark signal and read noise,
+    saturated at the full well and digitized, all in C++ and in parallel.  The image is then returned in digital
+    numbers (DN), as an array of :code:`uint16` values.
+
+    Noise is drawn from a counter based generator, so that an image is reproducible for a given :code:`seed`
+    whatever the number of threads used.
+
+    :param psf: Point spread function, either a 2D kernel or, for a separable kernel, a tuple of the
+                horizontal and vertical 1D kernels.  Kernels are centered on their middle element and
+                should sum to 1.  Large 2D kernels are applied with an FFT |default| :code:`None`
+    :type psf: Union[ArrayLike, Tuple[ArrayLike, ArrayLike]], optional
+    :param electrons_per_unit: Mean photo-electrons collected per unit of rendered radiance |default| :code:`1000`
+    :type electrons_per_unit: float, optional
+    :param dark_electrons: Mean dark electrons per pixel |default| :code:`0`
+    :type dark_electrons: float, optional
+    :param shot_noise: Flag to apply Poisson noise to the collected electrons |default| :code:`True`
+    :type shot_noise: bool, optional
+    :param read_noise: Standard deviation of the read noise, in electrons |default| :code:`0`
+    :type read_noise: float, optional
+    :param full_well: Capacity of a pixel, in electrons |default| :code:`np.inf`
+    :type full_well: float, optional
+    :param gain: Conversion gain, in electrons per DN |default| :code:`1`
+    :type gain: float, optional
+    :param bias: Offset added by the analog to digital converter, in DN |default| :code:`0`
+    :type bias: float, optional
+    :param bits: Bit depth of the analog to digital converter, from 1 to 16 |default| :code:`12`
+    :type bits: int, optional
+    :param monochrome: Flag to record the mean of the red, green and blue radiance as a single channel, in
+                       which case images have the shape (rows, cols) rather than (rows, cols, 3) |default| :code:`False`
+    :type monochrome: bool, optional
+    :param seed: Seed of the noise.  If :code:`None`, a new seed is drawn for every image |default| :code:`None`
+    :type seed: int, optional
+    """
+    def __init__(self, psf=None, electrons_per_unit: float=1000., dark_electrons: float=0.,
+                 shot_noise: bool=True, read_noise: float=0., full_well: float=np.inf,
+                 gain: float=1., bias: float=0., bits: int=12, monochrome: bool=False, seed: int=None):
+
+        assert(1 <= bits <= 16), "bits must be between 1 and 16"
+        assert(gain > 0), "gain must be positive"
+
+        self._cpp = _crt.SensorModel()
+        """
+        Corresponding C++ SensorModel object
+        """
+
+        self.set_psf(psf)
+
+        self.electrons_per_unit = electrons_per_unit
+        """
+        Mean photo-electrons collected per unit of rendered radiance (:code:`float`)
+        """
+
+        self.dark_electrons = dark_electrons
+        """
+        Mean dark electrons per pixel (:code:`float`)
+        """
+
+        self.shot_noise = shot_noise
+        """
+        Flag to apply Poisson noise to the collected electrons (:code:`bool`)
+        """
+
+        self.read_noise = read_noise
+        """
+        Standard deviation of the read noise, in electrons (:code:`float`)
+        """
+
+        self.full_well = full_well
+        """
+        Capacity of a pixel, in electrons (:code:`float`)
+        """
+
+        self.gain = gain
+        """
+        Conversion gain, in electrons per DN (:code:`float`)
+        """
+
+        self.bias = bias
+        """
+        Offset added by the analog to digital converter, in DN (:code:`float`)
+        """
+
+        self.bits = bits
+        """
+        Bit depth of the analog to digital converter (:code:`int`)
+        """
+
+        self.monochrome = monochrome
+        """
+        Flag to record a single channel (:code:`bool`)
+        """
+
+        self.seed = seed
+        """
+        Seed of the noise, or :code:`None` for a new seed every image (:code:`int`)
+        """
+
+        self._cpp.electrons_per_unit = electrons_per_unit
+        self._cpp.dark_electrons = dark_electrons
+        self._cpp.shot_noise = shot_noise
+        self._cpp.read_noise = read_noise
+        self._cpp.full_well = full_well
+        self._cpp.gain = gain
+        self._cpp.bias = bias
+        self._cpp.bits = bits
+        self._cpp.monochrome = monochrome
+        self._cpp.seed = -1 if seed is None else seed
+
+    def set_psf(self, psf):
+        """
+        Set the point spread function of the sensor
+
+        :param psf: Either a 2D kernel, a tuple of the horizontal and vertical 1D kernels of a separable
+                    kernel, or :code:`None` for no blur
+        :type psf: Union[ArrayLike, Tuple[ArrayLike, ArrayLike]]
+        """
+        if psf is None:
+            self._cpp.set_psf(np.zeros((0, 0), dtype=np.float32))
+        elif type(psf) is tuple:
+            assert(len(psf) == 2), "A separable psf must be given as (psf_x, psf_y)"
+            self._cpp.set_separable_psf(np.asarray(psf[0], dtype=np.float32).ravel().tolist(),
+                                        np.asarray(psf[1], dtype=np.float32).ravel().tolist())
+        else:
+            psf = np.asarray(psf, dtype=np.float32)
+            assert(psf.ndim == 2), "psf must be a 2D array, or a tuple of two 1D arrays"
+            self._cpp.set_psf(psf)
+
+        self.psf = psf
+        """
+        Point spread function of the sensor
+        """
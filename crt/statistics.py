@@ -0,0 +1,62 @@
+"""
+Every render, pass and lidar simulation can report what it did when called with :code:`return_statistics=True`,
+in which case a dictionary is returned as an additional last output, with the keys:
+
+- :code:`build_time`: seconds spent building the Bounding Volume Heirarchy (zero when a cached one was used)
+- :code:`trace_time`: seconds spent tracing
+- :code:`total_time`: sum of the build and trace times
+- :code:`pixels`: number of pixels traced (zero for lidar simulations)
+- :code:`samples_per_pixel`: mean number of camera rays per pixel, after adaptive sampling
+- :code:`camera_rays`, :code:`secondary_rays`, :code:`shadow_rays` and :code:`lidar_rays`: number of rays of each
+  type traced
+- :code:`node_visits`: number of bounding boxes of the hierarchy tested, and of quadtree nodes and cells of
+  heightfields
+- :code:`primitive_tests`: number of triangles, ellipsoids and heightfields tested, and of triangles tested
+  inside heightfields
+- :code:`threads`: number of threads available
+- :code:`thread_utilization`: fraction of the trace time that the threads spent tracing
+
+Rays are only counted while statistics are requested, so calls without them run at full speed.
+"""
+import _crt
+
+def set_verbose(verbose: bool):
+    """
+    Print build summaries and timings of every render, pass and lidar simulation to standard output, along
+    with their statistics when they are requested.  Output is silent by default.
+
+    :param verbose: Flag to print progress and timings
+    :type verbose: bool
+    """
+    _crt.set_verbose(verbose)
+
+def _new_statistics(return_statistics: bool):
+    """
+    C++ RenderStatistics object to be filled in by a call, or :code:`None` if statistics are not requested
+    """
+    return _crt.RenderStatistics() if return_statistics else None
+
+def _statistics_to_dict(stats) -> dict:
+    return {"build_time": stats.build_time,
+            "trace_time": stats.trace_time,
+            "total_time": stats.total_time,
+            "pixels": stats.pixels,
+            "samples_per_pixel": stats.samples_per_pixel,
+            "camera_rays": stats.camera_rays,
+            "secondary_rays": stats.secondary_rays,
+            "shadow_rays": stats.shadow_rays,
+            "lidar_rays": stats.lidar_rays,
+            "node_visits": stats.node_visits,
+            "primitive_tests": stats.primitive_tests,
+            "threads": stats.threads,
+            "thread_utilization": stats.thread_utilization}
+
+def _with_statistics(outputs, stats):
+    """
+    Append the statistics of a call, as a dictionary, to its outputs if they were requested
+    """
+    if stats is None:
+        return outputs
+    if type(outputs) is tuple:
+        return outputs + (_statistics_to_dict(stats),)
+    return outputs, _statistics_to_dict(stats)
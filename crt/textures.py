@@ -0,0 +1,83 @@
+import _crt
+import numpy as np
+
+def bake_tiled_texture(png_path: str, output_path: str, tile_size: int=64):
+    """
+    Convert a PNG image into a tiled :code:`.crtt` texture.  Tiled textures are memory-mapped and only
+    the tiles that are actually sampled are decoded, so they can be used for images that are too large
+    to hold in memory.  Pass the resulting path as the :code:`texture_path` of an entity to use it.
+
+    Gray images (such as 16 bit elevation maps) keep a single channel and their bit depth, and every
+    other image is stored as 8 bit RGB.  The PNG has to be decoded as a whole, which takes 1 to 3 bytes
+    per texel of memory while converting.  Images too large for that can be converted from raw samples
+    with :func:`bake_raw_tiled_texture`
+
+    :param png_path: Path to the PNG image to convert
+    :type png_path: str
+    :param output_path: Path of the tiled texture to write, which should end in :code:`.crtt`
+    :type output_path: str
+    :param tile_size: Width and height of each tile, in texels |default| :code:`64`
+    :type tile_size: int, optional
+    """
+    _crt.bake_tiled_texture(png_path, output_path, tile_size)
+
+def bake_raw_tiled_texture(raw_path: str, output_path: str, width: int, height: int, channels: int=1,
+                           dtype=np.uint16, tile_size: int=64):
+    """
+    Convert a raw image into a tiled :code:`.crtt` texture.  The file holds rows of :code:`width*channels`
+    samples in native byte order, top row first, and nothing else, as written by :code:`numpy.ndarray.tofile`.
+    It is read a row at a time, and each level of the texture is written a row of tiles at a time, so
+    images of any size are converted in a small, fixed amount of memory.
+
+    Integer samples are scaled to [0,1] when the texture is sampled, and :code:`float32` samples (for
+    instance elevations) are used as they are.
+
+    :param raw_path: Path to the raw image to convert
+    :type raw_path: str
+    :param output_path: Path of the tiled texture to write, which should end in :code:`.crtt`
+    :type output_path: str
+    :param width: Width of the image, in texels
+    :type width: int
+    :param height: Height of the image, in texels
+    :type height: int
+    :param channels: Number of channels, 1 (gray) or 3 (RGB) |default| :code:`1`
+    :type channels: int, optional
+    :param dtype: Type of the samples, :code:`uint8`, :code:`uint16` or :code:`float32` |default| :code:`numpy.uint16`
+    :type dtype: numpy.dtype, optional
+    :param tile_size: Width and height of each tile, in texels |default| :code:`64`
+    :type tile_size: int, optional
+    """
+    formats = {np.dtype(np.uint8): 0, np.dtype(np.uint16): 1, np.dtype(np.float32): 2}
+    dtype = np.dtype(dtype)
+    if dtype not in formats:
+        raise ValueError("Raw textures must have uint8, uint16 or float32 samples")
+    _crt.bake_raw_tiled_texture(raw_path, output_path, width, height, channels, formats[dtype], tile_size)
+
+def set_tiled_texture_cache_budget(budget_bytes: int):
+    """
+    Set the amount of memory that each tiled texture opened after this call may use for decoded tiles.
+    Once the budget is reached the least recently used tiles are evicted |default| :code:`256 MiB`
+
+    :param budget_bytes: Memory budget per texture, in bytes
+    :type budget_bytes: int
+    """
+    _crt.set_tiled_texture_cache_budget(budget_bytes)
+
+def tiled_texture_statistics(path: str) -> dict:
+    """
+    Get the tile cache statistics of a tiled texture that is currently in use
+
+    :param path: Path the tiled texture was loaded from
+    :type path: str
+
+    :return: Dictionary with the number of cache :code:`hits`, :code:`misses` and :code:`evictions`, the
+        :code:`hit_rate`, and the number of :code:`resident_tiles` out of :code:`capacity_tiles`
+    :rtype: dict
+    """
+    stats = _crt.tiled_texture_statistics(path)
+    return {"hits": stats.hits,
+            "misses": stats.misses,
+            "evictions": stats.evictions,
+            "hit_rate": stats.hit_rate(),
+            "resident_tiles": stats.resident_tiles,
+            "capacity_tiles": stats.capacity_tiles}
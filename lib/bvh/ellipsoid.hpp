@@ -0,0 +1,138 @@
+#ifndef BVH_ELLIPSOID_HPP
+#define BVH_ELLIPSOID_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "bvh/vector.hpp"
+#include "bvh/bounding_box.hpp"
+#include "bvh/ray.hpp"
+
+template <typename Scalar>
+class Entity;
+
+namespace bvh {
+
+/// Triaxial ellipsoid primitive, defined by a center, three orthonormal axes and the radius
+/// along each of them.  A sphere is an ellipsoid with three equal radii.  Rays are intersected
+/// in the frame where the ellipsoid is the unit sphere, with the quadratic rearranged as in
+/// Haines et al. ("Precision Improvements for Ray/Sphere Intersection", Ray Tracing Gems, 2019),
+/// which stays accurate when the ellipsoid is small compared to its distance from the ray origin.
+template <typename Scalar>
+struct Ellipsoid {
+    struct Intersection {
+        Scalar t;
+
+        Scalar distance() const { return t; }
+    };
+
+    using ScalarType       = Scalar;
+    using IntersectionType = Intersection;
+
+    Vector3<Scalar> origin;
+    Vector3<Scalar> axes[3];
+    Vector3<Scalar> radii;
+    Entity<Scalar> *parent;
+
+    // Index of this ellipsoid's material, remapped into the scene-wide material table when a
+    // scene is flattened, as for triangles:
+    uint32_t material_id;
+
+    Ellipsoid() = default;
+    Ellipsoid(const Vector3<Scalar>& origin, const Vector3<Scalar>& radii)
+        : origin(origin), radii(radii), parent(nullptr), material_id(0)
+    {
+        axes[0] = Vector3<Scalar>(1, 0, 0);
+        axes[1] = Vector3<Scalar>(0, 1, 0);
+        axes[2] = Vector3<Scalar>(0, 0, 1);
+    }
+
+    void set_parent(Entity<Scalar> *parent) {
+        this->parent = parent;
+    }
+
+    Vector3<Scalar> center() const {
+        return origin;
+    }
+
+    BoundingBox<Scalar> bounding_box() const {
+        // Half extent of the rotated ellipsoid along each world axis:
+        Vector3<Scalar> extent;
+        for (int i = 0; i < 3; ++i) {
+            auto a = radii[0] * axes[0][i];
+            auto b = radii[1] * axes[1][i];
+            auto c = radii[2] * axes[2][i];
+            extent[i] = std::sqrt(a * a + b * b + c * c);
+        }
+        return BoundingBox<Scalar>(origin - extent, origin + extent);
+    }
+
+    /// Coordinates of a vector in the frame of the axes, divided by the radii, which maps the
+    /// ellipsoid onto the unit sphere.
+    Vector3<Scalar> to_unit_sphere(const Vector3<Scalar>& v) const {
+        return Vector3<Scalar>(dot(axes[0], v) / radii[0], dot(axes[1], v) / radii[1], dot(axes[2], v) / radii[2]);
+    }
+
+    /// Outward unit normal at a point on the surface.
+    Vector3<Scalar> normal(const Vector3<Scalar>& point) const {
+        auto q = to_unit_sphere(point - origin);
+        return normalize(
+            (q[0] / radii[0]) * axes[0] +
+            (q[1] / radii[1]) * axes[1] +
+            (q[2] / radii[2]) * axes[2]);
+    }
+
+    /// Longitude and latitude of a point on the surface, mapped to [0, 1] so that an
+    /// equirectangular texture covers the whole body, with the third axis pointing north (v = 1).
+    std::pair<Scalar, Scalar> texture_coordinates(const Vector3<Scalar>& point) const {
+        auto q = normalize(to_unit_sphere(point - origin));
+        auto u = Scalar(0.5) + std::atan2(q[1], q[0]) * Scalar(0.5 * M_1_PI);
+        auto v = Scalar(0.5) + std::asin(std::clamp(q[2], Scalar(-1), Scalar(1))) * Scalar(M_1_PI);
+        return std::make_pair(u, v);
+    }
+
+    /// Splits the bounding box, which is all the spatial split builder needs from a primitive
+    /// that is unlikely to straddle many split planes.
+    std::pair<BoundingBox<Scalar>, BoundingBox<Scalar>> split(size_t axis, Scalar position) const {
+        auto left  = bounding_box();
+        auto right = left;
+        left.max[axis]  = std::min(left.max[axis], position);
+        right.min[axis] = std::max(right.min[axis], position);
+        return std::make_pair(left, right);
+    }
+
+    std::optional<Intersection> intersect(const Ray<Scalar>& ray) const {
+        auto o = to_unit_sphere(ray.origin - origin);
+        auto d = to_unit_sphere(ray.direction);
+
+        // Solve a*t^2 - 2*b*t + c = 0.  The discriminant is computed from the distance between
+        // the center and the closest point of the line, rather than as b^2 - a*c, which loses
+        // all precision when the ray starts far away:
+        auto a = dot(d, d);
+        auto b = -dot(o, d);
+        auto c = dot(o, o) - Scalar(1);
+        auto f = o + (b / a) * d;
+        auto delta = a * (Scalar(1) - dot(f, f));
+        if (delta < 0)
+            return std::nullopt;
+
+        auto q = b + std::copysign(std::sqrt(delta), b);
+        auto t0 = c / q;
+        auto t1 = q / a;
+        if (t0 > t1)
+            std::swap(t0, t1);
+        if (t0 >= ray.tmin && t0 <= ray.tmax)
+            return std::make_optional(Intersection { t0 });
+        if (t1 >= ray.tmin && t1 <= ray.tmax)
+            return std::make_optional(Intersection { t1 });
+
+        return std::nullopt;
+    }
+};
+
+} // namespace bvh
+
+#endif
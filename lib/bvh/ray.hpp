@@ -13,12 +13,17 @@ struct Ray {
     Scalar tmin;
     Scalar tmax;
 
+    /// Time at which the ray is traced, from 0 at the start of a motion to 1 at its end.
+    /// Primitives that move are intersected where they are at that time.
+    Scalar time = Scalar(0);
+
     Ray() = default;
     Ray(const Vector3<Scalar>& origin,
         const Vector3<Scalar>& direction,
         Scalar tmin = Scalar(0),
-        Scalar tmax = std::numeric_limits<Scalar>::max())
-        : origin(origin), direction(direction), tmin(tmin), tmax(tmax)
+        Scalar tmax = std::numeric_limits<Scalar>::max(),
+        Scalar time = Scalar(0))
+        : origin(origin), direction(direction), tmin(tmin), tmax(tmax), time(time)
     {}
 };
 
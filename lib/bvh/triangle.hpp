@@ -3,6 +3,8 @@
 
 #include <optional>
 #include <cassert>
+#include <cmath>
+#include <utility>
 
 #include "bvh/utilities.hpp"
 #include "bvh/vector.hpp"
@@ -14,9 +16,35 @@ class Entity;
 
 namespace bvh {
 
-/// Triangle primitive, defined by three points, and using the Moeller-Trumbore test.
-/// By default, the normal is left-handed, which minimizes the number of operations in
-/// the intersection routine.
+/// Per-ray setup of the watertight ray-triangle test (Woop, Benthin and Wald, 2013).
+/// The axes are permuted so that the largest direction component is z, and the shear
+/// maps the ray direction onto the z axis, after which triangles are tested in 2D.
+template <typename Scalar>
+struct WatertightRay {
+    int kx, ky, kz;
+    Scalar sx, sy, sz;
+
+    WatertightRay() = default;
+    explicit WatertightRay(const Ray<Scalar>& ray) {
+        auto& d = ray.direction;
+        kz = std::fabs(d[0]) > std::fabs(d[1])
+            ? (std::fabs(d[0]) > std::fabs(d[2]) ? 0 : 2)
+            : (std::fabs(d[1]) > std::fabs(d[2]) ? 1 : 2);
+        kx = kz == 2 ? 0 : kz + 1;
+        ky = kx == 2 ? 0 : kx + 1;
+        // Preserve the winding of the triangles
+        if (d[kz] < 0)
+            std::swap(kx, ky);
+        sx = d[kx] / d[kz];
+        sy = d[ky] / d[kz];
+        sz = Scalar(1.0) / d[kz];
+    }
+};
+
+/// Triangle primitive, defined by three points, and using the watertight test, so that
+/// rays hitting a shared edge or vertex always hit one of the triangles sharing it.
+/// By default, the normal is left-handed, which matches the winding expected by the
+/// rest of the library.
 template <typename Scalar, bool LeftHandedNormal = true>
 struct Triangle {
     struct Intersection {
@@ -28,13 +56,21 @@ struct Triangle {
     using IntersectionType = Intersection;
 
     Vector3<Scalar> p0, e1, e2, n, vn0, vn1, vn2;
+
+    // Exact positions of the other two vertices (p0 - e1 and p0 + e2 are rounded), so that
+    // all triangles sharing a vertex test the same coordinates:
+    Vector3<Scalar> v1, v2;
     std::array<float, 3> vc[3];
     bvh::Vector<float, 2> uv[3];
     Entity<Scalar> *parent;
 
+    // Index of this triangle's material.  Local to the parent entity on load, and remapped into
+    // the scene-wide material table when a scene is flattened:
+    uint32_t material_id;
+
     Triangle() = default;
     Triangle(const Vector3<Scalar>& p0, const Vector3<Scalar>& p1, const Vector3<Scalar>& p2)
-        : p0(p0), e1(p0 - p1), e2(p2 - p0), parent(nullptr)
+        : p0(p0), e1(p0 - p1), e2(p2 - p0), v1(p1), v2(p2), parent(nullptr), material_id(0)
     {
         n = LeftHandedNormal ? cross(e1, e2) : cross(e2, e1);
         // All white vertices
@@ -52,6 +88,8 @@ struct Triangle {
         this -> p0 = p0;
         this -> e1 = (p0 - p1);
         this -> e2 = (p2 - p0);
+        this -> v1 = p1;
+        this -> v2 = p2;
         this -> n = LeftHandedNormal ? cross(e1, e2) : cross(e2, e1);
     }
 
@@ -78,8 +116,8 @@ struct Triangle {
         this->parent = parent;
     }
 
-    Vector3<Scalar> p1() const { return p0 - e1; }
-    Vector3<Scalar> p2() const { return p0 + e2; }
+    Vector3<Scalar> p1() const { return v1; }
+    Vector3<Scalar> p2() const { return v2; }
 
     BoundingBox<Scalar> bounding_box() const {
         BoundingBox<Scalar> bbox(p0);
@@ -138,23 +176,49 @@ struct Triangle {
     }
 
     std::optional<Intersection> intersect(const Ray<Scalar>& ray) const {
-        auto negate_when_right_handed = [] (Scalar x) { return LeftHandedNormal ? x : -x; };
-
-        auto c = p0 - ray.origin;
-        auto r = cross(ray.direction, c);
-        auto inv_det = negate_when_right_handed(1.0) / dot(n, ray.direction);
-
-        auto u = dot(r, e2) * inv_det;
-        auto v = dot(r, e1) * inv_det;
-        auto w = Scalar(1.0) - u - v;
-
-        // These comparisons are designed to return false
-        // when one of t, u, or v is a NaN
-        if (u >= 0 && v >= 0 && w >= 0) {
-            auto t = negate_when_right_handed(dot(n, c)) * inv_det;
-            if (t >= ray.tmin && t <= ray.tmax)
-                return std::make_optional(Intersection{ t, u, v });
-        }
+        return intersect(ray, WatertightRay<Scalar>(ray));
+    }
+
+    /// Watertight test with the per-ray setup already done. As with the Moeller-Trumbore
+    /// test this replaces, u and v are the barycentric weights of p1() and p2().
+    std::optional<Intersection> intersect(const Ray<Scalar>& ray, const WatertightRay<Scalar>& w_ray) const {
+        auto a = p0 - ray.origin;
+        auto b = p1() - ray.origin;
+        auto c = p2() - ray.origin;
+
+        // Shear and scale the vertices into the space of the ray.  Both this and the edge functions
+        // are written so that every triangle sharing a vertex or an edge computes it identically, and
+        // with opposite signs for an edge, whether or not the compiler fuses multiply-adds
+        auto ax = fast_multiply_add(-w_ray.sx, a[w_ray.kz], a[w_ray.kx]);
+        auto ay = fast_multiply_add(-w_ray.sy, a[w_ray.kz], a[w_ray.ky]);
+        auto bx = fast_multiply_add(-w_ray.sx, b[w_ray.kz], b[w_ray.kx]);
+        auto by = fast_multiply_add(-w_ray.sy, b[w_ray.kz], b[w_ray.ky]);
+        auto cx = fast_multiply_add(-w_ray.sx, c[w_ray.kz], c[w_ray.kx]);
+        auto cy = fast_multiply_add(-w_ray.sy, c[w_ray.kz], c[w_ray.ky]);
+
+        // Scaled barycentric coordinates (edge functions), of p0, p1 and p2 respectively
+        auto w0 = difference_of_products(cx, by, cy, bx);
+        auto w1 = difference_of_products(ax, cy, ay, cx);
+        auto w2 = difference_of_products(bx, ay, by, ax);
+
+        // Edges are hit from either side, and a zero edge function counts as inside
+        if ((w0 < 0 || w1 < 0 || w2 < 0) && (w0 > 0 || w1 > 0 || w2 > 0))
+            return std::nullopt;
+
+        auto det = w0 + w1 + w2;
+        if (det == Scalar(0))
+            return std::nullopt;
+
+        auto t_scaled =
+            w0 * w_ray.sz * a[w_ray.kz] +
+            w1 * w_ray.sz * b[w_ray.kz] +
+            w2 * w_ray.sz * c[w_ray.kz];
+        auto inv_det = Scalar(1.0) / det;
+        auto t = t_scaled * inv_det;
+
+        // Written so that a NaN t is rejected
+        if (t >= ray.tmin && t <= ray.tmax)
+            return std::make_optional(Intersection{ t, w1 * inv_det, w2 * inv_det, w0 * inv_det });
 
         return std::nullopt;
     }
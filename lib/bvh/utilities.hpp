@@ -54,6 +54,26 @@ inline double fast_multiply_add(double x, double y, double z) {
 #endif
 }
 
+/// Computes x * y - z * w, such that exchanging the two products negates the result exactly.
+/// A compiler contracting the expression into a single fused multiply-add would round only one
+/// of the products, breaking that symmetry, so when fused multiply-adds are available both
+/// orders are evaluated and averaged.
+inline float difference_of_products(float x, float y, float z, float w) {
+#ifdef FP_FAST_FMAF
+    return (std::fmaf(x, y, -z * w) - std::fmaf(z, w, -x * y)) * 0.5f;
+#else
+    return x * y - z * w;
+#endif
+}
+
+inline double difference_of_products(double x, double y, double z, double w) {
+#ifdef FP_FAST_FMA
+    return (std::fma(x, y, -z * w) - std::fma(z, w, -x * y)) * 0.5;
+#else
+    return x * y - z * w;
+#endif
+}
+
 /// Returns the mininum of two values.
 /// Guaranteed to return a non-NaN value if the right hand side is not a NaN.
 template <typename T>
@@ -24,7 +24,9 @@ inline char* strip_spaces(char* ptr) {
     return ptr;
 }
 
-inline std::optional<int> read_index(char** ptr) {
+// Read a single face vertex ("v", "v/vt", "v//vn" or "v/vt/vn").  The texture coordinate index, if
+// present, is written to tex_index:
+inline std::optional<int> read_index(char** ptr, std::optional<int>* tex_index = nullptr) {
     char* base = *ptr;
 
     // Detect end of line (negative indices are supported) 
@@ -39,8 +41,11 @@ inline std::optional<int> read_index(char** ptr) {
         base++;
 
         // Handle the case when there is no texture coordinate
-        if (*base != '/')
-            std::strtol(base, &base, 10);
+        if (*base != '/') {
+            int tex = std::strtol(base, &base, 10);
+            if (tex_index)
+                *tex_index = tex;
+        }
 
         base = strip_spaces(base);
 
@@ -64,6 +69,7 @@ load_from_stream(std::istream& is) {
     std::vector<bvh::Vector3<Scalar> > vertices;
     std::vector<bvh::Triangle<Scalar> > triangles;
     std::vector<bvh::Vector3<Scalar> > normals;
+    std::vector<bvh::Vector<float, 2> > uvs;
     std::vector<std::tuple<size_t, size_t, size_t> > tri_idx;
 
     while (is.getline(line, max_line)) {
@@ -77,24 +83,37 @@ load_from_stream(std::istream& is) {
             auto z = std::strtof(ptr, &ptr);
             vertices.emplace_back(x, y, z);
             normals.emplace_back(0, 0, 0);
+        } else if (ptr[0] == 'v' && ptr[1] == 't' && std::isspace(ptr[2])) {
+            auto u = std::strtof(ptr + 2, &ptr);
+            auto v = std::strtof(ptr, &ptr);
+            uvs.emplace_back(bvh::Vector<float, 2>(u, v));
         } else if (*ptr == 'f' && std::isspace(ptr[1])) {
             bvh::Vector3<Scalar> points[2];
+            bvh::Vector<float, 2> tex[2];
             size_t idx[2];
             ptr += 2;
             for (size_t i = 0; ; ++i) {
-                if (auto index = read_index(&ptr)) {
+                std::optional<int> tex_index;
+                if (auto index = read_index(&ptr, &tex_index)) {
                     size_t j = *index < 0 ? vertices.size() + *index : *index - 1;
                     assert(j < vertices.size());
                     auto v = vertices[j];
+                    auto t = bvh::Vector<float, 2>(0);
+                    if (tex_index) {
+                        size_t k = *tex_index < 0 ? uvs.size() + *tex_index : *tex_index - 1;
+                        if (k < uvs.size())
+                            t = uvs[k];
+                    }
                     if (i >= 2) {
                         triangles.emplace_back(points[0], points[1], v);
+                        triangles.rbegin()->add_vertex_uv(tex[0], tex[1], t);
                         normals[idx[0]] += triangles.rbegin()->n;
                         normals[idx[1]] += triangles.rbegin()->n;
                         normals[j] += triangles.rbegin()->n;
                         tri_idx.emplace_back(idx[0], idx[1], j);
-                        points[1] = v; idx[1] = j;
+                        points[1] = v; idx[1] = j; tex[1] = t;
                     } else {
-                        points[i] = v; idx[i] = j;
+                        points[i] = v; idx[i] = j; tex[i] = t;
                     }
                 } else {
                     break;
@@ -0,0 +1,165 @@
+#ifndef __ACCELERATION_STRUCTURE_H
+#define __ACCELERATION_STRUCTURE_H
+
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/ellipsoid.hpp>
+
+#include "transform.hpp"
+#include "materials/material.hpp"
+#include "acceleration/heightfield.hpp"
+#include "acceleration/moving_primitives.hpp"
+#include "acceleration/build_bvh.hpp"
+#include "acceleration/refit.hpp"
+#include "acceleration/scene_primitives.hpp"
+
+// The flattened, world frame triangles, ellipsoids and heightfields of a set of entities together
+// with the BVH built over them (primitive indices past the triangles refer to the ellipsoids, and
+// past those to the heightfields).
+// Every rendering entry point (render, simulate_lidar, the passes and BodyFixedGroup) goes through
+// this class, so there is a single place where scenes are assembled and their BVHs are built.  The
+// ScenePrimitives that the traversers test leaves with belong to the BVH, and are built with it, so
+// that calls tracing a cached scene do not repack its triangles:
+template <typename Scalar>
+class AccelerationStructure {
+    public:
+        bvh::Bvh<Scalar> bvh;
+        std::vector<bvh::Triangle<Scalar>> triangles;
+        std::vector<bvh::Ellipsoid<Scalar>> ellipsoids;
+        std::vector<Heightfield<Scalar>> heightfields;
+
+        // Entities making up the scene, and the first of the triangles each one occupies:
+        std::vector<Entity<Scalar>*> entities;
+        std::vector<size_t> entity_offsets;
+
+        // Primitives of the entities that move while an image is exposed:
+        std::vector<MovingPrimitives<Scalar>> moving;
+
+        // Materials of every entity, indexed by Triangle::material_id:
+        std::vector<MaterialVariant<Scalar>> materials;
+
+        BuildOptions build_options;
+        BuildStatistics statistics;
+
+        // Leaf intersector for the current BVH, which points into the arrays above:
+        ScenePrimitives<Scalar> primitives;
+
+        AccelerationStructure() = default;
+
+        // Moving the arrays keeps their storage, and so the pointers of primitives, but copying them
+        // would not:
+        AccelerationStructure(const AccelerationStructure&) = delete;
+        AccelerationStructure& operator=(const AccelerationStructure&) = delete;
+        AccelerationStructure(AccelerationStructure&&) = default;
+        AccelerationStructure& operator=(AccelerationStructure&&) = default;
+
+        AccelerationStructure(std::vector<Entity<Scalar>*> entities, const BuildOptions &build_options){
+            this->entities = entities;
+            this->build_options = build_options;
+            flatten();
+            build();
+        }
+
+        // Copy the triangles of every entity, at its active level of detail, into a single array,
+        // applying each entity's scale, rotation and position.  The offsets are known up front, so
+        // every triangle is written directly into its final slot by the fused transform_triangles()
+        // kernel.  The entity materials are gathered into one table at the same time, and the
+        // ellipsoids and heightfields are placed the same way.  Entities that move are placed in
+        // their start pose, with their triangles after all the others (ScenePrimitives tests them
+        // one at a time), and their primitives are listed in moving.  The primitives are cleared until
+        // the next build():
+        void flatten(){
+            auto start = std::chrono::high_resolution_clock::now();
+            primitives = ScenePrimitives<Scalar>();
+
+            entity_offsets.assign(entities.size(), 0);
+            materials.clear();
+            moving.clear();
+            size_t triangle_count = 0;
+            for (bool moving_pass : {false, true}) {
+                for (size_t e = 0; e < entities.size(); ++e) {
+                    if (entities[e]->moving == moving_pass) {
+                        entity_offsets[e] = triangle_count;
+                        triangle_count += entities[e]->active_triangles().size();
+                    }
+                }
+            }
+
+            triangles.resize(triangle_count);
+            ellipsoids.clear();
+            heightfields.clear();
+            std::vector<size_t> ellipsoid_offsets, heightfield_offsets;
+            for (size_t e = 0; e < entities.size(); ++e) {
+                auto entity = entities[e];
+                uint32_t material_offset = (uint32_t) materials.size();
+                materials.insert(materials.end(), entity->materials.begin(), entity->materials.end());
+                auto &entity_triangles = entity->active_triangles();
+                transform_triangles(entity_triangles.data(), triangles.data() + entity_offsets[e], entity_triangles.size(),
+                                    entity->rotation, entity->position, entity->scale, material_offset);
+
+                size_t ellipsoid_offset = ellipsoids.size();
+                ellipsoid_offsets.push_back(ellipsoid_offset);
+                ellipsoids.resize(ellipsoid_offset + entity->ellipsoids.size());
+                transform_ellipsoids(entity->ellipsoids.data(), ellipsoids.data() + ellipsoid_offset, entity->ellipsoids.size(),
+                                     entity->rotation, entity->position, entity->scale, material_offset);
+
+                size_t heightfield_offset = heightfields.size();
+                heightfield_offsets.push_back(heightfield_offset);
+                heightfields.resize(heightfield_offset + entity->heightfields.size());
+                transform_heightfields(entity->heightfields.data(), heightfields.data() + heightfield_offset, entity->heightfields.size(),
+                                       entity->rotation, entity->position, entity->scale, material_offset);
+            }
+
+            // Primitive index ranges of the moving entities, as in build_bvh():
+            size_t ellipsoid_end = triangle_count + ellipsoids.size();
+            for (size_t e = 0; e < entities.size(); ++e) {
+                auto entity = entities[e];
+                if (!entity->moving) {
+                    continue;
+                }
+                entity->prepare_motion();
+                std::pair<size_t, size_t> ranges[3] = {
+                    {entity_offsets[e], entity_offsets[e] + entity->active_triangles().size()},
+                    {triangle_count + ellipsoid_offsets[e], triangle_count + ellipsoid_offsets[e] + entity->ellipsoids.size()},
+                    {ellipsoid_end + heightfield_offsets[e], ellipsoid_end + heightfield_offsets[e] + entity->heightfields.size()}
+                };
+                for (auto [begin, end] : ranges) {
+                    if (begin < end) {
+                        moving.push_back(MovingPrimitives<Scalar>{begin, end, entity->motion});
+                    }
+                }
+            }
+
+            auto stop = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+            statistics.flatten_time = duration.count()/1000000.0;
+        }
+
+        // Build a new BVH over the current triangles, ellipsoids and heightfields, and the primitives
+        // for it.  Packing the triangles is part of the build time:
+        const BuildStatistics& build(){
+            auto flatten_time = statistics.flatten_time;
+            statistics = build_bvh(bvh, triangles, ellipsoids, heightfields, build_options, moving);
+            statistics.flatten_time = flatten_time;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            primitives = ScenePrimitives<Scalar>(bvh, triangles, ellipsoids, heightfields, moving);
+            auto stop = std::chrono::high_resolution_clock::now();
+            statistics.build_time += std::chrono::duration_cast<std::chrono::microseconds>(stop - start).count()/1000000.0;
+            return statistics;
+        }
+
+        // Refit the existing BVH to triangles that have been moved in place, copy them into the packed
+        // blocks, and return the new SAH cost:
+        Scalar refit(){
+            refit_bvh(bvh, triangles.data(), triangles.size(), ellipsoids.data(), ellipsoids.size(), heightfields.data(), moving);
+            primitives.update_vertices();
+            return compute_sah_cost(bvh, Scalar(build_options.traversal_cost));
+        }
+};
+
+#endif
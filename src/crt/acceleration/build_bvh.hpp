@@ -0,0 +1,270 @@
+#ifndef __BUILD_BVH_H
+#define __BUILD_BVH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/ellipsoid.hpp>
+#include <bvh/sweep_sah_builder.hpp>
+#include <bvh/binned_sah_builder.hpp>
+#include <bvh/locally_ordered_clustering_builder.hpp>
+#include <bvh/linear_bvh_builder.hpp>
+#include <bvh/spatial_split_bvh_builder.hpp>
+#include <bvh/leaf_collapser.hpp>
+#include <bvh/parallel_reinsertion_optimizer.hpp>
+#include <bvh/node_layout_optimizer.hpp>
+
+#include "acceleration/heightfield.hpp"
+#include "acceleration/moving_primitives.hpp"
+#include "acceleration/refit.hpp"
+
+// Available BVH construction algorithms (see lib/bvh for details on each):
+enum class BuilderType {
+    SweepSah,
+    BinnedSah,
+    LocallyOrderedClustering,
+    LinearBvh,
+    SpatialSplit
+};
+
+inline std::string builder_name(BuilderType builder) {
+    switch (builder) {
+        case BuilderType::SweepSah:                 return "SweepSahBuilder";
+        case BuilderType::BinnedSah:                return "BinnedSahBuilder";
+        case BuilderType::LocallyOrderedClustering: return "LocallyOrderedClusteringBuilder";
+        case BuilderType::LinearBvh:                return "LinearBvhBuilder";
+        case BuilderType::SpatialSplit:             return "SpatialSplitBvhBuilder";
+    }
+    return "UnknownBuilder";
+}
+
+// Options controlling how every BVH in crt is built.  The defaults reproduce the original
+// high quality pipeline (full sweep SAH followed by both optimizers).  Bottom-up builders
+// (LinearBvh and LocallyOrderedClustering) are much faster to build, which makes them a good
+// fit for dynamic scenes that are rebuilt every frame:
+struct BuildOptions {
+    BuilderType builder = BuilderType::SweepSah;
+
+    // Run the parallel reinsertion optimizer after the build:
+    bool optimize = true;
+
+    // Reorder the nodes in memory for better cache behavior during traversal:
+    bool optimize_layout = true;
+
+    // Largest leaf the top-down builders are allowed to create.  Bottom-up builders always
+    // produce single primitive leaves, which are collapsed according to the SAH instead:
+    size_t max_leaf_size = 16;
+
+    // Cost of visiting a node, relative to testing one triangle, in the SAH used by the builders
+    // and optimizers.  The default is that of lib/bvh.  Leaves are tested a block of
+    // PackedTriangles at a time, so a few triangles per leaf cost little more than one, and
+    // larger values (fewer, larger leaves) can trace faster on scenes that are mostly triangles:
+    double traversal_cost = 1;
+
+    // Budget of additional references the spatial split builder may create, as a fraction
+    // of the number of primitives:
+    double split_factor = 0.3;
+};
+
+// Summary of a single BVH build.  Times are in seconds:
+struct BuildStatistics {
+    std::string builder;
+    size_t triangle_count = 0;
+    size_t ellipsoid_count = 0;
+    size_t heightfield_count = 0;
+    size_t node_count = 0;
+    size_t reference_count = 0;
+    double sah_cost = 0;
+    double flatten_time = 0;
+    double build_time = 0;
+};
+
+inline std::ostream& operator<<(std::ostream &os, const BuildStatistics &statistics) {
+    os << "    BVH ( using " << statistics.builder << " ) of "
+       << statistics.node_count << " node(s) and "
+       << statistics.reference_count << " reference(s) for "
+       << statistics.triangle_count << " triangles";
+    if (statistics.ellipsoid_count > 0) {
+        os << " and " << statistics.ellipsoid_count << " ellipsoid(s)";
+    }
+    if (statistics.heightfield_count > 0) {
+        os << " and " << statistics.heightfield_count << " heightfield(s)";
+    }
+    os << "\n";
+    os << "    BVH built in " << statistics.build_time << " seconds\n";
+    return os;
+}
+
+// Any kind of scene primitive.  The spatial split builder splits primitives through a single
+// array, so a scene with ellipsoids or heightfields hands it one of these per primitive.  Split
+// primitives are referenced from several leaves, so the leaves index an array of reference_count
+// primitive indices, and per-leaf tables must be sized by PackedTriangles::primitive_count().
+// A moving primitive is only known to lie within its swept bounds, which are clipped instead:
+template <typename Scalar>
+struct PrimitiveReference {
+    const bvh::Triangle<Scalar> *triangle;
+    const bvh::Ellipsoid<Scalar> *ellipsoid;
+    const Heightfield<Scalar> *heightfield;
+    const bvh::BoundingBox<Scalar> *swept = nullptr;
+
+    std::pair<bvh::BoundingBox<Scalar>, bvh::BoundingBox<Scalar>> split(size_t axis, Scalar position) const {
+        if (swept) {
+            auto left = *swept, right = *swept;
+            left.max[axis]  = std::min(left.max[axis], position);
+            right.min[axis] = std::max(right.min[axis], position);
+            return std::make_pair(left, right);
+        }
+        if (triangle) {
+            return triangle->split(axis, position);
+        }
+        return ellipsoid ? ellipsoid->split(axis, position) : heightfield->split(axis, position);
+    }
+};
+
+// Build a BVH over the given triangles, ellipsoids and heightfields, according to the provided options.
+// Primitive indices below triangles.size() refer to triangles, the following ones to ellipsoids, and
+// the last ones to heightfields.  The primitives of moving ranges are bounded over their motion:
+template <typename Scalar>
+BuildStatistics build_bvh(bvh::Bvh<Scalar> &bvh, const std::vector<bvh::Triangle<Scalar>> &triangles,
+                          const std::vector<bvh::Ellipsoid<Scalar>> &ellipsoids,
+                          const std::vector<Heightfield<Scalar>> &heightfields, const BuildOptions &options,
+                          const std::vector<MovingPrimitives<Scalar>> &moving = {}) {
+    using Bvh = bvh::Bvh<Scalar>;
+
+    size_t triangle_count = triangles.size();
+    size_t ellipsoid_end = triangle_count + ellipsoids.size();
+    size_t primitive_count = ellipsoid_end + heightfields.size();
+    size_t reference_count = primitive_count;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto tri_data = triangles.data();
+    auto bboxes_ptr  = std::make_unique<bvh::BoundingBox<Scalar>[]>(primitive_count);
+    auto centers_ptr = std::make_unique<bvh::Vector3<Scalar>[]>(primitive_count);
+    auto bboxes  = bboxes_ptr.get();
+    auto centers = centers_ptr.get();
+    #pragma omp parallel for
+    for (size_t i = 0; i < primitive_count; ++i) {
+        if (i < triangle_count) {
+            bboxes[i]  = tri_data[i].bounding_box();
+            centers[i] = tri_data[i].center();
+        }
+        else if (i < ellipsoid_end) {
+            bboxes[i]  = ellipsoids[i - triangle_count].bounding_box();
+            centers[i] = ellipsoids[i - triangle_count].center();
+        }
+        else {
+            bboxes[i]  = heightfields[i - ellipsoid_end].bounding_box();
+            centers[i] = heightfields[i - ellipsoid_end].center();
+        }
+    }
+    for (auto &range : moving) {
+        #pragma omp parallel for
+        for (size_t i = range.begin; i < range.end; ++i) {
+            bboxes[i]  = range.motion.sweep(bboxes[i]);
+            centers[i] = bboxes[i].center();
+        }
+    }
+
+    auto global_bbox = bvh::compute_bounding_boxes_union(bboxes, primitive_count);
+
+    switch (options.builder) {
+        case BuilderType::SweepSah: {
+            bvh::SweepSahBuilder<Bvh> builder(bvh);
+            builder.max_leaf_size = options.max_leaf_size;
+            builder.traversal_cost = Scalar(options.traversal_cost);
+            builder.build(global_bbox, bboxes, centers, reference_count);
+            break;
+        }
+        case BuilderType::BinnedSah: {
+            bvh::BinnedSahBuilder<Bvh, 16> builder(bvh);
+            builder.max_leaf_size = options.max_leaf_size;
+            builder.traversal_cost = Scalar(options.traversal_cost);
+            builder.build(global_bbox, bboxes, centers, reference_count);
+            break;
+        }
+        case BuilderType::LocallyOrderedClustering: {
+            bvh::LocallyOrderedClusteringBuilder<Bvh, uint32_t> builder(bvh);
+            builder.build(global_bbox, bboxes, centers, reference_count);
+            bvh::LeafCollapser<Bvh> collapser(bvh);
+            collapser.traversal_cost = Scalar(options.traversal_cost);
+            collapser.collapse();
+            break;
+        }
+        case BuilderType::LinearBvh: {
+            bvh::LinearBvhBuilder<Bvh, uint32_t> builder(bvh);
+            builder.build(global_bbox, bboxes, centers, reference_count);
+            bvh::LeafCollapser<Bvh> collapser(bvh);
+            collapser.traversal_cost = Scalar(options.traversal_cost);
+            collapser.collapse();
+            break;
+        }
+        case BuilderType::SpatialSplit: {
+            if (primitive_count == triangle_count && moving.empty()) {
+                bvh::SpatialSplitBvhBuilder<Bvh, bvh::Triangle<Scalar>, 64> builder(bvh);
+                builder.max_leaf_size = options.max_leaf_size;
+                builder.traversal_cost = Scalar(options.traversal_cost);
+                reference_count = builder.build(global_bbox, tri_data, bboxes, centers, primitive_count,
+                                                Scalar(1e-5), Scalar(options.split_factor));
+            }
+            else {
+                std::vector<PrimitiveReference<Scalar>> primitives(primitive_count);
+                for (size_t i = 0; i < primitive_count; ++i) {
+                    primitives[i].triangle    = i < triangle_count ? &tri_data[i] : nullptr;
+                    primitives[i].ellipsoid   = i >= triangle_count && i < ellipsoid_end ? &ellipsoids[i - triangle_count] : nullptr;
+                    primitives[i].heightfield = i >= ellipsoid_end ? &heightfields[i - ellipsoid_end] : nullptr;
+                }
+                for (auto &range : moving) {
+                    for (size_t i = range.begin; i < range.end; ++i) {
+                        primitives[i].swept = &bboxes[i];
+                    }
+                }
+                bvh::SpatialSplitBvhBuilder<Bvh, PrimitiveReference<Scalar>, 64> builder(bvh);
+                builder.max_leaf_size = options.max_leaf_size;
+                builder.traversal_cost = Scalar(options.traversal_cost);
+                reference_count = builder.build(global_bbox, primitives.data(), bboxes, centers, primitive_count,
+                                                Scalar(1e-5), Scalar(options.split_factor));
+            }
+            break;
+        }
+    }
+
+    if (options.optimize) {
+        bvh::ParallelReinsertionOptimizer<Bvh> pro_opt(bvh);
+        pro_opt.traversal_cost = Scalar(options.traversal_cost);
+        pro_opt.optimize();
+    }
+
+    if (options.optimize_layout) {
+        bvh::NodeLayoutOptimizer<Bvh> nlo_opt(bvh);
+        nlo_opt.optimize();
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+
+    BuildStatistics statistics;
+    statistics.builder = builder_name(options.builder);
+    statistics.triangle_count = triangle_count;
+    statistics.ellipsoid_count = ellipsoids.size();
+    statistics.heightfield_count = heightfields.size();
+    statistics.node_count = bvh.node_count;
+    statistics.reference_count = reference_count;
+    statistics.sah_cost = compute_sah_cost(bvh, Scalar(options.traversal_cost));
+    statistics.build_time = duration.count()/1000000.0;
+    return statistics;
+};
+
+template <typename Scalar>
+BuildStatistics build_bvh(bvh::Bvh<Scalar> &bvh, const std::vector<bvh::Triangle<Scalar>> &triangles, const BuildOptions &options) {
+    return build_bvh(bvh, triangles, std::vector<bvh::Ellipsoid<Scalar>>(), std::vector<Heightfield<Scalar>>(), options);
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef __CLOSEST_HIT_TRAVERSER_H
+#define __CLOSEST_HIT_TRAVERSER_H
+
+#include <cassert>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include <bvh/bvh.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/node_intersectors.hpp>
+#include <bvh/triangle.hpp>
+
+#include "acceleration/scene_primitives.hpp"
+#include "statistics.hpp"
+
+// Closest hit queries for the renderer.  The traversal is the same as SingleRayTraverser with a
+// ClosestPrimitiveIntersector (children are visited nearest first, and leaves are intersected as
+// soon as they are reached), but leaves are tested by ScenePrimitives (triangles a block of
+// PackedTriangles at a time), and the per-ray setup of the watertight test is done once per ray
+// rather than once per triangle.  Nodes are tested with RobustNodeIntersector: the fast test
+// replaces zero direction components by a tiny slope, and so misses boxes that a ray running
+// exactly along one of their faces (for instance through an axis-aligned edge of a mesh) touches.
+//
+// Hits are reported as ClosestPrimitiveIntersector::Result, with the index of the primitive in the
+// BVH (see ScenePrimitives for how to interpret it).
+template <typename Scalar, size_t StackSize = 64>
+class ClosestHitTraverser {
+    public:
+        using Hit = typename ScenePrimitives<Scalar>::Hit;
+
+        ClosestHitTraverser(const bvh::Bvh<Scalar> &bvh, const ScenePrimitives<Scalar> &primitives)
+            : bvh(bvh), primitives(primitives) { }
+
+        std::optional<Hit> traverse(bvh::Ray<Scalar> ray) const {
+            TraversalCount count(false);
+            return traverse(ray, count);
+        }
+
+        // Closest hit of ray, adding the nodes and primitives tested to count (the counterpart of
+        // SingleRayTraverser::Statistics, except that both children of a traversal step are counted):
+        std::optional<Hit> traverse(bvh::Ray<Scalar> ray, TraversalCount &count) const {
+            std::optional<Hit> best_hit;
+            bvh::WatertightRay<Scalar> w_ray(ray);
+
+            auto &root = bvh.nodes[0];
+            if (root.is_leaf()) {
+                count.primitive_tests += root.primitive_count;
+                primitives.intersect_leaf(root, ray, w_ray, best_hit, &count);
+                return best_hit;
+            }
+
+            bvh::RobustNodeIntersector<bvh::Bvh<Scalar>> node_intersector(ray);
+
+            size_t stack[StackSize];
+            size_t stack_size = 0;
+            auto* left_child = &bvh.nodes[root.first_child_or_primitive];
+            while (true) {
+                auto* right_child = left_child + 1;
+                auto distance_left  = node_intersector.intersect(*left_child,  ray);
+                auto distance_right = node_intersector.intersect(*right_child, ray);
+                count.node_visits += 2;
+
+                if (distance_left.first <= distance_left.second) {
+                    if (left_child->is_leaf()) {
+                        count.primitive_tests += left_child->primitive_count;
+                        primitives.intersect_leaf(*left_child, ray, w_ray, best_hit, &count);
+                        left_child = nullptr;
+                    }
+                }
+                else {
+                    left_child = nullptr;
+                }
+
+                if (distance_right.first <= distance_right.second) {
+                    if (right_child->is_leaf()) {
+                        count.primitive_tests += right_child->primitive_count;
+                        primitives.intersect_leaf(*right_child, ray, w_ray, best_hit, &count);
+                        right_child = nullptr;
+                    }
+                }
+                else {
+                    right_child = nullptr;
+                }
+
+                if (left_child) {
+                    if (right_child) {
+                        if (distance_left.first > distance_right.first) {
+                            std::swap(left_child, right_child);
+                        }
+                        assert(stack_size < StackSize);
+                        stack[stack_size++] = right_child->first_child_or_primitive;
+                    }
+                    left_child = &bvh.nodes[left_child->first_child_or_primitive];
+                }
+                else if (right_child) {
+                    left_child = &bvh.nodes[right_child->first_child_or_primitive];
+                }
+                else {
+                    if (stack_size == 0) {
+                        break;
+                    }
+                    left_child = &bvh.nodes[stack[--stack_size]];
+                }
+            }
+            return best_hit;
+        }
+
+    private:
+        const bvh::Bvh<Scalar> &bvh;
+        const ScenePrimitives<Scalar> &primitives;
+};
+
+#endif
@@ -0,0 +1,451 @@
+#ifndef __HEIGHTFIELD_H
+#define __HEIGHTFIELD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/utilities.hpp>
+
+#include "statistics.hpp"
+
+template <typename Scalar>
+class Entity;
+
+// A raster of heights (a digital elevation model), together with an implicit min/max quadtree over
+// its cells.  Posts are stored row-major as 32 bit floats and are never copied into triangles: each
+// cell between four posts is split into two triangles along its (0,0)-(1,1) diagonal only when a ray
+// reaches it.  The heights themselves are not owned, so that a memory-mapped file or an array owned
+// by the caller can be traced in place; owner keeps whatever holds them alive.
+//
+// Level 0 of the quadtree bounds blocks of block_size x block_size cells, and each following level
+// bounds 2 x 2 nodes of the previous one, up to a single root.  Its nodes are stored as dense
+// arrays, so no child pointers are needed, and the whole tree adds less than a fifth to the memory
+// of the heights.
+class HeightfieldRaster {
+    public:
+        static constexpr size_t block_size = 4;
+
+        struct Range {
+            float min, max;
+        };
+
+        size_t rows, cols;
+        double spacing[2];
+
+        HeightfieldRaster(const float *heights, size_t rows, size_t cols, double spacing_x, double spacing_y,
+                          std::shared_ptr<const void> owner = nullptr)
+            : rows(rows), cols(cols), heights(heights), owner(std::move(owner)) {
+            if (rows < 2 || cols < 2) {
+                throw std::invalid_argument("A heightfield needs at least 2 x 2 posts");
+            }
+            if (!(spacing_x > 0) || !(spacing_y > 0)) {
+                throw std::invalid_argument("Heightfield post spacing must be positive");
+            }
+            spacing[0] = spacing_x;
+            spacing[1] = spacing_y;
+            build_pyramid();
+        }
+
+        // Raster owning its heights:
+        static std::shared_ptr<HeightfieldRaster> from_vector(std::vector<float> heights, size_t rows, size_t cols,
+                                                              double spacing_x, double spacing_y) {
+            if (heights.size() != rows*cols) {
+                throw std::invalid_argument("Expected " + std::to_string(rows*cols) + " heights but received " +
+                                            std::to_string(heights.size()));
+            }
+            auto owned = std::make_shared<const std::vector<float>>(std::move(heights));
+            return std::make_shared<HeightfieldRaster>(owned->data(), rows, cols, spacing_x, spacing_y, owned);
+        }
+
+        HeightfieldRaster(const HeightfieldRaster&) = delete;
+        HeightfieldRaster& operator=(const HeightfieldRaster&) = delete;
+
+        float height(size_t row, size_t col) const {
+            return heights[row*cols + col];
+        }
+
+        // Lowest and highest post of the whole raster:
+        Range range() const {
+            return levels.back()[0];
+        }
+
+        // Memory used by the quadtree, on top of the heights:
+        size_t pyramid_bytes() const {
+            size_t bytes = 0;
+            for (auto &level : levels) {
+                bytes += level.size()*sizeof(Range);
+            }
+            return bytes;
+        }
+
+        // Closest (or, if any is set, first found) intersection of a ray given in grid coordinates,
+        // where x is the column, y the row and z the height.  On a hit, ray.tmax is shortened to its
+        // distance and (x, y) is the grid position of the hit.  The quadtree nodes and cells whose
+        // bounds are tested are added to the node visits of count, if given, and the triangles tested
+        // to its primitive tests:
+        template <typename Scalar>
+        bool intersect(bvh::Ray<Scalar> &ray, bool any, Scalar &x, Scalar &y, TraversalCount *count = nullptr) const {
+            bvh::WatertightRay<Scalar> w_ray(ray);
+            bvh::Vector3<Scalar> inv_dir(Scalar(1) / ray.direction[0], Scalar(1) / ray.direction[1], Scalar(1) / ray.direction[2]);
+
+            // Children are visited nearest first, which depends only on the direction of the ray:
+            size_t near_x = ray.direction[0] < 0;
+            size_t near_y = ray.direction[1] < 0;
+
+            struct Node {
+                uint32_t level, a, b;
+            };
+            Node stack[4*64];
+            size_t stack_size = 0;
+            stack[stack_size++] = Node{(uint32_t) (levels.size() - 1), 0, 0};
+
+            uint64_t node_visits = 0, triangle_tests = 0;
+            auto finish = [&] (bool found) {
+                if (count) {
+                    count->node_visits += node_visits;
+                    count->primitive_tests += triangle_tests;
+                }
+                return found;
+            };
+
+            bool found = false;
+            while (stack_size > 0) {
+                auto node = stack[--stack_size];
+                node_visits++;
+                size_t span = block_size << node.level;
+                size_t x0 = node.a*span, x1 = std::min(x0 + span, cols - 1);
+                size_t y0 = node.b*span, y1 = std::min(y0 + span, rows - 1);
+                auto range = levels[node.level][node.b*level_width[node.level] + node.a];
+                Scalar entry, exit;
+                if (!overlaps(ray, inv_dir, Scalar(x0), Scalar(x1), Scalar(y0), Scalar(y1), range, entry, exit)) {
+                    continue;
+                }
+
+                if (node.level > 0) {
+                    // Push the farthest child first, so that the nearest is popped next:
+                    for (size_t k = 4; k-- > 0;) {
+                        size_t a = 2*node.a + ((k & 1) ^ near_x);
+                        size_t b = 2*node.b + ((k >> 1) ^ near_y);
+                        if (a < level_width[node.level - 1] && b < level_height[node.level - 1]) {
+                            stack[stack_size++] = Node{node.level - 1, (uint32_t) a, (uint32_t) b};
+                        }
+                    }
+                    continue;
+                }
+
+                // Only the cells under the part of the ray inside the block can be hit:
+                auto [col_begin, col_end] = cell_span(ray.origin[0], ray.direction[0], entry, exit, x0, x1);
+                auto [row_begin, row_end] = cell_span(ray.origin[1], ray.direction[1], entry, exit, y0, y1);
+                node_visits += (row_end - row_begin)*(col_end - col_begin);
+                for (size_t row = row_begin; row < row_end; ++row) {
+                    for (size_t col = col_begin; col < col_end; ++col) {
+                        if (intersect_cell(ray, w_ray, inv_dir, row, col, x, y, triangle_tests)) {
+                            found = true;
+                            if (any) {
+                                return finish(true);
+                            }
+                        }
+                    }
+                }
+            }
+            return finish(found);
+        }
+
+    private:
+        const float *heights;
+        std::shared_ptr<const void> owner;
+
+        std::vector<std::vector<Range>> levels;
+        std::vector<size_t> level_width;
+        std::vector<size_t> level_height;
+
+        void build_pyramid() {
+            size_t nodes_x = (cols - 1 + block_size - 1) / block_size;
+            size_t nodes_y = (rows - 1 + block_size - 1) / block_size;
+            levels.emplace_back(nodes_x*nodes_y);
+            level_width.push_back(nodes_x);
+            level_height.push_back(nodes_y);
+
+            auto &blocks = levels.back();
+            #pragma omp parallel for schedule(dynamic, 16)
+            for (size_t b = 0; b < nodes_y; ++b) {
+                for (size_t a = 0; a < nodes_x; ++a) {
+                    Range range{height(b*block_size, a*block_size), height(b*block_size, a*block_size)};
+                    for (size_t row = b*block_size; row <= std::min((b + 1)*block_size, rows - 1); ++row) {
+                        for (size_t col = a*block_size; col <= std::min((a + 1)*block_size, cols - 1); ++col) {
+                            range.min = std::min(range.min, height(row, col));
+                            range.max = std::max(range.max, height(row, col));
+                        }
+                    }
+                    blocks[b*nodes_x + a] = range;
+                }
+            }
+
+            while (nodes_x > 1 || nodes_y > 1) {
+                size_t coarse_x = (nodes_x + 1) / 2;
+                size_t coarse_y = (nodes_y + 1) / 2;
+                std::vector<Range> coarse(coarse_x*coarse_y);
+                auto &fine = levels.back();
+                #pragma omp parallel for
+                for (size_t b = 0; b < coarse_y; ++b) {
+                    for (size_t a = 0; a < coarse_x; ++a) {
+                        Range range = fine[2*b*nodes_x + 2*a];
+                        for (size_t k = 1; k < 4; ++k) {
+                            size_t fa = 2*a + (k & 1);
+                            size_t fb = 2*b + (k >> 1);
+                            if (fa < nodes_x && fb < nodes_y) {
+                                range.min = std::min(range.min, fine[fb*nodes_x + fa].min);
+                                range.max = std::max(range.max, fine[fb*nodes_x + fa].max);
+                            }
+                        }
+                        coarse[b*coarse_x + a] = range;
+                    }
+                }
+                levels.push_back(std::move(coarse));
+                nodes_x = coarse_x;
+                nodes_y = coarse_y;
+                level_width.push_back(nodes_x);
+                level_height.push_back(nodes_y);
+            }
+        }
+
+        // Slab test of the box [x0, x1] x [y0, y1] x [range.min, range.max] against the current
+        // extent of the ray.  A ray lying exactly in the plane of a slab gives a NaN, which the robust
+        // min/max ignore:
+        template <typename Scalar>
+        static bool overlaps(const bvh::Ray<Scalar> &ray, const bvh::Vector3<Scalar> &inv_dir,
+                             Scalar x0, Scalar x1, Scalar y0, Scalar y1, Range range, Scalar &entry, Scalar &exit) {
+            Scalar lower[3] = {x0, y0, Scalar(range.min)};
+            Scalar upper[3] = {x1, y1, Scalar(range.max)};
+            entry = ray.tmin;
+            exit = ray.tmax;
+            for (int axis = 0; axis < 3; ++axis) {
+                Scalar t0 = (lower[axis] - ray.origin[axis]) * inv_dir[axis];
+                Scalar t1 = (upper[axis] - ray.origin[axis]) * inv_dir[axis];
+                entry = bvh::robust_max(bvh::robust_min(t0, t1), entry);
+                exit  = bvh::robust_min(bvh::robust_max(t0, t1), exit);
+            }
+            return entry <= exit;
+        }
+
+        // Cells [begin, end) of a block spanning [first, last] along one axis that the ray crosses
+        // between entry and exit, widened by one cell on each side against rounding:
+        template <typename Scalar>
+        static std::pair<size_t, size_t> cell_span(Scalar origin, Scalar direction, Scalar entry, Scalar exit,
+                                                   size_t first, size_t last) {
+            Scalar a = origin + entry*direction;
+            Scalar b = origin + exit*direction;
+            Scalar low  = std::floor(std::min(a, b)) - 1;
+            Scalar high = std::floor(std::max(a, b)) + 2;
+            size_t begin = low  > Scalar(first) ? (size_t) low  : first;
+            size_t end   = high < Scalar(last)  ? (size_t) high : last;
+            return std::make_pair(begin, std::max(begin, end));
+        }
+
+        // The two triangles of a cell, which are only tested (and added to triangle_tests) if the ray
+        // reaches the bounds of the cell.  Posts are at integer grid positions and heights are exact
+        // floats, so neighboring cells test exactly the same edges and the surface stays watertight:
+        template <typename Scalar>
+        bool intersect_cell(bvh::Ray<Scalar> &ray, const bvh::WatertightRay<Scalar> &w_ray, const bvh::Vector3<Scalar> &inv_dir,
+                            size_t row, size_t col, Scalar &x, Scalar &y, uint64_t &triangle_tests) const {
+            float h00 = height(row, col),     h10 = height(row, col + 1);
+            float h01 = height(row + 1, col), h11 = height(row + 1, col + 1);
+            Range range{std::min(std::min(h00, h10), std::min(h01, h11)), std::max(std::max(h00, h10), std::max(h01, h11))};
+            Scalar x0 = Scalar(col), x1 = Scalar(col + 1);
+            Scalar y0 = Scalar(row), y1 = Scalar(row + 1);
+            Scalar entry, exit;
+            if (!overlaps(ray, inv_dir, x0, x1, y0, y1, range, entry, exit)) {
+                return false;
+            }
+            triangle_tests += 2;
+
+            bvh::Vector3<Scalar> p00(x0, y0, Scalar(h00));
+            bvh::Vector3<Scalar> p10(x1, y0, Scalar(h10));
+            bvh::Vector3<Scalar> p01(x0, y1, Scalar(h01));
+            bvh::Vector3<Scalar> p11(x1, y1, Scalar(h11));
+            bool found = false;
+            for (auto &tri : {bvh::Triangle<Scalar>(p00, p10, p11), bvh::Triangle<Scalar>(p00, p11, p01)}) {
+                if (auto hit = tri.intersect(ray, w_ray)) {
+                    auto point = hit->u*tri.p1() + hit->v*tri.p2() + (Scalar(1) - hit->u - hit->v)*tri.p0;
+                    x = point[0];
+                    y = point[1];
+                    ray.tmax = hit->t;
+                    found = true;
+                }
+            }
+            return found;
+        }
+};
+
+// A HeightfieldRaster placed in a scene.  Grid position (x, y) with height z lies at
+// origin + scale*(x*spacing[0]*axes[0] + y*spacing[1]*axes[1] + z*axes[2]), so that columns run
+// along the first axis, rows along the second one and heights along the third one.  Rays are
+// moved into grid coordinates for traversal, which leaves their distances unchanged.  Copies share
+// the raster, so flattening a scene never copies the heights:
+template <typename Scalar>
+struct Heightfield {
+    struct Intersection {
+        Scalar t, x, y;
+
+        Scalar distance() const { return t; }
+    };
+
+    std::shared_ptr<const HeightfieldRaster> raster;
+    bvh::Vector3<Scalar> origin;
+    bvh::Vector3<Scalar> axes[3];
+    Scalar scale;
+    Entity<Scalar> *parent;
+
+    // Index of this heightfield's material, remapped into the scene-wide material table when a
+    // scene is flattened, as for triangles:
+    uint32_t material_id;
+
+    Heightfield() = default;
+    explicit Heightfield(std::shared_ptr<const HeightfieldRaster> raster)
+        : raster(std::move(raster)), origin(0, 0, 0), scale(1), parent(nullptr), material_id(0)
+    {
+        axes[0] = bvh::Vector3<Scalar>(1, 0, 0);
+        axes[1] = bvh::Vector3<Scalar>(0, 1, 0);
+        axes[2] = bvh::Vector3<Scalar>(0, 0, 1);
+    }
+
+    void set_parent(Entity<Scalar> *parent) {
+        this->parent = parent;
+    }
+
+    bvh::Vector3<Scalar> to_world(Scalar x, Scalar y, Scalar z) const {
+        return origin + scale*((x*Scalar(raster->spacing[0]))*axes[0] + (y*Scalar(raster->spacing[1]))*axes[1] + z*axes[2]);
+    }
+
+    bvh::Ray<Scalar> to_grid(const bvh::Ray<Scalar> &ray) const {
+        auto o = ray.origin - origin;
+        auto &d = ray.direction;
+        Scalar sx = scale*Scalar(raster->spacing[0]);
+        Scalar sy = scale*Scalar(raster->spacing[1]);
+        return bvh::Ray<Scalar>(
+            bvh::Vector3<Scalar>(bvh::dot(axes[0], o) / sx, bvh::dot(axes[1], o) / sy, bvh::dot(axes[2], o) / scale),
+            bvh::Vector3<Scalar>(bvh::dot(axes[0], d) / sx, bvh::dot(axes[1], d) / sy, bvh::dot(axes[2], d) / scale),
+            ray.tmin, ray.tmax);
+    }
+
+    bvh::BoundingBox<Scalar> bounding_box() const {
+        auto range = raster->range();
+        auto bbox = bvh::BoundingBox<Scalar>::empty();
+        for (int k = 0; k < 8; ++k) {
+            bbox.extend(to_world((k & 1) ? Scalar(raster->cols - 1) : Scalar(0),
+                                 (k & 2) ? Scalar(raster->rows - 1) : Scalar(0),
+                                 (k & 4) ? Scalar(range.max) : Scalar(range.min)));
+        }
+        return bbox;
+    }
+
+    bvh::Vector3<Scalar> center() const {
+        return bounding_box().center();
+    }
+
+    // As for ellipsoids, the spatial split builder only gets the bounding box clipped:
+    std::pair<bvh::BoundingBox<Scalar>, bvh::BoundingBox<Scalar>> split(size_t axis, Scalar position) const {
+        auto left  = bounding_box();
+        auto right = left;
+        left.max[axis]  = std::min(left.max[axis], position);
+        right.min[axis] = std::max(right.min[axis], position);
+        return std::make_pair(left, right);
+    }
+
+    // Closest (or first found) hit, adding the quadtree nodes and triangles tested to count, if given:
+    std::optional<Intersection> intersect(const bvh::Ray<Scalar> &ray, bool any = false, TraversalCount *count = nullptr) const {
+        auto grid_ray = to_grid(ray);
+        Scalar x, y;
+        if (raster->intersect(grid_ray, any, x, y, count)) {
+            return std::make_optional(Intersection{grid_ray.tmax, x, y});
+        }
+        return std::nullopt;
+    }
+
+    // Height of the surface at a grid position, interpolated over the triangle of the cell containing it:
+    Scalar height(Scalar x, Scalar y) const {
+        auto [row, col] = cell(x, y);
+        Scalar fx = x - Scalar(col), fy = y - Scalar(row);
+        auto [dzdx, dzdy] = gradient(row, col, fx, fy);
+        return Scalar(raster->height(row, col)) + dzdx*fx + dzdy*fy;
+    }
+
+    bvh::Vector3<Scalar> point(Scalar x, Scalar y) const {
+        return to_world(x, y, height(x, y));
+    }
+
+    // Upward unit normal of the triangle containing a grid position:
+    bvh::Vector3<Scalar> normal(Scalar x, Scalar y) const {
+        auto [row, col] = cell(x, y);
+        auto [dzdx, dzdy] = gradient(row, col, x - Scalar(col), y - Scalar(row));
+        return local_normal(dzdx, dzdy);
+    }
+
+    // Upward normal interpolated bilinearly between the normals of the posts of a cell, which are
+    // estimated from central differences:
+    bvh::Vector3<Scalar> smooth_normal(Scalar x, Scalar y) const {
+        auto [row, col] = cell(x, y);
+        Scalar fx = x - Scalar(col), fy = y - Scalar(row);
+        Scalar dzdx = 0, dzdy = 0;
+        for (size_t k = 0; k < 4; ++k) {
+            size_t r = row + (k >> 1), c = col + (k & 1);
+            Scalar weight = ((k & 1) ? fx : 1 - fx) * ((k >> 1) ? fy : 1 - fy);
+            size_t c0 = c > 0 ? c - 1 : c, c1 = std::min(c + 1, raster->cols - 1);
+            size_t r0 = r > 0 ? r - 1 : r, r1 = std::min(r + 1, raster->rows - 1);
+            dzdx += weight * Scalar(raster->height(r, c1) - raster->height(r, c0)) / Scalar(c1 - c0);
+            dzdy += weight * Scalar(raster->height(r1, c) - raster->height(r0, c)) / Scalar(r1 - r0);
+        }
+        return local_normal(dzdx, dzdy);
+    }
+
+    // The raster covers the whole texture, with the first row at the top (v = 1):
+    std::pair<Scalar, Scalar> texture_coordinates(Scalar x, Scalar y) const {
+        return std::make_pair(x / Scalar(raster->cols - 1), Scalar(1) - y / Scalar(raster->rows - 1));
+    }
+
+    // Texture coordinates per unit of length across the surface (the geometric mean of the two
+    // directions, ignoring slopes):
+    Scalar texture_scale() const {
+        Scalar width  = scale*Scalar(raster->spacing[0])*Scalar(raster->cols - 1);
+        Scalar height = scale*Scalar(raster->spacing[1])*Scalar(raster->rows - 1);
+        return Scalar(1) / std::sqrt(width*height);
+    }
+
+    private:
+    std::pair<size_t, size_t> cell(Scalar x, Scalar y) const {
+        auto clamp = [] (Scalar value, size_t count) {
+            return std::min((size_t) std::max(std::floor(value), Scalar(0)), count - 2);
+        };
+        return std::make_pair(clamp(y, raster->rows), clamp(x, raster->cols));
+    }
+
+    // Slopes of the triangle of cell (row, col) containing (fx, fy), in height per grid unit:
+    std::pair<Scalar, Scalar> gradient(size_t row, size_t col, Scalar fx, Scalar fy) const {
+        Scalar h00 = raster->height(row, col),     h10 = raster->height(row, col + 1);
+        Scalar h01 = raster->height(row + 1, col), h11 = raster->height(row + 1, col + 1);
+        if (fx >= fy) {
+            return std::make_pair(h10 - h00, h11 - h10);
+        }
+        return std::make_pair(h11 - h01, h01 - h00);
+    }
+
+    bvh::Vector3<Scalar> local_normal(Scalar dzdx, Scalar dzdy) const {
+        return bvh::normalize(
+            (-dzdx / Scalar(raster->spacing[0]))*axes[0] +
+            (-dzdy / Scalar(raster->spacing[1]))*axes[1] +
+            axes[2]);
+    }
+};
+
+#endif
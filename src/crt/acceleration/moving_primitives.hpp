@@ -0,0 +1,29 @@
+#ifndef __MOVING_PRIMITIVES_H
+#define __MOVING_PRIMITIVES_H
+
+#include <cstddef>
+#include <vector>
+
+#include "rigid_body.hpp"
+
+// A range of primitive indices (as in build_bvh()) belonging to an entity that moves while an image
+// is exposed.  The primitives are stored in the entity's start pose: the BVH bounds them over the
+// whole motion, and ScenePrimitives carries each ray back to the start pose from its time:
+template <typename Scalar>
+struct MovingPrimitives {
+    size_t begin, end;
+    RigidMotion<Scalar> motion;
+};
+
+// Motion of a primitive, or nullptr if it does not move.  A scene has a few moving ranges at most:
+template <typename Scalar>
+const RigidMotion<Scalar>* find_motion(const std::vector<MovingPrimitives<Scalar>> &moving, size_t index) {
+    for (auto &range : moving) {
+        if (index >= range.begin && index < range.end) {
+            return &range.motion;
+        }
+    }
+    return nullptr;
+}
+
+#endif
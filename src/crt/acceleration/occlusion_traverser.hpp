@@ -0,0 +1,93 @@
+#ifndef __OCCLUSION_TRAVERSER_H
+#define __OCCLUSION_TRAVERSER_H
+
+#include <cassert>
+#include <cstddef>
+
+#include <bvh/bvh.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/node_intersectors.hpp>
+#include <bvh/triangle.hpp>
+
+#include "acceleration/scene_primitives.hpp"
+#include "statistics.hpp"
+
+// Visibility queries for shadow rays.  Compared to SingleRayTraverser with an
+// AnyPrimitiveIntersector, only a yes/no answer is needed, so:
+//   - leaves are tested by ScenePrimitives (triangles a block of PackedTriangles at a time), and
+//     no Intersection is built,
+//   - children are visited in whatever order they are stored, since any hit ends the search and
+//     sorting them by entry distance buys nothing,
+//   - the ray is never shortened, so the node intersector and ray stay constant for the whole query.
+// Nodes are tested with RobustNodeIntersector, as in ClosestHitTraverser.
+template <typename Scalar, size_t StackSize = 64>
+class OcclusionTraverser {
+    public:
+        OcclusionTraverser(const bvh::Bvh<Scalar> &bvh, const ScenePrimitives<Scalar> &primitives)
+            : bvh(bvh), primitives(primitives) { }
+
+        // Returns true if any primitive is hit between ray.tmin and ray.tmax:
+        bool occluded(const bvh::Ray<Scalar> &ray) const {
+            bvh::WatertightRay<Scalar> w_ray(ray);
+            TraversalCount count(true);
+            auto &root = bvh.nodes[0];
+            if (root.is_leaf()) {
+                count.primitive_tests += root.primitive_count;
+                return primitives.occluded_leaf(root, ray, w_ray, &count);
+            }
+
+            bvh::RobustNodeIntersector<bvh::Bvh<Scalar>> node_intersector(ray);
+
+            size_t stack[StackSize];
+            size_t stack_size = 0;
+            size_t first_child = root.first_child_or_primitive;
+            while (true) {
+                auto &left  = bvh.nodes[first_child];
+                auto &right = bvh.nodes[first_child + 1];
+                auto distance_left  = node_intersector.intersect(left,  ray);
+                auto distance_right = node_intersector.intersect(right, ray);
+                bool hit_left  = distance_left.first  <= distance_left.second;
+                bool hit_right = distance_right.first <= distance_right.second;
+                count.node_visits += 2;
+
+                // Leaves are tested as soon as they are reached:
+                if (hit_left && left.is_leaf()) {
+                    count.primitive_tests += left.primitive_count;
+                    if (primitives.occluded_leaf(left, ray, w_ray, &count)) {
+                        return true;
+                    }
+                    hit_left = false;
+                }
+                if (hit_right && right.is_leaf()) {
+                    count.primitive_tests += right.primitive_count;
+                    if (primitives.occluded_leaf(right, ray, w_ray, &count)) {
+                        return true;
+                    }
+                    hit_right = false;
+                }
+
+                if (hit_left) {
+                    if (hit_right) {
+                        assert(stack_size < StackSize);
+                        stack[stack_size++] = right.first_child_or_primitive;
+                    }
+                    first_child = left.first_child_or_primitive;
+                }
+                else if (hit_right) {
+                    first_child = right.first_child_or_primitive;
+                }
+                else {
+                    if (stack_size == 0) {
+                        return false;
+                    }
+                    first_child = stack[--stack_size];
+                }
+            }
+        }
+
+    private:
+        const bvh::Bvh<Scalar> &bvh;
+        const ScenePrimitives<Scalar> &primitives;
+};
+
+#endif
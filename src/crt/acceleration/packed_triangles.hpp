@@ -0,0 +1,229 @@
+#ifndef __PACKED_TRIANGLES_H
+#define __PACKED_TRIANGLES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/primitive_intersectors.hpp>
+
+// Copies of the triangles of every BVH leaf, in blocks of Width triangles stored component by
+// component, so that one block is tested against a ray with the lanes of a single vector register
+// (4 triangles in double precision, 8 in single precision with 256 bit registers).  The test is
+// the watertight test of bvh::Triangle, written as a loop over lanes for the compiler to
+// vectorize.  The last block of a leaf is padded with NaN vertices, which never hit.
+//
+// The blocks are built from the current triangle positions, and must be rebuilt whenever the BVH
+// changes.  Triangles moved in place under the same hierarchy (as when it is refitted) are copied
+// into the blocks again by update_vertices().  Primitive indices from triangle_count on belong to
+// other kinds of primitives (see ScenePrimitives), and are left out of the blocks.
+template <typename Scalar, size_t Width = 32 / sizeof(Scalar)>
+class PackedTriangles {
+    public:
+        using Hit = typename bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false>::Result;
+        using Intersection = typename bvh::Triangle<Scalar>::Intersection;
+
+        static constexpr size_t width = Width;
+
+        struct alignas(Width * sizeof(Scalar)) Block {
+            Scalar p0[3][Width];
+            Scalar p1[3][Width];
+            Scalar p2[3][Width];
+            uint32_t primitive[Width];
+        };
+
+        PackedTriangles() = default;
+
+        PackedTriangles(const bvh::Bvh<Scalar> &bvh, const bvh::Triangle<Scalar> *triangles,
+                        size_t triangle_count = std::numeric_limits<size_t>::max()) {
+            // Blocks of each leaf, indexed by the leaf's first primitive:
+            leaf_blocks.assign(primitive_count(bvh), LeafBlocks{0, 0});
+            size_t block_count = 0;
+            for (size_t i = 0; i < bvh.node_count; ++i) {
+                auto &node = bvh.nodes[i];
+                if (node.is_leaf()) {
+                    size_t leaf_triangles = 0;
+                    for (size_t j = 0; j < node.primitive_count; ++j) {
+                        leaf_triangles += bvh.primitive_indices[node.first_child_or_primitive + j] < triangle_count;
+                    }
+                    auto &range = leaf_blocks[node.first_child_or_primitive];
+                    range.begin = (uint32_t) block_count;
+                    block_count += (leaf_triangles + Width - 1) / Width;
+                    range.end = (uint32_t) block_count;
+                }
+            }
+
+            blocks.resize(block_count);
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (size_t i = 0; i < bvh.node_count; ++i) {
+                auto &node = bvh.nodes[i];
+                if (!node.is_leaf()) {
+                    continue;
+                }
+                auto range = leaf_blocks[node.first_child_or_primitive];
+                size_t next = 0;
+                for (size_t j = 0; j < (range.end - range.begin) * Width; ++j) {
+                    auto &block = blocks[range.begin + j / Width];
+                    size_t lane = j % Width;
+
+                    // Next triangle of the leaf, if any are left:
+                    while (next < node.primitive_count && bvh.primitive_indices[node.first_child_or_primitive + next] >= triangle_count) {
+                        next++;
+                    }
+                    if (next < node.primitive_count) {
+                        auto index = bvh.primitive_indices[node.first_child_or_primitive + next++];
+                        auto &tri = triangles[index];
+                        auto p1 = tri.p1();
+                        auto p2 = tri.p2();
+                        for (int axis = 0; axis < 3; ++axis) {
+                            block.p0[axis][lane] = tri.p0[axis];
+                            block.p1[axis][lane] = p1[axis];
+                            block.p2[axis][lane] = p2[axis];
+                        }
+                        block.primitive[lane] = (uint32_t) index;
+                    }
+                    else {
+                        for (int axis = 0; axis < 3; ++axis) {
+                            block.p0[axis][lane] = std::numeric_limits<Scalar>::quiet_NaN();
+                            block.p1[axis][lane] = std::numeric_limits<Scalar>::quiet_NaN();
+                            block.p2[axis][lane] = std::numeric_limits<Scalar>::quiet_NaN();
+                        }
+                        block.primitive[lane] = padding;
+                    }
+                }
+            }
+        }
+
+        // Copy the current positions of the triangles into the blocks, which must have been built for
+        // the same BVH and the same triangle array:
+        void update_vertices(const bvh::Triangle<Scalar> *triangles) {
+            #pragma omp parallel for schedule(dynamic, 1024)
+            for (size_t b = 0; b < blocks.size(); ++b) {
+                auto &block = blocks[b];
+                for (size_t lane = 0; lane < Width; ++lane) {
+                    if (block.primitive[lane] == padding) {
+                        continue;
+                    }
+                    auto &tri = triangles[block.primitive[lane]];
+                    auto p1 = tri.p1();
+                    auto p2 = tri.p2();
+                    for (int axis = 0; axis < 3; ++axis) {
+                        block.p0[axis][lane] = tri.p0[axis];
+                        block.p1[axis][lane] = p1[axis];
+                        block.p2[axis][lane] = p2[axis];
+                    }
+                }
+            }
+        }
+
+        // Closest hit in a leaf that is nearer than ray.tmax.  When one is found, it is stored in
+        // best_hit and ray.tmax is shortened to its distance:
+        bool intersect_leaf(const typename bvh::Bvh<Scalar>::Node &leaf, bvh::Ray<Scalar> &ray,
+                            const bvh::WatertightRay<Scalar> &w_ray, std::optional<Hit> &best_hit) const {
+            bool found = false;
+            auto range = leaf_blocks[leaf.first_child_or_primitive];
+            for (size_t b = range.begin; b < range.end; ++b) {
+                alignas(Block) Scalar t[Width], u[Width], v[Width], w[Width];
+                test(blocks[b], ray, w_ray, t, u, v, w);
+                for (size_t lane = 0; lane < Width; ++lane) {
+                    if (t[lane] <= ray.tmax) {
+                        best_hit = Hit{blocks[b].primitive[lane], Intersection{t[lane], u[lane], v[lane], w[lane]}};
+                        ray.tmax = t[lane];
+                        found = true;
+                    }
+                }
+            }
+            return found;
+        }
+
+        // True if any triangle of a leaf is hit between ray.tmin and ray.tmax:
+        bool occluded_leaf(const typename bvh::Bvh<Scalar>::Node &leaf, const bvh::Ray<Scalar> &ray,
+                           const bvh::WatertightRay<Scalar> &w_ray) const {
+            auto range = leaf_blocks[leaf.first_child_or_primitive];
+            for (size_t b = range.begin; b < range.end; ++b) {
+                alignas(Block) Scalar t[Width], u[Width], v[Width], w[Width];
+                test(blocks[b], ray, w_ray, t, u, v, w);
+                bool any = false;
+                for (size_t lane = 0; lane < Width; ++lane) {
+                    any |= t[lane] <= ray.tmax;
+                }
+                if (any) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Length of the primitive index array that the leaves cover, which is larger than the number
+        // of primitives when a spatial split build references some of them more than once:
+        static size_t primitive_count(const bvh::Bvh<Scalar> &bvh) {
+            size_t count = 0;
+            for (size_t i = 0; i < bvh.node_count; ++i) {
+                if (bvh.nodes[i].is_leaf()) {
+                    count = std::max(count, (size_t) (bvh.nodes[i].first_child_or_primitive + bvh.nodes[i].primitive_count));
+                }
+            }
+            return count;
+        }
+
+    private:
+        struct LeafBlocks {
+            uint32_t begin, end;
+        };
+
+        // Primitive of the NaN lanes that pad the last block of a leaf:
+        static constexpr uint32_t padding = std::numeric_limits<uint32_t>::max();
+
+        std::vector<Block> blocks;
+        std::vector<LeafBlocks> leaf_blocks;
+
+        // The watertight test of bvh::Triangle::intersect(), for every lane of a block.  Lanes that
+        // miss get an infinite distance, so that no mask has to be returned (a mask of bools would
+        // make the compiler pick 32 lanes of bytes and give up on a loop of Width iterations):
+        static void test(const Block &block, const bvh::Ray<Scalar> &ray, const bvh::WatertightRay<Scalar> &w_ray,
+                         Scalar *t, Scalar *u, Scalar *v, Scalar *w) {
+            const Scalar *p0x = block.p0[w_ray.kx], *p0y = block.p0[w_ray.ky], *p0z = block.p0[w_ray.kz];
+            const Scalar *p1x = block.p1[w_ray.kx], *p1y = block.p1[w_ray.ky], *p1z = block.p1[w_ray.kz];
+            const Scalar *p2x = block.p2[w_ray.kx], *p2y = block.p2[w_ray.ky], *p2z = block.p2[w_ray.kz];
+            Scalar ox = ray.origin[w_ray.kx], oy = ray.origin[w_ray.ky], oz = ray.origin[w_ray.kz];
+            Scalar sx = w_ray.sx, sy = w_ray.sy, sz = w_ray.sz;
+            Scalar tmin = ray.tmin, tmax = ray.tmax;
+
+            // Conditions are combined with bitwise operators, since branches prevent vectorization:
+            #pragma omp simd
+            for (size_t lane = 0; lane < Width; ++lane) {
+                Scalar az = p0z[lane] - oz;
+                Scalar bz = p1z[lane] - oz;
+                Scalar cz = p2z[lane] - oz;
+                Scalar ax = bvh::fast_multiply_add(-sx, az, p0x[lane] - ox);
+                Scalar ay = bvh::fast_multiply_add(-sy, az, p0y[lane] - oy);
+                Scalar bx = bvh::fast_multiply_add(-sx, bz, p1x[lane] - ox);
+                Scalar by = bvh::fast_multiply_add(-sy, bz, p1y[lane] - oy);
+                Scalar cx = bvh::fast_multiply_add(-sx, cz, p2x[lane] - ox);
+                Scalar cy = bvh::fast_multiply_add(-sy, cz, p2y[lane] - oy);
+
+                Scalar w0 = bvh::difference_of_products(cx, by, cy, bx);
+                Scalar w1 = bvh::difference_of_products(ax, cy, ay, cx);
+                Scalar w2 = bvh::difference_of_products(bx, ay, by, ax);
+                bool outside = ((w0 < 0) | (w1 < 0) | (w2 < 0)) & ((w0 > 0) | (w1 > 0) | (w2 > 0));
+
+                Scalar det = w0 + w1 + w2;
+                Scalar inv_det = Scalar(1.0) / det;
+                Scalar t_lane = (w0 * sz * az + w1 * sz * bz + w2 * sz * cz) * inv_det;
+
+                bool hit = !outside & (det != Scalar(0)) & (t_lane >= tmin) & (t_lane <= tmax);
+                t[lane] = hit ? t_lane : std::numeric_limits<Scalar>::infinity();
+                u[lane] = w1 * inv_det;
+                v[lane] = w2 * inv_det;
+                w[lane] = w0 * inv_det;
+            }
+        }
+};
+
+#endif
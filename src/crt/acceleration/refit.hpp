@@ -0,0 +1,68 @@
+#ifndef __REFIT_H
+#define __REFIT_H
+
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/ellipsoid.hpp>
+#include <bvh/hierarchy_refitter.hpp>
+
+#include "acceleration/heightfield.hpp"
+#include "acceleration/moving_primitives.hpp"
+
+// Surface area heuristic cost of an existing BVH, normalized by the area of the root node.
+// This is the same metric that the SAH based builders and optimizers in bvh/ minimize, so it
+// can be used to monitor how much a refitted hierarchy has degraded since it was built:
+template <typename Scalar>
+Scalar compute_sah_cost(const bvh::Bvh<Scalar> &bvh, Scalar traversal_cost = 1) {
+    Scalar cost(0);
+    #pragma omp parallel for reduction(+: cost)
+    for (size_t i = 0; i < bvh.node_count; ++i) {
+        auto &node = bvh.nodes[i];
+        if (node.is_leaf()) {
+            cost += node.bounding_box_proxy().half_area() * node.primitive_count;
+        }
+        else {
+            cost += traversal_cost * node.bounding_box_proxy().half_area();
+        }
+    }
+    return cost / bvh.nodes[0].bounding_box_proxy().half_area();
+};
+
+// Refit the bounding boxes of an existing BVH to the current triangle positions.  The topology
+// of the hierarchy is preserved, so this is only valid when the triangles have been moved in place.
+// Primitive indices from triangle_count on refer to the ellipsoids, and from triangle_count +
+// ellipsoid_count on to the heightfields, and moving primitives are bounded over their motion, as in
+// build_bvh():
+template <typename Scalar>
+void refit_bvh(bvh::Bvh<Scalar> &bvh, const bvh::Triangle<Scalar> *triangles, size_t triangle_count,
+               const bvh::Ellipsoid<Scalar> *ellipsoids, size_t ellipsoid_count,
+               const Heightfield<Scalar> *heightfields, const std::vector<MovingPrimitives<Scalar>> &moving = {}) {
+    bvh::HierarchyRefitter<bvh::Bvh<Scalar>> refitter(bvh);
+    refitter.refit([&] (typename bvh::Bvh<Scalar>::Node &leaf) {
+        auto bbox = bvh::BoundingBox<Scalar>::empty();
+        size_t begin = leaf.first_child_or_primitive;
+        size_t end   = begin + leaf.primitive_count;
+        for (size_t i = begin; i < end; ++i) {
+            auto index = bvh.primitive_indices[i];
+            bvh::BoundingBox<Scalar> primitive_bbox;
+            if (index < triangle_count) {
+                primitive_bbox = triangles[index].bounding_box();
+            }
+            else if (index < triangle_count + ellipsoid_count) {
+                primitive_bbox = ellipsoids[index - triangle_count].bounding_box();
+            }
+            else {
+                primitive_bbox = heightfields[index - triangle_count - ellipsoid_count].bounding_box();
+            }
+            if (auto motion = moving.empty() ? nullptr : find_motion(moving, index)) {
+                primitive_bbox = motion->sweep(primitive_bbox);
+            }
+            bbox.extend(primitive_bbox);
+        }
+        leaf.bounding_box_proxy() = bbox;
+    });
+};
+
+#endif
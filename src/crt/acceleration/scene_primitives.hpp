@@ -0,0 +1,335 @@
+#ifndef __SCENE_PRIMITIVES_H
+#define __SCENE_PRIMITIVES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/triangle.hpp>
+#include <bvh/ellipsoid.hpp>
+
+#include "acceleration/heightfield.hpp"
+#include "acceleration/moving_primitives.hpp"
+#include "acceleration/packed_triangles.hpp"
+#include "statistics.hpp"
+
+// Position, normals and texture coordinates of a hit.  Normals follow the left-handed convention
+// of the triangles, pointing into the surface.  Two sided shading flips them towards the incoming
+// ray, as mis() does.
+//
+// footprint is the width, in (u,v) units, of the ray cone that reached the hit (see
+// ScenePrimitives::surface_point()), which selects the mip level of texture lookups.  It is 0 for
+// a thin ray, which samples the full resolution texture:
+template <typename Scalar>
+struct SurfacePoint {
+    bvh::Vector3<Scalar> point;
+    bvh::Vector3<Scalar> normal;
+    bvh::Vector3<Scalar> shading_normal;
+    bvh::Vector<float, 2> uv;
+    float footprint = 0;
+};
+
+// Heterogeneous leaf intersector for a BVH built by build_bvh() over triangles, analytic
+// ellipsoids and heightfields.  Primitive indices below the number of triangles are tested a block
+// of PackedTriangles at a time, and the (few) other primitives of a leaf are then tested one by
+// one.  Hits on any kind are reported as the same Hit, whose primitive_index is the index in the
+// BVH, so the traversers never need to know which kind they reached.  A heightfield hit stores its
+// grid position in the u and v of the intersection.  The accessors below turn a Hit back into the
+// properties of whichever primitive it refers to.
+//
+// Primitives of moving entities (see AccelerationStructure::flatten()) are tested one by one
+// too, against the ray carried back to their start pose from its time, and their hits are carried
+// forward again.  Their triangles follow all the others, and are left out of the blocks.
+template <typename Scalar>
+class ScenePrimitives {
+    public:
+        using Hit = typename PackedTriangles<Scalar>::Hit;
+        using Intersection = typename PackedTriangles<Scalar>::Intersection;
+
+        // Primitives of an empty scene:
+        ScenePrimitives() : triangles(nullptr), triangle_count(0), ellipsoids(nullptr), ellipsoid_end(0), heightfields(nullptr) { }
+
+        ScenePrimitives(const bvh::Bvh<Scalar> &bvh, const std::vector<bvh::Triangle<Scalar>> &triangles,
+                        const std::vector<bvh::Ellipsoid<Scalar>> &ellipsoids = {},
+                        const std::vector<Heightfield<Scalar>> &heightfields = {},
+                        const std::vector<MovingPrimitives<Scalar>> &moving = {})
+            : triangles(triangles.data()), triangle_count(triangles.size()),
+              ellipsoids(ellipsoids.data()), ellipsoid_end(triangles.size() + ellipsoids.size()),
+              heightfields(heightfields.data()), moving(moving),
+              packed_triangles(bvh, triangles.data(), static_triangle_count(triangles.size(), moving)) {
+            size_t packed_count = static_triangle_count(triangle_count, moving);
+            if (ellipsoids.empty() && heightfields.empty() && packed_count == triangle_count) {
+                return;
+            }
+
+            // Other primitives of each leaf, indexed by the leaf's first primitive (which runs up to the
+            // number of references, not primitives, after a spatial split build):
+            leaf_others.assign(PackedTriangles<Scalar>::primitive_count(bvh), LeafOthers{0, 0});
+            for (size_t i = 0; i < bvh.node_count; ++i) {
+                auto &node = bvh.nodes[i];
+                if (!node.is_leaf()) {
+                    continue;
+                }
+                auto &range = leaf_others[node.first_child_or_primitive];
+                range.begin = (uint32_t) other_indices.size();
+                for (size_t j = 0; j < node.primitive_count; ++j) {
+                    auto index = bvh.primitive_indices[node.first_child_or_primitive + j];
+                    if (index >= packed_count) {
+                        other_indices.push_back((uint32_t) index);
+                        other_motions.push_back(motion_index(index));
+                    }
+                }
+                range.end = (uint32_t) other_indices.size();
+            }
+        }
+
+        // Copy triangles that have been moved in place, under the same BVH, into the blocks.  The
+        // other primitives are tested where they are stored, and need no update:
+        void update_vertices() {
+            packed_triangles.update_vertices(triangles);
+        }
+
+        // Closest hit in a leaf that is nearer than ray.tmax, as PackedTriangles::intersect_leaf().  The
+        // work done inside heightfields is added to count, if given (see HeightfieldRaster::intersect()):
+        bool intersect_leaf(const typename bvh::Bvh<Scalar>::Node &leaf, bvh::Ray<Scalar> &ray,
+                            const bvh::WatertightRay<Scalar> &w_ray, std::optional<Hit> &best_hit,
+                            TraversalCount *count = nullptr) const {
+            bool found = packed_triangles.intersect_leaf(leaf, ray, w_ray, best_hit);
+            if (leaf_others.empty()) {
+                return found;
+            }
+            auto range = leaf_others[leaf.first_child_or_primitive];
+            for (size_t i = range.begin; i < range.end; ++i) {
+                auto index = other_indices[i];
+                auto motion = other_motions[i];
+                auto local = motion ? moving[motion - 1].motion.to_start(ray) : ray;
+                if (index < triangle_count) {
+                    if (auto hit = triangles[index].intersect(local)) {
+                        best_hit = Hit{index, *hit};
+                        ray.tmax = hit->t;
+                        found = true;
+                    }
+                }
+                else if (index < ellipsoid_end) {
+                    if (auto hit = ellipsoids[index - triangle_count].intersect(local)) {
+                        best_hit = Hit{index, Intersection{hit->t, 0, 0, 0}};
+                        ray.tmax = hit->t;
+                        found = true;
+                    }
+                }
+                else if (auto hit = heightfields[index - ellipsoid_end].intersect(local, false, count)) {
+                    best_hit = Hit{index, Intersection{hit->t, hit->x, hit->y, 0}};
+                    ray.tmax = hit->t;
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        // True if any primitive of a leaf is hit between ray.tmin and ray.tmax, counting as above:
+        bool occluded_leaf(const typename bvh::Bvh<Scalar>::Node &leaf, const bvh::Ray<Scalar> &ray,
+                           const bvh::WatertightRay<Scalar> &w_ray, TraversalCount *count = nullptr) const {
+            if (packed_triangles.occluded_leaf(leaf, ray, w_ray)) {
+                return true;
+            }
+            if (leaf_others.empty()) {
+                return false;
+            }
+            auto range = leaf_others[leaf.first_child_or_primitive];
+            for (size_t i = range.begin; i < range.end; ++i) {
+                auto index = other_indices[i];
+                auto motion = other_motions[i];
+                auto local = motion ? moving[motion - 1].motion.to_start(ray) : ray;
+                bool hit = index < triangle_count ? triangles[index].intersect(local).has_value()
+                         : index < ellipsoid_end  ? ellipsoids[index - triangle_count].intersect(local).has_value()
+                                                  : heightfields[index - ellipsoid_end].intersect(local, true, count).has_value();
+                if (hit) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool is_triangle(const Hit &hit) const {
+            return hit.primitive_index < triangle_count;
+        }
+
+        bool is_ellipsoid(const Hit &hit) const {
+            return hit.primitive_index >= triangle_count && hit.primitive_index < ellipsoid_end;
+        }
+
+        uint32_t material_id(const Hit &hit) const {
+            if (is_triangle(hit)) {
+                return triangles[hit.primitive_index].material_id;
+            }
+            return is_ellipsoid(hit) ? ellipsoid(hit).material_id : heightfield(hit).material_id;
+        }
+
+        Entity<Scalar>* parent(const Hit &hit) const {
+            if (is_triangle(hit)) {
+                return triangles[hit.primitive_index].parent;
+            }
+            return is_ellipsoid(hit) ? ellipsoid(hit).parent : heightfield(hit).parent;
+        }
+
+        // True if the scene has moving primitives, whose hits depend on the time of the rays:
+        bool has_motion() const {
+            return !moving.empty();
+        }
+
+        // Hit point, for the ray the hit was found with.  Points on an ellipsoid or a heightfield are
+        // projected back onto its surface, which removes the rounding error of a long ray:
+        bvh::Vector3<Scalar> hit_point(const Hit &hit, const bvh::Ray<Scalar> &ray) const {
+            if (auto motion = motion_of(hit)) {
+                return motion->apply(start_hit_point(hit, motion->to_start(ray)), ray.time);
+            }
+            return start_hit_point(hit, ray);
+        }
+
+        // Surface of a hit, for a ray that stands for a cone of the given width where it hits (as
+        // traced by the integrators, see Camera::pixel_spread()).  The width is turned into a texture
+        // footprint by the (u,v) extent of a unit of length on the primitive, and stretched by the
+        // obliquity of the ray:
+        SurfacePoint<Scalar> surface_point(const Hit &hit, const bvh::Ray<Scalar> &ray, bool two_sided, Scalar cone_width = 0) const {
+            SurfacePoint<Scalar> surface;
+            if (auto motion = motion_of(hit)) {
+                surface = start_surface_point(hit, motion->to_start(ray), cone_width);
+                surface.point = motion->apply(surface.point, ray.time);
+                surface.normal = motion->rotate(surface.normal, ray.time);
+                surface.shading_normal = motion->rotate(surface.shading_normal, ray.time);
+            }
+            else {
+                surface = start_surface_point(hit, ray, cone_width);
+            }
+            if (two_sided && bvh::dot(ray.direction, surface.normal) < 0) {
+                surface.normal = -surface.normal;
+                surface.shading_normal = -surface.shading_normal;
+            }
+            return surface;
+        }
+
+    private:
+        struct LeafOthers {
+            uint32_t begin, end;
+        };
+
+        const bvh::Triangle<Scalar> *triangles;
+        size_t triangle_count;
+        const bvh::Ellipsoid<Scalar> *ellipsoids;
+        size_t ellipsoid_end;
+        const Heightfield<Scalar> *heightfields;
+        std::vector<MovingPrimitives<Scalar>> moving;
+
+        PackedTriangles<Scalar> packed_triangles;
+
+        // Ellipsoids, heightfields and moving triangles of each leaf, with the motion of each (one
+        // past its index in moving, or 0 if it does not move).  Empty when the scene has none, which
+        // leaves the triangle path untouched:
+        std::vector<LeafOthers> leaf_others;
+        std::vector<uint32_t> other_indices;
+        std::vector<uint32_t> other_motions;
+
+        // Number of triangles in the blocks, which is where the moving ones begin:
+        static size_t static_triangle_count(size_t triangle_count, const std::vector<MovingPrimitives<Scalar>> &moving) {
+            for (auto &range : moving) {
+                triangle_count = std::min(triangle_count, range.begin);
+            }
+            return triangle_count;
+        }
+
+        uint32_t motion_index(size_t index) const {
+            for (size_t k = 0; k < moving.size(); ++k) {
+                if (index >= moving[k].begin && index < moving[k].end) {
+                    return (uint32_t) k + 1;
+                }
+            }
+            return 0;
+        }
+
+        const RigidMotion<Scalar>* motion_of(const Hit &hit) const {
+            return moving.empty() ? nullptr : find_motion(moving, hit.primitive_index);
+        }
+
+        const bvh::Ellipsoid<Scalar>& ellipsoid(const Hit &hit) const {
+            return ellipsoids[hit.primitive_index - triangle_count];
+        }
+
+        const Heightfield<Scalar>& heightfield(const Hit &hit) const {
+            return heightfields[hit.primitive_index - ellipsoid_end];
+        }
+
+        // Hit point and surface of a primitive where it is stored, for a ray in the same pose:
+        bvh::Vector3<Scalar> start_hit_point(const Hit &hit, const bvh::Ray<Scalar> &ray) const {
+            if (is_triangle(hit)) {
+                auto &tri = triangles[hit.primitive_index];
+                auto u = hit.intersection.u;
+                auto v = hit.intersection.v;
+                return u*tri.p1() + v*tri.p2() + (1-u-v)*tri.p0;
+            }
+            if (!is_ellipsoid(hit)) {
+                return heightfield(hit).point(hit.intersection.u, hit.intersection.v);
+            }
+            auto &body = ellipsoid(hit);
+            auto q = bvh::normalize(body.to_unit_sphere(ray.origin + hit.intersection.t*ray.direction - body.origin));
+            return body.origin + (q[0]*body.radii[0])*body.axes[0] + (q[1]*body.radii[1])*body.axes[1] + (q[2]*body.radii[2])*body.axes[2];
+        }
+
+        SurfacePoint<Scalar> start_surface_point(const Hit &hit, const bvh::Ray<Scalar> &ray, Scalar cone_width) const {
+            SurfacePoint<Scalar> surface;
+            surface.point = start_hit_point(hit, ray);
+            Scalar texture_scale = 0;
+            if (is_triangle(hit)) {
+                auto &tri = triangles[hit.primitive_index];
+                auto u = hit.intersection.u;
+                auto v = hit.intersection.v;
+                surface.normal = bvh::normalize(tri.n);
+                if (tri.parent->smooth_shading){
+                    surface.shading_normal = bvh::normalize(u*tri.vn1 + v*tri.vn2 + (Scalar(1.0)-u-v)*tri.vn0);
+                }
+                else {
+                    surface.shading_normal = surface.normal;
+                }
+                surface.uv = (float)u*tri.uv[1] + (float)v*tri.uv[2] + (float)(Scalar(1.0)-u-v)*tri.uv[0];
+                if (cone_width > 0) {
+                    auto duv1 = tri.uv[1] - tri.uv[0];
+                    auto duv2 = tri.uv[2] - tri.uv[0];
+                    Scalar uv_area = std::abs(Scalar(duv1[0])*Scalar(duv2[1]) - Scalar(duv1[1])*Scalar(duv2[0]));
+                    Scalar area = bvh::length(tri.n);
+                    texture_scale = area > 0 ? std::sqrt(uv_area / area) : 0;
+                }
+            }
+            else if (!is_ellipsoid(hit)) {
+                auto &terrain = heightfield(hit);
+                auto x = hit.intersection.u;
+                auto y = hit.intersection.v;
+                surface.normal = -terrain.normal(x, y);
+                surface.shading_normal = terrain.parent->smooth_shading ? -terrain.smooth_normal(x, y) : surface.normal;
+                auto [u, v] = terrain.texture_coordinates(x, y);
+                surface.uv = bvh::Vector<float, 2>((float) u, (float) v);
+                texture_scale = terrain.texture_scale();
+            }
+            else {
+                auto &body = ellipsoid(hit);
+                surface.normal = -body.normal(surface.point);
+                surface.shading_normal = surface.normal;
+                auto [u, v] = body.texture_coordinates(surface.point);
+                surface.uv = bvh::Vector<float, 2>((float) u, (float) v);
+                // A full turn of u and half a turn of v around a sphere of the mean radius (so the
+                // stretching of u towards the poles is left out):
+                Scalar radius = std::cbrt(body.radii[0]*body.radii[1]*body.radii[2]);
+                texture_scale = Scalar(1) / (Scalar(M_PI*M_SQRT2)*radius);
+            }
+            if (cone_width > 0) {
+                Scalar cosine = std::abs(bvh::dot(bvh::normalize(ray.direction), surface.normal));
+                surface.footprint = (float) (cone_width * texture_scale / std::max(cosine, Scalar(1e-2)));
+            }
+            return surface;
+        }
+};
+
+#endif
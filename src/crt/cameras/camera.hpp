@@ -1,6 +1,11 @@
 #ifndef __CAMERA_H
 #define __CAMERA_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
 #include <bvh/bvh.hpp>
 #include "rigid_body.hpp"
 
@@ -14,6 +19,109 @@ class Camera: public RigidBody<Scalar> {
 
         virtual bvh::Ray<Scalar> pixel_to_ray(Scalar u, Scalar v) = 0;
 
+        // Called before an image is traced, once the pose is final, for camera models that
+        // precompute something from it.  pixel_to_ray() may then be called from many threads.
+        // Camera models overriding this must call it too:
+        virtual void prepare() {
+            prepare_motion();
+        }
+
+        // A camera can move from its pose to an end pose while an image is exposed.  Times run from 0
+        // at the pose to 1 at the end pose, along a straight line and the shortest rotation between
+        // them.  Row v starts its exposure at readout*v/resolution[1] (a rolling shutter, or a global
+        // one when readout is 0) and is exposed for the given exposure time, so that every ray is taken
+        // between 0 and 1 as long as exposure + readout is at most 1.  Entities that move (see
+        // Entity::set_motion()) run on the same clock, whether or not the camera moves:
+        bool moving = false;
+        bvh::Vector3<Scalar> end_position;
+        Scalar end_rotation[3][3];
+        Scalar exposure = 0;
+        Scalar readout = 0;
+
+        void set_motion(bvh::Vector3<Scalar> end_position, Scalar end_rotation[3][3]) {
+            this -> moving = true;
+            this -> end_position = end_position;
+            for (int i = 0; i < 3; i++){
+                for (int j = 0; j < 3; j++){
+                    this -> end_rotation[i][j] = end_rotation[i][j];
+                }
+            }
+        }
+
+        void clear_motion() {
+            this -> moving = false;
+        }
+
+        // Angle between the rays through the centers of neighboring pixels, at the center of the
+        // image.  A pixel sees a cone that widens by this much per unit of distance, which sets the
+        // texture footprint of what it hits (see SurfacePoint::footprint).  Must be called after
+        // prepare():
+        Scalar pixel_spread() {
+            Scalar u = this->resolution[0]/2;
+            Scalar v = this->resolution[1]/2;
+            auto d0 = bvh::normalize(pixel_to_ray(u, v).direction);
+            auto d1 = bvh::normalize(pixel_to_ray(u + 1, v).direction);
+            return 2*std::asin(std::min(bvh::length(d1 - d0)/2, Scalar(1)));
+        }
+
+        // Motion is only defined, and swept bounds only hold, between the pose and the end pose, so the
+        // shutter must close by time 1:
+        void set_shutter(Scalar exposure, Scalar readout) {
+            if (!(exposure >= 0) || !(readout >= 0) || !(exposure + readout <= 1)) {
+                throw std::invalid_argument("Shutter times must be non-negative, with exposure + readout at most 1");
+            }
+            this -> exposure = exposure;
+            this -> readout = readout;
+        }
+
+        // Fraction of the exposure at which to take sample index of a pixel: the base 2 radical inverse
+        // of the index, rotated by an offset drawn once per pixel, so that however many samples a
+        // pixel ends up with, they cover its exposure evenly:
+        static Scalar shutter_sample(uint32_t index, Scalar offset) {
+            index = (index << 16) | (index >> 16);
+            index = ((index & 0x00ff00ffu) << 8) | ((index & 0xff00ff00u) >> 8);
+            index = ((index & 0x0f0f0f0fu) << 4) | ((index & 0xf0f0f0f0u) >> 4);
+            index = ((index & 0x33333333u) << 2) | ((index & 0xccccccccu) >> 2);
+            index = ((index & 0x55555555u) << 1) | ((index & 0xaaaaaaaau) >> 1);
+            Scalar shutter = index*Scalar(2.3283064365386963e-10) + offset;
+            return shutter - std::floor(shutter);
+        }
+
+        // Ray of a sample at (u, v), taken at the given fraction (from 0 to 1) of its row's exposure.
+        // The ray carries the time it is taken at, where moving entities are intersected:
+        bvh::Ray<Scalar> sample_ray(Scalar u, Scalar v, Scalar shutter) {
+            auto ray = pixel_to_ray(u, v);
+            ray.time = readout*v/this->resolution[1] + exposure*shutter;
+            if (!moving) {
+                return ray;
+            }
+            return bvh::Ray<Scalar>(motion.apply(ray.origin, ray.time), motion.rotate(ray.direction, ray.time),
+                                    ray.tmin, ray.tmax, ray.time);
+        }
+
+    private:
+        RigidMotion<Scalar> motion;
+
+        // Rotations map the world frame to the camera frame, so the world frame rotation taking rays
+        // from the pose to the end pose is end_rotation^T*rotation:
+        void prepare_motion() {
+            if (!moving) {
+                return;
+            }
+            Scalar m[3][3];
+            for (int i = 0; i < 3; i++){
+                for (int j = 0; j < 3; j++){
+                    m[i][j] = 0;
+                    for (int k = 0; k < 3; k++){
+                        m[i][j] += end_rotation[k][i]*this->rotation[k][j];
+                    }
+                }
+            }
+            motion = RigidMotion<Scalar>(this->position, end_position, m);
+        }
+
+    public:
+
         // Additional information:
         // Aperture aperture;
 
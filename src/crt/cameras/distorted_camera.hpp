@@ -0,0 +1,216 @@
+#ifndef __DISTORTED_CAMERA_H
+#define __DISTORTED_CAMERA_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+
+// Unit ray directions at every pixel corner of an image, (resolution[0] + 1) by (resolution[1] + 1)
+// of them, stored as one array per component so that they can be rotated in a single vectorized
+// loop.  Corner (i, j) is at index j*columns + i:
+template <typename Scalar>
+struct DirectionTable {
+    size_t columns, rows;
+    std::vector<Scalar> x, y, z;
+
+    DirectionTable(size_t columns, size_t rows)
+        : columns(columns), rows(rows), x(columns*rows), y(columns*rows), z(columns*rows) { }
+};
+
+// Pinhole camera with Brown-Conrady lens distortion.  Distortion is applied to normalized image
+// coordinates (x to the right and y down the image, in units of the focal length):
+//
+//     r^2 = x^2 + y^2
+//     x_d = x*(1 + k1*r^2 + k2*r^4 + k3*r^6) + 2*p1*x*y + p2*(r^2 + 2*x^2)
+//     y_d = y*(1 + k1*r^2 + k2*r^4 + k3*r^6) + p1*(r^2 + 2*y^2) + 2*p2*x*y
+//
+// which is the convention of most calibration tools.  Inverting it takes a few Newton iterations,
+// so it is done once per set of intrinsics for every pixel corner, and the table is shared by all
+// cameras with the same intrinsics.  prepare() rotates the table into the world frame once per
+// image, after which a ray costs a bilinear interpolation between the corners around it.  If the
+// pose changes without prepare() being called, rays are rotated one at a time instead:
+template <typename Scalar>
+class DistortedCamera: public Camera<Scalar> {
+    using Vector3 = bvh::Vector3<Scalar>;
+    public:
+        // Radial (k1, k2, k3) and tangential (p1, p2) distortion coefficients:
+        Scalar radial[3];
+        Scalar tangential[2];
+
+        DistortedCamera(Scalar focal_length, Scalar resolution[2], Scalar sensor_size[2], bool z_positive,
+                        Scalar radial[3], Scalar tangential[2]) {
+            this -> focal_length = focal_length;
+            this -> z_positive   = z_positive;
+            for (int i = 0; i < 2; i++) {
+                this -> resolution[i] = resolution[i];
+                this -> sensor_size[i] = sensor_size[i];
+                this -> center[i] = resolution[i]/2.0;
+                this -> scale[i] = resolution[i]/sensor_size[i];
+                this -> tangential[i] = tangential[i];
+            }
+            for (int i = 0; i < 3; i++) {
+                this -> radial[i] = radial[i];
+            }
+            camera_directions = cached_table();
+        }
+
+        Scalar get_resolutionX() {
+            return this->resolution[0];
+        }
+
+        Scalar get_resolutionY() {
+            return this->resolution[1];
+        }
+
+        // Rotate the table into the world frame, unless it already is in the current pose:
+        void prepare() {
+            Camera<Scalar>::prepare();
+            if (world_directions && current(world_rotation)) {
+                return;
+            }
+            auto &from = *camera_directions;
+            auto table = std::make_shared<DirectionTable<Scalar>>(from.columns, from.rows);
+            Scalar r[3][3];
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    r[i][j] = this->rotation[i][j];
+                    world_rotation[i][j] = this->rotation[i][j];
+                }
+            }
+
+            // (NOTE: the TRANSPOSE of the provided rotation is used for this, as in SimpleCamera)
+            const Scalar *x = from.x.data(), *y = from.y.data(), *z = from.z.data();
+            Scalar *wx = table->x.data(), *wy = table->y.data(), *wz = table->z.data();
+            size_t count = from.x.size();
+            #pragma omp parallel for simd
+            for (size_t k = 0; k < count; ++k) {
+                wx[k] = r[0][0]*x[k] + r[1][0]*y[k] + r[2][0]*z[k];
+                wy[k] = r[0][1]*x[k] + r[1][1]*y[k] + r[2][1]*z[k];
+                wz[k] = r[0][2]*x[k] + r[1][2]*y[k] + r[2][2]*z[k];
+            }
+            world_directions = table;
+        }
+
+        bvh::Ray<Scalar> pixel_to_ray(Scalar u, Scalar v) {
+            bool rotated = world_directions && current(world_rotation);
+            Vector3 dir = interpolate(rotated ? *world_directions : *camera_directions, u, v);
+
+            // Rotate rays to the world frame (NOTE: the TRANSPOSE of the provided rotation is used for this)
+            if (!rotated) {
+                Vector3 temp;
+                temp[0] = this->rotation[0][0]*dir[0] + this->rotation[1][0]*dir[1] + this->rotation[2][0]*dir[2];
+                temp[1] = this->rotation[0][1]*dir[0] + this->rotation[1][1]*dir[1] + this->rotation[2][1]*dir[2];
+                temp[2] = this->rotation[0][2]*dir[0] + this->rotation[1][2]*dir[1] + this->rotation[2][2]*dir[2];
+                dir = temp;
+            }
+
+            // Return the ray object:
+            bvh::Ray<Scalar> ray(this->position, bvh::normalize(dir));
+            return ray;
+        }
+
+        // Undistorted normalized image coordinates (see above) of distorted ones:
+        void undistort(Scalar xd, Scalar yd, Scalar &x, Scalar &y) const {
+            Scalar k1 = radial[0], k2 = radial[1], k3 = radial[2];
+            Scalar p1 = tangential[0], p2 = tangential[1];
+            x = xd;
+            y = yd;
+            for (int iteration = 0; iteration < 20; ++iteration) {
+                Scalar r2 = x*x + y*y;
+                Scalar factor = 1 + r2*(k1 + r2*(k2 + r2*k3));
+                Scalar slope = k1 + r2*(2*k2 + 3*k3*r2);
+                Scalar fx = x*factor + 2*p1*x*y + p2*(r2 + 2*x*x) - xd;
+                Scalar fy = y*factor + p1*(r2 + 2*y*y) + 2*p2*x*y - yd;
+
+                // Newton step with the Jacobian of the distortion:
+                Scalar jxx = factor + 2*x*x*slope + 2*p1*y + 6*p2*x;
+                Scalar jxy = 2*x*y*slope + 2*p1*x + 2*p2*y;
+                Scalar jyy = factor + 2*y*y*slope + 6*p1*y + 2*p2*x;
+                Scalar det = jxx*jyy - jxy*jxy;
+                if (det == 0) {
+                    break;
+                }
+                Scalar dx = (jyy*fx - jxy*fy)/det;
+                Scalar dy = (jxx*fy - jxy*fx)/det;
+                x -= dx;
+                y -= dy;
+                if (std::abs(dx) + std::abs(dy) <= 1e-15*(1 + std::abs(x) + std::abs(y))) {
+                    break;
+                }
+            }
+        }
+
+    private:
+        std::shared_ptr<const DirectionTable<Scalar>> camera_directions;
+        std::shared_ptr<const DirectionTable<Scalar>> world_directions;
+        Scalar world_rotation[3][3];
+
+        bool current(const Scalar (&other)[3][3]) const {
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    if (other[i][j] != this->rotation[i][j]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Bilinear interpolation between the corners of the pixel containing (u, v), extrapolating
+        // from the outermost pixels beyond the edges of the image:
+        static Vector3 interpolate(const DirectionTable<Scalar> &table, Scalar u, Scalar v) {
+            Scalar i = std::min(std::max(std::floor(u), Scalar(0)), Scalar(table.columns - 2));
+            Scalar j = std::min(std::max(std::floor(v), Scalar(0)), Scalar(table.rows - 2));
+            Scalar fu = u - i, fv = v - j;
+            size_t k = (size_t) j*table.columns + (size_t) i;
+            size_t l = k + table.columns;
+            auto mix = [&] (const std::vector<Scalar> &c) {
+                Scalar top    = c[k] + fu*(c[k + 1] - c[k]);
+                Scalar bottom = c[l] + fu*(c[l + 1] - c[l]);
+                return top + fv*(bottom - top);
+            };
+            return Vector3(mix(table.x), mix(table.y), mix(table.z));
+        }
+
+        // Directions in the camera frame, computed the first time a camera with these intrinsics is
+        // made and then shared for as long as any such camera exists:
+        std::shared_ptr<const DirectionTable<Scalar>> cached_table() const {
+            using Key = std::array<Scalar, 12>;
+            static std::map<Key, std::weak_ptr<const DirectionTable<Scalar>>> cache;
+            static std::mutex mutex;
+
+            Key key = {this->focal_length, this->resolution[0], this->resolution[1], this->sensor_size[0],
+                       this->sensor_size[1], Scalar(this->z_positive), radial[0], radial[1], radial[2],
+                       tangential[0], tangential[1], Scalar(sizeof(Scalar))};
+            std::lock_guard<std::mutex> lock(mutex);
+            if (auto table = cache[key].lock()) {
+                return table;
+            }
+            auto table = std::make_shared<DirectionTable<Scalar>>((size_t) floor(this->resolution[0]) + 1,
+                                                                  (size_t) floor(this->resolution[1]) + 1);
+            Scalar z = this->z_positive ? 1 : -1;
+            #pragma omp parallel for
+            for (size_t j = 0; j < table->rows; ++j) {
+                for (size_t i = 0; i < table->columns; ++i) {
+                    Scalar x, y;
+                    undistort((i - this->center[0])/(this->scale[0]*this->focal_length),
+                              (j - this->center[1])/(this->scale[1]*this->focal_length), x, y);
+                    Vector3 dir = bvh::normalize(Vector3(x, -y, z));
+                    size_t k = j*table->columns + i;
+                    table->x[k] = dir[0];
+                    table->y[k] = dir[1];
+                    table->z[k] = dir[2];
+                }
+            }
+            cache[key] = table;
+            return table;
+        }
+};
+
+#endif
@@ -4,25 +4,26 @@
 #include <chrono>
 
 #include "bvh/bvh.hpp"
-#include "bvh/single_ray_traverser.hpp"
-#include "bvh/primitive_intersectors.hpp"
 #include "bvh/triangle.hpp"
 
 #include "lidars/lidar.hpp"
 
+#include "acceleration/acceleration_structure.hpp"
+#include "acceleration/closest_hit_traverser.hpp"
+#include "acceleration/scene_primitives.hpp"
+#include "statistics.hpp"
+
 template <typename Scalar>
 Scalar do_lidar(std::unique_ptr<Lidar<Scalar>> &lidar,
-                bvh::Bvh<Scalar> &bvh_cache,
-                std::vector<bvh::Triangle<Scalar>> triangles,
-                int num_rays){
+                const AccelerationStructure<Scalar> &scene,
+                int num_rays, RenderStatistics *statistics = nullptr){
 
     // Start time of the lidar process:
     auto start = std::chrono::high_resolution_clock::now();
+    StatisticsCollector collector(statistics);
 
-    auto tri_data = triangles.data();
-    bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> closest_intersector(bvh_cache, tri_data);
-    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_int(bvh_cache, tri_data);
-    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh_cache);
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> traverser(scene.bvh, primitives);
 
     // Define the output array:
     std::vector<bvh::Ray<Scalar>> rays = lidar->cast_rays(num_rays);
@@ -41,16 +42,15 @@ Scalar do_lidar(std::unique_ptr<Lidar<Scalar>> &lidar,
         num_threads = 1;
     #endif
     for (auto ray : rays) {
+        BusyTimer busy;
+
         // Traverse ray through BVH:
-        auto hit = traverser.traverse(ray, closest_intersector);
+        auto hit = traverser.traverse(ray);
 
         // Store intersection point:
         Scalar distance;
         if (hit) {
-            auto &tri = tri_data[hit->primitive_index];
-            auto u = hit->intersection.u;
-            auto v = hit->intersection.v;
-            auto intersect_point = bvh::Vector3<Scalar>(u*tri.p1() + v*tri.p2() + (1-u-v)*tri.p0);
+            auto intersect_point = primitives.hit_point(*hit, ray);
             distance = bvh::length(intersect_point - lidar->position);
         }
         else {
@@ -71,24 +71,23 @@ Scalar do_lidar(std::unique_ptr<Lidar<Scalar>> &lidar,
 
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    Lidar simulation completed in " << duration.count()/1000000.0 << " seconds (on " << num_threads << " threads)\n";
+    log_stream() << "    Lidar simulation completed in " << duration.count()/1000000.0 << " seconds (on " << num_threads << " threads)\n";
+    collector.finish(0, true);
 
     return distance;
 };
 
 template <typename Scalar>
 std::vector<Scalar> do_batch_lidar(std::unique_ptr<Lidar<Scalar>> &lidar,
-                                   bvh::Bvh<Scalar> &bvh_cache,
-                                   std::vector<bvh::Triangle<Scalar>> triangles,
-                                   int num_rays){
+                                   const AccelerationStructure<Scalar> &scene,
+                                   int num_rays, RenderStatistics *statistics = nullptr){
 
     // Start time of the batch lidar process:
     auto start = std::chrono::high_resolution_clock::now();
+    StatisticsCollector collector(statistics);
 
-    auto tri_data = triangles.data();
-    bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> closest_intersector(bvh_cache, tri_data);
-    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_int(bvh_cache, tri_data);
-    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh_cache);
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> traverser(scene.bvh, primitives);
 
     // Define the output array:
     std::vector<std::vector<bvh::Ray<Scalar>>> batch_rays = lidar->batch_cast_rays(num_rays);
@@ -109,19 +108,17 @@ std::vector<Scalar> do_batch_lidar(std::unique_ptr<Lidar<Scalar>> &lidar,
         num_threads = 1;
     #endif
     for (int i = 0; i < num_batches; i++) {
+        BusyTimer busy;
         auto rays = batch_rays[i];
         std::vector<Scalar> distances;
         for (auto ray : rays) {
             // Traverse ray through BVH:
-            auto hit = traverser.traverse(ray, closest_intersector);
+            auto hit = traverser.traverse(ray);
 
             // Store intersection point:
             Scalar distance;
             if (hit) {
-                auto &tri = tri_data[hit->primitive_index];
-                auto u = hit->intersection.u;
-                auto v = hit->intersection.v;
-                auto intersect_point = bvh::Vector3<Scalar>(u*tri.p1() + v*tri.p2() + (1-u-v)*tri.p0);
+                auto intersect_point = primitives.hit_point(*hit, ray);
                 distance = bvh::length(intersect_point - lidar->batch_positions[i]);
             }
             else {
@@ -149,7 +146,8 @@ std::vector<Scalar> do_batch_lidar(std::unique_ptr<Lidar<Scalar>> &lidar,
 
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    Batch lidar simulation completed in " << duration.count()/1000000.0 << " seconds (on " << num_threads << " threads)\n";
+    log_stream() << "    Batch lidar simulation completed in " << duration.count()/1000000.0 << " seconds (on " << num_threads << " threads)\n";
+    collector.finish(0, true);
 
     return batch_distances;
 };
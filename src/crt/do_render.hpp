@@ -19,42 +19,201 @@
 #include "bvh/triangle.hpp"
 
 #include "cameras/camera.hpp"
-#include "lights/light.hpp"
+#include "lights/light_variant.hpp"
 #include "materials/brdfs.hpp"
+#include "acceleration/acceleration_structure.hpp"
 #include "rendering_dynamic/entity.hpp"
-#include "path_tracing/unidirectional.hpp"
+#include "path_tracing/integrator.hpp"
+#include "path_tracing/wavefront.hpp"
+#include "measurements.hpp"
+#include "statistics.hpp"
 
+// Trace column i of a camera's image into pixels (RGBA floats, row major).  The column draws its
+// random numbers from a generator seeded with (seed, i), so the result depends only on the seed and
+// not on how columns are scheduled across threads.
+//
+// light_samples is the number of lights drawn from a light tree at every path vertex, or zero
+// to sample every light:
 template <typename Scalar>
-std::vector<uint8_t> do_render(std::unique_ptr<Camera<Scalar>> &camera, 
-                               std::vector<std::unique_ptr<Light<Scalar>>> &lights, 
-                               bvh::Bvh<Scalar> &bvh,
-                               std::vector<bvh::Triangle<Scalar>> &triangles,
-                               int min_samples, int max_samples, Scalar noise_threshold, int num_bounces) {
+void render_column(Camera<Scalar> &camera, size_t i, float *pixels,
+                   const std::vector<LightVariant<Scalar>> &lights, const LightTree<Scalar> &light_tree,
+                   const std::vector<MaterialVariant<Scalar>> &materials, const ScenePrimitives<Scalar> &primitives,
+                   const ClosestHitTraverser<Scalar> &closest_traverser, const OcclusionTraverser<Scalar> &occlusion_traverser,
+                   int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                   Integrator integrator, int light_samples, uint32_t seed) {
 
-    // Start time of the rendering process:
-    auto start = std::chrono::high_resolution_clock::now();
+    BusyTimer busy;
+    size_t width  = (size_t) floor(camera.get_resolutionX());
+    size_t height = (size_t) floor(camera.get_resolutionY());
+    uint64_t samples_taken = 0;
 
-    auto tri_data = triangles.data();
+    std::seed_seq column_seed{seed, (uint32_t) i};
+    std::minstd_rand eng(column_seed);
+    std::uniform_real_distribution<Scalar> distr(-0.5, 0.5);
+    Scalar pixel_spread = camera.pixel_spread();
+
+    for(size_t j = 0; j < height; ++j) {
+        size_t index = 4 * (width * j + i);
+        Color pixel_radiance(0);
 
-    bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> closest_intersector(bvh, tri_data);
-    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_intersector(bvh, tri_data);
-    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh);
+        // Samples are spread over the exposure when the camera or the scene moves (see Camera::shutter_sample()):
+        Scalar shutter_offset = camera.moving || primitives.has_motion() ? distr(eng) + 0.5 : 0;
+        
+        for (int sample = 1; sample < max_samples+1; ++sample) {
+            samples_taken++;
+
+            // Generate a random sample:
+            bvh::Ray<Scalar> ray;
+            auto i_rand = distr(eng);
+            auto j_rand = distr(eng);
+            if (max_samples == 1) {
+                ray = camera.sample_ray(i, j, 0.5);
+            }
+            else {
+                ray = camera.sample_ray(i + i_rand, j + j_rand, Camera<Scalar>::shutter_sample(sample - 1, shutter_offset));
+            }
+
+            // Perform path tracing operation:
+            Color path_radiance(0);
+            switch (integrator) {
+                case Integrator::Unidirectional:
+                    path_radiance = unidirectional(lights, light_tree, light_samples, materials, primitives, closest_traverser, 
+                                                   occlusion_traverser, ray, num_bounces, eng, pixel_spread);
+                    break;
+                case Integrator::MIS:
+                    path_radiance = mis(lights, light_tree, light_samples, materials, primitives, closest_traverser, 
+                                        occlusion_traverser, ray, num_bounces, eng, pixel_spread);
+                    break;
+            }
+
+            // Run adaptive sampling:
+            auto rad_contrib = (path_radiance - pixel_radiance)*(1.0f/sample);
+            pixel_radiance += rad_contrib;
+            if (sample >= min_samples) {
+                Scalar noise = bvh::length(rad_contrib);
+                if (noise < noise_threshold) {
+                    break;
+                }
+            }
+        }
+        // Store the pixel intensity:
+        pixels[index    ] = pixel_radiance[0];
+        pixels[index + 1] = pixel_radiance[1];
+        pixels[index + 2] = pixel_radiance[2];
+        pixels[index + 3] = 1;
+    }
+    statistics::add_samples(samples_taken);
+}
+
+// Trace every pixel of the camera and return the estimated radiance as RGBA floats.  When
+// measurements is given, the image is traced a tile of columns at a time and each tile is measured
+// (see measurements.hpp) as soon as it is done, while its radiance is still in cache:
+template <typename Scalar>
+std::vector<float> render_radiance(std::unique_ptr<Camera<Scalar>> &camera, 
+                                   const std::vector<LightVariant<Scalar>> &lights, 
+                                   const AccelerationStructure<Scalar> &scene,
+                                   int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                   Integrator integrator, int light_samples, uint32_t seed,
+                                   std::vector<EntityMeasurements<Scalar>> *measurements = nullptr) {
+
+    camera->prepare();
+    auto &bvh = scene.bvh;
+
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> closest_traverser(bvh, primitives);
+    OcclusionTraverser<Scalar> occlusion_traverser(bvh, primitives);
+
+    LightTree<Scalar> light_tree(lights);
 
     // RBGA
     size_t width  = (size_t) floor(camera->get_resolutionX());
     size_t height = (size_t) floor(camera->get_resolutionY());
-    auto pixels = std::make_unique<float[]>(4 * width * height);
+    std::vector<float> pixels(4 * width * height);
 
-    // Initialize random number generator:
-    std::random_device rd;
-    std::minstd_rand eng(rd());
-    std::uniform_real_distribution<Scalar> distr(-0.5, 0.5);
-    std::uniform_real_distribution<Scalar> dist1(0.0, 1.0);
+    // Sample pixels:
+    if (!measurements) {
+        #pragma omp parallel for
+        for(size_t i = 0; i < width; ++i) {
+            render_column(*camera, i, pixels.data(), lights, light_tree, scene.materials, primitives, closest_traverser,
+                          occlusion_traverser, min_samples, max_samples, noise_threshold, num_bounces, integrator,
+                          light_samples, seed);
+        }
+        return pixels;
+    }
 
-    // Default for now:
-    std::string path_tracing_type = "unidirectional";
+    ImageMeasurer<Scalar> measurer(*camera, lights, primitives, closest_traverser, occlusion_traverser);
+    typename ImageMeasurer<Scalar>::Accumulator total;
+    #pragma omp parallel
+    {
+        typename ImageMeasurer<Scalar>::Accumulator local;
+        #pragma omp for schedule(dynamic)
+        for (size_t tile = 0; tile < measurer.tile_count(); ++tile) {
+            for (size_t i = measurer.tile_begin(tile); i < measurer.tile_end(tile); ++i) {
+                render_column(*camera, i, pixels.data(), lights, light_tree, scene.materials, primitives, closest_traverser,
+                              occlusion_traverser, min_samples, max_samples, noise_threshold, num_bounces, integrator,
+                              light_samples, seed);
+            }
+            measurer.measure(tile, pixels.data(), local);
+        }
+        #pragma omp critical
+        ImageMeasurer<Scalar>::merge(local, total);
+    }
+    *measurements = ImageMeasurer<Scalar>::finish(total);
 
-    // Sample pixels:
+    return pixels;
+};
+
+// Trace a sequence of frames against one scene, all of the same resolution, and return their
+// radiance one after the other.  The traversers and light tree are set up once, and a single
+// parallel loop runs over every column of every frame, so that small images still keep all threads
+// busy.  Frame f is identical to render_radiance() of cameras[f] with seeds[f]:
+template <typename Scalar>
+std::vector<float> render_radiance_batch(std::vector<std::unique_ptr<Camera<Scalar>>> &cameras,
+                                         const std::vector<LightVariant<Scalar>> &lights,
+                                         const AccelerationStructure<Scalar> &scene,
+                                         int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                         Integrator integrator, int light_samples, const std::vector<uint32_t> &seeds) {
+
+    for (auto &camera : cameras) {
+        camera->prepare();
+    }
+    auto &bvh = scene.bvh;
+
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> closest_traverser(bvh, primitives);
+    OcclusionTraverser<Scalar> occlusion_traverser(bvh, primitives);
+
+    LightTree<Scalar> light_tree(lights);
+
+    size_t width  = (size_t) floor(cameras[0]->get_resolutionX());
+    size_t height = (size_t) floor(cameras[0]->get_resolutionY());
+    size_t frame_size = 4 * width * height;
+    std::vector<float> pixels(cameras.size() * frame_size);
+
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (size_t f = 0; f < cameras.size(); ++f) {
+        for (size_t i = 0; i < width; ++i) {
+            render_column(*cameras[f], i, pixels.data() + f*frame_size, lights, light_tree, scene.materials, primitives,
+                          closest_traverser, occlusion_traverser, min_samples, max_samples, noise_threshold, num_bounces,
+                          integrator, light_samples, seeds[f]);
+        }
+    }
+
+    return pixels;
+};
+
+// Convert RGBA radiance to 8 bit RGBA pixels:
+inline std::vector<uint8_t> quantize_pixels(const std::vector<float> &pixels) {
+    std::vector<uint8_t> image(pixels.size());
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        image[i] = (uint8_t) std::clamp(pixels[i] * 256, 0.0f, 255.0f);
+    }
+    return image;
+}
+
+inline int render_thread_count() {
     int num_threads;
     #ifdef _OPENMP
         #pragma omp parallel 
@@ -62,80 +221,115 @@ std::vector<uint8_t> do_render(std::unique_ptr<Camera<Scalar>> &camera,
             #pragma omp single
             num_threads = omp_get_num_threads();
         }
-        #pragma omp parallel for
     #else
         num_threads = 1;
     #endif
-    for(size_t i = 0; i < width; ++i) {
-        for(size_t j = 0; j < height; ++j) {
-            size_t index = 4 * (width * j + i);
-            Color pixel_radiance(0);
-            
-            for (int sample = 1; sample < max_samples+1; ++sample) {
-
-                // Generate a random sample:
-                bvh::Ray<Scalar> ray;
-                auto i_rand = distr(eng);
-                auto j_rand = distr(eng);
-                if (max_samples == 1) {
-                    ray = camera->pixel_to_ray(i, j);
-                }
-                else {
-                    ray = camera->pixel_to_ray(i + i_rand, j + j_rand);
-                }
+    return num_threads;
+}
 
-                // Perform path tracing operation:
-                Color path_radiance(0);
-                if (path_tracing_type.compare("unidirectional") == 0) {
-                    path_radiance = unidirectional(lights, tri_data, closest_intersector, 
-                                                   any_intersector, traverser, ray, num_bounces);
-                }
-                else if (path_tracing_type.compare("bidirectional") == 0){
-                    // NOT YET IMPLEMENTED
-                }
-                else if (path_tracing_type.compare("metropolis") == 0){
-                    // NOT YET IMPLEMENTED
-                }
+// Render the estimated radiance of every pixel as RGBA floats, before any quantization (see
+// do_render() and SensorModel::expose()):
+template <typename Scalar>
+std::vector<float> render_pixels(std::unique_ptr<Camera<Scalar>> &camera, 
+                                 const std::vector<LightVariant<Scalar>> &lights, 
+                                 const AccelerationStructure<Scalar> &scene,
+                                 int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                 Integrator integrator = Integrator::Unidirectional, int light_samples = 0,
+                                 bool wavefront = false, std::vector<EntityMeasurements<Scalar>> *measurements = nullptr,
+                                 RenderStatistics *statistics = nullptr) {
 
-                // Run adaptive sampling:
-                auto rad_contrib = (path_radiance - pixel_radiance)*(1.0f/sample);
-                pixel_radiance += rad_contrib;
-                if (sample >= min_samples) {
-                    Scalar noise = bvh::length(rad_contrib);
-                    if (noise < noise_threshold) {
-                        break;
-                    }
-                }
-            }
-            // Store the pixel intensity:
-            pixels[index    ] = pixel_radiance[0];
-            pixels[index + 1] = pixel_radiance[1];
-            pixels[index + 2] = pixel_radiance[2];
-            pixels[index + 3] = 1;
+    // Start time of the rendering process:
+    auto start = std::chrono::high_resolution_clock::now();
+    StatisticsCollector collector(statistics);
+
+    int num_threads = render_thread_count();
+
+    // Seed for the random number generators:
+    std::random_device rd;
+    std::vector<float> pixels;
+    if (wavefront) {
+        pixels = render_radiance_wavefront(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                           integrator, light_samples, rd());
+
+        // Wavefront paths finish all at once, so the image is measured afterwards:
+        if (measurements) {
+            auto &primitives = scene.primitives;
+            ClosestHitTraverser<Scalar> closest_traverser(scene.bvh, primitives);
+            OcclusionTraverser<Scalar> occlusion_traverser(scene.bvh, primitives);
+            ImageMeasurer<Scalar> measurer(*camera, lights, primitives, closest_traverser, occlusion_traverser);
+            *measurements = measure_image(measurer, pixels.data());
         }
     }
+    else {
+        pixels = render_radiance(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                 integrator, light_samples, rd(), measurements);
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    log_stream() << "    Rendering completed in " << duration.count()/1000000.0 << " seconds (on " << num_threads << " threads)\n";
+    collector.finish(pixels.size() / 4);
+
+    return pixels;
+};
+
+template <typename Scalar>
+std::vector<uint8_t> do_render(std::unique_ptr<Camera<Scalar>> &camera, 
+                               const std::vector<LightVariant<Scalar>> &lights, 
+                               const AccelerationStructure<Scalar> &scene,
+                               int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                               Integrator integrator = Integrator::Unidirectional, int light_samples = 0,
+                               bool wavefront = false, std::vector<EntityMeasurements<Scalar>> *measurements = nullptr,
+                               RenderStatistics *statistics = nullptr) {
+    auto pixels = render_pixels(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                integrator, light_samples, wavefront, measurements, statistics);
 
     // Construct output image:
-    std::vector<uint8_t> image;
-    image.reserve(4*width*height);
+    auto image = quantize_pixels(pixels);
+    return image;
+};
+
+// Render one image per camera, all of the same resolution, into a single array of frames.  The
+// wavefront renderer already parallelizes within each frame, so its frames are rendered in turn:
+template <typename Scalar>
+std::vector<uint8_t> do_render_batch(std::vector<std::unique_ptr<Camera<Scalar>>> &cameras,
+                                     const std::vector<LightVariant<Scalar>> &lights,
+                                     const AccelerationStructure<Scalar> &scene,
+                                     int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                     Integrator integrator = Integrator::Unidirectional, int light_samples = 0,
+                                     bool wavefront = false, RenderStatistics *statistics = nullptr) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+    StatisticsCollector collector(statistics);
+
+    int num_threads = render_thread_count();
 
-    for (size_t j = 0; j < 4*width*height; j++) {
-        image.push_back((uint8_t) std::clamp(pixels[j] * 256, 0.0f, 255.0f));
+    std::random_device rd;
+    std::vector<uint32_t> seeds(cameras.size());
+    for (auto &seed : seeds) {
+        seed = rd();
     }
 
-    for(unsigned y = 0; y < height; y++) {
-        for(unsigned x = 0; x < width; x++) {
-            size_t i = 4 * (width * y + x);
-            image[4 * width * y + 4 * x + 0] = (uint8_t) std::clamp(pixels[i+0] * 256, 0.0f, 255.0f);
-            image[4 * width * y + 4 * x + 1] = (uint8_t) std::clamp(pixels[i+1] * 256, 0.0f, 255.0f);
-            image[4 * width * y + 4 * x + 2] = (uint8_t) std::clamp(pixels[i+2] * 256, 0.0f, 255.0f);
-            image[4 * width * y + 4 * x + 3] = (uint8_t) std::clamp(pixels[i+3] * 256, 0.0f, 255.0f);
+    std::vector<float> pixels;
+    if (wavefront) {
+        for (size_t f = 0; f < cameras.size(); ++f) {
+            auto frame = render_radiance_wavefront(cameras[f], lights, scene, min_samples, max_samples, noise_threshold,
+                                                   num_bounces, integrator, light_samples, seeds[f]);
+            pixels.insert(pixels.end(), frame.begin(), frame.end());
         }
     }
+    else {
+        pixels = render_radiance_batch(cameras, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                       integrator, light_samples, seeds);
+    }
+
+    auto image = quantize_pixels(pixels);
 
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    Rendering completed in " << duration.count()/1000000.0 << " seconds (on " << num_threads << " threads)\n";
+    log_stream() << "    Rendering " << cameras.size() << " frames completed in " << duration.count()/1000000.0
+              << " seconds (on " << num_threads << " threads)\n";
+    collector.finish(pixels.size() / 4);
 
     return image;
 };
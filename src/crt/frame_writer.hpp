@@ -0,0 +1,246 @@
+#ifndef __FRAME_WRITER_H
+#define __FRAME_WRITER_H
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <lodepng/lodepng.h>
+
+enum class PixelFormat { UInt8, UInt16, Float32 };
+
+inline size_t pixel_format_size(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::UInt8:  return 1;
+        case PixelFormat::UInt16: return 2;
+        default:                  return 4;
+    }
+}
+
+// An image to be written, height rows of width pixels of channels values each, in native byte order:
+struct Frame {
+    std::string path;
+    size_t width = 0;
+    size_t height = 0;
+    size_t channels = 1;
+    PixelFormat format = PixelFormat::UInt8;
+    std::vector<uint8_t> data;
+};
+
+namespace frames {
+
+inline bool ends_with(const std::string &path, const std::string &extension) {
+    if (path.size() < extension.size()) {
+        return false;
+    }
+    auto tail = path.substr(path.size() - extension.size());
+    std::transform(tail.begin(), tail.end(), tail.begin(), [] (unsigned char c) { return std::tolower(c); });
+    return tail == extension;
+}
+
+inline bool little_endian() {
+    uint16_t one = 1;
+    uint8_t first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+inline void write_png(const Frame &frame) {
+    static const LodePNGColorType color_types[4] = {LCT_GREY, LCT_GREY_ALPHA, LCT_RGB, LCT_RGBA};
+    if (frame.format == PixelFormat::Float32) {
+        throw std::invalid_argument("Cannot write floating point frame " + frame.path + " as PNG, use .npy or .raw");
+    }
+    if (frame.channels < 1 || frame.channels > 4) {
+        throw std::invalid_argument("Cannot write a frame with " + std::to_string(frame.channels) + " channels as PNG");
+    }
+
+    // 16 bit PNG samples are big endian:
+    const std::vector<uint8_t> *pixels = &frame.data;
+    std::vector<uint8_t> swapped;
+    if (frame.format == PixelFormat::UInt16 && little_endian()) {
+        swapped.resize(frame.data.size());
+        for (size_t i = 0; i + 1 < frame.data.size(); i += 2) {
+            swapped[i] = frame.data[i + 1];
+            swapped[i + 1] = frame.data[i];
+        }
+        pixels = &swapped;
+    }
+    unsigned error = lodepng::encode(frame.path, *pixels, (unsigned) frame.width, (unsigned) frame.height,
+                                     color_types[frame.channels - 1], frame.format == PixelFormat::UInt16 ? 16 : 8);
+    if (error) {
+        throw std::runtime_error("Failed to write " + frame.path + ": " + lodepng_error_text(error));
+    }
+}
+
+// NumPy .npy file (format version 1.0), which np.load() reads back with its shape and type:
+inline void write_npy(const Frame &frame) {
+    const char *types[3] = {"u1", "u2", "f4"};
+    std::string order = frame.format == PixelFormat::UInt8 ? "|" : little_endian() ? "<" : ">";
+    std::string shape = "(" + std::to_string(frame.height) + ", " + std::to_string(frame.width) +
+                        (frame.channels > 1 ? ", " + std::to_string(frame.channels) : "") + ")";
+    std::string header = "{'descr': '" + order + types[(int) frame.format] + "', 'fortran_order': False, 'shape': " + shape + ", }";
+    header.append(63 - (10 + header.size()) % 64, ' ');
+    header.push_back('\n');
+
+    std::ofstream file(frame.path, std::ios::binary);
+    uint16_t length = (uint16_t) header.size();
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.put((char) (length & 0xff));
+    file.put((char) (length >> 8));
+    file.write(header.data(), header.size());
+    file.write((const char*) frame.data.data(), frame.data.size());
+    if (!file) {
+        throw std::runtime_error("Failed to write " + frame.path);
+    }
+}
+
+inline void write_raw(const Frame &frame) {
+    std::ofstream file(frame.path, std::ios::binary);
+    file.write((const char*) frame.data.data(), frame.data.size());
+    if (!file) {
+        throw std::runtime_error("Failed to write " + frame.path);
+    }
+}
+
+}
+
+// Write a frame in the format given by the extension of its path: .png (8 or 16 bit, 1 to 4
+// channels), .npy or .raw (the bare pixel values, in native byte order):
+inline void write_frame(const Frame &frame) {
+    if (frame.data.size() != frame.width * frame.height * frame.channels * pixel_format_size(frame.format)) {
+        throw std::invalid_argument("Frame " + frame.path + " holds " + std::to_string(frame.data.size()) +
+                                    " bytes, which does not match its size");
+    }
+    if (frames::ends_with(frame.path, ".png")) {
+        frames::write_png(frame);
+    }
+    else if (frames::ends_with(frame.path, ".npy")) {
+        frames::write_npy(frame);
+    }
+    else if (frames::ends_with(frame.path, ".raw")) {
+        frames::write_raw(frame);
+    }
+    else {
+        throw std::invalid_argument("Unknown frame format " + frame.path + ", expected .png, .npy or .raw");
+    }
+}
+
+// Encodes and writes frames on a pool of background threads, so that a sequence can keep rendering
+// while earlier frames are compressed and saved.  Frames that are queued or being written hold at
+// most max_queued_bytes of pixels (or a single frame, if it is larger), and write() waits for room
+// beyond that, so memory stays bounded however far rendering runs ahead of the disk.
+//
+// The first error a worker hits is thrown by the next call to write() or flush():
+class FrameWriter {
+    public:
+        FrameWriter(size_t threads, size_t max_queued_bytes) : max_queued_bytes(max_queued_bytes) {
+            threads = std::max<size_t>(threads, 1);
+            for (size_t i = 0; i < threads; ++i) {
+                workers.emplace_back([this] { work(); });
+            }
+        }
+
+        FrameWriter(const FrameWriter&) = delete;
+        FrameWriter& operator=(const FrameWriter&) = delete;
+
+        ~FrameWriter() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            work_available.notify_all();
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        }
+
+        void write(Frame frame) {
+            std::unique_lock<std::mutex> lock(mutex);
+            space_available.wait(lock, [&] {
+                return error || queued_bytes == 0 || queued_bytes + frame.data.size() <= max_queued_bytes;
+            });
+            rethrow();
+            queued_bytes += frame.data.size();
+            queue.push_back(std::move(frame));
+            lock.unlock();
+            work_available.notify_one();
+        }
+
+        // Wait for every frame written so far to be on disk:
+        void flush() {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [&] { return queue.empty() && writing == 0; });
+            rethrow();
+        }
+
+        // Number of frames queued or being written:
+        size_t pending() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return queue.size() + writing;
+        }
+
+    private:
+        size_t max_queued_bytes;
+        size_t queued_bytes = 0;
+        size_t writing = 0;
+        bool stopping = false;
+        std::exception_ptr error;
+
+        std::deque<Frame> queue;
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable work_available, space_available, idle;
+
+        void rethrow() {
+            if (error) {
+                auto thrown = error;
+                error = nullptr;
+                std::rethrow_exception(thrown);
+            }
+        }
+
+        void work() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                work_available.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                Frame frame = std::move(queue.front());
+                queue.pop_front();
+                writing++;
+                lock.unlock();
+
+                std::exception_ptr failure;
+                try {
+                    write_frame(frame);
+                }
+                catch (...) {
+                    failure = std::current_exception();
+                }
+
+                lock.lock();
+                writing--;
+                queued_bytes -= frame.data.size();
+                if (failure && !error) {
+                    error = failure;
+                }
+                space_available.notify_all();
+                if (queue.empty() && writing == 0) {
+                    idle.notify_all();
+                }
+            }
+        }
+};
+
+#endif
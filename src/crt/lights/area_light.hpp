@@ -1,26 +1,20 @@
 #ifndef __AREA_LIGHT_H
 #define __AREA_LIGHT_H
 
+#include <bvh/bvh.hpp>
+
+#include "lights/light.hpp"
+
 template <typename Scalar>
 class AreaLight: public Light<Scalar> {
     public:
         Scalar size[2];
-        bvh::Vector3<Scalar> sampled_point;
-
-        std::mt19937 generator;
-        std::uniform_real_distribution<Scalar> distr_x;
-        std::uniform_real_distribution<Scalar> distr_y;
 
         AreaLight(Scalar intensity, Scalar size[2]) {
             this->intensity = intensity;
             this->size[0] = size[0];
             this->size[1] = size[1];
 
-            std::random_device rand_dev;
-            std::mt19937 generator(rand_dev());
-            std::uniform_real_distribution<Scalar> distr_x(0.0,1.0);
-            std::uniform_real_distribution<Scalar> distr_y(0.0,1.0);
-
             // Default pose information:
             this -> position = bvh::Vector3<Scalar>(0,0,0);
             this -> rotation[0][0] = 1;
@@ -39,9 +33,6 @@ class AreaLight: public Light<Scalar> {
             this -> intensity = original.intensity;
             this -> size[0] = original.size[0];
             this -> size[1] = original.size[1];
-            this -> generator = original.generator;
-            this -> distr_x = original.distr_x;
-            this -> distr_y = original.distr_y;
 
             this -> position  = original.position;
             for (auto i = 0; i < 3; i++){
@@ -51,24 +42,83 @@ class AreaLight: public Light<Scalar> {
             }
         };
 
-        bvh::Ray<Scalar> sample_ray(bvh::Vector3<Scalar> origin){
+        LightSample<Scalar> sample(bvh::Vector3<Scalar> origin, Scalar r1, Scalar r2) const {
             // Select a random point on the light:
-            Scalar x_coord = (this->size[0])*distr_x(generator) - (this->size[0]/2);
-            Scalar y_coord = (this->size[1])*distr_y(generator) - (this->size[1]/2);
+            Scalar x_coord = (this->size[0])*r1 - (this->size[0]/2);
+            Scalar y_coord = (this->size[1])*r2 - (this->size[1]/2);
             bvh::Vector3<Scalar> point_on_light(x_coord, y_coord, 0.);
 
             Scalar scale = 1.0;
 
             // Transform the point to world coordinates:
-            this->sampled_point = transform(point_on_light, this->rotation, this->position, scale);
+            bvh::Vector3<Scalar> sampled_point = transform(point_on_light, this->rotation, this->position, scale);
 
             // Generate the ray:
-            bvh::Vector3<Scalar> light_direction = bvh::normalize(this->sampled_point - origin);
-            return bvh::Ray<Scalar>(origin, light_direction, 0, bvh::length(this->sampled_point - origin));
+            Scalar distance_squared = bvh::dot(origin - sampled_point, origin - sampled_point);
+            bvh::Vector3<Scalar> light_direction = bvh::normalize(sampled_point - origin);
+            LightSample<Scalar> light_sample{bvh::Ray<Scalar>(origin, light_direction, 0, std::sqrt(distance_squared)),
+                                             this->intensity / distance_squared};
+
+            // Convert the uniform density over the light's area into a solid angle density:
+            Scalar cos_light = std::abs(bvh::dot(light_direction, normal()));
+            if (cos_light > 0) {
+                light_sample.radiance = radiance();
+                light_sample.pdf = distance_squared / (area() * cos_light);
+            }
+            light_sample.delta = false;
+            return light_sample;
+        };
+
+        bvh::BoundingBox<Scalar> bounding_box() const {
+            auto bbox = bvh::BoundingBox<Scalar>::empty();
+            for (Scalar x : {-this->size[0]/2, this->size[0]/2}) {
+                for (Scalar y : {-this->size[1]/2, this->size[1]/2}) {
+                    bbox.extend(transform(bvh::Vector3<Scalar>(x, y, 0), this->rotation, this->position, Scalar(1)));
+                }
+            }
+            return bbox;
+        };
+
+        bool is_infinite() const {
+            return false;
+        };
+
+        // Intersect a ray with the (two-sided) rectangle of the light:
+        std::optional<LightHit<Scalar>> intersect(const bvh::Ray<Scalar> &ray) const {
+            auto n = normal();
+            Scalar denom = bvh::dot(ray.direction, n);
+            if (std::abs(denom) < Scalar(1e-12)) {
+                return std::nullopt;
+            }
+            Scalar t = bvh::dot(this->position - ray.origin, n) / denom;
+            if (t <= ray.tmin || t >= ray.tmax) {
+                return std::nullopt;
+            }
+
+            // Check that the hit lies within the extent of the light along its local x and y axes:
+            auto offset = ray.origin + t*ray.direction - this->position;
+            bvh::Vector3<Scalar> x_axis(this->rotation[0][0], this->rotation[1][0], this->rotation[2][0]);
+            bvh::Vector3<Scalar> y_axis(this->rotation[0][1], this->rotation[1][1], this->rotation[2][1]);
+            if (std::abs(bvh::dot(offset, x_axis)) > this->size[0]/2 || std::abs(bvh::dot(offset, y_axis)) > this->size[1]/2) {
+                return std::nullopt;
+            }
+            Scalar cos_light = std::abs(denom) / bvh::length(ray.direction);
+            return LightHit<Scalar>{t, radiance(), t*t / (area() * cos_light)};
+        };
+
+        // The light is a Lambertian emitter whose radiance is chosen so that a point directly
+        // in front of it receives intensity/distance^2, matching the unidirectional convention:
+        Scalar area() const {
+            return this->size[0]*this->size[1];
+        };
+
+        Scalar radiance() const {
+            return this->intensity / area();
         };
 
-        Scalar get_intensity(bvh::Vector3<Scalar> point) { 
-            return this->intensity / bvh::dot(point - this->sampled_point, point - this->sampled_point);
+        // Light emits along its local z axis (and, being two-sided, against it):
+        bvh::Vector3<Scalar> normal() const {
+            return bvh::Vector3<Scalar>(this->rotation[0][2], this->rotation[1][2], this->rotation[2][2]);
         };
 };
 
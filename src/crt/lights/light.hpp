@@ -1,21 +1,46 @@
 #ifndef __LIGHT_H
 #define __LIGHT_H
 
+#include <optional>
 #include <random>
 
 #include <bvh/bvh.hpp>
 
 #include "transform.hpp"
 
-// Abstract light class:
+// A shadow ray from a shaded point towards a light, along with the light's intensity at that point.
+// The remaining fields are used by physically based integrators: radiance/pdf is the light's
+// contribution for a sample drawn with the solid angle density pdf, and delta is set for lights
+// that occupy no area and so can never be hit by a BSDF sampled ray:
+template <typename Scalar>
+struct LightSample {
+    bvh::Ray<Scalar> ray;
+    Scalar intensity;
+    Scalar radiance = 0;
+    Scalar pdf = 1;
+    bool delta = true;
+};
+
+// A ray that reached the emitting surface of a light, with the emitted radiance and the solid
+// angle density with which sample() would have produced the same direction:
+template <typename Scalar>
+struct LightHit {
+    Scalar distance;
+    Scalar radiance;
+    Scalar pdf;
+};
+
+// Base class for all lights.  Lights have no virtual methods; every light type provides
+//     LightSample<Scalar> sample(bvh::Vector3<Scalar> origin, Scalar r1, Scalar r2) const
+//     std::optional<LightHit<Scalar>> intersect(const bvh::Ray<Scalar> &ray) const
+//     bvh::BoundingBox<Scalar> bounding_box() const
+//     bool is_infinite() const
+// where (r1, r2) are uniform random numbers drawn by the caller, and the set of light types is
+// closed over by LightVariant (see light_variant.hpp):
 template <typename Scalar>
 class Light: public RigidBody<Scalar> {
     public:
         Scalar intensity;
-
-        // Abstract methods:
-        virtual bvh::Ray<Scalar> sample_ray(bvh::Vector3<Scalar> origin) = 0;
-        virtual Scalar get_intensity(bvh::Vector3<Scalar> point) = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,286 @@
+#ifndef __LIGHT_TREE_H
+#define __LIGHT_TREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+
+#include "lights/light_variant.hpp"
+
+// Binary hierarchy over the lights of a scene, used to pick lights for a shading point with
+// probability roughly proportional to their contribution there.  Each node stores the bounding
+// box and total intensity of the lights below it, and its importance for a point is estimated as
+// intensity/distance^2 to the center of the box (with the distance clamped to the box's extent,
+// so nodes containing the point are not overweighted).  Selecting a light walks a single path
+// from the root to a leaf, so the cost per sample is O(log L) rather than O(L).
+//
+// Lights at infinite distance have no meaningful bounds and are kept outside of the hierarchy.
+// Their importance is their intensity (an irradiance, like intensity/distance^2), and a sample
+// first chooses between them and the root of the hierarchy:
+template <typename Scalar>
+class LightTree {
+    public:
+        // Index of the selected light, and the probability with which it was selected:
+        struct Selection {
+            size_t light;
+            Scalar pmf;
+        };
+
+        LightTree() = default;
+
+        LightTree(const std::vector<LightVariant<Scalar>> &lights) {
+            leaves.resize(lights.size(), invalid);
+
+            std::vector<Primitive> primitives;
+            primitives.reserve(lights.size());
+            for (size_t i = 0; i < lights.size(); ++i) {
+                if (light_is_infinite(lights[i])) {
+                    infinite_lights.push_back(InfiniteLight{light_power(lights[i]), (uint32_t) i});
+                }
+                else {
+                    primitives.push_back(Primitive{light_bounding_box(lights[i]), light_power(lights[i]), (uint32_t) i});
+                }
+            }
+            if (!primitives.empty()) {
+                nodes.reserve(2*primitives.size() - 1);
+                build(primitives, 0, primitives.size(), invalid);
+            }
+        }
+
+        size_t size() const {
+            return leaves.size();
+        }
+
+        // Select one light for point, using the uniform random number r in [0,1):
+        Selection sample(const bvh::Vector3<Scalar> &point, Scalar r) const {
+            Scalar pmf = 1;
+            if (!infinite_lights.empty()) {
+                Scalar root = root_importance(point);
+                Scalar total = root + infinite_power();
+                for (auto &infinite_light : infinite_lights) {
+                    Scalar p = total > 0 ? infinite_light.power / total : Scalar(1) / (infinite_lights.size() + !nodes.empty());
+                    if (r < p) {
+                        return Selection{infinite_light.light, p};
+                    }
+                    r -= p;
+                }
+                if (nodes.empty()) {
+                    auto &last = infinite_lights.back();
+                    return Selection{last.light, total > 0 ? last.power / total : Scalar(1) / infinite_lights.size()};
+                }
+                Scalar p_root = total > 0 ? root / total : Scalar(1) / (infinite_lights.size() + 1);
+                r = std::min(r / p_root, Scalar(1) - std::numeric_limits<Scalar>::epsilon());
+                pmf = p_root;
+            }
+
+            uint32_t node = 0;
+            while (!nodes[node].is_leaf()) {
+                auto &parent = nodes[node];
+                Scalar p_left = left_probability(parent, point);
+                if (r < p_left) {
+                    r = r / p_left;
+                    pmf *= p_left;
+                    node = parent.left;
+                }
+                else {
+                    r = std::min((r - p_left) / (1 - p_left), Scalar(1) - std::numeric_limits<Scalar>::epsilon());
+                    pmf *= 1 - p_left;
+                    node = parent.right;
+                }
+            }
+            return Selection{nodes[node].light, pmf};
+        }
+
+        // Probability that sample(point, r) selects the given light:
+        Scalar pmf(const bvh::Vector3<Scalar> &point, size_t light) const {
+            Scalar pmf = 1;
+            if (!infinite_lights.empty()) {
+                Scalar root = root_importance(point);
+                Scalar total = root + infinite_power();
+                size_t count = infinite_lights.size() + !nodes.empty();
+                if (leaves[light] == invalid) {
+                    for (auto &infinite_light : infinite_lights) {
+                        if (infinite_light.light == light) {
+                            return total > 0 ? infinite_light.power / total : Scalar(1) / count;
+                        }
+                    }
+                }
+                pmf = total > 0 ? root / total : Scalar(1) / count;
+            }
+
+            uint32_t node = leaves[light];
+            while (nodes[node].parent != invalid) {
+                auto &parent = nodes[nodes[node].parent];
+                Scalar p_left = left_probability(parent, point);
+                pmf *= (parent.left == node) ? p_left : 1 - p_left;
+                node = nodes[node].parent;
+            }
+            return pmf;
+        }
+
+        // Call visitor(light) for every light whose bounding box is crossed by ray, so that the
+        // lights a ray may hit are found without testing each of them:
+        template <typename Visitor>
+        void traverse(const bvh::Ray<Scalar> &ray, Visitor &&visitor) const {
+            for (auto &infinite_light : infinite_lights) {
+                visitor((size_t) infinite_light.light);
+            }
+            if (nodes.empty()) {
+                return;
+            }
+            auto inverse_direction = bvh::Vector3<Scalar>(1/ray.direction[0], 1/ray.direction[1], 1/ray.direction[2]);
+
+            uint32_t stack[64];
+            size_t stack_size = 0;
+            stack[stack_size++] = 0;
+            while (stack_size > 0) {
+                auto &node = nodes[stack[--stack_size]];
+                if (!intersects(node.bbox, ray, inverse_direction)) {
+                    continue;
+                }
+                if (node.is_leaf()) {
+                    visitor((size_t) node.light);
+                }
+                else {
+                    stack[stack_size++] = node.left;
+                    stack[stack_size++] = node.right;
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
+
+        struct Primitive {
+            bvh::BoundingBox<Scalar> bbox;
+            Scalar power;
+            uint32_t light;
+        };
+
+        struct Node {
+            bvh::BoundingBox<Scalar> bbox;
+            Scalar power;
+            uint32_t parent;
+            uint32_t left;
+            uint32_t right;
+            uint32_t light;
+
+            bool is_leaf() const { return left == invalid; }
+        };
+
+        struct InfiniteLight {
+            Scalar power;
+            uint32_t light;
+        };
+
+        std::vector<Node> nodes;
+        std::vector<uint32_t> leaves;
+        std::vector<InfiniteLight> infinite_lights;
+
+        Scalar root_importance(const bvh::Vector3<Scalar> &point) const {
+            return nodes.empty() ? Scalar(0) : importance(nodes[0], point);
+        }
+
+        Scalar infinite_power() const {
+            Scalar power = 0;
+            for (auto &infinite_light : infinite_lights) {
+                power += infinite_light.power;
+            }
+            return power;
+        }
+
+        // Slab test.  Axes along which the ray is parallel to a face of the box produce NaNs,
+        // which std::min/std::max discard, so those axes never reject the box:
+        static bool intersects(const bvh::BoundingBox<Scalar> &bbox, const bvh::Ray<Scalar> &ray, const bvh::Vector3<Scalar> &inverse_direction) {
+            Scalar tmin = ray.tmin;
+            Scalar tmax = ray.tmax;
+            for (int axis = 0; axis < 3; ++axis) {
+                Scalar t0 = (bbox.min[axis] - ray.origin[axis]) * inverse_direction[axis];
+                Scalar t1 = (bbox.max[axis] - ray.origin[axis]) * inverse_direction[axis];
+                tmin = std::max(tmin, std::min(t0, t1));
+                tmax = std::min(tmax, std::max(t0, t1));
+            }
+            return tmin <= tmax;
+        }
+
+        Scalar importance(const Node &node, const bvh::Vector3<Scalar> &point) const {
+            auto offset = point - node.bbox.center();
+            auto half_diagonal = node.bbox.diagonal() * Scalar(0.5);
+            Scalar distance_squared = std::max(bvh::dot(offset, offset), bvh::dot(half_diagonal, half_diagonal));
+            return node.power / std::max(distance_squared, std::numeric_limits<Scalar>::min());
+        }
+
+        Scalar left_probability(const Node &parent, const bvh::Vector3<Scalar> &point) const {
+            Scalar left  = importance(nodes[parent.left], point);
+            Scalar right = importance(nodes[parent.right], point);
+            return (left + right > 0) ? left / (left + right) : Scalar(0.5);
+        }
+
+        // Split the lights in [begin, end) at the median of their centers along the widest axis:
+        uint32_t build(std::vector<Primitive> &primitives, size_t begin, size_t end, uint32_t parent) {
+            uint32_t index = (uint32_t) nodes.size();
+            nodes.push_back(Node{bvh::BoundingBox<Scalar>::empty(), 0, parent, invalid, invalid, invalid});
+
+            auto bbox = bvh::BoundingBox<Scalar>::empty();
+            auto center_bbox = bvh::BoundingBox<Scalar>::empty();
+            Scalar power = 0;
+            for (size_t i = begin; i < end; ++i) {
+                bbox.extend(primitives[i].bbox);
+                center_bbox.extend(primitives[i].bbox.center());
+                power += primitives[i].power;
+            }
+            nodes[index].bbox = bbox;
+            nodes[index].power = power;
+
+            if (end - begin == 1) {
+                nodes[index].light = primitives[begin].light;
+                leaves[primitives[begin].light] = index;
+                return index;
+            }
+
+            size_t axis = center_bbox.largest_axis();
+            size_t middle = begin + (end - begin)/2;
+            std::nth_element(primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end,
+                             [axis](const Primitive &a, const Primitive &b) { return a.bbox.center()[axis] < b.bbox.center()[axis]; });
+
+            uint32_t left  = build(primitives, begin, middle, index);
+            uint32_t right = build(primitives, middle, end, index);
+            nodes[index].left  = left;
+            nodes[index].right = right;
+            return index;
+        }
+};
+
+// Call visitor(light, selection_probability) for each light sample to take at point.  When
+// light_samples is zero every light is sampled once, otherwise light_samples lights are drawn from
+// the tree, and selection_probability is the expected number of times the light is drawn:
+template <typename Scalar, typename Generator, typename Visitor>
+void for_each_light_sample(const LightTree<Scalar> &light_tree, int light_samples, const bvh::Vector3<Scalar> &point,
+                           Generator &generator, Visitor &&visitor) {
+    if (light_samples <= 0) {
+        for (size_t light = 0; light < light_tree.size(); ++light) {
+            visitor(light, Scalar(1));
+        }
+        return;
+    }
+    if (light_tree.size() == 0) {
+        return;
+    }
+    std::uniform_real_distribution<Scalar> distr(0.0, 1.0);
+    for (int sample = 0; sample < light_samples; ++sample) {
+        auto selection = light_tree.sample(point, distr(generator));
+        visitor(selection.light, selection.pmf * light_samples);
+    }
+}
+
+// Expected number of times for_each_light_sample() visits light at point:
+template <typename Scalar>
+Scalar light_selection_probability(const LightTree<Scalar> &light_tree, int light_samples, const bvh::Vector3<Scalar> &point, size_t light) {
+    return light_samples <= 0 ? Scalar(1) : light_samples * light_tree.pmf(point, light);
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __LIGHT_VARIANT_H
+#define __LIGHT_VARIANT_H
+
+#include <optional>
+#include <variant>
+#include <vector>
+
+#include "lights/light.hpp"
+#include "lights/point_light.hpp"
+#include "lights/area_light.hpp"
+#include "lights/sun_light.hpp"
+
+// Closed set of light types that can be placed in a scene.  Lights are stored by value in a
+// contiguous std::vector and dispatched with std::visit, so sampling them is inlinable:
+template <typename Scalar>
+using LightVariant = std::variant<PointLight<Scalar>, AreaLight<Scalar>, SunLight<Scalar>>;
+
+template <typename Scalar>
+inline LightSample<Scalar> sample_light(const LightVariant<Scalar> &light, const bvh::Vector3<Scalar> &origin, Scalar r1, Scalar r2) {
+    return std::visit([&](const auto &l) { return l.sample(origin, r1, r2); }, light);
+}
+
+template <typename Scalar>
+inline bvh::BoundingBox<Scalar> light_bounding_box(const LightVariant<Scalar> &light) {
+    return std::visit([&](const auto &l) { return l.bounding_box(); }, light);
+}
+
+// Lights at infinite distance, whose contribution does not depend on the position of the shaded point:
+template <typename Scalar>
+inline bool light_is_infinite(const LightVariant<Scalar> &light) {
+    return std::visit([&](const auto &l) { return l.is_infinite(); }, light);
+}
+
+template <typename Scalar>
+inline Scalar light_power(const LightVariant<Scalar> &light) {
+    return std::visit([&](const auto &l) { return l.intensity; }, light);
+}
+
+template <typename Scalar>
+inline std::optional<LightHit<Scalar>> intersect_light(const LightVariant<Scalar> &light, const bvh::Ray<Scalar> &ray) {
+    return std::visit([&](const auto &l) { return l.intersect(ray); }, light);
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <bvh/bvh.hpp>
 
+#include "lights/light.hpp"
+
 template <typename Scalar>
 class PointLight: public Light<Scalar>  {
     public:
@@ -29,13 +31,25 @@ class PointLight: public Light<Scalar>  {
             this -> rotation[2][2] = 1;
         }
 
-        bvh::Ray<Scalar> sample_ray(bvh::Vector3<Scalar> origin){
+        LightSample<Scalar> sample(bvh::Vector3<Scalar> origin, Scalar r1, Scalar r2) const {
             bvh::Vector3<Scalar> light_direction = bvh::normalize(this->position - origin);
-            return bvh::Ray<Scalar>(origin, light_direction, 0, bvh::length(this->position - origin));
+            Scalar distance_squared = bvh::dot(origin - this->position, origin - this->position);
+            Scalar intensity = std::min(this->intensity / distance_squared, Scalar(10000));
+            return LightSample<Scalar>{bvh::Ray<Scalar>(origin, light_direction, 0, std::sqrt(distance_squared)),
+                                       intensity, intensity, 1, true};
+        };
+
+        bvh::BoundingBox<Scalar> bounding_box() const {
+            return bvh::BoundingBox<Scalar>(this->position);
+        };
+
+        bool is_infinite() const {
+            return false;
         };
 
-        Scalar get_intensity(bvh::Vector3<Scalar> point) { 
-            return std::min(this->intensity / bvh::dot(point - this->position, point - this->position), Scalar(10000));
+        // Point lights have no area, so rays can never hit them:
+        std::optional<LightHit<Scalar>> intersect(const bvh::Ray<Scalar> &ray) const {
+            return std::nullopt;
         };
 };
 
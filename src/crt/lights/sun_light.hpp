@@ -0,0 +1,99 @@
+#ifndef __SUN_LIGHT_H
+#define __SUN_LIGHT_H
+
+#include <cmath>
+#include <limits>
+
+#include <bvh/bvh.hpp>
+
+#include "lights/light.hpp"
+
+// Light at infinite distance in the direction of its position (as seen from the origin of the
+// scene), such as the Sun.  intensity is the irradiance delivered to a surface facing the light,
+// and does not fall off with distance.  The light is a disk of uniform radiance subtending
+// angular_radius; directions are sampled uniformly over the cone it covers, and shadow rays
+// extend to infinity.  An angular_radius of zero gives a purely directional (delta) light:
+template <typename Scalar>
+class SunLight: public Light<Scalar> {
+    public:
+        Scalar angular_radius;
+
+        // The mean angular radius of the Sun as seen from 1 AU:
+        static constexpr Scalar solar_angular_radius = Scalar(0.004653);
+
+        SunLight(Scalar intensity, Scalar angular_radius = solar_angular_radius) {
+            this -> intensity = intensity;
+            this -> angular_radius = angular_radius;
+
+            // Default pose information (Sun along the +z axis):
+            this -> position = bvh::Vector3<Scalar>(0,0,1);
+        };
+
+        LightSample<Scalar> sample(bvh::Vector3<Scalar> origin, Scalar r1, Scalar r2) const {
+            auto sun_direction = direction();
+            if (angular_radius <= 0) {
+                return LightSample<Scalar>{bvh::Ray<Scalar>(origin, sun_direction), this->intensity, this->intensity, 1, true};
+            }
+
+            // Uniformly sample the cone subtended by the solar disk:
+            Scalar cos_max = std::cos(angular_radius);
+            Scalar cos_theta = 1 - r1*(1 - cos_max);
+            Scalar sin_theta = std::sqrt(std::max(Scalar(0), 1 - cos_theta*cos_theta));
+            Scalar phi = 2*M_PI*r2;
+            bvh::Vector3<Scalar> x_axis, y_axis;
+            orthonormal_basis(sun_direction, x_axis, y_axis);
+            auto light_direction = bvh::normalize(sin_theta*std::cos(phi)*x_axis + sin_theta*std::sin(phi)*y_axis + cos_theta*sun_direction);
+
+            LightSample<Scalar> light_sample{bvh::Ray<Scalar>(origin, light_direction), this->intensity};
+            light_sample.radiance = radiance();
+            light_sample.pdf = pdf();
+            light_sample.delta = false;
+            return light_sample;
+        };
+
+        // Rays within the solar disk reach the light at infinity:
+        std::optional<LightHit<Scalar>> intersect(const bvh::Ray<Scalar> &ray) const {
+            if (angular_radius <= 0) {
+                return std::nullopt;
+            }
+            if (bvh::dot(bvh::normalize(ray.direction), direction()) < std::cos(angular_radius)) {
+                return std::nullopt;
+            }
+            return LightHit<Scalar>{std::numeric_limits<Scalar>::infinity(), radiance(), pdf()};
+        };
+
+        bvh::BoundingBox<Scalar> bounding_box() const {
+            return bvh::BoundingBox<Scalar>::full();
+        };
+
+        bool is_infinite() const {
+            return true;
+        };
+
+        bvh::Vector3<Scalar> direction() const {
+            return bvh::normalize(this->position);
+        };
+
+        // Radiance of the disk that produces an irradiance of intensity at normal incidence:
+        Scalar radiance() const {
+            Scalar sin_radius = std::sin(angular_radius);
+            return this->intensity / (M_PI * sin_radius*sin_radius);
+        };
+
+        Scalar pdf() const {
+            return 1 / (2*M_PI*(1 - std::cos(angular_radius)));
+        };
+
+    private:
+        static void orthonormal_basis(const bvh::Vector3<Scalar> &n, bvh::Vector3<Scalar> &x_axis, bvh::Vector3<Scalar> &y_axis) {
+            if (std::abs(n[0]) > std::abs(n[1])) {
+                x_axis = bvh::normalize(bvh::Vector3<Scalar>(-n[2], 0, n[0]));
+            }
+            else {
+                x_axis = bvh::normalize(bvh::Vector3<Scalar>(0, n[2], -n[1]));
+            }
+            y_axis = bvh::cross(n, x_axis);
+        };
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef __LEVEL_OF_DETAIL_H
+#define __LEVEL_OF_DETAIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/triangle.hpp>
+
+#include "transform.hpp"
+#include "statistics.hpp"
+#include "cameras/camera.hpp"
+#include "lod/simplify.hpp"
+
+// A decimated copy of an entity's triangles, and the largest distance between it and the full
+// mesh, in the entity's own units:
+template <typename Scalar>
+struct LevelOfDetail {
+    std::vector<bvh::Triangle<Scalar>> triangles;
+    Scalar error;
+};
+
+// Chain of successively coarser levels, each with about a quarter of the triangles of the one
+// before, stopping after max_levels or once a level would drop below min_triangles.  Every level is
+// simplified from the previous one, so its error is the sum of the errors along the chain:
+template <typename Scalar>
+std::vector<LevelOfDetail<Scalar>> generate_lod_chain(const std::vector<bvh::Triangle<Scalar>> &triangles,
+                                                      size_t max_levels, size_t min_triangles){
+    std::vector<LevelOfDetail<Scalar>> levels;
+    const std::vector<bvh::Triangle<Scalar>> *previous = &triangles;
+    Scalar error = 0;
+    while (levels.size() < max_levels && previous->size() / 4 >= std::max(min_triangles, (size_t) 1)) {
+        auto simplified = simplify_mesh(*previous, previous->size() / 4);
+
+        // Stop when locked boundaries or seams keep the simplifier from making progress:
+        if (simplified.triangles.size() > previous->size() / 2) {
+            break;
+        }
+        error += simplified.error;
+        levels.push_back(LevelOfDetail<Scalar>{std::move(simplified.triangles), error});
+        previous = &levels.back().triangles;
+    }
+    return levels;
+}
+
+// Levels of detail are cached in a small binary file next to the model, which is only reused when
+// it was generated from a mesh with the same triangle count and vertex checksum:
+namespace lod_cache {
+    constexpr char magic[4] = {'C', 'R', 'T', 'L'};
+    constexpr uint32_t version = 1;
+
+    template <typename Scalar>
+    double checksum(const std::vector<bvh::Triangle<Scalar>> &triangles){
+        double sum = 0;
+        for (auto &tri : triangles) {
+            sum += (double) tri.p0[0] + 2*(double) tri.p0[1] + 3*(double) tri.p0[2];
+        }
+        return sum;
+    }
+
+    template <typename T>
+    void write(std::ofstream &file, const T &value){
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T read(std::ifstream &file){
+        T value;
+        file.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    template <typename Scalar>
+    void write_vector(std::ofstream &file, const bvh::Vector3<Scalar> &v){
+        for (int i = 0; i < 3; ++i) {
+            write(file, (double) v[i]);
+        }
+    }
+
+    template <typename Scalar>
+    bvh::Vector3<Scalar> read_vector(std::ifstream &file){
+        bvh::Vector3<Scalar> v;
+        for (int i = 0; i < 3; ++i) {
+            v[i] = (Scalar) read<double>(file);
+        }
+        return v;
+    }
+}
+
+template <typename Scalar>
+void save_lod_chain(const std::string &path, const std::vector<bvh::Triangle<Scalar>> &source,
+                    const std::vector<LevelOfDetail<Scalar>> &levels){
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        log_stream() << "    Could not write level of detail cache " << path << "\n";
+        return;
+    }
+    file.write(lod_cache::magic, 4);
+    lod_cache::write(file, lod_cache::version);
+    lod_cache::write(file, (uint64_t) source.size());
+    lod_cache::write(file, lod_cache::checksum(source));
+    lod_cache::write(file, (uint64_t) levels.size());
+    for (auto &level : levels) {
+        lod_cache::write(file, (double) level.error);
+        lod_cache::write(file, (uint64_t) level.triangles.size());
+        for (auto &tri : level.triangles) {
+            lod_cache::write_vector(file, tri.p0);
+            lod_cache::write_vector(file, tri.p1());
+            lod_cache::write_vector(file, tri.p2());
+            lod_cache::write_vector(file, tri.vn0);
+            lod_cache::write_vector(file, tri.vn1);
+            lod_cache::write_vector(file, tri.vn2);
+            for (int k = 0; k < 3; ++k) {
+                lod_cache::write(file, tri.uv[k]);
+                lod_cache::write(file, tri.vc[k]);
+            }
+            lod_cache::write(file, tri.material_id);
+        }
+    }
+}
+
+// Levels read back from a cache file, or nothing when the file is missing, stale or unreadable.
+// Parents are left unset:
+template <typename Scalar>
+std::optional<std::vector<LevelOfDetail<Scalar>>> load_lod_chain(const std::string &path,
+                                                                 const std::vector<bvh::Triangle<Scalar>> &source){
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    char magic[4];
+    file.read(magic, 4);
+    if (!file || !std::equal(magic, magic + 4, lod_cache::magic) ||
+        lod_cache::read<uint32_t>(file) != lod_cache::version ||
+        lod_cache::read<uint64_t>(file) != source.size() ||
+        lod_cache::read<double>(file) != lod_cache::checksum(source)) {
+        return std::nullopt;
+    }
+
+    std::vector<LevelOfDetail<Scalar>> levels(lod_cache::read<uint64_t>(file));
+    for (auto &level : levels) {
+        level.error = (Scalar) lod_cache::read<double>(file);
+        level.triangles.resize(lod_cache::read<uint64_t>(file));
+        for (auto &tri : level.triangles) {
+            auto p0 = lod_cache::read_vector<Scalar>(file);
+            auto p1 = lod_cache::read_vector<Scalar>(file);
+            auto p2 = lod_cache::read_vector<Scalar>(file);
+            tri = bvh::Triangle<Scalar>(p0, p1, p2);
+            auto vn0 = lod_cache::read_vector<Scalar>(file);
+            auto vn1 = lod_cache::read_vector<Scalar>(file);
+            auto vn2 = lod_cache::read_vector<Scalar>(file);
+            tri.update_vertex_normals(vn0, vn1, vn2);
+            for (int k = 0; k < 3; ++k) {
+                tri.uv[k] = lod_cache::read<bvh::Vector<float, 2>>(file);
+                tri.vc[k] = lod_cache::read<std::array<float, 3>>(file);
+            }
+            tri.material_id = lod_cache::read<uint32_t>(file);
+        }
+    }
+    if (!file) {
+        return std::nullopt;
+    }
+    return levels;
+}
+
+// Angle subtended by one pixel at the center of a pinhole camera's image.  The finer of the two
+// axes is used, so that no level is ever chosen coarser than either of them allows:
+template <typename Scalar>
+Scalar pixel_angle(const Camera<Scalar> &camera){
+    Scalar pitch = std::min(camera.sensor_size[0] / camera.resolution[0], camera.sensor_size[1] / camera.resolution[1]);
+    return pitch / camera.focal_length;
+}
+
+// Coarsest level of an entity whose error, projected from the point of its bounding sphere nearest
+// to the camera, stays within the entity's lod_tolerance in pixels:
+template <typename Scalar, typename EntityPointer>
+size_t lod_level(const EntityPointer &entity, const Camera<Scalar> &camera){
+    auto center = transform(entity->lod_center, entity->rotation, entity->position, entity->scale);
+    Scalar distance = bvh::length(center - camera.position) - entity->scale*entity->lod_radius;
+    Scalar allowed = entity->lod_tolerance * pixel_angle(camera) * std::max(distance, Scalar(0));
+
+    size_t level = 0;
+    while (level < entity->lods.size() && entity->scale*entity->lods[level].error <= allowed) {
+        level++;
+    }
+    return level;
+}
+
+// Pick a level of detail for every entity that has them, as lod_level().  Returns true when any
+// entity changed level, in which case the scene has to be flattened and its BVH rebuilt:
+template <typename Scalar, typename EntityPointer>
+bool select_lods(const std::vector<EntityPointer> &entities, const Camera<Scalar> &camera){
+    bool changed = false;
+    for (auto entity : entities) {
+        if (entity->lods.empty()) {
+            continue;
+        }
+        size_t level = lod_level(entity, camera);
+        if (level != entity->active_lod) {
+            entity->active_lod = level;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// Levels for a scene traced from several cameras at once: the finest that any of them needs:
+template <typename Scalar, typename EntityPointer>
+bool select_lods(const std::vector<EntityPointer> &entities, const std::vector<std::unique_ptr<Camera<Scalar>>> &cameras){
+    bool changed = false;
+    for (auto entity : entities) {
+        if (entity->lods.empty() || cameras.empty()) {
+            continue;
+        }
+        size_t level = entity->lods.size();
+        for (auto &camera : cameras) {
+            level = std::min(level, lod_level(entity, *camera));
+        }
+        if (level != entity->active_lod) {
+            entity->active_lod = level;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+#endif
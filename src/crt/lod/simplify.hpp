@@ -0,0 +1,348 @@
+#ifndef __SIMPLIFY_H
+#define __SIMPLIFY_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include <bvh/bvh.hpp>
+#include <bvh/triangle.hpp>
+
+// Error quadric of Garland and Heckbert ("Surface Simplification Using Quadric Error Metrics",
+// 1997): the area weighted sum of squared distances from a point to a set of planes, stored as the
+// upper half of a symmetric 4x4 matrix.  Dividing by the total weight gives a mean squared distance:
+template <typename Scalar>
+struct Quadric {
+    Scalar a[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    Scalar weight = 0;
+
+    void add_plane(const bvh::Vector3<Scalar> &n, Scalar d, Scalar w) {
+        a[0] += w*n[0]*n[0]; a[1] += w*n[0]*n[1]; a[2] += w*n[0]*n[2]; a[3] += w*n[0]*d;
+        a[4] += w*n[1]*n[1]; a[5] += w*n[1]*n[2]; a[6] += w*n[1]*d;
+        a[7] += w*n[2]*n[2]; a[8] += w*n[2]*d;
+        a[9] += w*d*d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric &other) {
+        for (int i = 0; i < 10; ++i) {
+            a[i] += other.a[i];
+        }
+        weight += other.weight;
+        return *this;
+    }
+
+    Scalar evaluate(const bvh::Vector3<Scalar> &p) const {
+        Scalar x = p[0], y = p[1], z = p[2];
+        return a[0]*x*x + 2*a[1]*x*y + 2*a[2]*x*z + 2*a[3]*x
+             + a[4]*y*y + 2*a[5]*y*z + 2*a[6]*y
+             + a[7]*z*z + 2*a[8]*z
+             + a[9];
+    }
+};
+
+template <typename Scalar>
+struct SimplifiedMesh {
+    std::vector<bvh::Triangle<Scalar>> triangles;
+
+    // Largest root mean squared distance between a removed vertex's surroundings and the point it
+    // was collapsed onto, which bounds how far the simplified surface strays from the input:
+    Scalar error = 0;
+};
+
+// Reduce a triangle mesh to about target_count triangles by repeatedly collapsing the edge of least
+// quadric error.  Corners are first welded by position and texture coordinates.  Collapses move one
+// end of an edge onto the other (half-edge collapses), so every output vertex is an input vertex
+// and keeps its exact position and texture coordinates.  Vertices on open boundaries and texture
+// seams are never moved, which keeps seams and the outline of open meshes intact, and collapses
+// that would make the mesh non-manifold or flip a triangle are skipped.  Materials, colors and the
+// parent of each remaining triangle are those of the triangle it came from, and vertex normals are
+// recomputed the way the OBJ loader computes them:
+template <typename Scalar>
+SimplifiedMesh<Scalar> simplify_mesh(const std::vector<bvh::Triangle<Scalar>> &triangles, size_t target_count) {
+    using Vector3 = bvh::Vector3<Scalar>;
+
+    SimplifiedMesh<Scalar> result;
+    if (target_count >= triangles.size()) {
+        result.triangles = triangles;
+        return result;
+    }
+
+    // Weld the corners of the triangles into vertices:
+    struct Corner {
+        Scalar p[3];
+        float uv[2];
+
+        bool operator==(const Corner &other) const {
+            return std::memcmp(this, &other, sizeof(Corner)) == 0;
+        }
+    };
+    struct CornerHash {
+        size_t operator()(const Corner &corner) const {
+            size_t hash = 0;
+            const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&corner);
+            for (size_t i = 0; i < sizeof(Corner); ++i) {
+                hash = hash*1099511628211ull ^ bytes[i];
+            }
+            return hash;
+        }
+    };
+
+    std::unordered_map<Corner, uint32_t, CornerHash> vertex_index;
+    std::unordered_map<Corner, uint32_t, CornerHash> position_index;
+    std::vector<Vector3> positions;
+    std::vector<bvh::Vector<float, 2>> uvs;
+    std::vector<uint32_t> position_group;
+    std::vector<std::array<uint32_t, 3>> faces(triangles.size());
+    for (size_t f = 0; f < triangles.size(); ++f) {
+        auto &tri = triangles[f];
+        Vector3 corners[3] = {tri.p0, tri.p1(), tri.p2()};
+        for (int k = 0; k < 3; ++k) {
+            Corner corner;
+            std::memset(&corner, 0, sizeof(Corner));
+            for (int i = 0; i < 3; ++i) {
+                corner.p[i] = corners[k][i];
+            }
+            corner.uv[0] = tri.uv[k][0];
+            corner.uv[1] = tri.uv[k][1];
+            auto inserted = vertex_index.emplace(corner, (uint32_t) positions.size());
+            if (inserted.second) {
+                positions.push_back(corners[k]);
+                uvs.push_back(tri.uv[k]);
+
+                Corner position = corner;
+                position.uv[0] = position.uv[1] = 0;
+                position_group.push_back(position_index.emplace(position, (uint32_t) position_index.size()).first->second);
+            }
+            faces[f][k] = inserted.first->second;
+        }
+    }
+    vertex_index.clear();
+    position_index.clear();
+    size_t vertex_count = positions.size();
+
+    // Triangles that weld down to a line or a point (at the poles of a UV sphere, for example) have
+    // no area, and are dropped rather than left to pin their vertices:
+    std::vector<char> face_alive(faces.size(), 1);
+    size_t face_count = 0;
+    for (size_t f = 0; f < faces.size(); ++f) {
+        auto &face = faces[f];
+        face_alive[f] = face[0] != face[1] && face[1] != face[2] && face[2] != face[0];
+        face_count += face_alive[f];
+    }
+
+    // Vertices of boundary and non-manifold edges (seams included) are locked in place:
+    std::vector<char> locked(vertex_count, 0);
+    {
+        std::unordered_map<uint64_t, uint32_t> edge_faces;
+        for (size_t f = 0; f < faces.size(); ++f) {
+            if (!face_alive[f]) {
+                continue;
+            }
+            auto &face = faces[f];
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = face[k], b = face[(k + 1) % 3];
+                edge_faces[(uint64_t) std::min(a, b) << 32 | std::max(a, b)]++;
+            }
+        }
+        for (auto &[edge, count] : edge_faces) {
+            if (count != 2) {
+                locked[edge >> 32] = 1;
+                locked[edge & 0xffffffffu] = 1;
+            }
+        }
+    }
+
+    // Quadrics are accumulated around the center of the mesh, where they are best conditioned:
+    auto bbox = bvh::BoundingBox<Scalar>::empty();
+    for (auto &p : positions) {
+        bbox.extend(p);
+    }
+    Vector3 origin = bbox.center();
+
+    std::vector<Quadric<Scalar>> quadrics(vertex_count);
+    std::vector<std::vector<uint32_t>> vertex_faces(vertex_count);
+    for (uint32_t f = 0; f < faces.size(); ++f) {
+        if (!face_alive[f]) {
+            continue;
+        }
+        auto &face = faces[f];
+        Vector3 p0 = positions[face[0]] - origin;
+        Vector3 n = bvh::cross(positions[face[1]] - positions[face[0]], positions[face[2]] - positions[face[0]]);
+        Scalar area = bvh::length(n) / 2;
+        if (area > 0) {
+            n = n * (Scalar(1) / (2*area));
+            for (int k = 0; k < 3; ++k) {
+                quadrics[face[k]].add_plane(n, -bvh::dot(n, p0), area);
+            }
+        }
+        for (int k = 0; k < 3; ++k) {
+            vertex_faces[face[k]].push_back(f);
+        }
+    }
+
+    std::vector<char> vertex_alive(vertex_count, 1);
+    std::vector<uint32_t> stamp(vertex_count, 0);
+
+    struct Collapse {
+        Scalar cost;
+        uint32_t from, to;
+        uint32_t from_stamp, to_stamp;
+
+        bool operator>(const Collapse &other) const {
+            return cost > other.cost;
+        }
+    };
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+    auto push = [&] (uint32_t from, uint32_t to) {
+        if (locked[from]) {
+            return;
+        }
+        Quadric<Scalar> q = quadrics[from];
+        q += quadrics[to];
+        Scalar cost = std::max(q.evaluate(positions[to] - origin), Scalar(0));
+        queue.push(Collapse{cost, from, to, stamp[from], stamp[to]});
+    };
+
+    auto neighbors = [&] (uint32_t v, std::vector<uint32_t> &out) {
+        out.clear();
+        for (auto f : vertex_faces[v]) {
+            if (!face_alive[f]) {
+                continue;
+            }
+            for (auto w : faces[f]) {
+                if (w != v) {
+                    out.push_back(w);
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    };
+
+    std::vector<uint32_t> around_a, around_b;
+    for (uint32_t v = 0; v < vertex_count; ++v) {
+        neighbors(v, around_a);
+        for (auto w : around_a) {
+            push(v, w);
+        }
+    }
+
+    while (face_count > target_count && !queue.empty()) {
+        auto collapse = queue.top();
+        queue.pop();
+        uint32_t a = collapse.from, b = collapse.to;
+        if (!vertex_alive[a] || !vertex_alive[b] || stamp[a] != collapse.from_stamp || stamp[b] != collapse.to_stamp) {
+            continue;
+        }
+
+        // The two vertices of an interior edge must share exactly the two vertices opposite it,
+        // or the collapse would pinch the surface:
+        neighbors(a, around_a);
+        neighbors(b, around_b);
+        std::vector<uint32_t> shared;
+        std::set_intersection(around_a.begin(), around_a.end(), around_b.begin(), around_b.end(), std::back_inserter(shared));
+        if (shared.size() != 2) {
+            continue;
+        }
+
+        // Triangles that stay must not flip or collapse to a sliver:
+        bool valid = true;
+        for (auto f : vertex_faces[a]) {
+            auto &face = faces[f];
+            if (!face_alive[f] || face[0] == b || face[1] == b || face[2] == b) {
+                continue;
+            }
+            Vector3 p[3], q[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = positions[face[k]];
+                q[k] = face[k] == a ? positions[b] : p[k];
+            }
+            Vector3 before = bvh::cross(p[1] - p[0], p[2] - p[0]);
+            Vector3 after  = bvh::cross(q[1] - q[0], q[2] - q[0]);
+            if (bvh::dot(before, after) <= Scalar(0.2)*bvh::length(before)*bvh::length(after)) {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid) {
+            continue;
+        }
+
+        // Collapse a onto b:
+        for (auto f : vertex_faces[a]) {
+            if (!face_alive[f]) {
+                continue;
+            }
+            auto &face = faces[f];
+            if (face[0] == b || face[1] == b || face[2] == b) {
+                face_alive[f] = 0;
+                face_count--;
+                continue;
+            }
+            for (auto &v : face) {
+                if (v == a) {
+                    v = b;
+                }
+            }
+            vertex_faces[b].push_back(f);
+        }
+        vertex_faces[a].clear();
+        vertex_faces[a].shrink_to_fit();
+        auto &faces_b = vertex_faces[b];
+        faces_b.erase(std::remove_if(faces_b.begin(), faces_b.end(), [&] (uint32_t f) { return !face_alive[f]; }), faces_b.end());
+
+        Scalar weight = quadrics[a].weight + quadrics[b].weight;
+        if (weight > 0) {
+            result.error = std::max(result.error, std::sqrt(collapse.cost / weight));
+        }
+        quadrics[b] += quadrics[a];
+        vertex_alive[a] = 0;
+        stamp[b]++;
+
+        neighbors(b, around_b);
+        for (auto w : around_b) {
+            push(b, w);
+            push(w, b);
+        }
+    }
+
+    // Rebuild the triangles, with smooth normals averaged over the faces sharing each position:
+    std::vector<Vector3> normals(*std::max_element(position_group.begin(), position_group.end()) + 1, Vector3(0, 0, 0));
+    for (size_t f = 0; f < faces.size(); ++f) {
+        if (!face_alive[f]) {
+            continue;
+        }
+        auto &face = faces[f];
+        auto &source = triangles[f];
+        bvh::Triangle<Scalar> tri(positions[face[0]], positions[face[1]], positions[face[2]]);
+        tri.add_vertex_uv(uvs[face[0]], uvs[face[1]], uvs[face[2]]);
+        for (int k = 0; k < 3; ++k) {
+            tri.vc[k] = source.vc[k];
+            normals[position_group[face[k]]] += tri.n;
+        }
+        tri.parent = source.parent;
+        tri.material_id = source.material_id;
+        result.triangles.push_back(tri);
+    }
+    for (auto &n : normals) {
+        n = bvh::normalize(n);
+    }
+    size_t t = 0;
+    for (size_t f = 0; f < faces.size(); ++f) {
+        if (face_alive[f]) {
+            auto &face = faces[f];
+            result.triangles[t++].update_vertex_normals(normals[position_group[face[0]]], normals[position_group[face[1]]],
+                                                        normals[position_group[face[2]]]);
+        }
+    }
+    return result;
+}
+
+#endif
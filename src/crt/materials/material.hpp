@@ -1,156 +1,143 @@
 #ifndef __MATERIAL_H
 #define __MATERIAL_H
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
 #include <vector>
 #include <random>
-
-#include "lodepng/lodepng.h"
+#include <variant>
 
 #include "bvh/triangle.hpp"
 #include "bvh/vector.hpp"
 
 #include "brdfs.hpp"
-
-using Color = bvh::Vector3<float>;
+#include "texture.hpp"
+#include "tiled_texture.hpp"
 
 static Color inline clamp_color(Color c) {
     return(Color(std::clamp(c[0], 0.f, 1.f), std::clamp(c[1], 0.f, 1.f), std::clamp(c[2], 0.f, 1.f)));
 }
 
-template <typename Value>
-class UVMap {
-    public:
-    virtual Value operator()(float u, float v) = 0;
-};
-
-template <typename Value>
-class ConstantUVMap : public  UVMap<Value> {
-    private:
-    Value val;
-   
-    public:
-    ConstantUVMap(Value val) : val(val) { }
-    Value operator()(float u, float v) { return val; };
-};
+// Textures are either fully resident (Texture) or paged in from a tiled file (TiledTexture):
+using TextureVariant = std::variant<std::shared_ptr<const Texture>, std::shared_ptr<const TiledTexture>>;
 
-class ImageUVMap : public UVMap<Color> {
-    private:
-
-    unsigned int width;
-    unsigned int height;
-    std::vector<uint8_t> pixels;
- 
-    public:
-    ImageUVMap(std::string path) { 
-        unsigned error = lodepng::decode(pixels, width, height, path);
-        if(error) std::cout << "decoder error " << error << ": " << lodepng_error_text(error) << std::endl;
-     }
- 
-    Color operator()(float u, float v) {
-        size_t x = (size_t)(u * width + 0.5);
-        size_t y = (size_t)(v * height + 0.5);
-
-        size_t idx = 4 * width * y + 4 * x;
-
-        return Color(
-            pixels[idx+0] / 255.f,
-            pixels[idx+1] / 255.f,
-            pixels[idx+2] / 255.f
-        );
-    };
-};
+// Filtered lookup of a sample covering footprint units of (u,v) space (see SurfacePoint::footprint):
+inline Color sample_texture(const TextureVariant &texture, float u, float v, float footprint = 0) {
+    return std::visit([&](const auto &t) { return t->sample_trilinear(u, v, footprint); }, texture);
+}
 
-class ImageIndexUVMap : public UVMap<size_t> {
-    private:
-    size_t range;
-    ImageUVMap internal;
-    
-    public:
-    ImageIndexUVMap(std::string path, size_t range = 1) : range(range), internal(path) { }
-    
-    size_t operator()(float u, float v) {
-        return (size_t)(internal(u, v)[0] * range + 0.5);
-    };
-};
+// Open the texture at path, choosing the backend from the file extension (.crtt files are tiled):
+inline TextureVariant open_texture(const std::string &path) {
+    const std::string extension = ".crtt";
+    if (path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+        return load_tiled_texture(path);
+    }
+    return load_texture(path);
+}
 
+// A direction sampled from a material's BSDF.  weight is f*cos/pdf, and pdf is the solid angle
+// density of the sample, or zero for perfectly specular (delta) reflection:
 template <typename Scalar>
-class Material {
-    public:
-    virtual Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) = 0;
-    virtual std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) = 0;
-    
-    Color get(bvh::Ray<Scalar> light_ray, bvh::Vector3<Scalar> normal, float u, float v) {
-        std::cout << "hello from inside materials\n";
-        return this->compute(light_ray, light_ray, normal, u, v);
-    };
-
+struct BsdfSample {
+    bvh::Vector3<Scalar> direction;
+    Color weight;
+    Scalar pdf;
 };
 
+// Materials are plain value types with no virtual functions and no internal state that changes
+// while rendering.  Any randomness needed by sample() is drawn by the caller and passed in as
+// (r1, r2), so a single material can be shared by every rendering thread.  All of the material
+// types are collected into the closed MaterialVariant below, and dispatched with std::visit.
+//
+// compute() and sample() are used by the unidirectional integrator.  evaluate(), pdf() and
+// sample_bsdf() describe the physically based BSDF used by the MIS integrator; wi points towards
+// the light, wo towards the viewer, and normal is the left-handed normal used everywhere else.
+// Textures are sampled over footprint units of (u,v) space around (u, v):
+
 template <typename Scalar>
-class ColoredLambertianMaterial : public Material<Scalar> {
+class ColoredLambertianMaterial {
     private:
     Color c;
-    std::minstd_rand eng;
-    std::uniform_real_distribution<Scalar> d;
     
     public:
-    ColoredLambertianMaterial(Color color) : c(color), eng(std::random_device()()), d(0.0, 1.0) { }
+    ColoredLambertianMaterial(Color color) : c(color) { }
 
-    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
+    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
         auto L_dot_N = -bvh::dot(light_ray.direction, normal);
         return c * (float)(L_dot_N);
     }
 
-    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
-        auto r1 = d(eng);
-        auto r2 = d(eng);
+    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                                  Scalar r1, Scalar r2) const {
         auto dir = cosine_importance(normal, r1, r2);
         return std::make_pair(dir, (float)(1-r1)*Color(1));
     }
+
+    Color evaluate(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
+        return -bvh::dot(wi, normal) > 0 ? c * float(M_1_PI) : Color(0);
+    }
+
+    Scalar pdf(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal) const {
+        return std::max(-bvh::dot(wi, normal), Scalar(0)) * M_1_PI;
+    }
+
+    BsdfSample<Scalar> sample_bsdf(const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                   Scalar r1, Scalar r2, float footprint = 0) const {
+        auto dir = cosine_importance(normal, r1, r2);
+        return BsdfSample<Scalar>{dir, c, pdf(dir, wo, normal)};
+    }
 };
 
 template <typename Scalar>
-class TexturedLambertianMaterial : public Material<Scalar> {
+class TexturedLambertianMaterial {
     private:
-    std::shared_ptr<UVMap<Color>> tex_map;
-    std::minstd_rand eng;
-    std::uniform_real_distribution<Scalar> d;
+    TextureVariant tex_map;
    
     public:
-    TexturedLambertianMaterial(std::shared_ptr<UVMap<Color>> texture) 
-    : tex_map(texture), eng(std::random_device()()), d(0.0, 1.0) { }
+    TexturedLambertianMaterial(TextureVariant texture) : tex_map(texture) { }
 
-    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
+    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
         auto L_dot_N = -bvh::dot(light_ray.direction, normal);
-        return (*tex_map)(u, v) * (float)(L_dot_N);
+        return sample_texture(tex_map, u, v, footprint) * (float)(L_dot_N);
     }
 
-    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
-        auto r1 = d(eng);
-        auto r2 = d(eng);
+    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                                  Scalar r1, Scalar r2) const {
         auto dir = cosine_importance(normal, r1, r2);
         return std::make_pair(dir, (float)(1-r1)*Color(1));
     }
+
+    Color evaluate(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
+        return -bvh::dot(wi, normal) > 0 ? sample_texture(tex_map, u, v, footprint) * float(M_1_PI) : Color(0);
+    }
+
+    Scalar pdf(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal) const {
+        return std::max(-bvh::dot(wi, normal), Scalar(0)) * M_1_PI;
+    }
+
+    BsdfSample<Scalar> sample_bsdf(const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                   Scalar r1, Scalar r2, float footprint = 0) const {
+        auto dir = cosine_importance(normal, r1, r2);
+        return BsdfSample<Scalar>{dir, sample_texture(tex_map, u, v, footprint), pdf(dir, wo, normal)};
+    }
 };
 
 template <typename Scalar>
-class TexturedBlinnPhongMaterial : public Material<Scalar> {
+class TexturedBlinnPhongMaterial {
     private:
-    std::shared_ptr<UVMap<Color>> tex_map;
-    std::shared_ptr<UVMap<Color>> spec_map;
+    TextureVariant tex_map;
+    TextureVariant spec_map;
     Scalar alpha;
-    std::minstd_rand eng;
-    std::uniform_real_distribution<Scalar> d;
    
     public:
-    TexturedBlinnPhongMaterial(std::shared_ptr<UVMap<Color>> texture, std::shared_ptr<UVMap<Color>> specular, Scalar alpha = 24) 
-    : tex_map(texture), spec_map(specular), alpha(alpha), eng(std::random_device()()), d(0.0, 1.0) { }
+    TexturedBlinnPhongMaterial(TextureVariant texture, TextureVariant specular, Scalar alpha = 24) 
+    : tex_map(texture), spec_map(specular), alpha(alpha) { }
 
-    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
+    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
         float diffuse = -static_cast<float>(bvh::dot(light_ray.direction, normal));
-        auto color = (*tex_map)(u, v);
-        auto coeffs = (*spec_map)(u, v);
+        auto color = sample_texture(tex_map, u, v, footprint);
+        auto coeffs = sample_texture(spec_map, u, v, footprint);
         auto ka = coeffs[0];
         auto kd = coeffs[1];
         auto ks = coeffs[2];
@@ -158,29 +145,116 @@ class TexturedBlinnPhongMaterial : public Material<Scalar> {
         return clamp_color(color*(ka + kd*diffuse) + ks*spec*Color(1));
     }
 
-    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
-        auto r1 = d(eng);
-        auto r2 = d(eng);
+    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                                  Scalar r1, Scalar r2) const {
         auto dir = cosine_importance(normal, r1, r2);
         return std::make_pair(dir, (float)(1-r1)*Color(1));
     }
+
+    // Energy normalized Blinn-Phong: a diffuse lobe scaled by kd plus a specular lobe scaled by
+    // ks.  The ambient term has no physical counterpart and is left out:
+    Color evaluate(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
+        if (-bvh::dot(wi, normal) <= 0) {
+            return Color(0);
+        }
+        auto color = sample_texture(tex_map, u, v, footprint);
+        auto coeffs = sample_texture(spec_map, u, v, footprint);
+        auto kd = coeffs[1];
+        auto ks = coeffs[2];
+        auto N_dot_H = std::max(-bvh::dot(bvh::normalize(normal), bvh::normalize(wi + wo)), Scalar(0));
+        float spec = static_cast<float>((alpha + 8) / (8*M_PI) * std::pow(N_dot_H, alpha));
+        return color*(kd*float(M_1_PI)) + ks*spec*Color(1);
+    }
+
+    // Directions are drawn from the diffuse lobe only:
+    Scalar pdf(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal) const {
+        return std::max(-bvh::dot(wi, normal), Scalar(0)) * M_1_PI;
+    }
+
+    BsdfSample<Scalar> sample_bsdf(const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                   Scalar r1, Scalar r2, float footprint = 0) const {
+        auto dir = cosine_importance(normal, r1, r2);
+        auto dir_pdf = pdf(dir, wo, normal);
+        if (dir_pdf <= 0) {
+            return BsdfSample<Scalar>{dir, Color(0), 0};
+        }
+        auto weight = evaluate(dir, wo, normal, u, v, footprint) * (float)(-bvh::dot(dir, normal) / dir_pdf);
+        return BsdfSample<Scalar>{dir, weight, dir_pdf};
+    }
 };
 
 template <typename Scalar>
-class MirrorMaterial : public Material<Scalar> {
+class MirrorMaterial {
     private:
     
     public:
     MirrorMaterial() { }
 
-    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
+    Color compute(const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
         return Color(0);
     }
 
-    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v) {
+    std::pair<bvh::Vector3<Scalar>, Color> sample(const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                                  Scalar r1, Scalar r2) const {
         // Is this right?
         return std::make_pair(view_ray.direction - normal * Scalar(2) * bvh::dot(view_ray.direction, normal), Color(1));
     }
+    // Perfect specular reflection is a delta distribution, so it can only be sampled:
+    Color evaluate(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) const {
+        return Color(0);
+    }
+
+    Scalar pdf(const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal) const {
+        return 0;
+    }
+
+    BsdfSample<Scalar> sample_bsdf(const bvh::Vector3<Scalar> &wo, const bvh::Vector3<Scalar> &normal, float u, float v,
+                                   Scalar r1, Scalar r2, float footprint = 0) const {
+        return BsdfSample<Scalar>{-wo + normal * Scalar(2) * bvh::dot(wo, normal), Color(1), 0};
+    }
 };
 
+template <typename Scalar>
+using MaterialVariant = std::variant<ColoredLambertianMaterial<Scalar>,
+                                     TexturedLambertianMaterial<Scalar>,
+                                     TexturedBlinnPhongMaterial<Scalar>,
+                                     MirrorMaterial<Scalar>>;
+
+template <typename Scalar>
+inline Color compute_material(const MaterialVariant<Scalar> &material, const bvh::Ray<Scalar> &light_ray, const bvh::Ray<Scalar> &view_ray,
+                              const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) {
+    return std::visit([&](const auto &m) { return m.compute(light_ray, view_ray, normal, u, v, footprint); }, material);
+}
+
+template <typename Scalar>
+inline std::pair<bvh::Vector3<Scalar>, Color> sample_material(const MaterialVariant<Scalar> &material, const bvh::Ray<Scalar> &view_ray,
+                                                              const bvh::Vector3<Scalar> &normal, float u, float v, Scalar r1, Scalar r2) {
+    return std::visit([&](const auto &m) { return m.sample(view_ray, normal, u, v, r1, r2); }, material);
+}
+
+template <typename Scalar>
+inline Color evaluate_material(const MaterialVariant<Scalar> &material, const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo,
+                               const bvh::Vector3<Scalar> &normal, float u, float v, float footprint = 0) {
+    return std::visit([&](const auto &m) { return m.evaluate(wi, wo, normal, u, v, footprint); }, material);
+}
+
+template <typename Scalar>
+inline Scalar material_pdf(const MaterialVariant<Scalar> &material, const bvh::Vector3<Scalar> &wi, const bvh::Vector3<Scalar> &wo,
+                           const bvh::Vector3<Scalar> &normal) {
+    return std::visit([&](const auto &m) { return m.pdf(wi, wo, normal); }, material);
+}
+
+template <typename Scalar>
+inline BsdfSample<Scalar> sample_material_bsdf(const MaterialVariant<Scalar> &material, const bvh::Vector3<Scalar> &wo,
+                                               const bvh::Vector3<Scalar> &normal, float u, float v, Scalar r1, Scalar r2,
+                                               float footprint = 0) {
+    return std::visit([&](const auto &m) { return m.sample_bsdf(wo, normal, u, v, r1, r2, footprint); }, material);
+}
+
+// Materials whose BSDF is a delta distribution gain nothing from light sampling:
+template <typename Scalar>
+inline bool is_specular_material(const MaterialVariant<Scalar> &material) {
+    return std::holds_alternative<MirrorMaterial<Scalar>>(material);
+}
+
 #endif
\ No newline at end of file
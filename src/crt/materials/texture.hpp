@@ -0,0 +1,202 @@
+#ifndef __TEXTURE_H
+#define __TEXTURE_H
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lodepng/lodepng.h"
+
+#include "bvh/vector.hpp"
+
+using Color = bvh::Vector3<float>;
+
+// How texture coordinates outside of [0,1] are handled:
+enum class WrapMode {
+    Repeat,
+    Clamp
+};
+
+inline int wrap_texel(int coord, int size, WrapMode mode) {
+    if (mode == WrapMode::Clamp) {
+        return std::clamp(coord, 0, size - 1);
+    }
+    coord %= size;
+    return coord < 0 ? coord + size : coord;
+}
+
+// Filtering shared by every texture type.  TextureType must provide level_count(), width(level),
+// height(level) and texel(level, x, y, mode):
+template <typename TextureType>
+Color bilinear_lookup(const TextureType &texture, float u, float v, size_t level, WrapMode mode) {
+    float x = u * texture.width(level) - 0.5f;
+    float y = (1.f - v) * texture.height(level) - 0.5f;
+    float x_floor = std::floor(x);
+    float y_floor = std::floor(y);
+    float fx = x - x_floor;
+    float fy = y - y_floor;
+    int x0 = (int) x_floor;
+    int y0 = (int) y_floor;
+
+    Color top    = (1.f - fx)*texture.texel(level, x0, y0,     mode) + fx*texture.texel(level, x0 + 1, y0,     mode);
+    Color bottom = (1.f - fx)*texture.texel(level, x0, y0 + 1, mode) + fx*texture.texel(level, x0 + 1, y0 + 1, mode);
+    return (1.f - fy)*top + fy*bottom;
+}
+
+// Filtered lookup for a sample covering footprint units of (u,v) space.  The level of detail is
+// chosen so that one texel roughly matches the footprint, and the two nearest levels are blended.
+// A footprint of at most one texel (including 0) is a bilinear lookup of the full resolution level,
+// and the blend leaves a color shared by both levels unchanged:
+template <typename TextureType>
+Color trilinear_lookup(const TextureType &texture, float u, float v, float footprint, WrapMode mode) {
+    size_t level_count = texture.level_count();
+    float lod = std::log2(std::max(footprint * std::max(texture.width(0), texture.height(0)), 1.f));
+    lod = std::min(lod, float(level_count - 1));
+    size_t level = (size_t) lod;
+    float t = lod - level;
+    Color fine = texture.sample_bilinear(u, v, level, mode);
+    if (t == 0.f || level + 1 == level_count) {
+        return fine;
+    }
+    return fine + t*(texture.sample_bilinear(u, v, level + 1, mode) - fine);
+}
+
+// RGB image texture with a full chain of mip levels.  Texels are converted to float once on
+// load (with the same value/255 scaling previously applied on every lookup), and each level is
+// stored in 8x8 texel tiles so that the four texels of a bilinear lookup, and the lookups of
+// neighboring rays, usually fall on the same few cache lines.
+//
+// (u,v) follow the OBJ convention: u increases to the right and v increases upwards, so v = 1 is
+// the first row of the image:
+class Texture {
+    private:
+    static constexpr unsigned tile_bits = 3;
+    static constexpr unsigned tile_size = 1 << tile_bits;
+    static constexpr unsigned tile_mask = tile_size - 1;
+
+    struct Level {
+        unsigned width;
+        unsigned height;
+        unsigned tiles_x;
+        std::vector<Color> texels;
+
+        Level(unsigned width, unsigned height) : width(width), height(height) {
+            tiles_x = (width  + tile_mask) >> tile_bits;
+            unsigned tiles_y = (height + tile_mask) >> tile_bits;
+            texels.resize(size_t(tiles_x)*tiles_y*tile_size*tile_size);
+        }
+
+        size_t index(unsigned x, unsigned y) const {
+            size_t tile = size_t(y >> tile_bits)*tiles_x + (x >> tile_bits);
+            return (tile << (2*tile_bits)) | ((y & tile_mask) << tile_bits) | (x & tile_mask);
+        }
+
+        const Color& operator()(unsigned x, unsigned y) const { return texels[index(x, y)]; }
+        Color& operator()(unsigned x, unsigned y) { return texels[index(x, y)]; }
+    };
+
+    std::vector<Level> levels;
+
+    // Each level is a 2x2 box filtered copy of the previous one, down to a single texel:
+    void build_mip_levels() {
+        while (levels.back().width > 1 || levels.back().height > 1) {
+            const Level &fine = levels.back();
+            Level coarse(std::max(1u, fine.width/2), std::max(1u, fine.height/2));
+            for (unsigned y = 0; y < coarse.height; ++y) {
+                unsigned y0 = std::min(2*y,     fine.height - 1);
+                unsigned y1 = std::min(2*y + 1, fine.height - 1);
+                for (unsigned x = 0; x < coarse.width; ++x) {
+                    unsigned x0 = std::min(2*x,     fine.width - 1);
+                    unsigned x1 = std::min(2*x + 1, fine.width - 1);
+                    coarse(x, y) = 0.25f*(fine(x0, y0) + fine(x1, y0) + fine(x0, y1) + fine(x1, y1));
+                }
+            }
+            levels.push_back(std::move(coarse));
+        }
+    }
+
+    public:
+    // Load a PNG image from disk:
+    Texture(const std::string &path) {
+        std::vector<uint8_t> pixels;
+        unsigned width, height;
+        unsigned error = lodepng::decode(pixels, width, height, path);
+        if (error) {
+            throw std::runtime_error("Failed to load texture " + path + ": " + lodepng_error_text(error));
+        }
+
+        Level base(width, height);
+        for (unsigned y = 0; y < height; ++y) {
+            for (unsigned x = 0; x < width; ++x) {
+                size_t idx = 4*(size_t(width)*y + x);
+                base(x, y) = Color(pixels[idx+0] / 255.f, pixels[idx+1] / 255.f, pixels[idx+2] / 255.f);
+            }
+        }
+        levels.push_back(std::move(base));
+        build_mip_levels();
+    }
+
+    // Create a texture from row-major texel data (first row is v = 1):
+    Texture(unsigned width, unsigned height, const std::vector<Color> &texels) {
+        if (width == 0 || height == 0 || texels.size() != size_t(width)*height) {
+            throw std::invalid_argument("Texture data does not match the provided dimensions");
+        }
+        Level base(width, height);
+        for (unsigned y = 0; y < height; ++y) {
+            for (unsigned x = 0; x < width; ++x) {
+                base(x, y) = texels[size_t(width)*y + x];
+            }
+        }
+        levels.push_back(std::move(base));
+        build_mip_levels();
+    }
+
+    size_t level_count() const { return levels.size(); }
+    unsigned width(size_t level = 0)  const { return levels[level].width; }
+    unsigned height(size_t level = 0) const { return levels[level].height; }
+
+    Color texel(size_t level, int x, int y, WrapMode mode = WrapMode::Repeat) const {
+        const Level &l = levels[level];
+        return l(wrap_texel(x, l.width, mode), wrap_texel(y, l.height, mode));
+    }
+
+    Color sample_nearest(float u, float v, size_t level = 0, WrapMode mode = WrapMode::Repeat) const {
+        const Level &l = levels[level];
+        int x = (int) std::floor(u * l.width);
+        int y = (int) std::floor((1.f - v) * l.height);
+        return texel(level, x, y, mode);
+    }
+
+    Color sample_bilinear(float u, float v, size_t level = 0, WrapMode mode = WrapMode::Repeat) const {
+        return bilinear_lookup(*this, u, v, level, mode);
+    }
+
+    Color sample_trilinear(float u, float v, float footprint, WrapMode mode = WrapMode::Repeat) const {
+        return trilinear_lookup(*this, u, v, footprint, mode);
+    }
+
+    Color operator()(float u, float v) const {
+        return sample_bilinear(u, v);
+    }
+};
+
+// Load a texture, reusing the already decoded copy if the same path is still in use elsewhere:
+inline std::shared_ptr<const Texture> load_texture(const std::string &path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<const Texture>> cache;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto texture = cache[path].lock()) {
+        return texture;
+    }
+    auto texture = std::make_shared<const Texture>(path);
+    cache[path] = texture;
+    return texture;
+}
+
+#endif
@@ -0,0 +1,608 @@
+#ifndef __TILED_TEXTURE_H
+#define __TILED_TEXTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lodepng/lodepng.h"
+
+#include "texture.hpp"
+
+// Textures too large to decode into memory are pre-baked into a tiled file (.crtt), which is then
+// memory-mapped and paged in one tile at a time by TiledTexture.  The file consists of this header
+// followed by every mip level, finest first.  Each level is a row-major grid of square tiles of
+// texels, with partial tiles on the right/bottom edges padded by repeating the last texel.  Texels
+// have 1 (gray) or 3 (RGB) channels, all stored as the same sample format in native byte order:
+struct TiledTextureHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tile_size;
+    uint32_t level_count;
+    uint32_t channels;
+    uint32_t format;
+};
+
+static constexpr char tiled_texture_magic[4] = {'C', 'R', 'T', 'T'};
+static constexpr uint32_t tiled_texture_version = 2;
+
+// Sample formats of a tiled texture.  Integer samples are scaled to [0,1] when sampled, and floating
+// point samples (for instance elevations) are used as they are:
+enum class TexelFormat : uint32_t {
+    UInt8   = 0,
+    UInt16  = 1,
+    Float32 = 2
+};
+
+inline size_t texel_format_size(TexelFormat format) {
+    switch (format) {
+        case TexelFormat::UInt8:   return 1;
+        case TexelFormat::UInt16:  return 2;
+        case TexelFormat::Float32: return 4;
+    }
+    throw std::invalid_argument("Unknown texel format");
+}
+
+// Writes a tiled texture from rows of texels given one at a time, top row first, so that no level
+// is ever held in memory as a whole.  Every mip level is built alongside the full resolution one:
+// each level collects a row of tiles (tile_size rows), which is written to its place in the file as
+// soon as it is complete, and the first of the two rows that are 2x2 box filtered into a row of the
+// next level.  All levels together hold about twice a row of tiles of the full resolution image,
+// whatever its height:
+class TiledTextureBaker {
+    public:
+    TiledTextureBaker(const std::string &output_path, uint32_t width, uint32_t height, uint32_t channels,
+                      TexelFormat format, uint32_t tile_size = 64)
+        : channels(channels), format(format), tile_size(tile_size), output_path(output_path) {
+        if (tile_size == 0) {
+            throw std::invalid_argument("Tile size must be greater than zero");
+        }
+        if (width == 0 || height == 0) {
+            throw std::invalid_argument("Texture dimensions must be greater than zero");
+        }
+        if (channels != 1 && channels != 3) {
+            throw std::invalid_argument("Tiled textures have 1 or 3 channels");
+        }
+        texel_bytes = channels*texel_format_size(format);
+        tile_bytes = texel_bytes*tile_size*tile_size;
+
+        uint64_t offset = sizeof(TiledTextureHeader);
+        for (unsigned w = width, h = height; ; w = std::max(1u, w/2), h = std::max(1u, h/2)) {
+            Level level;
+            level.width = w;
+            level.height = h;
+            level.tiles_x = (w + tile_size - 1)/tile_size;
+            level.offset = offset;
+            level.band.resize(size_t(tile_size)*w*texel_bytes);
+            level.pending.resize(size_t(w)*texel_bytes);
+            level.coarse.resize(size_t(std::max(1u, w/2))*texel_bytes);
+            offset += uint64_t(level.tiles_x)*((h + tile_size - 1)/tile_size)*tile_bytes;
+            levels.push_back(std::move(level));
+            if (w == 1 && h == 1) {
+                break;
+            }
+        }
+        tile.resize(tile_bytes);
+
+        out.open(output_path, std::ios::binary);
+        if (!out) {
+            throw std::runtime_error("Unable to open " + output_path + " for writing");
+        }
+        TiledTextureHeader header;
+        std::memcpy(header.magic, tiled_texture_magic, 4);
+        header.version = tiled_texture_version;
+        header.width = width;
+        header.height = height;
+        header.tile_size = tile_size;
+        header.level_count = (uint32_t) levels.size();
+        header.channels = channels;
+        header.format = (uint32_t) format;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    // Add the next row of the full resolution image, width*channels samples of the texture's format:
+    void add_row(const void *row) {
+        add_row(0, static_cast<const uint8_t*>(row));
+    }
+
+    // Check that every row was given, and that everything was written:
+    void finish() {
+        if (levels[0].rows != levels[0].height) {
+            throw std::invalid_argument("Fewer rows were given than the height of " + output_path);
+        }
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Failed while writing " + output_path);
+        }
+    }
+
+    private:
+    struct Level {
+        unsigned width;
+        unsigned height;
+        unsigned tiles_x;
+        uint64_t offset;
+        std::vector<uint8_t> band;
+        unsigned band_rows = 0;
+        unsigned rows = 0;
+        std::vector<uint8_t> pending;
+        std::vector<uint8_t> coarse;
+    };
+
+    uint32_t channels;
+    TexelFormat format;
+    uint32_t tile_size;
+    size_t texel_bytes;
+    size_t tile_bytes;
+    std::string output_path;
+    std::ofstream out;
+    std::vector<Level> levels;
+    std::vector<uint8_t> tile;
+
+    void add_row(size_t l, const uint8_t *row) {
+        Level &level = levels[l];
+        if (level.rows == level.height) {
+            throw std::invalid_argument("More rows were given than the height of " + output_path);
+        }
+        size_t row_bytes = size_t(level.width)*texel_bytes;
+        std::memcpy(&level.band[level.band_rows*row_bytes], row, row_bytes);
+        unsigned y = level.rows++;
+        if (++level.band_rows == tile_size || level.rows == level.height) {
+            write_band(level);
+        }
+
+        // Rows 2y and 2y + 1 make row y of the next level (so the last row of an odd height is left
+        // out), and a level one row high is filtered with itself:
+        if (l + 1 == levels.size()) {
+            return;
+        }
+        if (level.height == 1) {
+            downsample(row, row, level.width, level.coarse.data());
+        }
+        else if (y % 2 == 0) {
+            std::memcpy(level.pending.data(), row, row_bytes);
+            return;
+        }
+        else {
+            downsample(level.pending.data(), row, level.width, level.coarse.data());
+        }
+        add_row(l + 1, level.coarse.data());
+    }
+
+    // Write the collected rows of a level as a row of tiles:
+    void write_band(Level &level) {
+        unsigned tile_row = (level.rows - 1)/tile_size;
+        out.seekp(level.offset + uint64_t(tile_row)*level.tiles_x*tile_bytes);
+        for (unsigned tx = 0; tx < level.tiles_x; ++tx) {
+            for (unsigned y = 0; y < tile_size; ++y) {
+                const uint8_t *src = &level.band[size_t(std::min(y, level.band_rows - 1))*level.width*texel_bytes];
+                for (unsigned x = 0; x < tile_size; ++x) {
+                    unsigned sx = std::min(tx*tile_size + x, level.width - 1);
+                    std::memcpy(&tile[(size_t(y)*tile_size + x)*texel_bytes], &src[sx*texel_bytes], texel_bytes);
+                }
+            }
+            out.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+        }
+        level.band_rows = 0;
+    }
+
+    void downsample(const uint8_t *row0, const uint8_t *row1, unsigned width, uint8_t *coarse) const {
+        switch (format) {
+            case TexelFormat::UInt8:   downsample<uint8_t>(row0, row1, width, coarse); break;
+            case TexelFormat::UInt16:  downsample<uint16_t>(row0, row1, width, coarse); break;
+            case TexelFormat::Float32: downsample<float>(row0, row1, width, coarse); break;
+        }
+    }
+
+    // 2x2 box filter of two rows into a row of the next level.  Integer samples are rounded:
+    template <typename T>
+    void downsample(const uint8_t *row0, const uint8_t *row1, unsigned width, uint8_t *coarse) const {
+        const T *a = reinterpret_cast<const T*>(row0);
+        const T *b = reinterpret_cast<const T*>(row1);
+        T *c = reinterpret_cast<T*>(coarse);
+        unsigned coarse_width = std::max(1u, width/2);
+        for (unsigned x = 0; x < coarse_width; ++x) {
+            size_t x0 = std::min(2*x,     width - 1)*channels;
+            size_t x1 = std::min(2*x + 1, width - 1)*channels;
+            for (uint32_t k = 0; k < channels; ++k) {
+                if constexpr (std::is_floating_point_v<T>) {
+                    c[x*channels + k] = T(0.25)*(a[x0 + k] + a[x1 + k] + b[x0 + k] + b[x1 + k]);
+                }
+                else {
+                    uint32_t sum = uint32_t(a[x0 + k]) + a[x1 + k] + b[x0 + k] + b[x1 + k];
+                    c[x*channels + k] = (T)((sum + 2)/4);
+                }
+            }
+        }
+    }
+};
+
+// Convert a PNG image into the tiled format, including all of its mip levels.  Gray images (such as
+// 16 bit elevation maps) keep a single channel and their bit depth, and every other image becomes 8
+// bit RGB.  lodepng can only decode the whole image at once, so this needs it in memory (1 to 3
+// bytes per texel); bake_raw_tiled_texture() converts images of any size:
+inline void bake_tiled_texture(const std::string &png_path, const std::string &output_path, uint32_t tile_size = 64) {
+    if (tile_size == 0) {
+        throw std::invalid_argument("Tile size must be greater than zero");
+    }
+
+    std::vector<uint8_t> png;
+    unsigned width, height;
+    lodepng::State state;
+    unsigned error = lodepng::load_file(png, png_path);
+    if (!error) {
+        error = lodepng_inspect(&width, &height, &state, png.data(), png.size());
+    }
+    if (error) {
+        throw std::runtime_error("Failed to load texture " + png_path + ": " + lodepng_error_text(error));
+    }
+    auto color_type = state.info_png.color.colortype;
+    bool gray = color_type == LCT_GREY || color_type == LCT_GREY_ALPHA;
+    bool wide = gray && state.info_png.color.bitdepth == 16;
+
+    std::vector<uint8_t> pixels;
+    error = lodepng::decode(pixels, width, height, png, gray ? LCT_GREY : LCT_RGB, wide ? 16 : 8);
+    if (error) {
+        throw std::runtime_error("Failed to load texture " + png_path + ": " + lodepng_error_text(error));
+    }
+    png.clear();
+    png.shrink_to_fit();
+
+    uint32_t channels = gray ? 1 : 3;
+    TiledTextureBaker baker(output_path, width, height, channels, wide ? TexelFormat::UInt16 : TexelFormat::UInt8, tile_size);
+    size_t row_samples = size_t(width)*channels;
+    std::vector<uint16_t> wide_row(wide ? row_samples : 0);
+    for (unsigned y = 0; y < height; ++y) {
+        if (wide) {
+            // PNG samples are big endian:
+            const uint8_t *src = &pixels[2*row_samples*y];
+            for (size_t i = 0; i < row_samples; ++i) {
+                wide_row[i] = uint16_t((src[2*i] << 8) | src[2*i + 1]);
+            }
+            baker.add_row(wide_row.data());
+        }
+        else {
+            baker.add_row(&pixels[row_samples*y]);
+        }
+    }
+    baker.finish();
+}
+
+// Convert a raw image into the tiled format, including all of its mip levels.  The file holds rows of
+// width*channels samples of the given format in native byte order, top row first, and nothing else
+// (as written by numpy's tofile()).  It is read a row at a time, so images of any size can be
+// converted in a small, fixed amount of memory:
+inline void bake_raw_tiled_texture(const std::string &raw_path, const std::string &output_path, uint32_t width, uint32_t height,
+                                   uint32_t channels, TexelFormat format, uint32_t tile_size = 64) {
+    std::ifstream in(raw_path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Unable to open " + raw_path);
+    }
+    TiledTextureBaker baker(output_path, width, height, channels, format, tile_size);
+    std::vector<char> row(size_t(width)*channels*texel_format_size(format));
+    for (uint32_t y = 0; y < height; ++y) {
+        if (!in.read(row.data(), row.size())) {
+            throw std::runtime_error(raw_path + " is smaller than the given dimensions");
+        }
+        baker.add_row(row.data());
+    }
+    baker.finish();
+}
+
+// Default amount of memory each TiledTexture may use for decoded tiles:
+inline size_t& tiled_texture_cache_budget() {
+    static size_t budget = size_t(256) << 20;
+    return budget;
+}
+
+// Texture backed by a memory-mapped .crtt file.  Tiles are decoded to float on first use and kept
+// in a least recently used cache whose size is bounded by cache_bytes, so textures of any size can
+// be sampled in a fixed amount of memory.  The cache is split into independently locked shards to
+// keep contention low when many rendering threads sample the same texture.  Sampling has the same
+// interface (and the same (u,v) convention) as Texture:
+class TiledTexture {
+    public:
+    struct Statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t resident_tiles = 0;
+        size_t capacity_tiles = 0;
+
+        double hit_rate() const {
+            return (hits + misses) ? double(hits)/double(hits + misses) : 0.;
+        }
+    };
+
+    private:
+    struct Level {
+        unsigned width;
+        unsigned height;
+        unsigned tiles_x;
+        size_t first_tile;
+    };
+
+    struct Tile {
+        std::vector<Color> texels;
+    };
+
+    using TileKey = uint64_t;
+    using TileEntry = std::pair<std::shared_ptr<const Tile>, std::list<TileKey>::iterator>;
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<TileKey> lru;
+        std::unordered_map<TileKey, TileEntry> tiles;
+        size_t capacity;
+    };
+
+    static constexpr size_t shard_count = 16;
+
+    const uint8_t *mapped = nullptr;
+    size_t mapped_size = 0;
+    uint32_t tile_size;
+    uint32_t channels;
+    TexelFormat format;
+    size_t tile_bytes;
+    std::vector<Level> levels;
+
+    std::unique_ptr<Shard[]> shards;
+    size_t capacity_tiles;
+    mutable std::atomic<uint64_t> hits{0};
+    mutable std::atomic<uint64_t> misses{0};
+    mutable std::atomic<uint64_t> evictions{0};
+
+    std::shared_ptr<const Tile> decode_tile(size_t tile_index) const {
+        auto tile = std::make_shared<Tile>();
+        tile->texels.resize(size_t(tile_size)*tile_size);
+        const uint8_t *src = mapped + sizeof(TiledTextureHeader) + tile_index*tile_bytes;
+        switch (format) {
+            case TexelFormat::UInt8:   decode_texels<uint8_t>(src, 255.f, tile->texels); break;
+            case TexelFormat::UInt16:  decode_texels<uint16_t>(src, 65535.f, tile->texels); break;
+            case TexelFormat::Float32: decode_texels<float>(src, 1.f, tile->texels); break;
+        }
+        return tile;
+    }
+
+    // Gray texels are spread to all three channels:
+    template <typename T>
+    void decode_texels(const uint8_t *src, float range, std::vector<Color> &texels) const {
+        T samples[3];
+        for (size_t i = 0; i < texels.size(); ++i) {
+            std::memcpy(samples, src + i*channels*sizeof(T), channels*sizeof(T));
+            if (channels == 1) {
+                texels[i] = Color(samples[0] / range);
+            }
+            else {
+                texels[i] = Color(samples[0] / range, samples[1] / range, samples[2] / range);
+            }
+        }
+    }
+
+    std::shared_ptr<const Tile> fetch(size_t tile_index) const {
+        Shard &shard = shards[tile_index % shard_count];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto found = shard.tiles.find(tile_index);
+            if (found != shard.tiles.end()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, found->second.second);
+                hits++;
+                return found->second.first;
+            }
+        }
+
+        // Decode outside of the lock, so other threads can keep using the shard:
+        auto tile = decode_tile(tile_index);
+        misses++;
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.tiles.find(tile_index);
+        if (found != shard.tiles.end()) {
+            return found->second.first;
+        }
+        while (shard.tiles.size() >= shard.capacity) {
+            shard.tiles.erase(shard.lru.back());
+            shard.lru.pop_back();
+            evictions++;
+        }
+        shard.lru.push_front(tile_index);
+        shard.tiles.emplace(tile_index, TileEntry(tile, shard.lru.begin()));
+        return tile;
+    }
+
+    public:
+    TiledTexture(const std::string &path, size_t cache_bytes = tiled_texture_cache_budget()) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open tiled texture " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(TiledTextureHeader)) {
+            close(fd);
+            throw std::runtime_error(path + " is not a valid tiled texture");
+        }
+        mapped_size = st.st_size;
+        void *ptr = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (ptr == MAP_FAILED) {
+            throw std::runtime_error("Unable to memory map tiled texture " + path);
+        }
+        mapped = static_cast<const uint8_t*>(ptr);
+        madvise(ptr, mapped_size, MADV_RANDOM);
+
+        TiledTextureHeader header;
+        std::memcpy(&header, mapped, sizeof(header));
+        if (std::memcmp(header.magic, tiled_texture_magic, 4) != 0 || header.version != tiled_texture_version ||
+            header.tile_size == 0 || header.width == 0 || header.height == 0 ||
+            (header.channels != 1 && header.channels != 3) || header.format > uint32_t(TexelFormat::Float32)) {
+            munmap(ptr, mapped_size);
+            throw std::runtime_error(path + " is not a valid tiled texture");
+        }
+
+        tile_size = header.tile_size;
+        channels = header.channels;
+        format = TexelFormat(header.format);
+        tile_bytes = channels*texel_format_size(format)*tile_size*tile_size;
+        size_t tile_count = 0;
+        unsigned w = header.width;
+        unsigned h = header.height;
+        for (uint32_t l = 0; l < header.level_count; ++l) {
+            unsigned tiles_x = (w + tile_size - 1)/tile_size;
+            unsigned tiles_y = (h + tile_size - 1)/tile_size;
+            levels.push_back(Level{w, h, tiles_x, tile_count});
+            tile_count += size_t(tiles_x)*tiles_y;
+            w = std::max(1u, w/2);
+            h = std::max(1u, h/2);
+        }
+        if (sizeof(TiledTextureHeader) + tile_count*tile_bytes > mapped_size) {
+            munmap(ptr, mapped_size);
+            throw std::runtime_error(path + " is truncated");
+        }
+
+        // At least four tiles per shard, so a bilinear lookup spanning tiles never evicts itself:
+        size_t decoded_tile_bytes = size_t(tile_size)*tile_size*sizeof(Color);
+        capacity_tiles = std::max(cache_bytes/decoded_tile_bytes, 4*shard_count);
+        shards = std::make_unique<Shard[]>(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards[i].capacity = capacity_tiles/shard_count;
+        }
+    }
+
+    TiledTexture(const TiledTexture&) = delete;
+    TiledTexture& operator=(const TiledTexture&) = delete;
+
+    ~TiledTexture() {
+        if (mapped) {
+            munmap(const_cast<uint8_t*>(mapped), mapped_size);
+        }
+    }
+
+    size_t level_count() const { return levels.size(); }
+    unsigned width(size_t level = 0)  const { return levels[level].width; }
+    unsigned height(size_t level = 0) const { return levels[level].height; }
+
+    Color texel(size_t level, int x, int y, WrapMode mode = WrapMode::Repeat) const {
+        const Level &l = levels[level];
+        unsigned wx = wrap_texel(x, l.width, mode);
+        unsigned wy = wrap_texel(y, l.height, mode);
+        auto tile = fetch(l.first_tile + size_t(wy/tile_size)*l.tiles_x + wx/tile_size);
+        return tile->texels[size_t(wy % tile_size)*tile_size + wx % tile_size];
+    }
+
+    Color sample_nearest(float u, float v, size_t level = 0, WrapMode mode = WrapMode::Repeat) const {
+        const Level &l = levels[level];
+        int x = (int) std::floor(u * l.width);
+        int y = (int) std::floor((1.f - v) * l.height);
+        return texel(level, x, y, mode);
+    }
+
+    // Bilinear lookup that fetches each distinct tile only once (a single tile in the common case):
+    Color sample_bilinear(float u, float v, size_t level = 0, WrapMode mode = WrapMode::Repeat) const {
+        const Level &l = levels[level];
+        float x = u * l.width - 0.5f;
+        float y = (1.f - v) * l.height - 0.5f;
+        float x_floor = std::floor(x);
+        float y_floor = std::floor(y);
+        float fx = x - x_floor;
+        float fy = y - y_floor;
+
+        unsigned xs[2] = {(unsigned) wrap_texel((int) x_floor,     l.width,  mode),
+                          (unsigned) wrap_texel((int) x_floor + 1, l.width,  mode)};
+        unsigned ys[2] = {(unsigned) wrap_texel((int) y_floor,     l.height, mode),
+                          (unsigned) wrap_texel((int) y_floor + 1, l.height, mode)};
+
+        Color texels[2][2];
+        size_t cached_index = SIZE_MAX;
+        std::shared_ptr<const Tile> cached_tile;
+        for (int j = 0; j < 2; ++j) {
+            for (int i = 0; i < 2; ++i) {
+                size_t tile_index = l.first_tile + size_t(ys[j]/tile_size)*l.tiles_x + xs[i]/tile_size;
+                if (tile_index != cached_index) {
+                    cached_tile = fetch(tile_index);
+                    cached_index = tile_index;
+                }
+                texels[j][i] = cached_tile->texels[size_t(ys[j] % tile_size)*tile_size + xs[i] % tile_size];
+            }
+        }
+
+        Color top    = (1.f - fx)*texels[0][0] + fx*texels[0][1];
+        Color bottom = (1.f - fx)*texels[1][0] + fx*texels[1][1];
+        return (1.f - fy)*top + fy*bottom;
+    }
+
+    Color sample_trilinear(float u, float v, float footprint, WrapMode mode = WrapMode::Repeat) const {
+        return trilinear_lookup(*this, u, v, footprint, mode);
+    }
+
+    Color operator()(float u, float v) const {
+        return sample_bilinear(u, v);
+    }
+
+    Statistics statistics() const {
+        Statistics statistics;
+        statistics.hits = hits;
+        statistics.misses = misses;
+        statistics.evictions = evictions;
+        statistics.capacity_tiles = capacity_tiles;
+        for (size_t i = 0; i < shard_count; ++i) {
+            std::lock_guard<std::mutex> lock(shards[i].mutex);
+            statistics.resident_tiles += shards[i].tiles.size();
+        }
+        return statistics;
+    }
+};
+
+// Tiled textures currently in use, by path:
+struct TiledTextureRegistry {
+    std::mutex mutex;
+    std::map<std::string, std::weak_ptr<const TiledTexture>> textures;
+};
+
+inline TiledTextureRegistry& tiled_texture_registry() {
+    static TiledTextureRegistry registry;
+    return registry;
+}
+
+// Open a tiled texture, reusing the already mapped copy if the same path is still in use elsewhere:
+inline std::shared_ptr<const TiledTexture> load_tiled_texture(const std::string &path) {
+    auto &registry = tiled_texture_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (auto texture = registry.textures[path].lock()) {
+        return texture;
+    }
+    auto texture = std::make_shared<const TiledTexture>(path);
+    registry.textures[path] = texture;
+    return texture;
+}
+
+// Cache statistics of the tiled texture loaded from path:
+inline TiledTexture::Statistics tiled_texture_statistics(const std::string &path) {
+    auto &registry = tiled_texture_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto found = registry.textures.find(path);
+    if (found != registry.textures.end()) {
+        if (auto texture = found->second.lock()) {
+            return texture->statistics();
+        }
+    }
+    throw std::invalid_argument("No tiled texture is loaded from " + path);
+}
+
+#endif
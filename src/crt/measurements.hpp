@@ -0,0 +1,256 @@
+#ifndef __MEASUREMENTS_H
+#define __MEASUREMENTS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <variant>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+
+#include "cameras/camera.hpp"
+#include "lights/light_variant.hpp"
+#include "acceleration/closest_hit_traverser.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+#include "statistics.hpp"
+#include "acceleration/scene_primitives.hpp"
+#include "path_tracing/ray_offset.hpp"
+
+// Reductions of an image used for optical navigation, for one entity (identified by the id that
+// instance_pass() reports).  Pixels are given as (column, row):
+template <typename Scalar>
+struct EntityMeasurements {
+    uint32_t id;
+
+    // Number of pixels the entity covers, and the sum of their brightness (the mean of the red,
+    // green and blue radiance, or 1 per pixel when no image was rendered):
+    size_t pixel_count = 0;
+    double brightness = 0;
+
+    // Brightness weighted mean pixel position (center of brightness), NaN when the entity is dark:
+    double centroid[2];
+
+    // Smallest and largest column and row covered by the entity:
+    uint32_t bounding_box[4];
+
+    // Pixels of the entity next to a pixel of something else (the limb), and lit pixels of the
+    // entity next to unlit pixels of it (the terminator), both sorted by row and then column.
+    // Neighbours are the four adjacent pixels, and pixels outside the image are not neighbours, so
+    // the image border is never reported as a limb:
+    std::vector<std::array<uint32_t, 2>> limb;
+    std::vector<std::array<uint32_t, 2>> terminator;
+};
+
+// Shadow ray from origin toward the center of a light.  The middle of an area light is at r1 = r2 = 0.5,
+// but a sun light samples the cone of its disk from the center outwards, so its center is at r1 = 0:
+template <typename Scalar>
+bvh::Ray<Scalar> light_center_ray(const LightVariant<Scalar> &light, const bvh::Vector3<Scalar> &origin) {
+    if (auto sun = std::get_if<SunLight<Scalar>>(&light)) {
+        return sun->sample(origin, Scalar(0), Scalar(0)).ray;
+    }
+    return sample_light(light, origin, Scalar(0.5), Scalar(0.5)).ray;
+}
+
+// Computes EntityMeasurements while an image is traced.  The image is split into tiles of whole
+// columns.  For each tile, the entity and illumination of every pixel are found with one primary
+// ray (and a shadow ray per light), together with a column of neighbours on either side, so limb
+// and terminator pixels are found without a pass over the full frame.  Results are summed into one
+// Accumulator per thread and merged once at the end.
+//
+// A pixel is lit when the center of any light is above its surface and unoccluded, which places
+// the terminator where the geometry puts it rather than where sampling noise does:
+template <typename Scalar>
+class ImageMeasurer {
+    public:
+        static constexpr size_t tile_width = 16;
+
+        struct Partial {
+            size_t pixel_count = 0;
+            double weight = 0, weighted_u = 0, weighted_v = 0;
+            uint32_t bounding_box[4] = {std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max(), 0, 0};
+            std::vector<std::array<uint32_t, 2>> limb;
+            std::vector<std::array<uint32_t, 2>> terminator;
+        };
+
+        // Partial measurements of each entity, by id:
+        using Accumulator = std::map<uint32_t, Partial>;
+
+        ImageMeasurer(Camera<Scalar> &camera, const std::vector<LightVariant<Scalar>> &lights,
+                      const ScenePrimitives<Scalar> &primitives, const ClosestHitTraverser<Scalar> &closest_traverser,
+                      const OcclusionTraverser<Scalar> &occlusion_traverser)
+            : camera(camera), lights(lights), primitives(primitives),
+              closest_traverser(closest_traverser), occlusion_traverser(occlusion_traverser) {
+            width  = (size_t) floor(camera.get_resolutionX());
+            height = (size_t) floor(camera.get_resolutionY());
+        }
+
+        size_t tile_count() const {
+            return (width + tile_width - 1) / tile_width;
+        }
+
+        size_t tile_begin(size_t tile) const {
+            return tile * tile_width;
+        }
+
+        size_t tile_end(size_t tile) const {
+            return std::min(width, (tile + 1) * tile_width);
+        }
+
+        // Measure the columns of a tile.  pixels is the RGBA radiance of the whole image, of which
+        // only the tile's columns are read, or nullptr to weigh every pixel equally:
+        void measure(size_t tile, const float *pixels, Accumulator &accumulator) const {
+            BusyTimer busy;
+            size_t begin = tile_begin(tile);
+            size_t end = tile_end(tile);
+            size_t first = begin > 0 ? begin - 1 : 0;
+            size_t last = std::min(width, end + 1);
+
+            std::vector<Label> labels((last - first) * height);
+            for (size_t i = first; i < last; ++i) {
+                for (size_t j = 0; j < height; ++j) {
+                    labels[(i - first) * height + j] = label(i, j);
+                }
+            }
+            auto at = [&] (size_t i, size_t j) -> const Label& {
+                return labels[(i - first) * height + j];
+            };
+
+            for (size_t i = begin; i < end; ++i) {
+                for (size_t j = 0; j < height; ++j) {
+                    auto &pixel = at(i, j);
+                    if (pixel.id == 0) {
+                        continue;
+                    }
+                    auto &partial = accumulator[pixel.id];
+                    double weight = 1;
+                    if (pixels) {
+                        auto radiance = pixels + 4 * (width * j + i);
+                        weight = (radiance[0] + radiance[1] + radiance[2]) / 3.0;
+                    }
+                    partial.pixel_count++;
+                    partial.weight += weight;
+                    partial.weighted_u += weight * i;
+                    partial.weighted_v += weight * j;
+                    partial.bounding_box[0] = std::min(partial.bounding_box[0], (uint32_t) i);
+                    partial.bounding_box[1] = std::min(partial.bounding_box[1], (uint32_t) j);
+                    partial.bounding_box[2] = std::max(partial.bounding_box[2], (uint32_t) i);
+                    partial.bounding_box[3] = std::max(partial.bounding_box[3], (uint32_t) j);
+
+                    bool limb = false;
+                    bool terminator = false;
+                    auto neighbour = [&] (size_t ni, size_t nj) {
+                        auto &other = at(ni, nj);
+                        limb |= other.id != pixel.id;
+                        terminator |= other.id == pixel.id && pixel.lit && !other.lit;
+                    };
+                    if (i > 0)          neighbour(i - 1, j);
+                    if (i + 1 < width)  neighbour(i + 1, j);
+                    if (j > 0)          neighbour(i, j - 1);
+                    if (j + 1 < height) neighbour(i, j + 1);
+                    if (limb) {
+                        partial.limb.push_back({(uint32_t) i, (uint32_t) j});
+                    }
+                    if (terminator) {
+                        partial.terminator.push_back({(uint32_t) i, (uint32_t) j});
+                    }
+                }
+            }
+        }
+
+        static void merge(const Accumulator &from, Accumulator &into) {
+            for (auto &[id, partial] : from) {
+                auto &total = into[id];
+                total.pixel_count += partial.pixel_count;
+                total.weight += partial.weight;
+                total.weighted_u += partial.weighted_u;
+                total.weighted_v += partial.weighted_v;
+                total.bounding_box[0] = std::min(total.bounding_box[0], partial.bounding_box[0]);
+                total.bounding_box[1] = std::min(total.bounding_box[1], partial.bounding_box[1]);
+                total.bounding_box[2] = std::max(total.bounding_box[2], partial.bounding_box[2]);
+                total.bounding_box[3] = std::max(total.bounding_box[3], partial.bounding_box[3]);
+                total.limb.insert(total.limb.end(), partial.limb.begin(), partial.limb.end());
+                total.terminator.insert(total.terminator.end(), partial.terminator.begin(), partial.terminator.end());
+            }
+        }
+
+        // Measurements of every entity seen, in order of id:
+        static std::vector<EntityMeasurements<Scalar>> finish(Accumulator &accumulator) {
+            auto by_row = [] (const std::array<uint32_t, 2> &a, const std::array<uint32_t, 2> &b) {
+                return a[1] != b[1] ? a[1] < b[1] : a[0] < b[0];
+            };
+            std::vector<EntityMeasurements<Scalar>> measurements;
+            for (auto &[id, partial] : accumulator) {
+                EntityMeasurements<Scalar> entity;
+                entity.id = id;
+                entity.pixel_count = partial.pixel_count;
+                entity.brightness = partial.weight;
+                bool dark = !(partial.weight > 0);
+                entity.centroid[0] = dark ? std::numeric_limits<double>::quiet_NaN() : partial.weighted_u / partial.weight;
+                entity.centroid[1] = dark ? std::numeric_limits<double>::quiet_NaN() : partial.weighted_v / partial.weight;
+                std::copy(partial.bounding_box, partial.bounding_box + 4, entity.bounding_box);
+                entity.limb = std::move(partial.limb);
+                entity.terminator = std::move(partial.terminator);
+                std::sort(entity.limb.begin(), entity.limb.end(), by_row);
+                std::sort(entity.terminator.begin(), entity.terminator.end(), by_row);
+                measurements.push_back(std::move(entity));
+            }
+            return measurements;
+        }
+
+    private:
+        struct Label {
+            uint32_t id;
+            bool lit;
+        };
+
+        Camera<Scalar> &camera;
+        const std::vector<LightVariant<Scalar>> &lights;
+        const ScenePrimitives<Scalar> &primitives;
+        const ClosestHitTraverser<Scalar> &closest_traverser;
+        const OcclusionTraverser<Scalar> &occlusion_traverser;
+        size_t width, height;
+
+        Label label(size_t i, size_t j) const {
+            auto ray = camera.sample_ray(i, j, 0.5);
+            auto hit = closest_traverser.traverse(ray);
+            if (!hit) {
+                return Label{0, false};
+            }
+            auto surface = primitives.surface_point(*hit, ray, false);
+            auto origin = offset_ray_origin(surface.point, -surface.normal);
+            bool lit = false;
+            for (auto &light : lights) {
+                auto light_ray = light_center_ray(light, origin);
+                light_ray.time = ray.time;
+                if (bvh::dot(light_ray.direction, surface.shading_normal) < 0 && !occlusion_traverser.occluded(light_ray)) {
+                    lit = true;
+                    break;
+                }
+            }
+            return Label{primitives.parent(*hit)->id, lit};
+        }
+};
+
+// Measure a whole image that has already been rendered (or only traced, when pixels is nullptr),
+// a tile per iteration of a parallel loop:
+template <typename Scalar>
+std::vector<EntityMeasurements<Scalar>> measure_image(const ImageMeasurer<Scalar> &measurer, const float *pixels) {
+    typename ImageMeasurer<Scalar>::Accumulator total;
+    #pragma omp parallel
+    {
+        typename ImageMeasurer<Scalar>::Accumulator local;
+        #pragma omp for schedule(dynamic)
+        for (size_t tile = 0; tile < measurer.tile_count(); ++tile) {
+            measurer.measure(tile, pixels, local);
+        }
+        #pragma omp critical
+        ImageMeasurer<Scalar>::merge(local, total);
+    }
+    return ImageMeasurer<Scalar>::finish(total);
+}
+
+#endif
@@ -4,23 +4,30 @@
 #include <chrono>
 
 #include "bvh/bvh.hpp"
-#include "bvh/single_ray_traverser.hpp"
-#include "bvh/primitive_intersectors.hpp"
 #include "bvh/triangle.hpp"
 
 #include "cameras/camera.hpp"
 
+#include "acceleration/acceleration_structure.hpp"
+#include "acceleration/closest_hit_traverser.hpp"
+#include "acceleration/scene_primitives.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+#include "lights/light_variant.hpp"
+#include "measurements.hpp"
+#include "lod/level_of_detail.hpp"
+#include "statistics.hpp"
+
 template <typename Scalar>
 std::vector<Scalar> get_inetersections(std::unique_ptr<Camera<Scalar>> &camera,
-                                       bvh::Bvh<Scalar> &bvh_cache,
-                                       std::vector<bvh::Triangle<Scalar>> triangles){
+                                       const AccelerationStructure<Scalar> &scene,
+                                       RenderStatistics *statistics = nullptr){
 
     // Start the rendering process:
     auto start = std::chrono::high_resolution_clock::now();
-    auto tri_data = triangles.data();
-    bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> closest_intersector(bvh_cache, tri_data);
-    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_int(bvh_cache, tri_data);
-    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh_cache);
+    StatisticsCollector collector(statistics);
+    camera->prepare();
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> traverser(scene.bvh, primitives);
 
     // Define the output array:
     std::vector<Scalar> intersections;
@@ -33,28 +40,27 @@ std::vector<Scalar> get_inetersections(std::unique_ptr<Camera<Scalar>> &camera,
         #pragma omp parallel
         {   
             #pragma omp single
-            std::cout << "Calculating intersections intersected on " << omp_get_num_threads() << " threads..." << std::endl;
+            log_stream() << "Calculating intersections intersected on " << omp_get_num_threads() << " threads..." << std::endl;
         }
         #pragma omp parallel for
     #else
-        std::cout << "Calculating intersections intersected on single thread..." << std::endl;
+        log_stream() << "Calculating intersections intersected on single thread..." << std::endl;
     #endif
     for(size_t i = 0; i < width; ++i) {
+        BusyTimer busy;
+        statistics::add_samples(height);
         for(size_t j = 0; j < height; ++j) {
             // Cast ray:
             bvh::Ray<Scalar> ray;
-            ray = camera->pixel_to_ray(i, j);
+            ray = camera->sample_ray(i, j, 0.5);
 
             // Traverse ray through BVH:
-            auto hit = traverser.traverse(ray, closest_intersector);
+            auto hit = traverser.traverse(ray);
 
             // Store intersection point:
             bvh::Vector3<Scalar> intersect_point;
             if (hit) {
-                auto &tri = tri_data[hit->primitive_index];
-                auto u = hit->intersection.u;
-                auto v = hit->intersection.v;
-                intersect_point = bvh::Vector3<Scalar>(u*tri.p1() + v*tri.p2() + (1-u-v)*tri.p0);
+                intersect_point = primitives.hit_point(*hit, ray);
             }
             else {
                 // Zeros are fine for now, but maybe consider making these inf/nan or something?
@@ -69,22 +75,23 @@ std::vector<Scalar> get_inetersections(std::unique_ptr<Camera<Scalar>> &camera,
     }
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    Tracing intersections completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    log_stream() << "    Tracing intersections completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    collector.finish(width*height);
 
     return intersections;
 };
 
 template <typename Scalar>
 std::vector<uint32_t> get_instances(std::unique_ptr<Camera<Scalar>> &camera,
-                                    bvh::Bvh<Scalar> &bvh_cache,
-                                    std::vector<bvh::Triangle<Scalar>> triangles) {
+                                    const AccelerationStructure<Scalar> &scene,
+                                    RenderStatistics *statistics = nullptr) {
 
     // Start the rendering process:
     auto start = std::chrono::high_resolution_clock::now();
-    auto tri_data = triangles.data();
-    bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> closest_intersector(bvh_cache, tri_data);
-    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_int(bvh_cache, tri_data);
-    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh_cache);
+    StatisticsCollector collector(statistics);
+    camera->prepare();
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> traverser(scene.bvh, primitives);
 
     // Define the output array:
     std::vector<uint32_t> instances;
@@ -97,26 +104,27 @@ std::vector<uint32_t> get_instances(std::unique_ptr<Camera<Scalar>> &camera,
         #pragma omp parallel 
         {   
             #pragma omp single
-            std::cout << "Calculating instances intersected on " << omp_get_num_threads() << " threads..." << std::endl;
+            log_stream() << "Calculating instances intersected on " << omp_get_num_threads() << " threads..." << std::endl;
         }
         #pragma omp parallel for
     #else
-        std::cout << "Calculating instances intersected on single thread..." << std::endl;
+        log_stream() << "Calculating instances intersected on single thread..." << std::endl;
     #endif
     for(size_t i = 0; i < width; ++i) {
+        BusyTimer busy;
+        statistics::add_samples(height);
         for(size_t j = 0; j < height; ++j) {
             // Cast ray:
             bvh::Ray<Scalar> ray;
-            ray = camera->pixel_to_ray(i, j);
+            ray = camera->sample_ray(i, j, 0.5);
 
             // Traverse ray through BVH:
-            auto hit = traverser.traverse(ray, closest_intersector);
+            auto hit = traverser.traverse(ray);
 
             // Store intersection point:
             uint32_t entity_instance;
             if (hit) {
-                auto &tri = tri_data[hit->primitive_index];
-                entity_instance = tri.parent->id;
+                entity_instance = primitives.parent(*hit)->id;
             }
             else {
                 // Zero is fine for now....
@@ -129,21 +137,22 @@ std::vector<uint32_t> get_instances(std::unique_ptr<Camera<Scalar>> &camera,
     }
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    Tracing instance intersections completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    log_stream() << "    Tracing instance intersections completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    collector.finish(width*height);
 
     return instances;
 };
 
 template <typename Scalar>
 std::vector<Scalar> get_normals(std::unique_ptr<Camera<Scalar>> &camera, 
-                                bvh::Bvh<Scalar> &bvh_cache,
-                                std::vector<bvh::Triangle<Scalar>> triangles){
+                                const AccelerationStructure<Scalar> &scene,
+                                RenderStatistics *statistics = nullptr){
 
     auto start = std::chrono::high_resolution_clock::now();
-    auto tri_data = triangles.data();
-    bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> closest_intersector(bvh_cache, tri_data);
-    bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> any_int(bvh_cache, tri_data);
-    bvh::SingleRayTraverser<bvh::Bvh<Scalar>> traverser(bvh_cache);
+    StatisticsCollector collector(statistics);
+    camera->prepare();
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> traverser(scene.bvh, primitives);
 
     // Define the output array:
     std::vector<Scalar> normals;
@@ -156,28 +165,27 @@ std::vector<Scalar> get_normals(std::unique_ptr<Camera<Scalar>> &camera,
         #pragma omp parallel 
         {   
             #pragma omp single
-            std::cout << "Calculating normals intersected on " << omp_get_num_threads() << " threads..." << std::endl;
+            log_stream() << "Calculating normals intersected on " << omp_get_num_threads() << " threads..." << std::endl;
         }
         #pragma omp parallel for
     #else
-        std::cout << "Calculating normals intersected on single thread..." << std::endl;
+        log_stream() << "Calculating normals intersected on single thread..." << std::endl;
     #endif
     for(size_t i = 0; i < width; ++i) {
+        BusyTimer busy;
+        statistics::add_samples(height);
         for(size_t j = 0; j < height; ++j) {
             // Cast ray:
             bvh::Ray<Scalar> ray;
-            ray = camera->pixel_to_ray(i, j);
+            ray = camera->sample_ray(i, j, 0.5);
 
             // Traverse ray through BVH:
-            auto hit = traverser.traverse(ray, closest_intersector);
+            auto hit = traverser.traverse(ray);
 
             // Store normal of the intersected point:
             bvh::Vector3<Scalar> normal;
             if (hit) {
-                auto &tri = tri_data[hit->primitive_index];
-                auto u = hit->intersection.u;
-                auto v = hit->intersection.v;
-                normal = tri.parent->smooth_shading ? bvh::normalize(u*tri.vn1 + v*tri.vn2 + (Scalar(1.0)-u-v)*tri.vn0) : bvh::normalize(tri.n);
+                normal = primitives.surface_point(*hit, ray, false).shading_normal;
             }
             else {
                 // Zeros are fine for now, but maybe consider making these inf/nan or something?
@@ -192,168 +200,164 @@ std::vector<Scalar> get_normals(std::unique_ptr<Camera<Scalar>> &camera,
     }
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    Tracing normals completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    log_stream() << "    Tracing normals completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    collector.finish(width*height);
 
     return normals;
 };
 
-template <typename Scalar> 
-std::vector<Scalar> intersection_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities){
-
-    // Store triangles locally:
-    std::vector<bvh::Triangle<Scalar>> triangles;
-    for (auto entity : entities) {
-        // Apply current entity transofmrations:
-        auto entity_triangles = entity->triangles;
-        resize_triangles(entity_triangles, entity->scale);
-        rotate_triangles(entity_triangles, entity->rotation);
-        translate_triangles(entity_triangles, entity->position);
-
-        // Store into triangle vector:
-        triangles.insert(triangles.end(), entity_triangles.begin(), entity_triangles.end());
-    }
-
-    // Build an acceleration data structure for this object set
-    bvh::Bvh<Scalar> bvh;
-
-    size_t reference_count = triangles.size();
-    std::unique_ptr<bvh::Triangle<Scalar>[]> shuffled_triangles;
+// Traversal cost of the camera ray of every pixel, as the number of BVH nodes visited and primitives
+// tested, interleaved (2 values per pixel, row major), counted as in RenderStatistics so that the
+// quadtree of a heightfield adds to both.  Regions that are expensive to trace, such as long thin
+// triangles, overlapping entities or terrain seen at grazing angles, stand out in either:
+template <typename Scalar>
+std::vector<uint32_t> get_traversal_costs(std::unique_ptr<Camera<Scalar>> &camera,
+                                          const AccelerationStructure<Scalar> &scene,
+                                          RenderStatistics *statistics = nullptr) {
 
-    std::cout << "\nBuilding BVH ( using SweepSahBuilder )... for " << triangles.size() << " triangles\n";
     auto start = std::chrono::high_resolution_clock::now();
+    StatisticsCollector collector(statistics);
+    camera->prepare();
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> traverser(scene.bvh, primitives);
 
-    auto tri_data = triangles.data();
-    auto bboxes_and_centers = bvh::compute_bounding_boxes_and_centers(tri_data, triangles.size());
-    auto bboxes = bboxes_and_centers.first.get(); 
-    auto centers = bboxes_and_centers.second.get(); 
-    
-    auto global_bbox = bvh::compute_bounding_boxes_union(bboxes, triangles.size());
-
-    bvh::SweepSahBuilder<bvh::Bvh<Scalar>> builder(bvh);
-    builder.build(global_bbox, bboxes, centers, reference_count);
+    // Define the output array:
+    size_t width  = (size_t) floor(camera->get_resolutionX());
+    size_t height = (size_t) floor(camera->get_resolutionY());
+    std::vector<uint32_t> costs(2*width*height);
 
-    bvh::ParallelReinsertionOptimizer<bvh::Bvh<Scalar>> pro_opt(bvh);
-    pro_opt.optimize();
+    Scalar distance_sum = 0;
+    #pragma omp parallel for reduction(+: distance_sum)
+    for(size_t i = 0; i < width; ++i) {
+        BusyTimer busy;
+        statistics::add_samples(height);
+        for(size_t j = 0; j < height; ++j) {
+            auto ray = camera->sample_ray(i, j, 0.5);
 
-    bvh::NodeLayoutOptimizer<bvh::Bvh<Scalar>> nlo_opt(bvh);
-    nlo_opt.optimize();
+            TraversalCount count(false);
+            if (auto hit = traverser.traverse(ray, count)) {
+                distance_sum += hit->intersection.t;
+            }
 
+            costs[2*(width*j + i) + 0] = (uint32_t) count.node_visits;
+            costs[2*(width*j + i) + 1] = (uint32_t) count.primitive_tests;
+        }
+    }
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    BVH of "
-        << bvh.node_count << " node(s) and "
-        << reference_count << " reference(s)\n";
-    std::cout << "    BVH built in " << duration.count()/1000000.0 << " seconds\n\n";
+    log_stream() << "    Tracing traversal costs completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    collector.finish(width*height);
 
-    auto intersections = get_inetersections<Scalar>(camera, bvh, triangles);
+    // The hits are only summed so that the compiler cannot drop intersections without side effects
+    // (such as those of a lone heightfield) from under the costs counted for them:
+    volatile Scalar sink = distance_sum;
+    (void) sink;
 
-    return intersections;
+    return costs;
 };
 
+// Per-entity pixel counts, centroids, bounding boxes, limbs and terminators (see measurements.hpp)
+// from primary and shadow rays alone, without rendering.  Every pixel of an entity weighs the same,
+// so the centroid is that of its silhouette:
 template <typename Scalar>
-std::vector<uint32_t> instance_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities){
-
-    // Store triangles locally:
-    std::vector<bvh::Triangle<Scalar>> triangles;
-    for (auto entity : entities) {
-        // Apply current entity transofmrations:
-        auto entity_triangles = entity->triangles;
-        resize_triangles(entity_triangles, entity->scale);
-        rotate_triangles(entity_triangles, entity->rotation);
-        translate_triangles(entity_triangles, entity->position);
-
-        // Store into triangle vector:
-        triangles.insert(triangles.end(), entity_triangles.begin(), entity_triangles.end());
-    }
-
-    // Build an acceleration data structure for this object set
-    bvh::Bvh<Scalar> bvh;
-
-    size_t reference_count = triangles.size();
-    std::unique_ptr<bvh::Triangle<Scalar>[]> shuffled_triangles;
-
-    std::cout << "\nBuilding BVH ( using SweepSahBuilder )... for " << triangles.size() << " triangles\n";
+std::vector<EntityMeasurements<Scalar>> get_measurements(std::unique_ptr<Camera<Scalar>> &camera,
+                                                         const AccelerationStructure<Scalar> &scene,
+                                                         const std::vector<LightVariant<Scalar>> &lights,
+                                                         RenderStatistics *statistics = nullptr){
     auto start = std::chrono::high_resolution_clock::now();
+    StatisticsCollector collector(statistics);
+    camera->prepare();
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> closest_traverser(scene.bvh, primitives);
+    OcclusionTraverser<Scalar> occlusion_traverser(scene.bvh, primitives);
 
-    auto tri_data = triangles.data();
-    auto bboxes_and_centers = bvh::compute_bounding_boxes_and_centers(tri_data, triangles.size());
-    auto bboxes = bboxes_and_centers.first.get(); 
-    auto centers = bboxes_and_centers.second.get(); 
-    
-    auto global_bbox = bvh::compute_bounding_boxes_union(bboxes, triangles.size());
-
-    bvh::SweepSahBuilder<bvh::Bvh<Scalar>> builder(bvh);
-    builder.build(global_bbox, bboxes, centers, reference_count);
-
-    bvh::ParallelReinsertionOptimizer<bvh::Bvh<Scalar>> pro_opt(bvh);
-    pro_opt.optimize();
+    size_t width  = (size_t) floor(camera->get_resolutionX());
+    size_t height = (size_t) floor(camera->get_resolutionY());
 
-    bvh::NodeLayoutOptimizer<bvh::Bvh<Scalar>> nlo_opt(bvh);
-    nlo_opt.optimize();
+    ImageMeasurer<Scalar> measurer(*camera, lights, primitives, closest_traverser, occlusion_traverser);
+    auto measurements = measure_image<Scalar>(measurer, nullptr);
+    statistics::add_samples(width*height);
 
     auto stop = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    BVH of "
-        << bvh.node_count << " node(s) and "
-        << reference_count << " reference(s)\n";
-    std::cout << "    BVH built in " << duration.count()/1000000.0 << " seconds\n\n";
+    log_stream() << "    Measuring entities completed in " << duration.count()/1000000.0 << " seconds\n\n";
+    collector.finish(width*height);
 
-    auto instances = get_instances<Scalar>(camera, bvh, triangles);
-
-    return instances;
-}
+    return measurements;
+};
 
-template <typename Scalar>
-std::vector<Scalar> normal_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities){
-    // Store triangles locally:
-    std::vector<bvh::Triangle<Scalar>> triangles;
-    for (auto entity : entities) {
-        // Apply current entity transofmrations:
-        auto entity_triangles = entity->triangles;
-        resize_triangles(entity_triangles, entity->scale);
-        rotate_triangles(entity_triangles, entity->rotation);
-        translate_triangles(entity_triangles, entity->position);
-
-        // Store into triangle vector:
-        triangles.insert(triangles.end(), entity_triangles.begin(), entity_triangles.end());
-    }
+template <typename Scalar> 
+std::vector<Scalar> intersection_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities,
+                                      const BuildOptions &build_options, RenderStatistics *statistics = nullptr){
 
-    // Build an acceleration data structure for this object set
-    bvh::Bvh<Scalar> bvh;
+    // Build an acceleration data structure for this object set, at the levels of detail this camera needs
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
 
-    size_t reference_count = triangles.size();
-    std::unique_ptr<bvh::Triangle<Scalar>[]> shuffled_triangles;
+    auto intersections = get_inetersections<Scalar>(camera, scene, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
 
-    std::cout << "\nBuilding BVH ( using SweepSahBuilder )... for " << triangles.size() << " triangles\n";
-    auto start = std::chrono::high_resolution_clock::now();
+    return intersections;
+};
 
-    auto tri_data = triangles.data();
-    auto bboxes_and_centers = bvh::compute_bounding_boxes_and_centers(tri_data, triangles.size());
-    auto bboxes = bboxes_and_centers.first.get(); 
-    auto centers = bboxes_and_centers.second.get(); 
-    
-    auto global_bbox = bvh::compute_bounding_boxes_union(bboxes, triangles.size());
+template <typename Scalar>
+std::vector<uint32_t> instance_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities,
+                                    const BuildOptions &build_options, RenderStatistics *statistics = nullptr){
 
-    bvh::SweepSahBuilder<bvh::Bvh<Scalar>> builder(bvh);
-    builder.build(global_bbox, bboxes, centers, reference_count);
+    // Build an acceleration data structure for this object set, at the levels of detail this camera needs
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
 
-    bvh::ParallelReinsertionOptimizer<bvh::Bvh<Scalar>> pro_opt(bvh);
-    pro_opt.optimize();
+    auto instances = get_instances<Scalar>(camera, scene, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
 
-    bvh::NodeLayoutOptimizer<bvh::Bvh<Scalar>> nlo_opt(bvh);
-    nlo_opt.optimize();
+    return instances;
+}
 
-    auto stop = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    BVH of "
-        << bvh.node_count << " node(s) and "
-        << reference_count << " reference(s)\n";
-    std::cout << "    BVH built in " << duration.count()/1000000.0 << " seconds\n\n";
+template <typename Scalar>
+std::vector<Scalar> normal_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities,
+                                const BuildOptions &build_options, RenderStatistics *statistics = nullptr){
+    // Build an acceleration data structure for this object set, at the levels of detail this camera needs
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
 
     // Calculate the normals:
-    auto normals = get_normals<Scalar>(camera, bvh, triangles);
+    auto normals = get_normals<Scalar>(camera, scene, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
 
     return normals;
 };
 
+template <typename Scalar>
+std::vector<uint32_t> traversal_cost_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities,
+                                          const BuildOptions &build_options, RenderStatistics *statistics = nullptr){
+    // Build an acceleration data structure for this object set, at the levels of detail this camera needs
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
+
+    auto costs = get_traversal_costs<Scalar>(camera, scene, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
+
+    return costs;
+};
+
+template <typename Scalar>
+std::vector<EntityMeasurements<Scalar>> measurement_pass(std::unique_ptr<Camera<Scalar>> &camera, std::vector<Entity<Scalar>*> entities,
+                                                         const std::vector<LightVariant<Scalar>> &lights,
+                                                         const BuildOptions &build_options, RenderStatistics *statistics = nullptr){
+    // Build an acceleration data structure for this object set, at the levels of detail this camera needs
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
+
+    auto measurements = get_measurements<Scalar>(camera, scene, lights, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
+
+    return measurements;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef __INTEGRATOR_H
+#define __INTEGRATOR_H
+
+#include <stdexcept>
+#include <string>
+
+#include "path_tracing/unidirectional.hpp"
+#include "path_tracing/mis.hpp"
+
+// Path tracing algorithms that can be selected when rendering:
+//     Unidirectional: the original integrator, with one light sample per light per bounce
+//     MIS:            next event estimation combined with BSDF sampling by multiple importance sampling
+enum class Integrator {
+    Unidirectional,
+    MIS
+};
+
+inline Integrator parse_integrator(const std::string &name) {
+    if (name == "unidirectional") {
+        return Integrator::Unidirectional;
+    }
+    if (name == "mis") {
+        return Integrator::MIS;
+    }
+    throw std::invalid_argument("Unknown integrator '" + name + "'.  Valid options are 'unidirectional' and 'mis'");
+}
+
+#endif
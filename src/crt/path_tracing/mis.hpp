@@ -0,0 +1,131 @@
+#ifndef __MIS_H
+#define __MIS_H
+
+#include <limits>
+#include <random>
+
+#include "bvh/bvh.hpp"
+#include "bvh/triangle.hpp"
+
+#include "acceleration/closest_hit_traverser.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+#include "acceleration/scene_primitives.hpp"
+#include "lights/light_variant.hpp"
+#include "lights/light_tree.hpp"
+#include "materials/material.hpp"
+#include "path_tracing/ray_offset.hpp"
+
+// Power heuristic (beta = 2) weight for a sample drawn with density pdf_a, when the same path
+// could also have been produced by a strategy with density pdf_b:
+template <typename Scalar>
+inline Scalar power_heuristic(Scalar pdf_a, Scalar pdf_b) {
+    Scalar a2 = pdf_a*pdf_a;
+    Scalar b2 = pdf_b*pdf_b;
+    return a2 + b2 > 0 ? a2 / (a2 + b2) : 0;
+}
+
+// Trace a single path with next event estimation and multiple importance sampling.  At every
+// vertex the lights are sampled, and one direction is drawn from the BSDF.  When the
+// BSDF direction reaches an area light, the two estimates of that light are combined with the
+// power heuristic, so neither strategy is relied on where it is weak: light sampling for small
+// or distant lights, BSDF sampling for large, close lights and glossy surfaces.
+//
+// Lights are sampled as described by for_each_light_sample(), and the probability of selecting a
+// light is folded into its density.  Lights are not part of the scene geometry, so they are never
+// visible to camera rays, and BSDF sampled rays are tested against the lights found by
+// traversing the light tree.  Random numbers are drawn from the caller's generator, which must
+// not be shared between threads.  Textures are filtered over a cone of pixel_spread, as in
+// unidirectional():
+template <typename Scalar, typename Generator>
+Color mis(const std::vector<LightVariant<Scalar>> &lights,
+          const LightTree<Scalar> &light_tree, int light_samples,
+          const std::vector<MaterialVariant<Scalar>> &materials,
+          const ScenePrimitives<Scalar> &primitives,
+          const ClosestHitTraverser<Scalar> &closest_traverser,
+          const OcclusionTraverser<Scalar> &occlusion_traverser,
+          bvh::Ray<Scalar> ray, int num_bounces, Generator &generator, Scalar pixel_spread = 0){
+
+    std::uniform_real_distribution<Scalar> distr(0.0, 1.0);
+    Scalar cone_width = 0;
+
+    auto hit = closest_traverser.traverse(ray);
+
+    Color path_radiance(0);
+    Color throughput(1);
+
+    // Density of the BSDF sample that produced the current ray (zero if it was specular):
+    Scalar bsdf_pdf = 0;
+    bvh::Vector3<Scalar> previous_point;
+
+    for (int bounce = 0; ; ++bounce){
+        // Emission from lights reached by the BSDF sampled ray, in front of any geometry:
+        if (bounce > 0) {
+            light_tree.traverse(ray, [&](size_t light){
+                auto light_hit = intersect_light(lights[light], ray);
+                if (light_hit && (!hit || light_hit->distance < hit->distance())) {
+                    Scalar mis_weight = 1;
+                    if (bsdf_pdf > 0) {
+                        Scalar light_pdf = light_hit->pdf * light_selection_probability(light_tree, light_samples, previous_point, light);
+                        mis_weight = power_heuristic(bsdf_pdf, light_pdf);
+                    }
+                    path_radiance += throughput * (float)(light_hit->radiance * mis_weight);
+                }
+            });
+        }
+        if (!hit || bounce == num_bounces) {
+            break;
+        }
+
+        // Orient the normals towards the incoming ray, so that both sides of a surface reflect:
+        cone_width += pixel_spread * hit->distance() * bvh::length(ray.direction);
+        auto surface = primitives.surface_point(*hit, ray, true, cone_width);
+        auto &interp_normal = surface.shading_normal;
+        auto &interp_uv = surface.uv;
+        auto &material = materials[primitives.material_id(*hit)];
+
+        auto intersect_point = offset_ray_origin(surface.point, -surface.normal);
+        auto wo = -bvh::normalize(ray.direction);
+
+        // Next event estimation:
+        if (!is_specular_material(material)) {
+            for_each_light_sample(light_tree, light_samples, intersect_point, generator, [&](size_t light, Scalar selection_probability){
+                Scalar r1 = distr(generator);
+                Scalar r2 = distr(generator);
+                auto light_sample = sample_light(lights[light], intersect_point, r1, r2);
+                light_sample.ray.time = ray.time;
+                auto cos_theta = -bvh::dot(light_sample.ray.direction, interp_normal);
+                if (light_sample.radiance <= 0 || cos_theta <= 0) {
+                    return;
+                }
+                if (occlusion_traverser.occluded(light_sample.ray)) {
+                    return;
+                }
+                auto f = evaluate_material(material, light_sample.ray.direction, wo, interp_normal, interp_uv[0], interp_uv[1],
+                                           surface.footprint);
+                Scalar light_pdf = light_sample.pdf * selection_probability;
+                Scalar mis_weight = 1;
+                if (!light_sample.delta) {
+                    mis_weight = power_heuristic(light_pdf, material_pdf(material, light_sample.ray.direction, wo, interp_normal));
+                }
+                path_radiance += throughput * f * (float)(cos_theta * light_sample.radiance / light_pdf * mis_weight);
+            });
+        }
+
+        // Continue the path in a direction drawn from the BSDF:
+        Scalar r1 = distr(generator);
+        Scalar r2 = distr(generator);
+        auto bsdf_sample = sample_material_bsdf(material, wo, interp_normal, interp_uv[0], interp_uv[1], r1, r2, surface.footprint);
+        throughput *= bsdf_sample.weight;
+        if (throughput[0] <= 0 && throughput[1] <= 0 && throughput[2] <= 0) {
+            break;
+        }
+        bsdf_pdf = bsdf_sample.pdf;
+        previous_point = intersect_point;
+        ray = bvh::Ray<Scalar>(intersect_point, bsdf_sample.direction, 0, std::numeric_limits<Scalar>::max(), ray.time);
+        hit = closest_traverser.traverse(ray);
+    }
+
+    return path_radiance;
+}
+
+#endif
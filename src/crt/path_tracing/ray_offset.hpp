@@ -0,0 +1,66 @@
+#ifndef __RAY_OFFSET_H
+#define __RAY_OFFSET_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "bvh/vector.hpp"
+
+// Moves a hit point off of its surface before a new ray is spawned from it, so that the ray does
+// not hit the surface it starts on (Wächter and Binder, "A Fast and Robust Method for Avoiding
+// Self-Intersection", Ray Tracing Gems, 2019).  A fixed distance along the normal is too large
+// for small scenes and too small for large ones, since the rounding error of a hit point grows
+// with its magnitude.  Instead, each coordinate is moved by a fixed number of units in the last
+// place along the normal, and only coordinates close to zero (where units in the last place
+// vanish) are moved by a small fixed distance.
+//
+// direction is the unit vector (usually plus or minus the geometric normal) pointing to the side
+// of the surface the new ray leaves from.
+template <typename Scalar>
+struct RayOffsetConstants;
+
+template <>
+struct RayOffsetConstants<float> {
+    using Integer = int32_t;
+    static constexpr float origin = 1.0f / 32.0f;
+    static constexpr float float_scale = 1.0f / 65536.0f;
+    static constexpr float int_scale = 256.0f;
+};
+
+// Same number of units in the last place as for float, and a fixed distance near zero that is
+// correspondingly smaller:
+template <>
+struct RayOffsetConstants<double> {
+    using Integer = int64_t;
+    static constexpr double origin = 1.0 / 32.0;
+    static constexpr double float_scale = 1.0 / 35184372088832.0; // 2^-45
+    static constexpr double int_scale = 256.0;
+};
+
+template <typename Scalar>
+bvh::Vector3<Scalar> offset_ray_origin(const bvh::Vector3<Scalar> &point, const bvh::Vector3<Scalar> &direction) {
+    using Constants = RayOffsetConstants<Scalar>;
+    using Integer = typename Constants::Integer;
+    static_assert(sizeof(Integer) == sizeof(Scalar), "offset_ray_origin() needs an integer type the size of Scalar");
+
+    Scalar offset_point[3];
+    for (int i = 0; i < 3; ++i) {
+        Scalar coordinate = point[i];
+        if (std::fabs(coordinate) < Constants::origin) {
+            offset_point[i] = coordinate + Constants::float_scale * direction[i];
+            continue;
+        }
+
+        // Stepping the integer representation moves the value away from zero for positive steps:
+        Integer ulps = (Integer) (Constants::int_scale * direction[i]);
+        Integer bits;
+        std::memcpy(&bits, &coordinate, sizeof(Scalar));
+        bits += coordinate < 0 ? -ulps : ulps;
+        std::memcpy(&offset_point[i], &bits, sizeof(Scalar));
+    }
+    return bvh::Vector3<Scalar>(offset_point[0], offset_point[1], offset_point[2]);
+}
+
+#endif
@@ -1,35 +1,53 @@
 #ifndef __UNIDIRECTIONAL_H
 #define __UNIDIRECTIONAL_H
 
+#include <limits>
+#include <random>
+
 #include "bvh/bvh.hpp"
-#include "bvh/single_ray_traverser.hpp"
-#include "bvh/primitive_intersectors.hpp"
 #include "bvh/triangle.hpp"
 
-#include "lights/light.hpp"
+#include "acceleration/closest_hit_traverser.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+#include "acceleration/scene_primitives.hpp"
+#include "lights/light_variant.hpp"
+#include "lights/light_tree.hpp"
+#include "materials/material.hpp"
+#include "path_tracing/ray_offset.hpp"
 
-template <typename Scalar, typename Intersector>
-Color illumination(bvh::SingleRayTraverser<bvh::Bvh<Scalar>> &traverser, Intersector &intersector, 
+template <typename Scalar>
+Color illumination(const OcclusionTraverser<Scalar> &occlusion_traverser,
                    float u, float v, const bvh::Ray<Scalar> &light_ray, 
-                   const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, Material<Scalar> *material) {
+                   const bvh::Ray<Scalar> &view_ray, const bvh::Vector3<Scalar> &normal, const MaterialVariant<Scalar> &material,
+                   float footprint = 0) {
     Color intensity(0);
-    auto hit = traverser.traverse(light_ray, intersector);
-    if (!hit) {
-        intensity = material->compute(light_ray, view_ray, normal, u, v);
+    if (!occlusion_traverser.occluded(light_ray)) {
+        intensity = compute_material(material, light_ray, view_ray, normal, u, v, footprint);
     }
     return intensity;
 }
 
-template <typename Scalar>
-Color unidirectional(std::vector<std::unique_ptr<Light<Scalar>>> &lights,
-                     bvh::Triangle<Scalar>* tri_data,
-                     bvh::ClosestPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> &closest_intersector,
-                     bvh::AnyPrimitiveIntersector<bvh::Bvh<Scalar>, bvh::Triangle<Scalar>, false> &any_intersector,
-                     bvh::SingleRayTraverser<bvh::Bvh<Scalar>> &traverser,
-                     bvh::Ray<Scalar> ray, int num_bounces){
+// Trace a single path.  Random numbers for light and bounce sampling are drawn from the caller's
+// generator, which must not be shared between threads.  Lights are sampled as described by
+// for_each_light_sample().
+//
+// The path stands for a cone that widens by pixel_spread per unit of distance (see
+// Camera::pixel_spread()), and textures are filtered over its width where it hits.  Bounces keep
+// the same spread, leaving out the curvature and roughness of the surfaces:
+template <typename Scalar, typename Generator>
+Color unidirectional(const std::vector<LightVariant<Scalar>> &lights,
+                     const LightTree<Scalar> &light_tree, int light_samples,
+                     const std::vector<MaterialVariant<Scalar>> &materials,
+                     const ScenePrimitives<Scalar> &primitives,
+                     const ClosestHitTraverser<Scalar> &closest_traverser,
+                     const OcclusionTraverser<Scalar> &occlusion_traverser,
+                     bvh::Ray<Scalar> ray, int num_bounces, Generator &generator, Scalar pixel_spread = 0){
     
+    std::uniform_real_distribution<Scalar> distr(0.0, 1.0);
+    Scalar cone_width = 0;
+
     // TODO: Make a better random sampling algorithm:
-    auto hit = traverser.traverse(ray, closest_intersector);
+    auto hit = closest_traverser.traverse(ray);
 
     // Initialize:
     Color path_radiance(0);
@@ -41,35 +59,28 @@ Color unidirectional(std::vector<std::unique_ptr<Light<Scalar>>> &lights,
         if (!hit) {
             break;
         }
-        auto &tri = tri_data[hit->primitive_index];
-        auto u = hit->intersection.u;
-        auto v = hit->intersection.v;
-
-        auto normal = bvh::normalize(tri.n);
-        bvh::Vector3<Scalar> interp_normal;
-        if (tri.parent->smooth_shading){
-            interp_normal = bvh::normalize(u*tri.vn1 + v*tri.vn2 + (Scalar(1.0)-u-v)*tri.vn0);
-        }
-        else {
-            interp_normal = normal;
-        }
-        bvh::Vector<float, 2> interp_uv = (float)u*tri.uv[1] + (float)v*tri.uv[2] + (float)(Scalar(1.0)-u-v)*tri.uv[0];
-        auto material = tri.parent->get_material(interp_uv[0], interp_uv[1]);
+        cone_width += pixel_spread * hit->distance() * bvh::length(ray.direction);
+        auto surface = primitives.surface_point(*hit, ray, false, cone_width);
+        auto &interp_normal = surface.shading_normal;
+        auto &interp_uv = surface.uv;
+        auto &material = materials[primitives.material_id(*hit)];
 
-        //TODO: Figure out how to deal with the self-intersection stuff in a more proper way...
-        bvh::Vector3<Scalar> intersect_point = (u*tri.p1() + v*tri.p2() + (1-u-v)*tri.p0);
-        Scalar scale = 0.0001;
-        intersect_point = intersect_point - scale*normal;
+        // Move the hit point off of the surface, to the side the normal points away from:
+        auto intersect_point = offset_ray_origin(surface.point, -surface.normal);
 
         // Calculate the direct illumination:
         Color light_radiance(0);
 
-        // Loop through all provided lights:
-        for (auto& light : lights){
-            bvh::Ray<Scalar> light_ray = light->sample_ray(intersect_point);
-            Color light_color = illumination(traverser, any_intersector, interp_uv[0], interp_uv[1], light_ray, ray, interp_normal, material);
-            light_radiance += light_color * (float) light->get_intensity(intersect_point);
-        };
+        // Loop through the sampled lights:
+        for_each_light_sample(light_tree, light_samples, intersect_point, generator, [&](size_t light, Scalar selection_probability){
+            Scalar r1 = distr(generator);
+            Scalar r2 = distr(generator);
+            auto light_sample = sample_light(lights[light], intersect_point, r1, r2);
+            light_sample.ray.time = ray.time;
+            Color light_color = illumination(occlusion_traverser, interp_uv[0], interp_uv[1], light_sample.ray, ray, interp_normal, material,
+                                             surface.footprint);
+            light_radiance += light_color * (float) (light_sample.intensity / selection_probability);
+        });
 
         if (bounce >= 1) {
             for (int idx = 0; idx < 3; ++idx){
@@ -86,13 +97,15 @@ Color unidirectional(std::vector<std::unique_ptr<Light<Scalar>>> &lights,
         }
 
         // Cast next ray:
-        auto [new_direction, bounce_color] = material->sample(ray, interp_normal, interp_uv[0], interp_uv[1]);
-        ray = bvh::Ray<Scalar>(intersect_point, new_direction);
-        hit = traverser.traverse(ray, closest_intersector);
+        Scalar r1 = distr(generator);
+        Scalar r2 = distr(generator);
+        auto [new_direction, bounce_color] = sample_material(material, ray, interp_normal, interp_uv[0], interp_uv[1], r1, r2);
+        ray = bvh::Ray<Scalar>(intersect_point, new_direction, 0, std::numeric_limits<Scalar>::max(), ray.time);
+        hit = closest_traverser.traverse(ray);
         weight *= bounce_color;
     }
 
     return path_radiance;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,441 @@
+#ifndef __WAVEFRONT_H
+#define __WAVEFRONT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+#include "bvh/morton.hpp"
+#include "bvh/triangle.hpp"
+
+#include "cameras/camera.hpp"
+#include "acceleration/acceleration_structure.hpp"
+#include "acceleration/closest_hit_traverser.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+#include "acceleration/scene_primitives.hpp"
+#include "lights/light_variant.hpp"
+#include "lights/light_tree.hpp"
+#include "materials/material.hpp"
+#include "path_tracing/integrator.hpp"
+#include "path_tracing/ray_offset.hpp"
+#include "statistics.hpp"
+
+// Wavefront path tracing.  Instead of each thread following one path through all of its bounces,
+// a batch of paths advances one bounce at a time, in stages that each run over the whole batch:
+//
+//   1. Sort:   rays are ordered by the Morton code of the cell containing their origin, and by
+//              the octant of their direction, so that neighboring rays take similar paths
+//              through the BVH (camera rays are already coherent and are not sorted).
+//   2. Trace:  closest hits are found for the whole batch.
+//   3. Shade:  surviving paths are grouped by material, light samples are turned into shadow
+//              rays, and the next direction is drawn from the material.
+//   4. Shadow: all shadow rays of the bounce are traced with the occlusion traverser, and the
+//              unoccluded contributions are added to their paths.
+//
+// The per-vertex math is the same as that of unidirectional() and mis(), and adaptive sampling
+// follows the same rule as render_radiance().  The first min_samples samples of every pixel are
+// traced together, then one more sample per pass for the pixels that have not yet converged.
+// Each path draws from its own generator, seeded from (seed, pixel, sample).
+
+namespace wavefront {
+
+template <typename Scalar>
+struct Path {
+    using Hit = typename ScenePrimitives<Scalar>::Hit;
+
+    bvh::Ray<Scalar> ray;
+    std::optional<Hit> hit;
+    Color throughput;
+    Color radiance;
+
+    // Weight applied to the summed light contributions of the current vertex, and whether that
+    // sum is clamped first (both are only used by the unidirectional integrator):
+    Color vertex_weight;
+    bool clamp_vertex;
+
+    // MIS state of the BSDF sample that produced the current ray:
+    Scalar bsdf_pdf;
+    bvh::Vector3<Scalar> previous_point;
+
+    // Width of the ray cone at the origin of the current ray (see unidirectional()):
+    Scalar cone_width;
+
+    std::minstd_rand generator;
+    uint32_t pixel;
+    uint32_t slot;
+    bool alive;
+};
+
+template <typename Scalar>
+struct ShadowRay {
+    bvh::Ray<Scalar> ray;
+    Color contribution;
+    bool valid;
+};
+
+// Sort key combining the cell of the ray origin (8 bits per axis) with its direction octant:
+template <typename Scalar>
+uint32_t ray_key(const bvh::MortonEncoder<uint32_t, Scalar> &encoder, const bvh::Ray<Scalar> &ray) {
+    uint32_t octant = (ray.direction[0] < 0) | ((ray.direction[1] < 0) << 1) | ((ray.direction[2] < 0) << 2);
+    return (encoder.encode(ray.origin) << 3) | octant;
+}
+
+// Stable radix sort of the 27 bit keys produced by ray_key(), 9 bits per pass.  order receives
+// the indices of the keys in sorted order (the keys are sorted in place):
+inline void sort_by_key(std::vector<uint32_t> &keys, std::vector<uint32_t> &order,
+                        std::vector<uint32_t> &key_scratch, std::vector<uint32_t> &order_scratch) {
+    constexpr int bits = 9;
+    constexpr uint32_t mask = (1 << bits) - 1;
+    order.resize(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    key_scratch.resize(keys.size());
+    order_scratch.resize(keys.size());
+    for (int shift = 0; shift < 27; shift += bits) {
+        std::vector<size_t> offsets((1 << bits) + 1, 0);
+        for (auto key : keys) {
+            offsets[((key >> shift) & mask) + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto destination = offsets[(keys[i] >> shift) & mask]++;
+            key_scratch[destination] = keys[i];
+            order_scratch[destination] = order[i];
+        }
+        std::swap(keys, key_scratch);
+        std::swap(order, order_scratch);
+    }
+}
+
+// Seed for the generator of one path, mixing the render seed, pixel and sample number (the
+// SplitMix64 finalizer), which is much cheaper than a std::seed_seq for every path:
+inline uint32_t path_seed(uint32_t seed, uint32_t pixel, uint32_t sample) {
+    uint64_t x = (uint64_t(seed) << 32 | pixel) ^ (uint64_t(sample) * 0x9E3779B97F4A7C15ull);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return uint32_t(x ^ (x >> 31));
+}
+
+}
+
+template <typename Scalar>
+std::vector<float> render_radiance_wavefront(std::unique_ptr<Camera<Scalar>> &camera,
+                                             const std::vector<LightVariant<Scalar>> &lights,
+                                             const AccelerationStructure<Scalar> &scene,
+                                             int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                             Integrator integrator, int light_samples, uint32_t seed) {
+    using Path = wavefront::Path<Scalar>;
+    using ShadowRay = wavefront::ShadowRay<Scalar>;
+
+    camera->prepare();
+    auto &bvh = scene.bvh;
+    auto &materials = scene.materials;
+
+    auto &primitives = scene.primitives;
+    ClosestHitTraverser<Scalar> closest_traverser(bvh, primitives);
+    OcclusionTraverser<Scalar> occlusion_traverser(bvh, primitives);
+    LightTree<Scalar> light_tree(lights);
+    bool use_mis = integrator == Integrator::MIS;
+    Scalar pixel_spread = camera->pixel_spread();
+
+    // Grid over the scene (padded so that flat scenes have a nonzero extent) for sorting rays:
+    auto &root = bvh.nodes[0];
+    bvh::BoundingBox<Scalar> scene_bbox(bvh::Vector3<Scalar>(root.bounds[0], root.bounds[2], root.bounds[4]),
+                                        bvh::Vector3<Scalar>(root.bounds[1], root.bounds[3], root.bounds[5]));
+    auto padding = std::max(bvh::length(scene_bbox.diagonal())*Scalar(1e-3), Scalar(1e-6));
+    scene_bbox.min = scene_bbox.min - bvh::Vector3<Scalar>(padding);
+    scene_bbox.max = scene_bbox.max + bvh::Vector3<Scalar>(padding);
+    bvh::MortonEncoder<uint32_t, Scalar> encoder(scene_bbox, 256);
+
+    size_t width  = (size_t) floor(camera->get_resolutionX());
+    size_t height = (size_t) floor(camera->get_resolutionY());
+    std::vector<float> pixels(4 * width * height);
+    std::vector<Color> pixel_radiance(width * height, Color(0));
+
+    // Paths are processed in batches small enough for their state and shadow rays to stay in cache:
+    size_t shadow_rays_per_vertex = light_samples > 0 ? (size_t) light_samples : lights.size();
+    size_t batch_size = std::clamp<size_t>((size_t(1) << 14) / std::max<size_t>(shadow_rays_per_vertex, 1), 256, 4096);
+
+    std::vector<Path> paths(batch_size), path_scratch(batch_size);
+    std::vector<ShadowRay> shadow_rays(batch_size * shadow_rays_per_vertex);
+    std::vector<Color> path_radiance(batch_size);
+    std::vector<uint32_t> keys, key_scratch, order, order_scratch, material_offsets;
+
+    std::vector<uint32_t> active(width * height);
+    std::iota(active.begin(), active.end(), 0);
+
+    for (int sample = 1; sample < max_samples+1 && !active.empty(); ) {
+        // No pixel can converge before min_samples, so the first round traces all of them at once.
+        // After that, each round traces one more sample for every pixel that has not converged:
+        size_t round_samples = sample == 1 ? (size_t) std::clamp(min_samples, 1, max_samples) : 1;
+        round_samples = std::min(round_samples, batch_size);
+        size_t batch_pixels = batch_size / round_samples;
+        std::vector<uint8_t> converged(active.size(), 0);
+
+        for (size_t batch_start = 0; batch_start < active.size(); batch_start += batch_pixels) {
+            size_t count = std::min(batch_pixels, active.size() - batch_start) * round_samples;
+            statistics::add_samples(count);
+
+            // Generate camera rays, with the samples of each pixel next to each other:
+            #pragma omp parallel for
+            for (size_t p = 0; p < count; ++p) {
+                auto &path = paths[p];
+                path.pixel = active[batch_start + p / round_samples];
+                path.slot = (uint32_t) p;
+                path.generator.seed(wavefront::path_seed(seed, path.pixel, (uint32_t) (sample + p % round_samples)));
+                std::uniform_real_distribution<Scalar> distr(-0.5, 0.5);
+                size_t i = path.pixel % width;
+                size_t j = path.pixel / width;
+                auto i_rand = distr(path.generator);
+                auto j_rand = distr(path.generator);
+                if (max_samples == 1) {
+                    path.ray = camera->sample_ray(i, j, 0.5);
+                }
+                else {
+                    // Samples are spread over the exposure of a moving camera or scene (see Camera::shutter_sample()):
+                    Scalar shutter_offset = wavefront::path_seed(seed, path.pixel, ~0u)*Scalar(2.3283064365386963e-10);
+                    path.ray = camera->sample_ray(i + i_rand, j + j_rand,
+                                                  Camera<Scalar>::shutter_sample(sample + p % round_samples, shutter_offset));
+                }
+                path.throughput = use_mis ? Color(1) : Color(2*M_PI);
+                path.radiance = Color(0);
+                path.bsdf_pdf = 0;
+                path.cone_width = 0;
+                path.alive = true;
+            }
+
+            // Paths [0, size) are still being traced:
+            size_t size = count;
+            for (int bounce = 0; size > 0; ++bounce) {
+                // Sort the incoherent secondary rays.  The paths themselves are moved, so that every
+                // later stage reads them in order:
+                if (bounce > 0) {
+                    keys.resize(size);
+                    #pragma omp parallel for
+                    for (size_t p = 0; p < size; ++p) {
+                        keys[p] = wavefront::ray_key(encoder, paths[p].ray);
+                    }
+                    wavefront::sort_by_key(keys, order, key_scratch, order_scratch);
+                    #pragma omp parallel for
+                    for (size_t p = 0; p < size; ++p) {
+                        path_scratch[p] = paths[order[p]];
+                    }
+                    std::swap(paths, path_scratch);
+                }
+
+                // Trace:
+                #pragma omp parallel for schedule(dynamic, 64)
+                for (size_t p = 0; p < size; ++p) {
+                    BusyTimer busy;
+                    paths[p].hit = closest_traverser.traverse(paths[p].ray);
+                }
+
+                // Emission from lights reached by BSDF sampled rays:
+                if (use_mis && bounce > 0) {
+                    #pragma omp parallel for
+                    for (size_t p = 0; p < size; ++p) {
+                        auto &path = paths[p];
+                        light_tree.traverse(path.ray, [&](size_t light){
+                            auto light_hit = intersect_light(lights[light], path.ray);
+                            if (light_hit && (!path.hit || light_hit->distance < path.hit->distance())) {
+                                Scalar mis_weight = 1;
+                                if (path.bsdf_pdf > 0) {
+                                    Scalar light_pdf = light_hit->pdf * light_selection_probability(light_tree, light_samples, path.previous_point, light);
+                                    mis_weight = power_heuristic(path.bsdf_pdf, light_pdf);
+                                }
+                                path.radiance += path.throughput * (float)(light_hit->radiance * mis_weight);
+                            }
+                        });
+                    }
+                }
+
+                // Retire finished paths, and group the rest by material with a counting sort (the last
+                // ray of a mis() path is only traced to find the lights it reaches):
+                material_offsets.assign(materials.size() + 1, 0);
+                for (size_t p = 0; p < size; ++p) {
+                    auto &path = paths[p];
+                    path.alive = path.hit && bounce < num_bounces;
+                    if (path.alive) {
+                        material_offsets[primitives.material_id(*path.hit) + 1]++;
+                    }
+                    else {
+                        path_radiance[path.slot] = path.radiance;
+                    }
+                }
+                std::partial_sum(material_offsets.begin(), material_offsets.end(), material_offsets.begin());
+                size_t surviving = material_offsets.back();
+                for (size_t p = 0; p < size; ++p) {
+                    if (paths[p].alive) {
+                        path_scratch[material_offsets[primitives.material_id(*paths[p].hit)]++] = paths[p];
+                    }
+                }
+                std::swap(paths, path_scratch);
+                size = surviving;
+
+                // Shade, writing shadow rays into fixed slots so that no synchronization is needed:
+                #pragma omp parallel for schedule(dynamic, 64)
+                for (size_t p = 0; p < size; ++p) {
+                    BusyTimer busy;
+                    auto &path = paths[p];
+                    auto &hit = *path.hit;
+                    auto &material = materials[primitives.material_id(hit)];
+                    path.cone_width += pixel_spread * hit.distance() * bvh::length(path.ray.direction);
+                    auto surface = primitives.surface_point(hit, path.ray, use_mis, path.cone_width);
+                    surface.point = offset_ray_origin(surface.point, -surface.normal);
+                    auto wo = -bvh::normalize(path.ray.direction);
+                    std::uniform_real_distribution<Scalar> distr(0.0, 1.0);
+
+                    ShadowRay* slots = shadow_rays.data() + p * shadow_rays_per_vertex;
+                    for (size_t s = 0; s < shadow_rays_per_vertex; ++s) {
+                        slots[s].valid = false;
+                    }
+                    size_t slot = 0;
+
+                    if (use_mis) {
+                        path.vertex_weight = Color(1);
+                        path.clamp_vertex = false;
+                        if (!is_specular_material(material)) {
+                            for_each_light_sample(light_tree, light_samples, surface.point, path.generator, [&](size_t light, Scalar selection_probability){
+                                auto &shadow = slots[slot++];
+                                Scalar r1 = distr(path.generator);
+                                Scalar r2 = distr(path.generator);
+                                auto light_sample = sample_light(lights[light], surface.point, r1, r2);
+                                light_sample.ray.time = path.ray.time;
+                                auto cos_theta = -bvh::dot(light_sample.ray.direction, surface.shading_normal);
+                                if (light_sample.radiance <= 0 || cos_theta <= 0) {
+                                    return;
+                                }
+                                auto f = evaluate_material(material, light_sample.ray.direction, wo, surface.shading_normal, surface.uv[0], surface.uv[1],
+                                                           surface.footprint);
+                                Scalar light_pdf = light_sample.pdf * selection_probability;
+                                Scalar mis_weight = 1;
+                                if (!light_sample.delta) {
+                                    mis_weight = power_heuristic(light_pdf, material_pdf(material, light_sample.ray.direction, wo, surface.shading_normal));
+                                }
+                                shadow.ray = light_sample.ray;
+                                shadow.contribution = path.throughput * f * (float)(cos_theta * light_sample.radiance / light_pdf * mis_weight);
+                                shadow.valid = true;
+                            });
+                        }
+
+                        Scalar r1 = distr(path.generator);
+                        Scalar r2 = distr(path.generator);
+                        auto bsdf_sample = sample_material_bsdf(material, wo, surface.shading_normal, surface.uv[0], surface.uv[1], r1, r2,
+                                                                surface.footprint);
+                        path.throughput *= bsdf_sample.weight;
+                        path.alive = path.throughput[0] > 0 || path.throughput[1] > 0 || path.throughput[2] > 0;
+                        path.bsdf_pdf = bsdf_sample.pdf;
+                        path.previous_point = surface.point;
+                        path.ray = bvh::Ray<Scalar>(surface.point, bsdf_sample.direction, 0, std::numeric_limits<Scalar>::max(), path.ray.time);
+                    }
+                    else {
+                        path.vertex_weight = path.throughput;
+                        path.clamp_vertex = bounce >= 1;
+                        for_each_light_sample(light_tree, light_samples, surface.point, path.generator, [&](size_t light, Scalar selection_probability){
+                            auto &shadow = slots[slot++];
+                            Scalar r1 = distr(path.generator);
+                            Scalar r2 = distr(path.generator);
+                            auto light_sample = sample_light(lights[light], surface.point, r1, r2);
+                            light_sample.ray.time = path.ray.time;
+                            auto light_color = compute_material(material, light_sample.ray, path.ray, surface.shading_normal, surface.uv[0], surface.uv[1],
+                                                                surface.footprint);
+                            shadow.ray = light_sample.ray;
+                            shadow.contribution = light_color * (float) (light_sample.intensity / selection_probability);
+                            shadow.valid = true;
+                        });
+
+                        path.alive = bounce < num_bounces - 1;
+                        if (path.alive) {
+                            Scalar r1 = distr(path.generator);
+                            Scalar r2 = distr(path.generator);
+                            auto [new_direction, bounce_color] = sample_material(material, path.ray, surface.shading_normal, surface.uv[0], surface.uv[1], r1, r2);
+                            path.ray = bvh::Ray<Scalar>(surface.point, new_direction, 0, std::numeric_limits<Scalar>::max(), path.ray.time);
+                            path.throughput *= bounce_color;
+                        }
+                    }
+                }
+
+                // Trace all shadow rays (in the order of their paths), then add the unoccluded
+                // contributions to their paths:
+                #pragma omp parallel for schedule(dynamic, 256)
+                for (size_t s = 0; s < size * shadow_rays_per_vertex; ++s) {
+                    BusyTimer busy;
+                    if (shadow_rays[s].valid && occlusion_traverser.occluded(shadow_rays[s].ray)) {
+                        shadow_rays[s].valid = false;
+                    }
+                }
+
+                #pragma omp parallel for
+                for (size_t p = 0; p < size; ++p) {
+                    auto &path = paths[p];
+                    Color vertex_radiance(0);
+                    for (size_t s = 0; s < shadow_rays_per_vertex; ++s) {
+                        auto &shadow = shadow_rays[p * shadow_rays_per_vertex + s];
+                        if (shadow.valid) {
+                            vertex_radiance += shadow.contribution;
+                        }
+                    }
+                    if (path.clamp_vertex) {
+                        for (int idx = 0; idx < 3; ++idx){
+                            vertex_radiance[idx] = std::clamp(vertex_radiance[idx], float(0), float(1));
+                        }
+                    }
+                    path.radiance += vertex_radiance * path.vertex_weight;
+                }
+
+                // Retire the paths that do not continue, and compact the rest:
+                size_t next_size = 0;
+                for (size_t p = 0; p < size; ++p) {
+                    if (paths[p].alive) {
+                        if (next_size != p) {
+                            paths[next_size] = paths[p];
+                        }
+                        next_size++;
+                    }
+                    else {
+                        path_radiance[paths[p].slot] = paths[p].radiance;
+                    }
+                }
+                size = next_size;
+            }
+
+            // Run adaptive sampling:
+            #pragma omp parallel for
+            for (size_t a = 0; a < count / round_samples; ++a) {
+                for (size_t s = 0; s < round_samples; ++s) {
+                    auto pixel = active[batch_start + a];
+                    auto rad_contrib = (path_radiance[a * round_samples + s] - pixel_radiance[pixel])*(1.0f/(sample + s));
+                    pixel_radiance[pixel] += rad_contrib;
+                    if (sample + s >= (size_t) min_samples && bvh::length(rad_contrib) < noise_threshold) {
+                        converged[batch_start + a] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+        sample += round_samples;
+
+        size_t remaining = 0;
+        for (size_t a = 0; a < active.size(); ++a) {
+            if (!converged[a]) {
+                active[remaining++] = active[a];
+            }
+        }
+        active.resize(remaining);
+    }
+
+    for (size_t pixel = 0; pixel < width * height; ++pixel) {
+        pixels[4*pixel    ] = pixel_radiance[pixel][0];
+        pixels[4*pixel + 1] = pixel_radiance[pixel][1];
+        pixels[4*pixel + 2] = pixel_radiance[pixel][2];
+        pixels[4*pixel + 3] = 1;
+    }
+    return pixels;
+};
+
+#endif
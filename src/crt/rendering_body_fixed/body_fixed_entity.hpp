@@ -1,7 +1,12 @@
 #ifndef __BODY_FIXED_ENTITY_H
 #define __BODY_FIXED_ENTITY_H
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "materials/material.hpp"
+#include "acceleration/heightfield.hpp"
 
 template <typename Scalar>
 class BodyFixedEntity: public RigidBody<Scalar> {
@@ -10,15 +15,84 @@ class BodyFixedEntity: public RigidBody<Scalar> {
         std::string geometry_type;
         bool smooth_shading;
         Color color;
+        std::string texture_path;
+
+        // Radii of an analytic ellipsoid, used when geometry_type is "ellipsoid":
+        bvh::Vector3<Scalar> radii;
+
+        // Raster of a terrain, used when geometry_type is "heightfield":
+        std::shared_ptr<const HeightfieldRaster> raster;
+
+        // Levels of detail given to the entity when its group is created (see Entity::generate_lods()
+        // and Entity::add_lod()).  No levels are generated while lod_levels is 0:
+        struct LodFile {
+            std::string geometry_path;
+            std::string geometry_type;
+            Scalar error;
+        };
+        size_t lod_levels = 0;
+        size_t lod_min_triangles = 1000;
+        std::string lod_cache_path;
+        std::vector<LodFile> lod_files;
+        Scalar lod_tolerance = 1;
 
         Scalar scale;
 
-        BodyFixedEntity(std::string geometry_path, std::string geometry_type, bool smooth_shading, Color color){
+        BodyFixedEntity(std::string geometry_path, std::string geometry_type, bool smooth_shading, Color color, std::string texture_path = ""){
             this->geometry_path = geometry_path;
             this->geometry_type = geometry_type;
             this->smooth_shading = smooth_shading;
             this->color = color;
+            this->texture_path = texture_path;
+            initialize();
+        }
+
+        BodyFixedEntity(bvh::Vector3<Scalar> radii, Color color, std::string texture_path = ""){
+            this->geometry_type = "ellipsoid";
+            this->smooth_shading = true;
+            this->color = color;
+            this->texture_path = texture_path;
+            this->radii = radii;
+            initialize();
+        }
+
+        BodyFixedEntity(std::shared_ptr<const HeightfieldRaster> raster, bool smooth_shading, Color color, std::string texture_path = ""){
+            this->geometry_type = "heightfield";
+            this->smooth_shading = smooth_shading;
+            this->color = color;
+            this->texture_path = texture_path;
+            this->raster = raster;
+            initialize();
+        }
+
+        bool is_ellipsoid() const {
+            return geometry_type == "ellipsoid";
+        }
+
+        bool is_heightfield() const {
+            return geometry_type == "heightfield";
+        }
+
+        void set_scale(Scalar scale){
+            this -> scale = scale;
+        }
+
+        void generate_lods(size_t max_levels, size_t min_triangles, std::string cache_path){
+            this -> lod_levels = max_levels;
+            this -> lod_min_triangles = min_triangles;
+            this -> lod_cache_path = cache_path;
+        }
 
+        void add_lod(std::string geometry_path, std::string geometry_type, Scalar error){
+            this -> lod_files.push_back(LodFile{geometry_path, geometry_type, error});
+        }
+
+        void set_lod_tolerance(Scalar lod_tolerance){
+            this -> lod_tolerance = lod_tolerance;
+        }
+
+    private:
+        void initialize(){
             // Default values for all pose information:
             this -> scale = 1;
             this -> position = bvh::Vector3<Scalar>(0,0,0);
@@ -32,10 +106,6 @@ class BodyFixedEntity: public RigidBody<Scalar> {
             this -> rotation[2][1] = 0;
             this -> rotation[2][2] = 1;
         }
-
-        void set_scale(Scalar scale){
-            this -> scale = scale;
-        }
 };
 
 #endif
\ No newline at end of file
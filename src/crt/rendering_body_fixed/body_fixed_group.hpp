@@ -4,11 +4,8 @@
 #include <memory>
 #include <vector>
 #include <random>
-
-#include <bvh/binned_sah_builder.hpp>
-#include <bvh/sweep_sah_builder.hpp>
-#include <bvh/parallel_reinsertion_optimizer.hpp>
-#include <bvh/node_layout_optimizer.hpp>
+#include <stdexcept>
+#include <string>
 
 #include "bvh/bvh.hpp"
 #include "bvh/single_ray_traverser.hpp"
@@ -21,8 +18,9 @@
 
 // CRT Imports:
 #include "transform.hpp"
+#include "acceleration/acceleration_structure.hpp"
 
-#include "lights/light.hpp"
+#include "lights/light_variant.hpp"
 #include "cameras/camera.hpp"
 #include "lidars/lidar.hpp"
 
@@ -32,96 +30,213 @@
 #include "do_lidar.hpp"
 
 #include "passes.hpp"
+#include "statistics.hpp"
 
 template <typename Scalar>
 class BodyFixedGroup: public RigidBody<Scalar> {
     public:
-        bvh::Bvh<Scalar> bvh_cache;
-        std::vector<bvh::Triangle<Scalar>> triangles;
+        AccelerationStructure<Scalar> scene;
+
+        // SAH cost of the hierarchy when it was last built from scratch.  Refitting after
+        // update_vertices() degrades the hierarchy, so once the cost has grown by more than
+        // rebuild_threshold times this value a full rebuild is performed instead:
+        Scalar build_cost;
+        Scalar rebuild_threshold = 1.5;
 
         Scalar scale;
 
         // Constructor:
-        BodyFixedGroup(std::vector<Entity<Scalar>*> entities){
-            // Store triangles locally:
-            for (auto entity : entities) {
-                // Apply current entity transofmrations:
-                auto entity_triangles = entity->triangles;
-                resize_triangles(entity_triangles, entity->scale);
-                rotate_triangles(entity_triangles, entity->rotation);
-                translate_triangles(entity_triangles, entity->position);
-
-                // Store into triangle vector:
-                triangles.insert(triangles.end(), entity_triangles.begin(), entity_triangles.end());
-            }
+        BodyFixedGroup(std::vector<Entity<Scalar>*> entities, const BuildOptions &build_options)
+            : scene(entities, build_options) {
+            log_stream() << "\n" << scene.statistics << "\n";
+            build_cost = scene.statistics.sah_cost;
+        }
 
-            // Build an acceleration data structure for this object set
-            size_t reference_count = triangles.size();
-            std::unique_ptr<bvh::Triangle<Scalar>[]> shuffled_triangles;
+        // Build an acceleration data structure for this object set
+        void rebuild_bvh(){
+            scene.build();
+            log_stream() << "\n" << scene.statistics << "\n";
+            build_cost = scene.statistics.sah_cost;
+        }
+
+        // Switch entities to the levels of detail a camera (or the finest any of several cameras) needs,
+        // rebuilding the scene if any changed.  Returns true if it was rebuilt:
+        template <typename Cameras>
+        bool select_lods(const Cameras &cameras){
+            if (::select_lods(scene.entities, cameras)) {
+                scene.flatten();
+                rebuild_bvh();
+                return true;
+            }
+            return false;
+        }
 
-            std::cout << "\nBuilding Static BVH ( using SweepSahBuilder )... for " << triangles.size() << " triangles\n";
-            using namespace std::chrono;
-            auto start = high_resolution_clock::now();
+        // Charge the statistics of a call for the rebuild it needed, if any:
+        void add_rebuild_time(RenderStatistics *statistics, bool rebuilt) const {
+            if (rebuilt) {
+                add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
+            }
+        }
 
-            auto tri_data = triangles.data();
-            auto bboxes_and_centers = bvh::compute_bounding_boxes_and_centers(tri_data, triangles.size());
-            auto bboxes = bboxes_and_centers.first.get(); 
-            auto centers = bboxes_and_centers.second.get(); 
-            
-            auto global_bbox = bvh::compute_bounding_boxes_union(bboxes, triangles.size());
+        const BuildStatistics& get_build_statistics() const {
+            return scene.statistics;
+        }
 
-            bvh::SweepSahBuilder<bvh::Bvh<Scalar>> builder(bvh_cache);
-            builder.build(global_bbox, bboxes, centers, reference_count);
+        // Move the vertices of a single entity in place and refit the cached BVH.  The vertices are
+        // given in the entity's own frame, as three consecutive points per triangle in the same order
+        // the triangles were loaded.  The scale, rotation and position the entity currently has are then
+        // applied (groups built from Python hold their own copies of the entities, posed as they were when
+        // the group was constructed).  Vertex normals are left unchanged:
+        void update_vertices(uint32_t id, const std::vector<bvh::Vector3<Scalar>> &vertices){
+            auto start = std::chrono::high_resolution_clock::now();
+
+            size_t index = 0;
+            auto &entities = scene.entities;
+            while (index < entities.size() && entities[index]->id != id) {
+                index++;
+            }
+            if (index == entities.size()) {
+                throw std::invalid_argument("BodyFixedGroup contains no entity with id " + std::to_string(id));
+            }
 
-            bvh::ParallelReinsertionOptimizer<bvh::Bvh<Scalar>> pro_opt(bvh_cache);
-            pro_opt.optimize();
+            auto entity = entities[index];
+            if (!entity->lods.empty()) {
+                throw std::invalid_argument("Vertices of entity " + std::to_string(id) + " cannot be updated, since it has levels of detail");
+            }
+            size_t begin = scene.entity_offsets[index];
+            size_t end   = begin + entity->active_triangles().size();
+            if (vertices.size() != 3*(end - begin)) {
+                throw std::invalid_argument("Expected " + std::to_string(3*(end - begin)) + " vertices for entity " + 
+                                            std::to_string(id) + " but received " + std::to_string(vertices.size()));
+            }
 
-            bvh::NodeLayoutOptimizer<bvh::Bvh<Scalar>> nlo_opt(bvh_cache);
-            nlo_opt.optimize();
+            const AffineTransform<Scalar> affine(entity->rotation, entity->position, entity->scale);
+            #pragma omp parallel for
+            for (size_t i = begin; i < end; ++i) {
+                size_t v = 3*(i - begin);
+                auto p0 = affine.apply(vertices[v + 0]);
+                auto p1 = affine.apply(vertices[v + 1]);
+                auto p2 = affine.apply(vertices[v + 2]);
+                scene.triangles[i].update_vertices(p0, p1, p2);
+            }
 
-            auto stop = high_resolution_clock::now();
-            auto duration = duration_cast<microseconds>(stop - start);
-            std::cout << "    BVH of "
-                << bvh_cache.node_count << " node(s) and "
-                << reference_count << " reference(s)\n";
-            std::cout << "    BVH built in " << duration.count()/1000000.0 << " seconds\n\n";
+            // Rebuild from scratch if the refitted hierarchy has degraded too far:
+            auto cost = scene.refit();
+            auto stop = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+            log_stream() << "    BVH refit in " << duration.count()/1000000.0 << " seconds\n";
+            if (cost > rebuild_threshold*build_cost) {
+                log_stream() << "    BVH cost grew from " << build_cost << " to " << cost << ", rebuilding...\n";
+                rebuild_bvh();
+                stop = std::chrono::high_resolution_clock::now();
+                duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+                log_stream() << "    BVH refit and rebuild in " << duration.count()/1000000.0 << " seconds\n";
+            }
+        }
 
+        void set_rebuild_threshold(Scalar rebuild_threshold){
+            this -> rebuild_threshold = rebuild_threshold;
         }
 
         void set_scale(Scalar scale){
             this -> scale = scale;
         }
 
-        std::vector<uint8_t> render(std::unique_ptr<Camera<Scalar>> &camera, std::vector<std::unique_ptr<Light<Scalar>>> &lights,
-                                    int min_samples, int max_samples, Scalar noise_threshold, int num_bounces){
-            auto image = do_render(camera, lights, bvh_cache, triangles, min_samples, max_samples, noise_threshold, num_bounces);
+        std::vector<uint8_t> render(std::unique_ptr<Camera<Scalar>> &camera, const std::vector<LightVariant<Scalar>> &lights,
+                                    int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                    Integrator integrator = Integrator::Unidirectional, int light_samples = 0,
+                                    bool wavefront = false, std::vector<EntityMeasurements<Scalar>> *measurements = nullptr,
+                                    RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto image = do_render(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                   integrator, light_samples, wavefront, measurements, statistics);
+            add_rebuild_time(statistics, rebuilt);
             return image;
         }
 
-        Scalar simulate_lidar(std::unique_ptr<Lidar<Scalar>> &lidar, int num_rays){
-            auto distance = do_lidar(lidar, this->bvh_cache, this->triangles, num_rays);
+        // Render, as above, the RGBA radiance of every pixel before quantization:
+        std::vector<float> render_pixels(std::unique_ptr<Camera<Scalar>> &camera, const std::vector<LightVariant<Scalar>> &lights,
+                                         int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                         Integrator integrator = Integrator::Unidirectional, int light_samples = 0,
+                                         bool wavefront = false, std::vector<EntityMeasurements<Scalar>> *measurements = nullptr,
+                                         RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto pixels = ::render_pixels(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                          integrator, light_samples, wavefront, measurements, statistics);
+            add_rebuild_time(statistics, rebuilt);
+            return pixels;
+        }
+
+        // Render one image per camera against the cached BVH, in a single parallel pass over every
+        // frame.  All cameras must share a resolution; the frames are returned one after the other:
+        std::vector<uint8_t> render_batch(std::vector<std::unique_ptr<Camera<Scalar>>> &cameras,
+                                          const std::vector<LightVariant<Scalar>> &lights,
+                                          int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                          Integrator integrator = Integrator::Unidirectional, int light_samples = 0,
+                                          bool wavefront = false, RenderStatistics *statistics = nullptr){
+            if (cameras.empty()) {
+                return {};
+            }
+            for (auto &camera : cameras) {
+                if (camera->get_resolutionX() != cameras[0]->get_resolutionX() ||
+                    camera->get_resolutionY() != cameras[0]->get_resolutionY()) {
+                    throw std::invalid_argument("All cameras of a batch must have the same resolution");
+                }
+            }
+            bool rebuilt = select_lods(cameras);
+            auto images = do_render_batch(cameras, lights, scene, min_samples, max_samples, noise_threshold, num_bounces,
+                                          integrator, light_samples, wavefront, statistics);
+            add_rebuild_time(statistics, rebuilt);
+            return images;
+        }
+
+        Scalar simulate_lidar(std::unique_ptr<Lidar<Scalar>> &lidar, int num_rays, RenderStatistics *statistics = nullptr){
+            auto distance = do_lidar(lidar, scene, num_rays, statistics);
             return distance;
         }
 
-        std::vector<Scalar> batch_simulate_lidar(std::unique_ptr<Lidar<Scalar>> &lidar, int num_rays){
-            auto distances = do_batch_lidar(lidar, this->bvh_cache, this->triangles, num_rays);
+        std::vector<Scalar> batch_simulate_lidar(std::unique_ptr<Lidar<Scalar>> &lidar, int num_rays,
+                                                 RenderStatistics *statistics = nullptr){
+            auto distances = do_batch_lidar(lidar, scene, num_rays, statistics);
             return distances;
         }
 
-        std::vector<Scalar> intersection_pass(std::unique_ptr<Camera<Scalar>> &camera){
-            auto intersections = get_inetersections<Scalar>(camera, this->bvh_cache, this->triangles);
+        std::vector<Scalar> intersection_pass(std::unique_ptr<Camera<Scalar>> &camera, RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto intersections = get_inetersections<Scalar>(camera, scene, statistics);
+            add_rebuild_time(statistics, rebuilt);
             return intersections;
         }
 
-        std::vector<uint32_t> instance_pass(std::unique_ptr<Camera<Scalar>> &camera){
-            auto instances = get_instances<Scalar>(camera, this->bvh_cache, this->triangles);
+        std::vector<uint32_t> instance_pass(std::unique_ptr<Camera<Scalar>> &camera, RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto instances = get_instances<Scalar>(camera, scene, statistics);
+            add_rebuild_time(statistics, rebuilt);
             return instances;
         }
 
-        std::vector<Scalar> normal_pass(std::unique_ptr<Camera<Scalar>> &camera){
-            auto normals = get_normals<Scalar>(camera, this->bvh_cache, this->triangles);
+        std::vector<Scalar> normal_pass(std::unique_ptr<Camera<Scalar>> &camera, RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto normals = get_normals<Scalar>(camera, scene, statistics);
+            add_rebuild_time(statistics, rebuilt);
             return normals;
         }
+
+        std::vector<uint32_t> traversal_cost_pass(std::unique_ptr<Camera<Scalar>> &camera, RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto costs = get_traversal_costs<Scalar>(camera, scene, statistics);
+            add_rebuild_time(statistics, rebuilt);
+            return costs;
+        }
+
+        std::vector<EntityMeasurements<Scalar>> measurement_pass(std::unique_ptr<Camera<Scalar>> &camera,
+                                                                 const std::vector<LightVariant<Scalar>> &lights,
+                                                                 RenderStatistics *statistics = nullptr){
+            bool rebuilt = select_lods(*camera);
+            auto measurements = get_measurements<Scalar>(camera, scene, lights, statistics);
+            add_rebuild_time(statistics, rebuilt);
+            return measurements;
+        }
         
 };
 
@@ -1,22 +1,30 @@
 #ifndef __ENTITY_H
 #define __ENTITY_H
 
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <random>
 
 #include "bvh/bvh.hpp"
 #include "bvh/triangle.hpp"
+#include "bvh/ellipsoid.hpp"
 #include "bvh/vector.hpp"
 
+#include "acceleration/heightfield.hpp"
+
 #include "model_loaders/happly.hpp"
 #include "model_loaders/tiny_obj_loader.hpp"
 #include "model_loaders/obj.hpp"
 
+#include "rigid_body.hpp"
 #include "transform.hpp"
 
 #include "materials/material.hpp"
 
+#include "lod/level_of_detail.hpp"
+#include "statistics.hpp"
+
 template <typename Scalar>
 class Entity: public RigidBody<Scalar> {
     public:
@@ -24,21 +32,24 @@ class Entity: public RigidBody<Scalar> {
         uint32_t id;
 
         std::vector<bvh::Triangle<Scalar>> triangles;
-        std::vector<std::shared_ptr<Material<Scalar>>> materials;
-        std::shared_ptr<UVMap<size_t>> material_map;
+        std::vector<bvh::Ellipsoid<Scalar>> ellipsoids;
+        std::vector<Heightfield<Scalar>> heightfields;
+        std::vector<MaterialVariant<Scalar>> materials;
         bool smooth_shading;
 
-        Entity(std::string geometry_path, std::string geometry_type, bool smooth_shading, Color color){
+        // Decimated copies of the triangles, from finest to coarsest (see lod/level_of_detail.hpp).
+        // active_lod is 0 while the full mesh is in use and i while lods[i-1] is, and is picked for
+        // each frame by select_lods() so that the error of the level stays below lod_tolerance pixels.
+        // The bounding sphere, in the entity's frame, gives the distance the error is seen from:
+        std::vector<LevelOfDetail<Scalar>> lods;
+        size_t active_lod = 0;
+        Scalar lod_tolerance = 1;
+        bvh::Vector3<Scalar> lod_center;
+        Scalar lod_radius = 0;
+
+        Entity(std::string geometry_path, std::string geometry_type, bool smooth_shading, Color color, std::string texture_path = ""){
             // Load the mesh geometry:
-            std::vector<bvh::Triangle<Scalar>> new_triangles;
-            std::transform(geometry_type.begin(), geometry_type.end(), geometry_type.begin(), static_cast<int(*)(int)>(std::tolower));
-            if (geometry_type.compare("obj") == 0) {
-                new_triangles = obj::load_from_file<Scalar>(geometry_path);
-            } 
-            else { 
-                std::cout << "file type of " << geometry_type << " is not a valid.  crt currently supports obj\n";
-            }
-            std::cout << new_triangles.size() << " triangles loaded from " << geometry_path << "\n";
+            auto new_triangles = load_triangles(geometry_path, geometry_type);
 
             // Set current entity as the parent object for all input triangles:
             for (auto &tri : new_triangles) {
@@ -47,23 +58,73 @@ class Entity: public RigidBody<Scalar> {
             }
 
             this->smooth_shading = smooth_shading;
+            initialize(color, texture_path);
+        }
 
-            //TODO: REMOVE ALL OF THE HARDCODED STUFF HERE:
-            this->materials.emplace_back(new ColoredLambertianMaterial<Scalar>(color));
-            this->material_map = std::shared_ptr<UVMap<size_t>>(new ConstantUVMap<size_t>(0));
+        // Analytic triaxial ellipsoid centered on the entity's origin, with the given radii along its
+        // own x, y and z axes (a sphere when all three are equal).  It is a single primitive however
+        // close the camera gets, and its texture coordinates are longitude and latitude, so an
+        // equirectangular texture wraps the whole body:
+        Entity(bvh::Vector3<Scalar> radii, Color color, std::string texture_path = ""){
+            bvh::Ellipsoid<Scalar> ellipsoid(bvh::Vector3<Scalar>(0,0,0), radii);
+            ellipsoid.set_parent(this);
+            this -> ellipsoids.push_back(ellipsoid);
 
-            // Default values for all pose information:
-            this -> scale = 1;
-            this -> position = bvh::Vector3<Scalar>(0,0,0);
-            this -> rotation[0][0] = 1;
-            this -> rotation[0][1] = 0;
-            this -> rotation[0][2] = 0;
-            this -> rotation[1][0] = 0;
-            this -> rotation[1][1] = 1;
-            this -> rotation[1][2] = 0;
-            this -> rotation[2][0] = 0;
-            this -> rotation[2][1] = 0;
-            this -> rotation[2][2] = 1;
+            this->smooth_shading = true;
+            initialize(color, texture_path);
+        }
+
+        // Terrain given as a raster of heights, traced through its own quadtree without ever being
+        // converted to triangles.  Post (row, col) lies at (col*spacing_x, row*spacing_y, height) in the
+        // entity's frame, and a texture covers the whole raster:
+        Entity(std::shared_ptr<const HeightfieldRaster> raster, bool smooth_shading, Color color, std::string texture_path = ""){
+            Heightfield<Scalar> heightfield(raster);
+            heightfield.set_parent(this);
+            this -> heightfields.push_back(heightfield);
+
+            this->smooth_shading = smooth_shading;
+            initialize(color, texture_path);
+        }
+
+        // An entity can move from its pose to an end pose while an image is exposed, on the clock of
+        // the camera's shutter (see Camera::set_shutter()): its origin follows a straight line, and it
+        // turns by the shortest rotation between the two attitudes.  Its primitives stay in the pose,
+        // and the scene bounds them over the whole motion (see AccelerationStructure::flatten()):
+        bool moving = false;
+        bvh::Vector3<Scalar> end_position;
+        Scalar end_rotation[3][3];
+        RigidMotion<Scalar> motion;
+
+        void set_motion(bvh::Vector3<Scalar> end_position, Scalar end_rotation[3][3]) {
+            this -> moving = true;
+            this -> end_position = end_position;
+            for (int i = 0; i < 3; i++){
+                for (int j = 0; j < 3; j++){
+                    this -> end_rotation[i][j] = end_rotation[i][j];
+                }
+            }
+        }
+
+        void clear_motion() {
+            this -> moving = false;
+        }
+
+        // Rotations map the entity frame to the world frame, so the world frame rotation from the
+        // pose to the end pose is end_rotation*rotation^T:
+        void prepare_motion() {
+            if (!moving) {
+                return;
+            }
+            Scalar m[3][3];
+            for (int i = 0; i < 3; i++){
+                for (int j = 0; j < 3; j++){
+                    m[i][j] = 0;
+                    for (int k = 0; k < 3; k++){
+                        m[i][j] += end_rotation[i][k]*this->rotation[j][k];
+                    }
+                }
+            }
+            motion = RigidMotion<Scalar>(this->position, end_position, m);
         }
 
         void set_id(uint32_t id){
@@ -79,10 +140,120 @@ class Entity: public RigidBody<Scalar> {
             return triangles;
         }
 
-        Material<Scalar>* get_material(float u, float v) {
-            return materials[(*material_map)(u, v)].get();
+        // Triangles of the level of detail currently in use:
+        const std::vector<bvh::Triangle<Scalar>>& active_triangles() const {
+            return active_lod == 0 ? triangles : lods[active_lod - 1].triangles;
+        }
+
+        // Simplify the mesh into a chain of up to max_levels levels of detail, each with about a quarter
+        // of the triangles of the one before and none with fewer than min_triangles.  The chain is
+        // read from cache_path when that file holds one generated from the same mesh, and written
+        // there otherwise, so that large models are only simplified once:
+        void generate_lods(size_t max_levels = 8, size_t min_triangles = 1000, std::string cache_path = ""){
+            auto start = std::chrono::high_resolution_clock::now();
+
+            std::optional<std::vector<LevelOfDetail<Scalar>>> cached;
+            if (!cache_path.empty()) {
+                cached = load_lod_chain(cache_path, triangles);
+            }
+            if (cached) {
+                lods = std::move(*cached);
+            }
+            else {
+                lods = generate_lod_chain(triangles, max_levels, min_triangles);
+                if (!cache_path.empty()) {
+                    save_lod_chain(cache_path, triangles, lods);
+                }
+            }
+            for (auto &level : lods) {
+                for (auto &tri : level.triangles) {
+                    tri.set_parent(this);
+                }
+            }
+            update_lod_bounds();
+
+            auto stop = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+            log_stream() << "    " << lods.size() << " levels of detail " << (cached ? "loaded" : "generated") << " in "
+                      << duration.count()/1000000.0 << " seconds:";
+            for (auto &level : lods) {
+                log_stream() << " " << level.triangles.size();
+            }
+            log_stream() << " triangles\n";
+        }
+
+        // Append a level of detail made elsewhere, coarser than the ones already added.  Its error is
+        // the largest distance from the full mesh in the entity's units; when none is known (error <=
+        // 0), half the mean edge length of the level is used instead:
+        void add_lod(std::vector<bvh::Triangle<Scalar>> new_triangles, Scalar error = 0){
+            if (error <= 0) {
+                Scalar length = 0;
+                for (auto &tri : new_triangles) {
+                    length += bvh::length(tri.e1) + bvh::length(tri.e2) + bvh::length(tri.e1 - tri.e2);
+                }
+                error = new_triangles.empty() ? 0 : length / (6*new_triangles.size());
+            }
+            for (auto &tri : new_triangles) {
+                tri.set_parent(this);
+            }
+            lods.push_back(LevelOfDetail<Scalar>{std::move(new_triangles), error});
+            update_lod_bounds();
+        }
+
+        void add_lod(std::string geometry_path, std::string geometry_type, Scalar error = 0){
+            add_lod(load_triangles(geometry_path, geometry_type), error);
+        }
+
+        void set_lod_tolerance(Scalar lod_tolerance){
+            this -> lod_tolerance = lod_tolerance;
+        }
+
+    private:
+        static std::vector<bvh::Triangle<Scalar>> load_triangles(std::string geometry_path, std::string geometry_type){
+            std::vector<bvh::Triangle<Scalar>> new_triangles;
+            std::transform(geometry_type.begin(), geometry_type.end(), geometry_type.begin(), static_cast<int(*)(int)>(std::tolower));
+            if (geometry_type.compare("obj") == 0) {
+                new_triangles = obj::load_from_file<Scalar>(geometry_path);
+            } 
+            else { 
+                std::cout << "file type of " << geometry_type << " is not a valid.  crt currently supports obj\n";
+            }
+            log_stream() << new_triangles.size() << " triangles loaded from " << geometry_path << "\n";
+            return new_triangles;
+        }
+
+        void update_lod_bounds(){
+            auto bbox = bvh::BoundingBox<Scalar>::empty();
+            for (auto &tri : triangles) {
+                bbox.extend(tri.bounding_box());
+            }
+            lod_center = bbox.center();
+            lod_radius = bvh::length(bbox.max - lod_center);
+            active_lod = 0;
         }
 
+        void initialize(Color color, std::string texture_path){
+            //TODO: REMOVE ALL OF THE HARDCODED STUFF HERE:
+            if (texture_path.empty()) {
+                this->materials.emplace_back(ColoredLambertianMaterial<Scalar>(color));
+            }
+            else {
+                this->materials.emplace_back(TexturedLambertianMaterial<Scalar>(open_texture(texture_path)));
+            }
+
+            // Default values for all pose information:
+            this -> scale = 1;
+            this -> position = bvh::Vector3<Scalar>(0,0,0);
+            this -> rotation[0][0] = 1;
+            this -> rotation[0][1] = 0;
+            this -> rotation[0][2] = 0;
+            this -> rotation[1][0] = 0;
+            this -> rotation[1][1] = 1;
+            this -> rotation[1][2] = 0;
+            this -> rotation[2][0] = 0;
+            this -> rotation[2][1] = 0;
+            this -> rotation[2][2] = 1;
+        }
 };
 
 #endif
\ No newline at end of file
@@ -7,62 +7,55 @@
 #include "bvh/triangle.hpp"
 
 #include "cameras/camera.hpp"
-#include "lights/light.hpp"
+#include "lights/light_variant.hpp"
 #include "lidars/lidar.hpp"
 
+#include "acceleration/acceleration_structure.hpp"
+#include "lod/level_of_detail.hpp"
+#include "path_tracing/integrator.hpp"
+#include "measurements.hpp"
+#include "statistics.hpp"
+
 template <typename Scalar>
 std::vector<uint8_t> render(std::unique_ptr<Camera<Scalar>> &camera, 
-                            std::vector<std::unique_ptr<Light<Scalar>>> &lights, 
+                            const std::vector<LightVariant<Scalar>> &lights, 
                             std::vector<Entity<Scalar>*> entities,
-                            int min_samples, int max_samples, Scalar noise_threshold, int num_bounces){
-
-    bvh::Bvh<Scalar> bvh;
-    std::vector<bvh::Triangle<Scalar>> triangles;
-
-    // Store triangles locally:
-    for (auto entity : entities) {
-        // Apply current entity transofmrations:
-        auto entity_triangles = entity->triangles;
-        resize_triangles(entity_triangles, entity->scale);
-        rotate_triangles(entity_triangles, entity->rotation);
-        translate_triangles(entity_triangles, entity->position);
-
-        // Store into triangle vector:
-        triangles.insert(triangles.end(), entity_triangles.begin(), entity_triangles.end());
-    }
-
-    size_t reference_count = triangles.size();
-    std::unique_ptr<bvh::Triangle<Scalar>[]> shuffled_triangles;
-
-    std::cout << "\nBuilding BVH ( using SweepSahBuilder )... for " << triangles.size() << " triangles\n";
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    auto tri_data = triangles.data();
-    auto bboxes_and_centers = bvh::compute_bounding_boxes_and_centers(tri_data, triangles.size());
-    auto bboxes = bboxes_and_centers.first.get(); 
-    auto centers = bboxes_and_centers.second.get(); 
-    
-    auto global_bbox = bvh::compute_bounding_boxes_union(bboxes, triangles.size());
-
-    bvh::SweepSahBuilder<bvh::Bvh<Scalar>> builder(bvh);
-    builder.build(global_bbox, bboxes, centers, reference_count);
-
-    bvh::ParallelReinsertionOptimizer<bvh::Bvh<Scalar>> pro_opt(bvh);
-    pro_opt.optimize();
-
-    bvh::NodeLayoutOptimizer<bvh::Bvh<Scalar>> nlo_opt(bvh);
-    nlo_opt.optimize();
-
-    auto stop = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
-    std::cout << "    BVH of "
-        << bvh.node_count << " node(s) and "
-        << reference_count << " reference(s)\n";
-    std::cout << "    BVH built in " << duration.count()/1000000.0 << " seconds\n\n";
-
-    auto image = do_render(camera, lights, bvh, triangles, min_samples, max_samples, noise_threshold, num_bounces);
+                            int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                            const BuildOptions &build_options, Integrator integrator = Integrator::Unidirectional,
+                            int light_samples = 0, bool wavefront = false,
+                            std::vector<EntityMeasurements<Scalar>> *measurements = nullptr,
+                            RenderStatistics *statistics = nullptr){
+
+    // Build an acceleration data structure for this object set, at the levels of detail this camera needs
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
+
+    auto image = do_render(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces, integrator, light_samples,
+                           wavefront, measurements, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
     return image;
 };
 
+// Render, as above, the RGBA radiance of every pixel before quantization:
+template <typename Scalar>
+std::vector<float> render_pixels(std::unique_ptr<Camera<Scalar>> &camera, 
+                                 const std::vector<LightVariant<Scalar>> &lights, 
+                                 std::vector<Entity<Scalar>*> entities,
+                                 int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                 const BuildOptions &build_options, Integrator integrator = Integrator::Unidirectional,
+                                 int light_samples = 0, bool wavefront = false,
+                                 std::vector<EntityMeasurements<Scalar>> *measurements = nullptr,
+                                 RenderStatistics *statistics = nullptr){
+
+    select_lods(entities, *camera);
+    AccelerationStructure<Scalar> scene(entities, build_options);
+    log_stream() << "\n" << scene.statistics << "\n";
+
+    auto pixels = render_pixels(camera, lights, scene, min_samples, max_samples, noise_threshold, num_bounces, integrator,
+                                light_samples, wavefront, measurements, statistics);
+    add_build_time(statistics, scene.statistics.flatten_time + scene.statistics.build_time);
+    return pixels;
+};
+
 #endif
\ No newline at end of file
@@ -1,7 +1,12 @@
 #ifndef __RIGID_BODY_H
 #define __RIGID_BODY_H
 
+#include <algorithm>
+#include <cmath>
+
 #include <bvh/bvh.hpp>
+#include <bvh/ray.hpp>
+#include <bvh/bounding_box.hpp>
 
 template <typename Scalar>
 class RigidBody {
@@ -48,4 +53,106 @@ class RigidBody {
         }
 };
 
+// Motion of a rigid body while an image is exposed.  Its origin moves along a straight line from
+// origin to origin + translation, while the body turns by the shortest rotation between its start
+// and end attitudes, about a fixed world frame axis through its origin.  Times run from 0 at the
+// start to 1 at the end:
+template <typename Scalar>
+struct RigidMotion {
+    using Vector3 = bvh::Vector3<Scalar>;
+
+    Vector3 origin = Vector3(0, 0, 0);
+    Vector3 translation = Vector3(0, 0, 0);
+    Vector3 axis = Vector3(0, 0, 1);
+    Scalar angle = 0;
+
+    RigidMotion() = default;
+
+    // Motion from origin to end_origin, turning by a rotation given in the world frame:
+    RigidMotion(Vector3 origin, Vector3 end_origin, const Scalar m[3][3])
+        : origin(origin), translation(end_origin - origin) {
+        // Quaternion of m (Shepperd's method, from its largest component), stable for any angle:
+        Scalar trace = m[0][0] + m[1][1] + m[2][2];
+        Scalar w, x, y, z;
+        if (trace > m[0][0] && trace > m[1][1] && trace > m[2][2]) {
+            w = std::sqrt(1 + trace)/2;
+            x = (m[2][1] - m[1][2])/(4*w);
+            y = (m[0][2] - m[2][0])/(4*w);
+            z = (m[1][0] - m[0][1])/(4*w);
+        }
+        else if (m[0][0] >= m[1][1] && m[0][0] >= m[2][2]) {
+            x = std::sqrt(1 + 2*m[0][0] - trace)/2;
+            w = (m[2][1] - m[1][2])/(4*x);
+            y = (m[0][1] + m[1][0])/(4*x);
+            z = (m[0][2] + m[2][0])/(4*x);
+        }
+        else if (m[1][1] >= m[2][2]) {
+            y = std::sqrt(1 + 2*m[1][1] - trace)/2;
+            w = (m[0][2] - m[2][0])/(4*y);
+            x = (m[0][1] + m[1][0])/(4*y);
+            z = (m[1][2] + m[2][1])/(4*y);
+        }
+        else {
+            z = std::sqrt(1 + 2*m[2][2] - trace)/2;
+            w = (m[1][0] - m[0][1])/(4*z);
+            x = (m[0][2] + m[2][0])/(4*z);
+            y = (m[1][2] + m[2][1])/(4*z);
+        }
+        if (w < 0) {
+            w = -w; x = -x; y = -y; z = -z;
+        }
+        Scalar sine = std::sqrt(x*x + y*y + z*z);
+        angle = 2*std::atan2(sine, w);
+        if (sine > 0) {
+            axis = Vector3(x/sine, y/sine, z/sine);
+        }
+    }
+
+    // Turn a direction by the part of the rotation done at the given time (Rodrigues' formula):
+    Vector3 rotate(const Vector3 &d, Scalar time) const {
+        Scalar c = std::cos(time*angle), s = std::sin(time*angle);
+        return d*c + bvh::cross(axis, d)*s + axis*(bvh::dot(axis, d)*(1 - c));
+    }
+
+    // Where a point given in the start pose is at the given time, and the reverse:
+    Vector3 apply(const Vector3 &point, Scalar time) const {
+        return origin + translation*time + rotate(point - origin, time);
+    }
+
+    Vector3 apply_inverse(const Vector3 &point, Scalar time) const {
+        return origin + rotate(point - origin - translation*time, -time);
+    }
+
+    // The ray, carried back to the start pose from its time.  The motion is rigid, so a body in its
+    // start pose is hit by this ray at the same distances as it is by ray at ray.time:
+    bvh::Ray<Scalar> to_start(const bvh::Ray<Scalar> &ray) const {
+        return bvh::Ray<Scalar>(apply_inverse(ray.origin, ray.time), rotate(ray.direction, -ray.time),
+                                ray.tmin, ray.tmax, ray.time);
+    }
+
+    // Bounds, over the whole motion, of what lies in bbox in the start pose.  The rotated box is
+    // sampled every 22.5 degrees at most, and padded by the distance between the arcs its corners
+    // follow and the chords between samples.  The translation is then swept separately:
+    bvh::BoundingBox<Scalar> sweep(const bvh::BoundingBox<Scalar> &bbox) const {
+        size_t steps = std::max<size_t>(1, (size_t) std::ceil(angle/Scalar(M_PI/8)));
+        Scalar radius = 0;
+        auto swept = bvh::BoundingBox<Scalar>::empty();
+        for (int corner = 0; corner < 8; ++corner) {
+            Vector3 point(corner & 1 ? bbox.max[0] : bbox.min[0],
+                          corner & 2 ? bbox.max[1] : bbox.min[1],
+                          corner & 4 ? bbox.max[2] : bbox.min[2]);
+            radius = std::max(radius, bvh::length(point - origin));
+            for (size_t k = 0; k <= steps; ++k) {
+                swept.extend(origin + rotate(point - origin, Scalar(k)/steps));
+            }
+        }
+        Scalar sagitta = radius*(1 - std::cos(angle/(2*steps)));
+        for (int axis = 0; axis < 3; ++axis) {
+            swept.min[axis] += std::min(translation[axis], Scalar(0)) - sagitta;
+            swept.max[axis] += std::max(translation[axis], Scalar(0)) + sagitta;
+        }
+        return swept;
+    }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,456 @@
+#ifndef __SENSOR_MODEL_H
+#define __SENSOR_MODEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "statistics.hpp"
+
+// Detector applied to a rendered image: blur by a point spread function, conversion of radiance to
+// photo-electrons with shot noise, dark signal and read noise, saturation of the wells and
+// conversion to digital numbers (DN) by an analog to digital converter of a given bit depth.
+//
+// Noise is drawn from a counter based generator keyed by the seed and the index of each pixel and
+// channel, so an image is the same for a given seed however many threads expose it:
+struct SensorModel {
+    // Point spread function, either a full psf_width by psf_height kernel (row major) or, when psf_x
+    // and psf_y are given instead, the separable kernel psf_y[j]*psf_x[i].  Element (i, j) is the
+    // fraction of a pixel's light that lands (i - width/2, j - height/2) pixels away from it (to the
+    // right and down the image), so kernels should sum to 1.  Light blurred past the edges of the
+    // image is lost.  An empty kernel leaves the image sharp:
+    std::vector<float> psf;
+    size_t psf_width = 0;
+    size_t psf_height = 0;
+    std::vector<float> psf_x;
+    std::vector<float> psf_y;
+
+    // Mean photo-electrons collected per unit of rendered radiance, and dark electrons per pixel:
+    double electrons_per_unit = 1000;
+    double dark_electrons = 0;
+
+    // Poisson noise on the collected electrons, and the standard deviation of the read noise (electrons):
+    bool shot_noise = true;
+    double read_noise = 0;
+
+    // Capacity of a pixel (electrons), conversion gain (electrons per DN), offset added by the
+    // converter (DN) and its bit depth (1 to 16):
+    double full_well = std::numeric_limits<double>::infinity();
+    double gain = 1;
+    double bias = 0;
+    int bits = 12;
+
+    // Expose the mean of the red, green and blue radiance as a single channel:
+    bool monochrome = false;
+
+    // Seed of the noise, or -1 to draw a new one for every image:
+    int64_t seed = -1;
+
+    size_t channels() const {
+        return monochrome ? 1 : 3;
+    }
+
+    // Digital numbers of an RGBA radiance image (as returned by render_pixels()), channels() per pixel:
+    std::vector<uint16_t> expose(const std::vector<float> &radiance, size_t width, size_t height) const;
+};
+
+namespace sensor {
+
+// Counter based random numbers: a uniform in [0, 1) for each (key, draw) pair.  Each pixel and
+// channel has its own key:
+inline uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline double uniform(uint64_t key, uint64_t draw) {
+    return (mix(key + draw * 0x9E3779B97F4A7C15ull) >> 11) * 0x1.0p-53;
+}
+
+// Standard normal deviate from draws 0 and 1 of a key (Box-Muller):
+inline double normal(uint64_t key) {
+    double u = 1 - uniform(key, 0);
+    double v = uniform(key, 1);
+    return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * v);
+}
+
+// log(k!), from a table for small k and Stirling's series beyond:
+inline double log_factorial(double k) {
+    static const double table[10] = {0, 0, 0.69314718055994531, 1.791759469228055, 3.1780538303479458,
+                                     4.7874917427820458, 6.5792512120101012, 8.5251613610654147,
+                                     10.604602902745251, 12.801827480081469};
+    if (k < 10) {
+        return table[(int) k];
+    }
+    double r = 1 / k, r2 = r * r;
+    return (k + 0.5) * std::log(k) - k + 0.91893853320467274 + r * (1.0 / 12 - r2 * (1.0 / 360 - r2 / 1260));
+}
+
+// Poisson deviate of mean lambda from the draws (2, 3, ...) of a key.  Small means are inverted by
+// sequential search, and larger ones use the transformed rejection of Hoermann (PTRS), which takes
+// about 1.1 pairs of draws whatever the mean:
+inline double poisson(double lambda, uint64_t key) {
+    if (!(lambda > 0)) {
+        return 0;
+    }
+    uint64_t draw = 2;
+    if (lambda < 10) {
+        double u = uniform(key, draw);
+        double p = std::exp(-lambda);
+        double cumulative = p;
+        double k = 0;
+        while (u > cumulative && k < 100) {
+            k++;
+            p *= lambda / k;
+            cumulative += p;
+        }
+        return k;
+    }
+    double slam = std::sqrt(lambda);
+    double loglam = std::log(lambda);
+    double b = 0.931 + 2.53 * slam;
+    double a = -0.059 + 0.02483 * b;
+    double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+    double vr = 0.9277 - 3.6224 / (b - 2);
+    while (true) {
+        double u = uniform(key, draw++) - 0.5;
+        double v = uniform(key, draw++);
+        double us = 0.5 - std::abs(u);
+        double k = std::floor((2 * a / us + b) * u + lambda + 0.43);
+        if (us >= 0.07 && v <= vr) {
+            return k;
+        }
+        if (k < 0 || (us < 0.013 && v > us)) {
+            continue;
+        }
+        if (std::log(v) + std::log(invalpha) - std::log(a / (us * us) + b) <= -lambda + k * loglam - log_factorial(k)) {
+            return k;
+        }
+    }
+}
+
+// In place radix 2 FFTs of n (a power of 2) values, with inverse set for the unnormalized inverse.
+// Twiddle factors are tabulated once, and products are written out so that they compile to plain
+// multiply-adds rather than calls handling the infinite and NaN cases of std::complex:
+class FFT {
+    public:
+        explicit FFT(size_t n) : n(n), twiddles(n / 2) {
+            for (size_t k = 0; k < n / 2; ++k) {
+                twiddles[k] = std::polar(1.0, -2 * M_PI * k / n);
+            }
+        }
+
+        void operator()(std::complex<double> *data, bool inverse) const {
+            for (size_t i = 1, j = 0; i < n; ++i) {
+                size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                if (i < j) {
+                    std::swap(data[i], data[j]);
+                }
+            }
+            double sign = inverse ? -1 : 1;
+            for (size_t length = 2; length <= n; length <<= 1) {
+                size_t half = length / 2, stride = n / length;
+                for (size_t i = 0; i < n; i += length) {
+                    for (size_t k = 0; k < half; ++k) {
+                        double wr = twiddles[k * stride].real(), wi = sign * twiddles[k * stride].imag();
+                        auto &even = data[i + k], &odd = data[i + k + half];
+                        double r = odd.real() * wr - odd.imag() * wi;
+                        double m = odd.real() * wi + odd.imag() * wr;
+                        odd = {even.real() - r, even.imag() - m};
+                        even = {even.real() + r, even.imag() + m};
+                    }
+                }
+            }
+        }
+
+    private:
+        size_t n;
+        std::vector<std::complex<double>> twiddles;
+};
+
+// In place 2D FFT of a rows by columns row major array, with a buffer for the columns:
+inline void fft_2d(std::complex<double> *data, const FFT &row_fft, const FFT &column_fft, size_t columns, size_t rows,
+                   bool inverse, std::vector<std::complex<double>> &column) {
+    for (size_t j = 0; j < rows; ++j) {
+        row_fft(data + j * columns, inverse);
+    }
+    column.resize(rows);
+    for (size_t i = 0; i < columns; ++i) {
+        for (size_t j = 0; j < rows; ++j) {
+            column[j] = data[j * columns + i];
+        }
+        column_fft(column.data(), inverse);
+        for (size_t j = 0; j < rows; ++j) {
+            data[j * columns + i] = column[j];
+        }
+    }
+}
+
+inline size_t next_power_of_2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Convolution of the planes of an image (width by height each) with a kernel, keeping the size of
+// the image.  Separable kernels and small full kernels are applied directly, a kernel row at a time
+// across whole image rows so the inner loops vectorize.  Full kernels for which that would cost more
+// go through FFTs instead, by overlap-save over tiles small enough to stay in cache, each tile in
+// parallel and two planes at a time as the real and imaginary parts of one complex tile:
+class Convolution {
+    public:
+        Convolution(const SensorModel &sensor, size_t width, size_t height)
+            : sensor(sensor), width(width), height(height) { }
+
+        void apply(std::vector<std::vector<float>> &planes) const {
+            if (!sensor.psf_x.empty() || !sensor.psf_y.empty()) {
+                for (auto &plane : planes) {
+                    separable(plane);
+                }
+            }
+            else if (!sensor.psf.empty()) {
+                size_t fft_width = transform_size(sensor.psf_width, width);
+                size_t fft_height = transform_size(sensor.psf_height, height);
+                if (sensor.psf_width * sensor.psf_height > transform_cost(fft_width, fft_height)) {
+                    transformed(planes, fft_width, fft_height);
+                }
+                else {
+                    for (auto &plane : planes) {
+                        direct(plane);
+                    }
+                }
+            }
+        }
+
+    private:
+        const SensorModel &sensor;
+        size_t width, height;
+
+        // Add weight times row from of the image, shifted right by offset, into row to:
+        void add_shifted(const float *from, float *to, float weight, long offset) const {
+            long begin = std::max(0l, offset);
+            long end = std::min((long) width, (long) width + offset);
+            for (long x = begin; x < end; ++x) {
+                to[x] += weight * from[x - offset];
+            }
+        }
+
+        void separable(std::vector<float> &plane) const {
+            std::vector<float> kx = sensor.psf_x.empty() ? std::vector<float>{1} : sensor.psf_x;
+            std::vector<float> ky = sensor.psf_y.empty() ? std::vector<float>{1} : sensor.psf_y;
+            std::vector<float> rows(plane.size(), 0), result(plane.size(), 0);
+            long cx = kx.size() / 2, cy = ky.size() / 2;
+
+            #pragma omp parallel for
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t s = 0; s < kx.size(); ++s) {
+                    add_shifted(&plane[y * width], &rows[y * width], kx[s], (long) s - cx);
+                }
+            }
+            #pragma omp parallel for
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t t = 0; t < ky.size(); ++t) {
+                    long source = (long) y - (long) t + cy;
+                    if (source >= 0 && source < (long) height) {
+                        add_shifted(&rows[source * width], &result[y * width], ky[t], 0);
+                    }
+                }
+            }
+            plane.swap(result);
+        }
+
+        void direct(std::vector<float> &plane) const {
+            std::vector<float> result(plane.size(), 0);
+            long cx = sensor.psf_width / 2, cy = sensor.psf_height / 2;
+
+            #pragma omp parallel for
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t t = 0; t < sensor.psf_height; ++t) {
+                    long source = (long) y - (long) t + cy;
+                    if (source < 0 || source >= (long) height) {
+                        continue;
+                    }
+                    for (size_t s = 0; s < sensor.psf_width; ++s) {
+                        add_shifted(&plane[source * width], &result[y * width], sensor.psf[t * sensor.psf_width + s], (long) s - cx);
+                    }
+                }
+            }
+            plane.swap(result);
+        }
+
+        // Cost per output pixel of convolving by columns by rows transforms, in units of one weight of
+        // the direct convolution.  A butterfly on doubles costs about as much as 36 vectorized float
+        // multiply-adds, which puts the break even point near 28 by 28 kernels:
+        double transform_cost(size_t columns, size_t rows) const {
+            double tile_area = double(columns - sensor.psf_width + 1) * (rows - sensor.psf_height + 1);
+            return 36 * std::log2(double(columns * rows)) * columns * rows / tile_area;
+        }
+
+        // Cheapest transform size along one axis, no larger than needed to cover the image at once:
+        static size_t transform_size(size_t kernel, size_t image) {
+            auto cost = [&] (size_t n) {
+                return std::log2(double(n)) * n / (n - kernel + 1);
+            };
+            size_t largest = next_power_of_2(image + kernel - 1);
+            size_t best = std::min(next_power_of_2(2 * kernel), largest);
+            for (size_t n = best; n <= largest; n *= 2) {
+                if (cost(n) < cost(best)) {
+                    best = n;
+                }
+            }
+            return best;
+        }
+
+        void transformed(std::vector<std::vector<float>> &planes, size_t columns, size_t rows) const {
+            long kw = sensor.psf_width, kh = sensor.psf_height;
+            long cx = kw / 2, cy = kh / 2;
+            size_t tile_width = columns - kw + 1, tile_height = rows - kh + 1;
+            size_t tiles_x = (width + tile_width - 1) / tile_width;
+            size_t tiles_y = (height + tile_height - 1) / tile_height;
+            double normalization = 1.0 / (columns * rows);
+
+            // Transform of the kernel, scaled for the unnormalized inverse:
+            FFT row_fft(columns), column_fft(rows);
+            std::vector<std::complex<double>> kernel(columns * rows, 0), column;
+            for (long t = 0; t < kh; ++t) {
+                for (long s = 0; s < kw; ++s) {
+                    kernel[t * columns + s] = sensor.psf[t * kw + s] * normalization;
+                }
+            }
+            fft_2d(kernel.data(), row_fft, column_fft, columns, rows, false, column);
+
+            // Each tile reads the window of the image that its outputs depend on, and keeps the
+            // outputs that the circular convolution did not wrap around:
+            std::vector<std::vector<float>> results(planes.size(), std::vector<float>(width * height));
+            #pragma omp parallel
+            {
+                std::vector<std::complex<double>> tile(columns * rows), column;
+                #pragma omp for collapse(2) schedule(dynamic)
+                for (size_t ty = 0; ty < tiles_y; ++ty) {
+                    for (size_t tx = 0; tx < tiles_x; ++tx) {
+                        long x0 = tx * tile_width, y0 = ty * tile_height;
+                        long left = x0 - (kw - 1 - cx), top = y0 - (kh - 1 - cy);
+                        for (size_t p = 0; p < planes.size(); p += 2) {
+                            auto &real = planes[p];
+                            auto *imaginary = p + 1 < planes.size() ? &planes[p + 1] : nullptr;
+                            for (long j = 0; j < (long) rows; ++j) {
+                                long y = top + j;
+                                for (long i = 0; i < (long) columns; ++i) {
+                                    long x = left + i;
+                                    bool inside = x >= 0 && y >= 0 && x < (long) width && y < (long) height;
+                                    size_t k = y * width + x;
+                                    tile[j * columns + i] = inside ? std::complex<double>(real[k], imaginary ? (*imaginary)[k] : 0.0f) : 0.0;
+                                }
+                            }
+                            fft_2d(tile.data(), row_fft, column_fft, columns, rows, false, column);
+                            for (size_t k = 0; k < tile.size(); ++k) {
+                                double r = tile[k].real() * kernel[k].real() - tile[k].imag() * kernel[k].imag();
+                                double m = tile[k].real() * kernel[k].imag() + tile[k].imag() * kernel[k].real();
+                                tile[k] = {r, m};
+                            }
+                            fft_2d(tile.data(), row_fft, column_fft, columns, rows, true, column);
+                            for (long y = y0; y < std::min(y0 + (long) tile_height, (long) height); ++y) {
+                                for (long x = x0; x < std::min(x0 + (long) tile_width, (long) width); ++x) {
+                                    auto value = tile[(y - y0 + kh - 1) * columns + (x - x0 + kw - 1)];
+                                    results[p][y * width + x] = (float) value.real();
+                                    if (imaginary) {
+                                        results[p + 1][y * width + x] = (float) value.imag();
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            planes.swap(results);
+        }
+};
+
+}
+
+inline std::vector<uint16_t> SensorModel::expose(const std::vector<float> &radiance, size_t width, size_t height) const {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (bits < 1 || bits > 16) {
+        throw std::invalid_argument("Sensor bit depth must be between 1 and 16, not " + std::to_string(bits));
+    }
+    if (psf.size() != psf_width * psf_height) {
+        throw std::invalid_argument("Sensor PSF has " + std::to_string(psf.size()) + " weights, expected " +
+                                    std::to_string(psf_width) + " by " + std::to_string(psf_height));
+    }
+    if (!(gain > 0)) {
+        throw std::invalid_argument("Sensor gain must be positive");
+    }
+
+    // Split the channels into planes, which are blurred one at a time:
+    size_t count = width * height;
+    size_t planes_count = channels();
+    std::vector<std::vector<float>> planes(planes_count, std::vector<float>(count));
+    #pragma omp parallel for
+    for (size_t k = 0; k < count; ++k) {
+        const float *pixel = &radiance[4 * k];
+        if (monochrome) {
+            planes[0][k] = (pixel[0] + pixel[1] + pixel[2]) / 3;
+        }
+        else {
+            planes[0][k] = pixel[0];
+            planes[1][k] = pixel[1];
+            planes[2][k] = pixel[2];
+        }
+    }
+    sensor::Convolution(*this, width, height).apply(planes);
+
+    // Electrons to digital numbers, a row at a time.  Read noise and conversion are independent per
+    // pixel and vectorize, while shot noise is drawn first in a scalar pass:
+    uint64_t key = seed >= 0 ? (uint64_t) seed : ((uint64_t) std::random_device()() << 32 | std::random_device()());
+    key = sensor::mix(key);
+    double max_dn = std::ldexp(1.0, bits) - 1;
+    std::vector<uint16_t> image(count * planes_count);
+    #pragma omp parallel
+    {
+        std::vector<double> electrons(width);
+        #pragma omp for
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t c = 0; c < planes_count; ++c) {
+                const float *row = &planes[c][y * width];
+                uint64_t first = (y * width) * planes_count + c;
+                for (size_t x = 0; x < width; ++x) {
+                    double mean = std::max(0.0, row[x] * electrons_per_unit + dark_electrons);
+                    electrons[x] = shot_noise ? sensor::poisson(mean, sensor::mix(key + first + x * planes_count)) : mean;
+                }
+                uint16_t *out = &image[first];
+                #pragma omp simd
+                for (size_t x = 0; x < width; ++x) {
+                    double e = std::min(electrons[x], full_well);
+                    if (read_noise > 0) {
+                        e += read_noise * sensor::normal(sensor::mix(key + first + x * planes_count));
+                    }
+                    double dn = std::floor(e / gain + bias + 0.5);
+                    out[x * planes_count] = (uint16_t) std::min(std::max(dn, 0.0), max_dn);
+                }
+            }
+        }
+    }
+
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
+    log_stream() << "    Sensor exposure completed in " << duration.count()/1000000.0 << " seconds\n";
+
+    return image;
+}
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef __STATISTICS_H
+#define __STATISTICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Build summaries and timings are only printed when verbose output is enabled:
+inline bool& verbose_output() {
+    static bool verbose = false;
+    return verbose;
+}
+
+// Stream for diagnostics, which discards everything unless verbose output is enabled:
+inline std::ostream& log_stream() {
+    static std::ostream silent(nullptr);
+    return verbose_output() ? std::cout : silent;
+}
+
+// Summary of one render, pass or lidar call.  Times are in seconds, and build_time is zero when a
+// cached BVH was used.  Every closest hit query is a camera, secondary or lidar ray and every
+// visibility query a shadow ray.  node_visits counts the bounding boxes tested and primitive_tests
+// the primitives tested in the leaves that were reached.  Inside a heightfield, its quadtree nodes
+// and cells count as bounding boxes and the triangles of the cells as primitives:
+struct RenderStatistics {
+    double build_time = 0;
+    double trace_time = 0;
+    double total_time = 0;
+
+    size_t pixels = 0;
+    double samples_per_pixel = 0;
+
+    uint64_t camera_rays = 0;
+    uint64_t secondary_rays = 0;
+    uint64_t shadow_rays = 0;
+    uint64_t lidar_rays = 0;
+    uint64_t node_visits = 0;
+    uint64_t primitive_tests = 0;
+
+    // Fraction of the trace time that the threads spent tracing rather than waiting for each other
+    // or for serial work:
+    int threads = 1;
+    double thread_utilization = 0;
+};
+
+inline std::ostream& operator<<(std::ostream &os, const RenderStatistics &statistics) {
+    uint64_t rays = statistics.camera_rays + statistics.secondary_rays + statistics.shadow_rays + statistics.lidar_rays;
+    os << "    Traced " << rays << " rays (" << statistics.camera_rays << " camera, " << statistics.secondary_rays
+       << " secondary, " << statistics.shadow_rays << " shadow, " << statistics.lidar_rays << " lidar) in "
+       << statistics.trace_time << " seconds\n";
+    os << "    " << statistics.node_visits << " node visits and " << statistics.primitive_tests << " primitive tests, "
+       << statistics.samples_per_pixel << " samples per pixel, " << 100*statistics.thread_utilization
+       << "% utilization of " << statistics.threads << " threads\n";
+    return os;
+}
+
+// Totals of the tracing done during a call:
+struct TraceCounters {
+    uint64_t closest_rays = 0;
+    uint64_t occlusion_rays = 0;
+    uint64_t node_visits = 0;
+    uint64_t primitive_tests = 0;
+    uint64_t samples = 0;
+    double busy_time = 0;
+};
+
+namespace statistics {
+
+// Each thread counts into its own ThreadCounters, on its own cache line, tagged with the collection
+// they belong to.  Only the thread itself writes them, so plain loads and stores of relaxed atomics
+// suffice, and keep a collector's reads of them race free:
+struct alignas(64) ThreadCounters {
+    std::atomic<uint64_t> collection{0};
+    std::atomic<uint64_t> closest_rays{0};
+    std::atomic<uint64_t> occlusion_rays{0};
+    std::atomic<uint64_t> node_visits{0};
+    std::atomic<uint64_t> primitive_tests{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<double> busy_time{0};
+
+    ThreadCounters();
+    ~ThreadCounters();
+
+    void reset(uint64_t collection) {
+        for (auto *counter : {&closest_rays, &occlusion_rays, &node_visits, &primitive_tests, &samples}) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+        busy_time.store(0, std::memory_order_relaxed);
+        this -> collection.store(collection, std::memory_order_release);
+    }
+
+    void add_to(TraceCounters &total) const {
+        total.closest_rays += closest_rays.load(std::memory_order_relaxed);
+        total.occlusion_rays += occlusion_rays.load(std::memory_order_relaxed);
+        total.node_visits += node_visits.load(std::memory_order_relaxed);
+        total.primitive_tests += primitive_tests.load(std::memory_order_relaxed);
+        total.samples += samples.load(std::memory_order_relaxed);
+        total.busy_time += busy_time.load(std::memory_order_relaxed);
+    }
+};
+
+// Add to a counter that only the calling thread writes:
+template <typename T>
+inline void add(std::atomic<T> &counter, T value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Every thread that has counted, and the counts of threads that exited during the active collection:
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    TraceCounters retired;
+    uint64_t retired_collection = 0;
+};
+
+// Never destroyed, since threads may still exit after static destruction:
+inline Registry& registry() {
+    static Registry *value = new Registry();
+    return *value;
+}
+
+// Id of the collection in progress, zero when no StatisticsCollector is counting:
+inline std::atomic<uint64_t>& active() {
+    static std::atomic<uint64_t> value{0};
+    return value;
+}
+
+inline std::atomic<uint64_t>& last_collection() {
+    static std::atomic<uint64_t> value{0};
+    return value;
+}
+
+inline ThreadCounters::ThreadCounters() {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    registry().threads.push_back(this);
+}
+
+inline ThreadCounters::~ThreadCounters() {
+    auto &registry = statistics::registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+    uint64_t id = collection.load(std::memory_order_relaxed);
+    if (id != 0 && id == active().load(std::memory_order_relaxed)) {
+        if (registry.retired_collection != id) {
+            registry.retired = TraceCounters();
+            registry.retired_collection = id;
+        }
+        add_to(registry.retired);
+    }
+}
+
+// Whether a StatisticsCollector is currently counting:
+inline bool enabled() {
+    return active().load(std::memory_order_relaxed) != 0;
+}
+
+// The counters of this thread for the collection in progress, or nullptr when none is:
+inline ThreadCounters* local() {
+    uint64_t collection = active().load(std::memory_order_acquire);
+    if (collection == 0) {
+        return nullptr;
+    }
+    thread_local ThreadCounters counters;
+    if (counters.collection.load(std::memory_order_relaxed) != collection) {
+        counters.reset(collection);
+    }
+    return &counters;
+}
+
+// Count camera rays (pixel samples) traced by this thread:
+inline void add_samples(uint64_t samples) {
+    if (auto *counters = local()) {
+        add(counters->samples, samples);
+    }
+}
+
+}
+
+// Nodes and primitives tested by one traversal.  The traversers count into one of these as they go,
+// which costs next to nothing, and it is added to the thread's counters when the traversal returns
+// only while statistics are being collected:
+struct TraversalCount {
+    uint64_t node_visits = 0;
+    uint64_t primitive_tests = 0;
+    bool occlusion;
+
+    explicit TraversalCount(bool occlusion) : occlusion(occlusion) { }
+
+    ~TraversalCount() {
+        if (auto *counters = statistics::local()) {
+            statistics::add(occlusion ? counters->occlusion_rays : counters->closest_rays, uint64_t(1));
+            statistics::add(counters->node_visits, node_visits);
+            statistics::add(counters->primitive_tests, primitive_tests);
+        }
+    }
+};
+
+// Adds the time from its construction to its destruction to the busy time of the thread:
+class BusyTimer {
+    public:
+        BusyTimer() : active(statistics::enabled()) {
+            if (active) {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~BusyTimer() {
+            auto *counters = active ? statistics::local() : nullptr;
+            if (counters) {
+                statistics::add(counters->busy_time, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+
+    private:
+        bool active;
+        std::chrono::steady_clock::time_point start;
+};
+
+// Collects the RenderStatistics of one call into out, from construction to finish().  Nothing is
+// counted when out is nullptr.  Only one call at a time may collect statistics, so a collector
+// constructed while another is counting throws rather than disturbing it.  Tracing that other threads
+// do meanwhile, for calls that collect nothing, is counted into the active collection too:
+class StatisticsCollector {
+    public:
+        explicit StatisticsCollector(RenderStatistics *out) : out(out), start(std::chrono::steady_clock::now()) {
+            if (out) {
+                *out = RenderStatistics();
+                #ifdef _OPENMP
+                    threads = omp_get_max_threads();
+                #endif
+                uint64_t idle = 0;
+                uint64_t id = statistics::last_collection().fetch_add(1) + 1;
+                if (!statistics::active().compare_exchange_strong(idle, id)) {
+                    throw std::runtime_error("Statistics are already being collected by another call");
+                }
+                collection = id;
+            }
+        }
+
+        StatisticsCollector(const StatisticsCollector&) = delete;
+        StatisticsCollector& operator=(const StatisticsCollector&) = delete;
+
+        ~StatisticsCollector() {
+            stop();
+        }
+
+        // Fill in out for a call that traced the given number of pixels (none for lidar, whose closest
+        // hit queries are all lidar rays):
+        void finish(size_t pixels, bool lidar = false) {
+            if (!collection) {
+                return;
+            }
+            TraceCounters total;
+            {
+                auto &registry = statistics::registry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                for (auto *counters : registry.threads) {
+                    if (counters->collection.load(std::memory_order_acquire) == collection) {
+                        counters->add_to(total);
+                    }
+                }
+                if (registry.retired_collection == collection) {
+                    total = sum(total, registry.retired);
+                }
+            }
+            stop();
+
+            out->trace_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            out->total_time = out->build_time + out->trace_time;
+            out->pixels = pixels;
+            out->camera_rays = lidar ? 0 : total.samples;
+            out->samples_per_pixel = pixels ? double(total.samples) / pixels : 0;
+            out->lidar_rays = lidar ? total.closest_rays : 0;
+            out->secondary_rays = lidar ? 0 : total.closest_rays - std::min(total.closest_rays, total.samples);
+            out->shadow_rays = total.occlusion_rays;
+            out->node_visits = total.node_visits;
+            out->primitive_tests = total.primitive_tests;
+            out->threads = threads;
+            out->thread_utilization = out->trace_time > 0 ? total.busy_time / (threads * out->trace_time) : 0;
+            log_stream() << *out;
+        }
+
+    private:
+        RenderStatistics *out;
+        std::chrono::steady_clock::time_point start;
+        int threads = 1;
+        uint64_t collection = 0;
+
+        void stop() {
+            if (collection) {
+                statistics::active().store(0, std::memory_order_release);
+                collection = 0;
+            }
+        }
+
+        static TraceCounters sum(TraceCounters a, const TraceCounters &b) {
+            a.closest_rays += b.closest_rays;
+            a.occlusion_rays += b.occlusion_rays;
+            a.node_visits += b.node_visits;
+            a.primitive_tests += b.primitive_tests;
+            a.samples += b.samples;
+            a.busy_time += b.busy_time;
+            return a;
+        }
+};
+
+// Add the time to build a scene to statistics already collected, if any:
+inline void add_build_time(RenderStatistics *statistics, double seconds) {
+    if (statistics) {
+        statistics->build_time += seconds;
+        statistics->total_time += seconds;
+    }
+}
+
+#endif
@@ -3,6 +3,9 @@
 
 #include <bvh/bvh.hpp>
 #include <bvh/triangle.hpp>
+#include <bvh/ellipsoid.hpp>
+
+#include "acceleration/heightfield.hpp"
 
 
 template <typename Scalar>
@@ -19,7 +22,7 @@ bvh::Vector3<Scalar> translate(bvh::Vector3<Scalar> vector, bvh::Vector3<Scalar>
 }
 
 template <typename Scalar>
-bvh::Vector3<Scalar> rotate(bvh::Vector3<Scalar> vector, Scalar rotation[3][3]){
+bvh::Vector3<Scalar> rotate(bvh::Vector3<Scalar> vector, const Scalar rotation[3][3]){
     return bvh::Vector3<Scalar>(
         rotation[0][0]*vector[0] + rotation[0][1]*vector[1] + rotation[0][2]*vector[2],
         rotation[1][0]*vector[0] + rotation[1][1]*vector[1] + rotation[1][2]*vector[2],
@@ -28,7 +31,7 @@ bvh::Vector3<Scalar> rotate(bvh::Vector3<Scalar> vector, Scalar rotation[3][3]){
 }
 
 template <typename Scalar>
-bvh::Vector3<Scalar> transform(bvh::Vector3<Scalar> vector, Scalar rotation[3][3], bvh::Vector3<Scalar> position, Scalar scale){
+bvh::Vector3<Scalar> transform(bvh::Vector3<Scalar> vector, const Scalar rotation[3][3], bvh::Vector3<Scalar> position, Scalar scale){
     vector[0] = scale*vector[0];
     vector[1] = scale*vector[1];
     vector[2] = scale*vector[2];
@@ -39,48 +42,118 @@ bvh::Vector3<Scalar> transform(bvh::Vector3<Scalar> vector, Scalar rotation[3][3
     );
 }
 
+// Scale, rotation and translation of an entity folded into a single affine map x' = A*x + b,
+// with A = scale*rotation and b = position:
+template <typename Scalar>
+struct AffineTransform {
+    Scalar linear[3][3];
+    bvh::Vector3<Scalar> translation;
+
+    AffineTransform(const Scalar rotation[3][3], bvh::Vector3<Scalar> position, Scalar scale){
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                linear[i][j] = scale*rotation[i][j];
+            }
+        }
+        translation = position;
+    }
+
+    // Transform a direction (an edge, for example), which is unaffected by the translation:
+    bvh::Vector3<Scalar> apply_linear(const bvh::Vector3<Scalar> &vector) const {
+        return bvh::Vector3<Scalar>(
+            linear[0][0]*vector[0] + linear[0][1]*vector[1] + linear[0][2]*vector[2],
+            linear[1][0]*vector[0] + linear[1][1]*vector[1] + linear[1][2]*vector[2],
+            linear[2][0]*vector[0] + linear[2][1]*vector[1] + linear[2][2]*vector[2]
+        );
+    }
+
+    bvh::Vector3<Scalar> apply(const bvh::Vector3<Scalar> &vector) const {
+        return bvh::Vector3<Scalar>(
+            linear[0][0]*vector[0] + linear[0][1]*vector[1] + linear[0][2]*vector[2] + translation[0],
+            linear[1][0]*vector[0] + linear[1][1]*vector[1] + linear[1][2]*vector[2] + translation[1],
+            linear[2][0]*vector[0] + linear[2][1]*vector[1] + linear[2][2]*vector[2] + translation[2]
+        );
+    }
+};
+
+// Apply scale, rotation and translation to count triangles in a single parallel pass, writing the
+// results to output (which may point into a larger, preallocated buffer).  Since the map is affine
+// the stored edges only need the linear part, and the geometric normal is recomputed once from the
+// transformed edges.  The vertices are transformed individually, so that triangles sharing a vertex
+// still share its exact coordinates.  material_offset is added to each
+// triangle's material id, moving it from the entity's material list into a scene-wide table:
 template <typename Scalar>
-void resize_triangles(std::vector<bvh::Triangle<Scalar>> &triangles, Scalar scale){
-    for (auto &tri : triangles) {
-        // Scale each of the vertices:
-        auto p0 = resize(tri.p0,   scale);
-        auto p1 = resize(tri.p1(), scale);
-        auto p2 = resize(tri.p2(), scale);
-
-        // Update the triangle:
-        tri.update_vertices(p0,p1,p2);
+void transform_triangles(const bvh::Triangle<Scalar> *input, bvh::Triangle<Scalar> *output, size_t count,
+                         const Scalar rotation[3][3], bvh::Vector3<Scalar> position, Scalar scale,
+                         uint32_t material_offset = 0){
+    const AffineTransform<Scalar> affine(rotation, position, scale);
+    const AffineTransform<Scalar> normal_rotation(rotation, bvh::Vector3<Scalar>(0,0,0), Scalar(1));
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < count; ++i) {
+        const auto &in = input[i];
+        auto &out = output[i];
+
+        // Carry over colors, uvs and the parent entity:
+        out = in;
+
+        out.p0 = affine.apply(in.p0);
+        out.v1 = affine.apply(in.v1);
+        out.v2 = affine.apply(in.v2);
+        out.e1 = affine.apply_linear(in.e1);
+        out.e2 = affine.apply_linear(in.e2);
+        out.n  = bvh::cross(out.e1, out.e2);
+
+        out.vn0 = normal_rotation.apply_linear(in.vn0);
+        out.vn1 = normal_rotation.apply_linear(in.vn1);
+        out.vn2 = normal_rotation.apply_linear(in.vn2);
+
+        out.material_id = in.material_id + material_offset;
     }
 }
 
+// Apply scale, rotation and translation to count ellipsoids, as transform_triangles() does for
+// triangles.  The axes are rotated, and since the scale is uniform it only multiplies the radii:
 template <typename Scalar>
-void translate_triangles(std::vector<bvh::Triangle<Scalar>> &triangles, bvh::Vector3<Scalar> position){
-    for (auto &tri : triangles) {
-        // Transform each of the vertices:
-        auto p0 = translate(tri.p0,   position);
-        auto p1 = translate(tri.p1(), position);
-        auto p2 = translate(tri.p2(), position);
-
-        // Update the triangle:
-        tri.update_vertices(p0,p1,p2);
+void transform_ellipsoids(const bvh::Ellipsoid<Scalar> *input, bvh::Ellipsoid<Scalar> *output, size_t count,
+                          const Scalar rotation[3][3], bvh::Vector3<Scalar> position, Scalar scale,
+                          uint32_t material_offset = 0){
+    const AffineTransform<Scalar> affine(rotation, position, scale);
+    const AffineTransform<Scalar> axis_rotation(rotation, bvh::Vector3<Scalar>(0,0,0), Scalar(1));
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &in = input[i];
+        auto &out = output[i];
+
+        out = in;
+        out.origin = affine.apply(in.origin);
+        for (int axis = 0; axis < 3; ++axis) {
+            out.axes[axis] = axis_rotation.apply_linear(in.axes[axis]);
+        }
+        out.radii = scale*in.radii;
+        out.material_id = in.material_id + material_offset;
     }
 }
 
+// Place count heightfields the same way.  Only their frame moves, the rasters are shared:
 template <typename Scalar>
-void rotate_triangles(std::vector<bvh::Triangle<Scalar>> &triangles, Scalar rotation[3][3]){
-    for (auto &tri : triangles) {
-        // Rotate each of the vertices:
-        auto p0 = rotate(tri.p0,   rotation);
-        auto p1 = rotate(tri.p1(), rotation);
-        auto p2 = rotate(tri.p2(), rotation);
-
-        // Transform each of the vertex normals:
-        auto vn0 = rotate(tri.vn0, rotation);
-        auto vn1 = rotate(tri.vn1, rotation);
-        auto vn2 = rotate(tri.vn2, rotation);
-
-        // Update the triangle:
-        tri.update_vertices(p0,p1,p2);
-        tri.update_vertex_normals(vn0, vn1, vn2);
+void transform_heightfields(const Heightfield<Scalar> *input, Heightfield<Scalar> *output, size_t count,
+                            const Scalar rotation[3][3], bvh::Vector3<Scalar> position, Scalar scale,
+                            uint32_t material_offset = 0){
+    const AffineTransform<Scalar> affine(rotation, position, scale);
+    const AffineTransform<Scalar> axis_rotation(rotation, bvh::Vector3<Scalar>(0,0,0), Scalar(1));
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &in = input[i];
+        auto &out = output[i];
+
+        out = in;
+        out.origin = affine.apply(in.origin);
+        for (int axis = 0; axis < 3; ++axis) {
+            out.axes[axis] = axis_rotation.apply_linear(in.axes[axis]);
+        }
+        out.scale = scale*in.scale;
+        out.material_id = in.material_id + material_offset;
     }
 }
 
@@ -7,6 +7,7 @@
 // CRT Includes:
 #include "crt/cameras/camera.hpp"
 #include "crt/cameras/simple_camera.hpp"
+#include "crt/cameras/distorted_camera.hpp"
 
 #include "crt/lidars/lidar.hpp"
 #include "crt/lidars/simple_lidar.hpp"
@@ -14,6 +15,8 @@
 #include "crt/lights/light.hpp"
 #include "crt/lights/point_light.hpp"
 #include "crt/lights/area_light.hpp"
+#include "crt/lights/sun_light.hpp"
+#include "crt/lights/light_variant.hpp"
 
 #include "crt/rendering_body_fixed/body_fixed_entity.hpp"
 #include "crt/rendering_body_fixed/body_fixed_group.hpp"
@@ -24,6 +27,16 @@
 
 #include "crt/passes.hpp"
 
+#include "crt/acceleration/acceleration_structure.hpp"
+
+#include "crt/materials/tiled_texture.hpp"
+
+#include "crt/sensors/sensor_model.hpp"
+
+#include "crt/frame_writer.hpp"
+
+#include "crt/statistics.hpp"
+
 namespace py = pybind11;
 
 // Make this configurable at somepoint:
@@ -45,6 +58,28 @@ SimpleCamera<Scalar> create_simple_camera(Scalar focal_length, py::list resoluti
     return SimpleCamera<Scalar>(focal_length, resolution, sensor_size, z_positive);
 }
 
+DistortedCamera<Scalar> create_distorted_camera(Scalar focal_length, py::list resolution_list, py::list sensor_size_list, bool z_positive,
+                                                py::list radial_list, py::list tangential_list) {
+    Scalar resolution[2];
+    Scalar sensor_size[2];
+    Scalar radial[3];
+    Scalar tangential[2];
+
+    resolution[0] = resolution_list[0].cast<Scalar>();
+    resolution[1] = resolution_list[1].cast<Scalar>();
+
+    sensor_size[0] = sensor_size_list[0].cast<Scalar>();
+    sensor_size[1] = sensor_size_list[1].cast<Scalar>();
+
+    for (int i = 0; i < 3; i++) {
+        radial[i] = radial_list[i].cast<Scalar>();
+    }
+    tangential[0] = tangential_list[0].cast<Scalar>();
+    tangential[1] = tangential_list[1].cast<Scalar>();
+
+    return DistortedCamera<Scalar>(focal_length, resolution, sensor_size, z_positive, radial, tangential);
+}
+
 SimpleLidar<Scalar> create_simple_lidar(bool z_positive){
     return SimpleLidar<Scalar>(z_positive);
 }
@@ -62,21 +97,84 @@ PointLight<Scalar> create_pointlight(Scalar intensity){
     return PointLight<Scalar>(intensity);
 }
 
-BodyFixedEntity<Scalar> create_body_fixed_entity(std::string geometry_path, std::string geometry_type, bool smooth_shading, py::list color_list){
+SunLight<Scalar> create_sunlight(Scalar intensity, Scalar angular_radius){
+    return SunLight<Scalar>(intensity, angular_radius);
+}
+
+BodyFixedEntity<Scalar> create_body_fixed_entity(std::string geometry_path, std::string geometry_type, bool smooth_shading, py::list color_list,
+                                                 std::string texture_path){
     Color color;
     color[0] = color_list[0].cast<Scalar>();
     color[1] = color_list[1].cast<Scalar>();
     color[2] = color_list[2].cast<Scalar>();
     
-    return BodyFixedEntity<Scalar>(geometry_path, geometry_type, smooth_shading, color);
+    return BodyFixedEntity<Scalar>(geometry_path, geometry_type, smooth_shading, color, texture_path);
+}
+
+// Heights are taken as a 2D float32 array, which is used in place when it already has that type and
+// layout (np.memmap included), so a DEM is never duplicated in memory.  The raster keeps the array
+// alive for as long as it is in use:
+using HeightArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+std::shared_ptr<const HeightfieldRaster> create_heightfield_raster(HeightArray heights, py::list spacing_list){
+    if (heights.ndim() != 2) {
+        throw std::invalid_argument("Heights must be a 2D array of shape (rows, cols)");
+    }
+    auto owner = std::shared_ptr<const void>(new HeightArray(heights), [](const void *array){
+        py::gil_scoped_acquire gil;
+        delete static_cast<const HeightArray*>(array);
+    });
+    return std::make_shared<const HeightfieldRaster>(heights.data(), heights.shape(0), heights.shape(1),
+                                                     spacing_list[0].cast<double>(), spacing_list[1].cast<double>(), owner);
+}
+
+BodyFixedEntity<Scalar> create_body_fixed_heightfield(HeightArray heights, py::list spacing_list, bool smooth_shading,
+                                                      py::list color_list, std::string texture_path){
+    Color color;
+    color[0] = color_list[0].cast<Scalar>();
+    color[1] = color_list[1].cast<Scalar>();
+    color[2] = color_list[2].cast<Scalar>();
+
+    return BodyFixedEntity<Scalar>(create_heightfield_raster(heights, spacing_list), smooth_shading, color, texture_path);
+}
+
+BodyFixedEntity<Scalar> create_body_fixed_ellipsoid(py::list radii_list, py::list color_list, std::string texture_path){
+    bvh::Vector3<Scalar> radii(radii_list[0].cast<Scalar>(), radii_list[1].cast<Scalar>(), radii_list[2].cast<Scalar>());
+    Color color;
+    color[0] = color_list[0].cast<Scalar>();
+    color[1] = color_list[1].cast<Scalar>();
+    color[2] = color_list[2].cast<Scalar>();
+
+    return BodyFixedEntity<Scalar>(radii, color, texture_path);
 }
 
-Entity<Scalar>* create_entity(std::string geometry_path, std::string geometry_type, bool smooth_shading, py::list color_list){
+Entity<Scalar>* create_entity(std::string geometry_path, std::string geometry_type, bool smooth_shading, py::list color_list,
+                              std::string texture_path){
     Color color;
     color[0] = color_list[0].cast<Scalar>();
     color[1] = color_list[1].cast<Scalar>();
     color[2] = color_list[2].cast<Scalar>();
-    Entity<Scalar>* new_entity = new Entity<Scalar>(geometry_path, geometry_type, smooth_shading, color);
+    Entity<Scalar>* new_entity = new Entity<Scalar>(geometry_path, geometry_type, smooth_shading, color, texture_path);
+    return new_entity;
+}
+
+Entity<Scalar>* create_ellipsoid(py::list radii_list, py::list color_list, std::string texture_path){
+    bvh::Vector3<Scalar> radii(radii_list[0].cast<Scalar>(), radii_list[1].cast<Scalar>(), radii_list[2].cast<Scalar>());
+    Color color;
+    color[0] = color_list[0].cast<Scalar>();
+    color[1] = color_list[1].cast<Scalar>();
+    color[2] = color_list[2].cast<Scalar>();
+    Entity<Scalar>* new_entity = new Entity<Scalar>(radii, color, texture_path);
+    return new_entity;
+}
+
+Entity<Scalar>* create_heightfield(HeightArray heights, py::list spacing_list, bool smooth_shading, py::list color_list,
+                                   std::string texture_path){
+    Color color;
+    color[0] = color_list[0].cast<Scalar>();
+    color[1] = color_list[1].cast<Scalar>();
+    color[2] = color_list[2].cast<Scalar>();
+    Entity<Scalar>* new_entity = new Entity<Scalar>(create_heightfield_raster(heights, spacing_list), smooth_shading, color, texture_path);
     return new_entity;
 }
 
@@ -86,12 +184,32 @@ std::unique_ptr<Camera<Scalar>> get_camera_model(py::handle camera){
         SimpleCamera<Scalar> camera_cast = camera.cast<SimpleCamera<Scalar>>();
         camera_ptr = std::make_unique<SimpleCamera<Scalar>>(camera_cast);
     }
+    else if (py::isinstance<DistortedCamera<Scalar>>(camera)){
+        DistortedCamera<Scalar> camera_cast = camera.cast<DistortedCamera<Scalar>>();
+        camera_ptr = std::make_unique<DistortedCamera<Scalar>>(camera_cast);
+    }
     else {
         // throw an exception
     }
     return camera_ptr;
 }
 
+std::vector<LightVariant<Scalar>> get_lights(py::list lights_list){
+    std::vector<LightVariant<Scalar>> lights;
+    for (py::handle light : lights_list) { 
+        if (py::isinstance<PointLight<Scalar>>(light)){
+            lights.emplace_back(light.cast<PointLight<Scalar>>());
+        }
+        else if (py::isinstance<AreaLight<Scalar>>(light)){
+            lights.emplace_back(light.cast<AreaLight<Scalar>>());
+        }
+        else if (py::isinstance<SunLight<Scalar>>(light)){
+            lights.emplace_back(light.cast<SunLight<Scalar>>());
+        }
+    }
+    return lights;
+}
+
 std::unique_ptr<Lidar<Scalar>> get_lidar_model(py::handle lidar){
     std::unique_ptr<Lidar<Scalar>> lidar_ptr;
     if (py::isinstance<SimpleLidar<Scalar>>(lidar)){
@@ -104,7 +222,81 @@ std::unique_ptr<Lidar<Scalar>> get_lidar_model(py::handle lidar){
     return lidar_ptr;
 }
 
-BodyFixedGroup<Scalar> create_body_fixed_group(py::list body_fixed_entity_list) {
+// Per-entity measurements as a list of dicts, with the limb and terminator pixels as (N,2) arrays of (column, row):
+py::list measurements_to_python(const std::vector<EntityMeasurements<Scalar>> &measurements){
+    auto pixel_array = [](const std::vector<std::array<uint32_t, 2>> &pixels){
+        auto result = py::array_t<uint32_t>({(py::ssize_t) pixels.size(), (py::ssize_t) 2});
+        auto raw = result.mutable_data();
+        for (size_t i = 0; i < pixels.size(); i++) {
+            raw[2*i + 0] = pixels[i][0];
+            raw[2*i + 1] = pixels[i][1];
+        }
+        return result;
+    };
+
+    py::list result;
+    for (auto &entity : measurements) {
+        py::dict entry;
+        entry["id"] = entity.id;
+        entry["pixel_count"] = entity.pixel_count;
+        entry["brightness"] = entity.brightness;
+        entry["centroid"] = py::make_tuple(entity.centroid[0], entity.centroid[1]);
+        entry["bounding_box"] = py::make_tuple(entity.bounding_box[0], entity.bounding_box[1],
+                                               entity.bounding_box[2], entity.bounding_box[3]);
+        entry["limb"] = pixel_array(entity.limb);
+        entry["terminator"] = pixel_array(entity.terminator);
+        result.append(entry);
+    }
+    return result;
+}
+
+// Rendered image, either as 8 bit RGBA pixels or, when a sensor is given, as the sensor's digital numbers:
+template <typename Render>
+py::array render_image(Render render_function, const SensorModel *sensor, py::ssize_t width, py::ssize_t height){
+    if (sensor) {
+        auto pixels = render_function();
+        auto digital = sensor->expose(pixels, width, height);
+        py::ssize_t channels = sensor->channels();
+        auto result = channels == 1 ? py::array_t<uint16_t>({height, width}) : py::array_t<uint16_t>({height, width, channels});
+        std::copy(digital.begin(), digital.end(), result.mutable_data());
+        return result;
+    }
+    auto pixels = quantize_pixels(render_function());
+    auto result = py::array_t<uint8_t>({height, width, (py::ssize_t) 4});
+    std::copy(pixels.begin(), pixels.end(), result.mutable_data());
+    return result;
+}
+
+// Copy an image array of shape (rows, cols) or (rows, cols, channels) into a frame to be written:
+Frame create_frame(std::string path, py::array image){
+    Frame frame;
+    frame.path = path;
+    if (py::isinstance<py::array_t<uint8_t>>(image)) {
+        frame.format = PixelFormat::UInt8;
+    }
+    else if (py::isinstance<py::array_t<uint16_t>>(image)) {
+        frame.format = PixelFormat::UInt16;
+    }
+    else if (py::isinstance<py::array_t<float>>(image)) {
+        frame.format = PixelFormat::Float32;
+    }
+    else {
+        throw std::invalid_argument("Frames must be uint8, uint16 or float32 arrays");
+    }
+    if (image.ndim() != 2 && image.ndim() != 3) {
+        throw std::invalid_argument("Frames must have the shape (rows, cols) or (rows, cols, channels)");
+    }
+    frame.height = image.shape(0);
+    frame.width = image.shape(1);
+    frame.channels = image.ndim() == 3 ? image.shape(2) : 1;
+
+    auto contiguous = py::array::ensure(image, py::array::c_style);
+    auto data = static_cast<const uint8_t*>(contiguous.data());
+    frame.data.assign(data, data + contiguous.nbytes());
+    return frame;
+}
+
+BodyFixedGroup<Scalar> create_body_fixed_group(py::list body_fixed_entity_list, BuildOptions build_options) {
     // Convert py::list of entities to std::vector
     std::vector<Entity<Scalar>*> entities;
     uint32_t id = 1;
@@ -112,7 +304,25 @@ BodyFixedGroup<Scalar> create_body_fixed_group(py::list body_fixed_entity_list)
         BodyFixedEntity<Scalar> body_fixed_entity = body_fixed_entity_handle.cast<BodyFixedEntity<Scalar>>();
 
         //Create the new entities:
-        Entity<Scalar>* new_entity = new Entity<Scalar>(body_fixed_entity.geometry_path, body_fixed_entity.geometry_type, body_fixed_entity.smooth_shading, body_fixed_entity.color);
+        Entity<Scalar>* new_entity;
+        if (body_fixed_entity.is_ellipsoid()) {
+            new_entity = new Entity<Scalar>(body_fixed_entity.radii, body_fixed_entity.color, body_fixed_entity.texture_path);
+        }
+        else if (body_fixed_entity.is_heightfield()) {
+            new_entity = new Entity<Scalar>(body_fixed_entity.raster, body_fixed_entity.smooth_shading, body_fixed_entity.color,
+                                            body_fixed_entity.texture_path);
+        }
+        else {
+            new_entity = new Entity<Scalar>(body_fixed_entity.geometry_path, body_fixed_entity.geometry_type, body_fixed_entity.smooth_shading,
+                                            body_fixed_entity.color, body_fixed_entity.texture_path);
+        }
+        if (body_fixed_entity.lod_levels > 0) {
+            new_entity->generate_lods(body_fixed_entity.lod_levels, body_fixed_entity.lod_min_triangles, body_fixed_entity.lod_cache_path);
+        }
+        for (auto &lod : body_fixed_entity.lod_files) {
+            new_entity->add_lod(lod.geometry_path, lod.geometry_type, lod.error);
+        }
+        new_entity->set_lod_tolerance(body_fixed_entity.lod_tolerance);
         new_entity->set_scale(body_fixed_entity.scale);
         new_entity->set_position(body_fixed_entity.position);
         new_entity->set_rotation(body_fixed_entity.rotation);
@@ -123,13 +333,136 @@ BodyFixedGroup<Scalar> create_body_fixed_group(py::list body_fixed_entity_list)
         entities.emplace_back(new_entity);
     }
 
-    return BodyFixedGroup(entities);
+    return BodyFixedGroup(entities, build_options);
 }
 
 // Definition of the python wrapper module:
 PYBIND11_MODULE(_crt, crt) {
     crt.doc() = "ceres ray tracer";
 
+    py::enum_<BuilderType>(crt, "BuilderType")
+        .value("SweepSah", BuilderType::SweepSah)
+        .value("BinnedSah", BuilderType::BinnedSah)
+        .value("LocallyOrderedClustering", BuilderType::LocallyOrderedClustering)
+        .value("LinearBvh", BuilderType::LinearBvh)
+        .value("SpatialSplit", BuilderType::SpatialSplit);
+
+    py::class_<BuildOptions>(crt, "BuildOptions")
+        .def(py::init<>())
+        .def_readwrite("builder", &BuildOptions::builder)
+        .def_readwrite("optimize", &BuildOptions::optimize)
+        .def_readwrite("optimize_layout", &BuildOptions::optimize_layout)
+        .def_readwrite("max_leaf_size", &BuildOptions::max_leaf_size)
+        .def_readwrite("traversal_cost", &BuildOptions::traversal_cost)
+        .def_readwrite("split_factor", &BuildOptions::split_factor);
+
+    py::class_<FrameWriter>(crt, "FrameWriter")
+        .def(py::init<size_t, size_t>())
+        .def("write", [](FrameWriter &self, std::string path, py::array image){
+            auto frame = create_frame(path, image);
+
+            // Waiting for room in the queue must not hold up other Python threads:
+            py::gil_scoped_release release;
+            self.write(std::move(frame));
+        })
+        .def("flush", [](FrameWriter &self){
+            py::gil_scoped_release release;
+            self.flush();
+        })
+        .def("pending", &FrameWriter::pending);
+
+    crt.def("write_frame", [](std::string path, py::array image){
+        auto frame = create_frame(path, image);
+        py::gil_scoped_release release;
+        write_frame(frame);
+    });
+
+    py::class_<SensorModel>(crt, "SensorModel")
+        .def(py::init<>())
+        .def("set_psf", [](SensorModel &self, py::array_t<float, py::array::c_style | py::array::forcecast> psf){
+            if (psf.ndim() != 2) {
+                throw std::invalid_argument("PSF must be a 2D array of shape (rows, cols)");
+            }
+            self.psf.assign(psf.data(), psf.data() + psf.size());
+            self.psf_height = psf.shape(0);
+            self.psf_width = psf.shape(1);
+            self.psf_x.clear();
+            self.psf_y.clear();
+        })
+        .def("set_separable_psf", [](SensorModel &self, std::vector<float> psf_x, std::vector<float> psf_y){
+            self.psf_x = psf_x;
+            self.psf_y = psf_y;
+            self.psf.clear();
+            self.psf_width = 0;
+            self.psf_height = 0;
+        })
+        .def_readwrite("electrons_per_unit", &SensorModel::electrons_per_unit)
+        .def_readwrite("dark_electrons", &SensorModel::dark_electrons)
+        .def_readwrite("shot_noise", &SensorModel::shot_noise)
+        .def_readwrite("read_noise", &SensorModel::read_noise)
+        .def_readwrite("full_well", &SensorModel::full_well)
+        .def_readwrite("gain", &SensorModel::gain)
+        .def_readwrite("bias", &SensorModel::bias)
+        .def_readwrite("bits", &SensorModel::bits)
+        .def_readwrite("monochrome", &SensorModel::monochrome)
+        .def_readwrite("seed", &SensorModel::seed);
+
+    crt.def("bake_tiled_texture", [](std::string png_path, std::string output_path, uint32_t tile_size){
+        bake_tiled_texture(png_path, output_path, tile_size);
+    });
+
+    crt.def("bake_raw_tiled_texture", [](std::string raw_path, std::string output_path, uint32_t width, uint32_t height,
+                                         uint32_t channels, uint32_t format, uint32_t tile_size){
+        bake_raw_tiled_texture(raw_path, output_path, width, height, channels, TexelFormat(format), tile_size);
+    });
+
+    crt.def("set_tiled_texture_cache_budget", [](size_t budget_bytes){
+        tiled_texture_cache_budget() = budget_bytes;
+    });
+
+    py::class_<TiledTexture::Statistics>(crt, "TiledTextureStatistics")
+        .def_readonly("hits", &TiledTexture::Statistics::hits)
+        .def_readonly("misses", &TiledTexture::Statistics::misses)
+        .def_readonly("evictions", &TiledTexture::Statistics::evictions)
+        .def_readonly("resident_tiles", &TiledTexture::Statistics::resident_tiles)
+        .def_readonly("capacity_tiles", &TiledTexture::Statistics::capacity_tiles)
+        .def("hit_rate", &TiledTexture::Statistics::hit_rate);
+
+    crt.def("tiled_texture_statistics", [](std::string path){
+        return tiled_texture_statistics(path);
+    });
+
+    py::class_<BuildStatistics>(crt, "BuildStatistics")
+        .def_readonly("builder", &BuildStatistics::builder)
+        .def_readonly("triangle_count", &BuildStatistics::triangle_count)
+        .def_readonly("ellipsoid_count", &BuildStatistics::ellipsoid_count)
+        .def_readonly("heightfield_count", &BuildStatistics::heightfield_count)
+        .def_readonly("node_count", &BuildStatistics::node_count)
+        .def_readonly("reference_count", &BuildStatistics::reference_count)
+        .def_readonly("sah_cost", &BuildStatistics::sah_cost)
+        .def_readonly("flatten_time", &BuildStatistics::flatten_time)
+        .def_readonly("build_time", &BuildStatistics::build_time);
+
+    crt.def("set_verbose", [](bool verbose){
+        verbose_output() = verbose;
+    });
+
+    py::class_<RenderStatistics>(crt, "RenderStatistics")
+        .def(py::init<>())
+        .def_readonly("build_time", &RenderStatistics::build_time)
+        .def_readonly("trace_time", &RenderStatistics::trace_time)
+        .def_readonly("total_time", &RenderStatistics::total_time)
+        .def_readonly("pixels", &RenderStatistics::pixels)
+        .def_readonly("samples_per_pixel", &RenderStatistics::samples_per_pixel)
+        .def_readonly("camera_rays", &RenderStatistics::camera_rays)
+        .def_readonly("secondary_rays", &RenderStatistics::secondary_rays)
+        .def_readonly("shadow_rays", &RenderStatistics::shadow_rays)
+        .def_readonly("lidar_rays", &RenderStatistics::lidar_rays)
+        .def_readonly("node_visits", &RenderStatistics::node_visits)
+        .def_readonly("primitive_tests", &RenderStatistics::primitive_tests)
+        .def_readonly("threads", &RenderStatistics::threads)
+        .def_readonly("thread_utilization", &RenderStatistics::thread_utilization);
+
     py::class_<SimpleCamera<Scalar>>(crt, "SimpleCamera")
         .def(py::init(&create_simple_camera))
         .def("set_position", [](SimpleCamera<Scalar> &self, py::array_t<Scalar> position){
@@ -170,7 +503,91 @@ PYBIND11_MODULE(_crt, crt) {
             }
             // Set the pose:
             self.set_pose(position_vector3, rotation_arr);
-        });
+        })
+        .def("set_motion", [](SimpleCamera<Scalar> &self, py::array_t<Scalar> position, py::array_t<double, py::array::c_style | py::array::forcecast> rotation){
+            // Get the end position:
+            py::buffer_info buffer_pos = position.request();
+            Scalar *ptr_pos = static_cast<Scalar *>(buffer_pos.ptr);
+            auto position_vector3 = Vector3(ptr_pos[0],ptr_pos[1],ptr_pos[2]);
+
+            // Get the end rotation:
+            py::buffer_info buffer_rot = rotation.request();
+            Scalar *ptr_rot = static_cast<Scalar *>(buffer_rot.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr_rot[idx];
+                    idx++;
+                }
+            }
+            self.set_motion(position_vector3, rotation_arr);
+        })
+        .def("clear_motion", &SimpleCamera<Scalar>::clear_motion)
+        .def("set_shutter", &SimpleCamera<Scalar>::set_shutter);
+
+    py::class_<DistortedCamera<Scalar>>(crt, "DistortedCamera")
+        .def(py::init(&create_distorted_camera))
+        .def("set_position", [](DistortedCamera<Scalar> &self, py::array_t<Scalar> position){
+            py::buffer_info buffer = position.request();
+            Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
+            auto position_vector3 = Vector3(ptr[0],ptr[1],ptr[2]);
+            self.set_position(position_vector3);
+        })
+        .def("set_rotation", [](DistortedCamera<Scalar> &self, py::array_t<Scalar> rotation){
+            py::buffer_info buffer = rotation.request();
+            Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr[idx];
+                    idx++;
+                }
+            }
+            self.set_rotation(rotation_arr);
+        })
+        .def("set_pose", [](DistortedCamera<Scalar> &self, py::array_t<Scalar> position, py::array_t<double, py::array::c_style | py::array::forcecast> rotation){
+            // Get the position:
+            py::buffer_info buffer_pos = position.request();
+            Scalar *ptr_pos = static_cast<Scalar *>(buffer_pos.ptr);
+            auto position_vector3 = Vector3(ptr_pos[0],ptr_pos[1],ptr_pos[2]);
+
+            // Get the rotation:
+            py::buffer_info buffer_rot = rotation.request();
+            Scalar *ptr_rot = static_cast<Scalar *>(buffer_rot.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr_rot[idx];
+                    idx++;
+                }
+            }
+            // Set the pose:
+            self.set_pose(position_vector3, rotation_arr);
+        })
+        .def("set_motion", [](DistortedCamera<Scalar> &self, py::array_t<Scalar> position, py::array_t<double, py::array::c_style | py::array::forcecast> rotation){
+            // Get the end position:
+            py::buffer_info buffer_pos = position.request();
+            Scalar *ptr_pos = static_cast<Scalar *>(buffer_pos.ptr);
+            auto position_vector3 = Vector3(ptr_pos[0],ptr_pos[1],ptr_pos[2]);
+
+            // Get the end rotation:
+            py::buffer_info buffer_rot = rotation.request();
+            Scalar *ptr_rot = static_cast<Scalar *>(buffer_rot.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr_rot[idx];
+                    idx++;
+                }
+            }
+            self.set_motion(position_vector3, rotation_arr);
+        })
+        .def("clear_motion", &DistortedCamera<Scalar>::clear_motion)
+        .def("set_shutter", &DistortedCamera<Scalar>::set_shutter);
 
     py::class_<SimpleLidar<Scalar>>(crt, "SimpleLidar")
         .def(py::init(&create_simple_lidar))
@@ -288,6 +705,48 @@ PYBIND11_MODULE(_crt, crt) {
             self.set_rotation(rotation_arr);
         });
 
+    py::class_<SunLight<Scalar>>(crt, "SunLight")
+        .def(py::init(&create_sunlight))
+        .def("set_position", [](SunLight<Scalar> &self, py::array_t<Scalar> position){
+            py::buffer_info buffer = position.request();
+            Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
+            auto position_vector3 = Vector3(ptr[0],ptr[1],ptr[2]);
+            self.set_position(position_vector3);
+        })
+        .def("set_rotation", [](SunLight<Scalar> &self, py::array_t<Scalar> rotation){
+            py::buffer_info buffer = rotation.request();
+            Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr[idx];
+                    idx++;
+                }
+            }
+            self.set_rotation(rotation_arr);
+        })
+        .def("set_pose", [](SunLight<Scalar> &self, py::array_t<Scalar> position, py::array_t<Scalar> rotation){
+            // Set the position:
+            py::buffer_info buffer_pos = position.request();
+            Scalar *ptr_pos = static_cast<Scalar *>(buffer_pos.ptr);
+            auto position_vector3 = Vector3(ptr_pos[0],ptr_pos[1],ptr_pos[2]);
+            self.set_position(position_vector3);
+
+            // Set the rotation:
+            py::buffer_info buffer_rot = rotation.request();
+            Scalar *ptr_rot = static_cast<Scalar *>(buffer_rot.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr_rot[idx];
+                    idx++;
+                }
+            }
+            self.set_rotation(rotation_arr);
+        });
+
     py::class_<AreaLight<Scalar>>(crt, "AreaLight")
         .def(py::init(&create_AreaLight))
         .def("set_position", [](AreaLight<Scalar> &self, py::array_t<Scalar> position){
@@ -332,9 +791,20 @@ PYBIND11_MODULE(_crt, crt) {
 
     py::class_<Entity<Scalar>>(crt, "Entity")
         .def(py::init(&create_entity))
+        .def(py::init(&create_ellipsoid))
+        .def(py::init(&create_heightfield))
         .def("set_scale",    [](Entity<Scalar> &self, Scalar scale){ 
             self.set_scale(scale);
         })
+        .def("generate_lods", [](Entity<Scalar> &self, size_t max_levels, size_t min_triangles, std::string cache_path){
+            self.generate_lods(max_levels, min_triangles, cache_path);
+        })
+        .def("add_lod", [](Entity<Scalar> &self, std::string geometry_path, std::string geometry_type, Scalar error){
+            self.add_lod(geometry_path, geometry_type, error);
+        })
+        .def("set_lod_tolerance", [](Entity<Scalar> &self, Scalar lod_tolerance){
+            self.set_lod_tolerance(lod_tolerance);
+        })
         .def("set_position", [](Entity<Scalar> &self, py::array_t<Scalar> position){
             py::buffer_info buffer = position.request();
             Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
@@ -373,13 +843,44 @@ PYBIND11_MODULE(_crt, crt) {
                 }
             }
             self.set_rotation(rotation_arr);
-        });
+        })
+        .def("set_motion", [](Entity<Scalar> &self, py::array_t<Scalar> position, py::array_t<double, py::array::c_style | py::array::forcecast> rotation){
+            // Get the end position:
+            py::buffer_info buffer_pos = position.request();
+            Scalar *ptr_pos = static_cast<Scalar *>(buffer_pos.ptr);
+            auto position_vector3 = Vector3(ptr_pos[0],ptr_pos[1],ptr_pos[2]);
+
+            // Get the end rotation:
+            py::buffer_info buffer_rot = rotation.request();
+            Scalar *ptr_rot = static_cast<Scalar *>(buffer_rot.ptr);
+            Scalar rotation_arr[3][3];
+            int idx = 0;
+            for (auto i = 0; i < 3; i++){
+                for (auto j = 0; j < 3; j++){
+                    rotation_arr[i][j] = ptr_rot[idx];
+                    idx++;
+                }
+            }
+            self.set_motion(position_vector3, rotation_arr);
+        })
+        .def("clear_motion", &Entity<Scalar>::clear_motion);
 
     py::class_<BodyFixedEntity<Scalar>>(crt, "BodyFixedEntity")
         .def(py::init(&create_body_fixed_entity))
+        .def(py::init(&create_body_fixed_ellipsoid))
+        .def(py::init(&create_body_fixed_heightfield))
         .def("set_scale",    [](BodyFixedEntity<Scalar> &self, Scalar scale){ 
             self.set_scale(scale);
         })
+        .def("generate_lods", [](BodyFixedEntity<Scalar> &self, size_t max_levels, size_t min_triangles, std::string cache_path){
+            self.generate_lods(max_levels, min_triangles, cache_path);
+        })
+        .def("add_lod", [](BodyFixedEntity<Scalar> &self, std::string geometry_path, std::string geometry_type, Scalar error){
+            self.add_lod(geometry_path, geometry_type, error);
+        })
+        .def("set_lod_tolerance", [](BodyFixedEntity<Scalar> &self, Scalar lod_tolerance){
+            self.set_lod_tolerance(lod_tolerance);
+        })
         .def("set_position", [](BodyFixedEntity<Scalar> &self, py::array_t<Scalar> position){
             py::buffer_info buffer = position.request();
             Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
@@ -464,53 +965,109 @@ PYBIND11_MODULE(_crt, crt) {
             }
             self.set_rotation(rotation_arr);
         })
+        .def("update_vertices", [](BodyFixedGroup<Scalar> &self, uint32_t id, 
+                                   py::array_t<Scalar, py::array::c_style | py::array::forcecast> vertices){
+            // Read the vertex data as a flat list of (x,y,z) points:
+            py::buffer_info buffer = vertices.request();
+            Scalar *ptr = static_cast<Scalar *>(buffer.ptr);
+            size_t num_vertices = buffer.size/3;
+            std::vector<Vector3> vertices_vector3;
+            vertices_vector3.reserve(num_vertices);
+            for (size_t i = 0; i < num_vertices; i++){
+                vertices_vector3.emplace_back(ptr[3*i + 0], ptr[3*i + 1], ptr[3*i + 2]);
+            }
+
+            // Move the vertices and refit the BVH:
+            self.update_vertices(id, vertices_vector3);
+        })
+        .def("set_rebuild_threshold", [](BodyFixedGroup<Scalar> &self, Scalar rebuild_threshold){
+            self.set_rebuild_threshold(rebuild_threshold);
+        })
+        .def("get_build_statistics", [](BodyFixedGroup<Scalar> &self){
+            return self.get_build_statistics();
+        })
         .def("render", [](BodyFixedGroup<Scalar> &self, py::handle camera, py::list lights_list,
-                          int min_samples, int max_samples, Scalar noise_threshold, int num_bounces){ 
+                          int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                          std::string integrator, int light_samples, bool wavefront, bool return_measurements,
+                          const SensorModel *sensor, RenderStatistics *statistics) -> py::object { 
 
             // Obtain the specific camera model:
             auto camera_ptr = get_camera_model(camera);
 
             // Convert py::list of lights to std::vector
-            std::vector<std::unique_ptr<Light<Scalar>>> lights;
-            for (py::handle light : lights_list) { 
-                if (py::isinstance<PointLight<Scalar>>(light)){
-                    PointLight<Scalar> light_new = light.cast<PointLight<Scalar>>();
-                    lights.push_back(std::make_unique<PointLight<Scalar>>(light_new));
-                }
-                else if (py::isinstance<AreaLight<Scalar>>(light)){
-                    AreaLight<Scalar> light_new = light.cast<AreaLight<Scalar>>();
-                    lights.push_back(std::make_unique<AreaLight<Scalar>>(light_new));
-                }
-            }
+            auto lights = get_lights(lights_list);
 
-            // Call the render method:
-            auto pixels = self.render(camera_ptr, lights, min_samples, max_samples, noise_threshold, num_bounces);
-
-            // Format the output image:
+            // Call the render method, and format the output image:
+            std::vector<EntityMeasurements<Scalar>> measurements;
             int width  = (size_t) floor(camera_ptr->get_resolutionX());
             int height = (size_t) floor(camera_ptr->get_resolutionY());
-            auto result = py::array_t<uint8_t>({height,width,4});
-            auto raw = result.mutable_data();
-            for (int i = 0; i < height*width*4; i++) {
-                raw[i] = pixels[i];
+            auto result = render_image([&](){
+                return self.render_pixels(camera_ptr, lights, min_samples, max_samples, noise_threshold, num_bounces,
+                                          parse_integrator(integrator), light_samples, wavefront,
+                                          return_measurements ? &measurements : nullptr, statistics);
+            }, sensor, width, height);
+            if (return_measurements) {
+                return py::make_tuple(result, measurements_to_python(measurements));
             }
             return result;
         })
-        .def("simulate_lidar", [](BodyFixedGroup<Scalar> &self, py::handle lidar, Scalar num_rays){
+        .def("render_batch", [](BodyFixedGroup<Scalar> &self, py::list camera_list, 
+                                py::array_t<Scalar, py::array::c_style | py::array::forcecast> positions,
+                                py::array_t<Scalar, py::array::c_style | py::array::forcecast> rotations,
+                                py::list lights_list, int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                                std::string integrator, int light_samples, bool wavefront, RenderStatistics *statistics){ 
+
+            // One camera per pose, copied from the camera given for it (or the only camera given):
+            size_t count = positions.shape(0);
+            if (camera_list.size() == 0 || (camera_list.size() != 1 && camera_list.size() != count)) {
+                throw std::invalid_argument("Expected one camera, or one camera per pose");
+            }
+            const Scalar *position = positions.data();
+            const Scalar *rotation = rotations.data();
+            std::vector<std::unique_ptr<Camera<Scalar>>> cameras;
+            for (size_t k = 0; k < count; ++k) {
+                auto camera_ptr = get_camera_model(camera_list[std::min(k, camera_list.size() - 1)]);
+                Scalar rotation_arr[3][3];
+                for (auto i = 0; i < 3; i++){
+                    for (auto j = 0; j < 3; j++){
+                        rotation_arr[i][j] = rotation[9*k + 3*i + j];
+                    }
+                }
+                camera_ptr->set_pose(Vector3(position[3*k], position[3*k+1], position[3*k+2]), rotation_arr);
+                camera_ptr->clear_motion();
+                cameras.push_back(std::move(camera_ptr));
+            }
+
+            // Convert py::list of lights to std::vector
+            auto lights = get_lights(lights_list);
+
+            // Call the render method:
+            auto pixels = self.render_batch(cameras, lights, min_samples, max_samples, noise_threshold, num_bounces,
+                                            parse_integrator(integrator), light_samples, wavefront, statistics);
+
+            // Format the output images:
+            py::ssize_t frames = (py::ssize_t) count;
+            py::ssize_t width  = count ? (py::ssize_t) floor(cameras[0]->get_resolutionX()) : 0;
+            py::ssize_t height = count ? (py::ssize_t) floor(cameras[0]->get_resolutionY()) : 0;
+            auto result = py::array_t<uint8_t>({frames, height, width, (py::ssize_t) 4});
+            std::copy(pixels.begin(), pixels.end(), result.mutable_data());
+            return result;
+        })
+        .def("simulate_lidar", [](BodyFixedGroup<Scalar> &self, py::handle lidar, Scalar num_rays, RenderStatistics *statistics){
             // Obtain the specific lidar model:
             auto lidar_ptr = get_lidar_model(lidar);
 
             // Call the lidar method:
-            auto distance = self.simulate_lidar(lidar_ptr, num_rays);
+            auto distance = self.simulate_lidar(lidar_ptr, num_rays, statistics);
 
             return distance;
         })
-        .def("batch_simulate_lidar", [](BodyFixedGroup<Scalar> &self, py::handle lidar, Scalar num_rays){
+        .def("batch_simulate_lidar", [](BodyFixedGroup<Scalar> &self, py::handle lidar, Scalar num_rays, RenderStatistics *statistics){
             // Obtain the specific lidar model:
             auto lidar_ptr = get_lidar_model(lidar);
 
             // Call the lidar method:
-            auto distances = self.batch_simulate_lidar(lidar_ptr, num_rays);
+            auto distances = self.batch_simulate_lidar(lidar_ptr, num_rays, statistics);
 
             // Format the output array:
             int length = (size_t) distances.size();
@@ -524,12 +1081,12 @@ PYBIND11_MODULE(_crt, crt) {
 
             return result;
         })
-        .def("intersection_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera){
+        .def("intersection_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera, RenderStatistics *statistics){
             // Obtain the specific camera model:
             auto camera_ptr = get_camera_model(camera);
 
             // Call the intersection_pass method:
-            auto intersections = self.intersection_pass(camera_ptr);
+            auto intersections = self.intersection_pass(camera_ptr, statistics);
 
             // Format the output array:
             int width  = (size_t) floor(camera_ptr->get_resolutionX());
@@ -542,12 +1099,12 @@ PYBIND11_MODULE(_crt, crt) {
             return result;
 
         })
-        .def("instance_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera){
+        .def("instance_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera, RenderStatistics *statistics){
             // Obtain the specific camera model:
             auto camera_ptr = get_camera_model(camera);
 
             // Call the instance_pass method:
-            auto instances = self.instance_pass(camera_ptr);
+            auto instances = self.instance_pass(camera_ptr, statistics);
 
             // Format the output array:
             int width  = (size_t) floor(camera_ptr->get_resolutionX());
@@ -559,12 +1116,12 @@ PYBIND11_MODULE(_crt, crt) {
             }
             return result;
         })
-        .def("normal_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera){
+        .def("normal_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera, RenderStatistics *statistics){
             // Obtain the specific camera model:
             auto camera_ptr = get_camera_model(camera);
 
             // Call the normal_pass method:
-            auto normals = self.normal_pass(camera_ptr);
+            auto normals = self.normal_pass(camera_ptr, statistics);
 
             // Format the output array:
             int width  = (size_t) floor(camera_ptr->get_resolutionX());
@@ -575,50 +1132,73 @@ PYBIND11_MODULE(_crt, crt) {
                 raw[i] = normals[i];
             }
             return result;
+        })
+        .def("traversal_cost_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera, RenderStatistics *statistics){
+            // Obtain the specific camera model:
+            auto camera_ptr = get_camera_model(camera);
+
+            // Call the traversal_cost_pass method:
+            auto costs = self.traversal_cost_pass(camera_ptr, statistics);
+
+            // Format the output array:
+            int width  = (size_t) floor(camera_ptr->get_resolutionX());
+            int height = (size_t) floor(camera_ptr->get_resolutionY());
+            auto result = py::array_t<uint32_t>({height,width,2});
+            std::copy(costs.begin(), costs.end(), result.mutable_data());
+            return result;
+        })
+        .def("measurement_pass", [](BodyFixedGroup<Scalar> &self, py::handle camera, py::list lights_list,
+                                    RenderStatistics *statistics){
+            // Obtain the specific camera model:
+            auto camera_ptr = get_camera_model(camera);
+
+            // Convert py::list of lights to std::vector
+            auto lights = get_lights(lights_list);
+
+            auto measurements = self.measurement_pass(camera_ptr, lights, statistics);
+            return measurements_to_python(measurements);
         });
 
     crt.def("render", [](py::handle camera, py::list lights_list, py::list entity_list,
-                         int min_samples, int max_samples, Scalar noise_threshold, int num_bounces){
+                         int min_samples, int max_samples, Scalar noise_threshold, int num_bounces,
+                         BuildOptions build_options, std::string integrator, int light_samples,
+                         bool wavefront, bool return_measurements, const SensorModel *sensor,
+                         RenderStatistics *statistics) -> py::object {
 
         // Obtain the specific camera model:
         auto camera_ptr = get_camera_model(camera);
 
         // Convert py::list of lights to std::vector
-        std::vector<std::unique_ptr<Light<Scalar>>> lights;
-        for (py::handle light : lights_list) { 
-            if (py::isinstance<PointLight<Scalar>>(light)){
-                PointLight<Scalar> light_new = light.cast<PointLight<Scalar>>();
-                lights.push_back(std::make_unique<PointLight<Scalar>>(light_new));
-            }
-            else if (py::isinstance<AreaLight<Scalar>>(light)){
-                AreaLight<Scalar> light_new = light.cast<AreaLight<Scalar>>();
-                lights.push_back(std::make_unique<AreaLight<Scalar>>(light_new));
-            }
-        }
+        auto lights = get_lights(lights_list);
 
-        // Convert py::list of entities to std::vector
+        // Convert py::list of entities to std::vector, numbered as by instance_pass:
+        uint32_t id = 1;
         std::vector<Entity<Scalar>*> entities;
         for (auto entity_handle : entity_list) {
             Entity<Scalar>* entity = entity_handle.cast<Entity<Scalar>*>();
+            entity->set_id(id);
             entities.emplace_back(entity);
+            id++;
         }
 
-        // Call the rendering function:
-        auto pixels = render(camera_ptr, lights, entities,
-                             min_samples, max_samples, noise_threshold, num_bounces);
-
-        // Format the output image:
+        // Call the rendering function, and format the output image:
+        std::vector<EntityMeasurements<Scalar>> measurements;
         int width  = (size_t) floor(camera_ptr->get_resolutionX());
         int height = (size_t) floor(camera_ptr->get_resolutionY());
-        auto result = py::array_t<uint8_t>({height,width,4});
-        auto raw = result.mutable_data();
-        for (int i = 0; i < height*width*4; i++) {
-            raw[i] = pixels[i];
+        auto result = render_image([&](){
+            return render_pixels(camera_ptr, lights, entities,
+                                 min_samples, max_samples, noise_threshold, num_bounces, build_options,
+                                 parse_integrator(integrator), light_samples, wavefront,
+                                 return_measurements ? &measurements : nullptr, statistics);
+        }, sensor, width, height);
+        if (return_measurements) {
+            return py::make_tuple(result, measurements_to_python(measurements));
         }
         return result;
     });
 
-    crt.def("simulate_lidar", [](py::handle lidar, py::list entity_list, int num_rays){
+    crt.def("simulate_lidar", [](py::handle lidar, py::list entity_list, int num_rays, BuildOptions build_options,
+                                 RenderStatistics *statistics){
         // OBtain the specific lidar model:
         auto lidar_ptr = get_lidar_model(lidar);
 
@@ -630,12 +1210,12 @@ PYBIND11_MODULE(_crt, crt) {
         }
 
         // Simulate the lidar:
-        auto distance = simulate_lidar(lidar_ptr, entities, num_rays);
+        auto distance = simulate_lidar(lidar_ptr, entities, num_rays, build_options, statistics);
 
         return distance;
     });
 
-    crt.def("intersection_pass", [](py::handle camera, py::list entity_list){
+    crt.def("intersection_pass", [](py::handle camera, py::list entity_list, BuildOptions build_options, RenderStatistics *statistics){
         // Obtain the specific camera model:
         auto camera_ptr = get_camera_model(camera);
 
@@ -647,7 +1227,7 @@ PYBIND11_MODULE(_crt, crt) {
         }
 
         // Call the intersection tracing function:
-        auto intersections = intersection_pass(camera_ptr, entities);
+        auto intersections = intersection_pass(camera_ptr, entities, build_options, statistics);
 
         // Format the output array:
         int width  = (size_t) floor(camera_ptr->get_resolutionX());
@@ -660,7 +1240,7 @@ PYBIND11_MODULE(_crt, crt) {
         return result;
     });
 
-    crt.def("instance_pass", [](py::handle camera, py::list entity_list){
+    crt.def("instance_pass", [](py::handle camera, py::list entity_list, BuildOptions build_options, RenderStatistics *statistics){
         // Obtain the specific camera model:
         auto camera_ptr = get_camera_model(camera);
 
@@ -675,7 +1255,7 @@ PYBIND11_MODULE(_crt, crt) {
         }
 
         // Call the intersection tracing function:
-        auto instances = instance_pass(camera_ptr, entities);
+        auto instances = instance_pass(camera_ptr, entities, build_options, statistics);
 
         // Format the output array:
         int width  = (size_t) floor(camera_ptr->get_resolutionX());
@@ -688,7 +1268,7 @@ PYBIND11_MODULE(_crt, crt) {
         return result;
     });
 
-    crt.def("normal_pass", [](py::handle camera, py::list entity_list){
+    crt.def("normal_pass", [](py::handle camera, py::list entity_list, BuildOptions build_options, RenderStatistics *statistics){
         // Obtain the specific camera model:
         auto camera_ptr = get_camera_model(camera);
 
@@ -703,7 +1283,7 @@ PYBIND11_MODULE(_crt, crt) {
         }
 
         // Call the intersection tracing function:
-        auto normals = normal_pass(camera_ptr, entities);
+        auto normals = normal_pass(camera_ptr, entities, build_options, statistics);
 
         // Format the output array:
         int width  = (size_t) floor(camera_ptr->get_resolutionX());
@@ -716,4 +1296,48 @@ PYBIND11_MODULE(_crt, crt) {
 
         return result;
     });
+
+    crt.def("traversal_cost_pass", [](py::handle camera, py::list entity_list, BuildOptions build_options, RenderStatistics *statistics){
+        // Obtain the specific camera model:
+        auto camera_ptr = get_camera_model(camera);
+
+        // Convert py::list of entities to std::vector
+        std::vector<Entity<Scalar>*> entities;
+        for (auto entity_handle : entity_list) {
+            Entity<Scalar>* entity = entity_handle.cast<Entity<Scalar>*>();
+            entities.emplace_back(entity);
+        }
+
+        // Call the traversal cost tracing function:
+        auto costs = traversal_cost_pass(camera_ptr, entities, build_options, statistics);
+
+        // Format the output array:
+        int width  = (size_t) floor(camera_ptr->get_resolutionX());
+        int height = (size_t) floor(camera_ptr->get_resolutionY());
+        auto result = py::array_t<uint32_t>({height,width,2});
+        std::copy(costs.begin(), costs.end(), result.mutable_data());
+        return result;
+    });
+
+    crt.def("measurement_pass", [](py::handle camera, py::list lights_list, py::list entity_list, BuildOptions build_options,
+                                   RenderStatistics *statistics){
+        // Obtain the specific camera model:
+        auto camera_ptr = get_camera_model(camera);
+
+        // Convert py::list of lights to std::vector
+        auto lights = get_lights(lights_list);
+
+        // Convert py::list of entities to std::vector
+        uint32_t id = 1;
+        std::vector<Entity<Scalar>*> entities;
+        for (auto entity_handle : entity_list) {
+            Entity<Scalar>* entity = entity_handle.cast<Entity<Scalar>*>();
+            entity->set_id(id);
+            entities.emplace_back(entity);
+            id++;
+        }
+
+        auto measurements = measurement_pass(camera_ptr, entities, lights, build_options, statistics);
+        return measurements_to_python(measurements);
+    });
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+import os
+import tempfile
+import numpy as np
+
+# Small meshes written to temporary OBJ files, for tests that need triangle geometry:
+
+def write_obj(vertices, faces, name):
+    path = os.path.join(tempfile.mkdtemp(), name)
+    with open(path, "w") as f:
+        for v in vertices:
+            f.write("v {} {} {}\n".format(*v))
+        for face in faces:
+            f.write("f {} {} {}\n".format(*(np.asarray(face) + 1)))
+    return path
+
+def random_triangles(count=2000, size=0.2, seed=0):
+    """
+    Triangles scattered through the cube of side 2 about the origin, overlapping each other
+    """
+    rng = np.random.default_rng(seed)
+    centers = rng.uniform(-1, 1, (count, 1, 3))
+    vertices = (centers + size*rng.uniform(-1, 1, (count, 3, 3))).reshape(-1, 3)
+    faces = np.arange(3*count).reshape(-1, 3)
+    return write_obj(vertices, faces, "random_triangles.obj")
+
+def uv_sphere(radius=1., rings=16, segments=32):
+    vertices = []
+    for r in range(rings + 1):
+        theta = np.pi*r/rings
+        for k in range(segments):
+            phi = 2*np.pi*k/segments
+            vertices.append(radius*np.array([np.sin(theta)*np.cos(phi), np.sin(theta)*np.sin(phi), np.cos(theta)]))
+    faces = []
+    for r in range(rings):
+        for k in range(segments):
+            i00 = r*segments + k
+            i01 = r*segments + (k + 1) % segments
+            if r > 0:
+                faces.append([i00, i01, i01 + segments])
+            if r < rings - 1:
+                faces.append([i00, i01 + segments, i00 + segments])
+    return write_obj(vertices, faces, "uv_sphere.obj")
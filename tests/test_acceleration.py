@@ -0,0 +1,101 @@
+from crt import Entity, Sphere, Heightfield
+from crt.body_fixed import BodyFixedEntity, BodyFixedGroup
+from crt.cameras import SimpleCamera
+from crt.acceleration import BuildOptions
+from crt.rendering import intersection_pass, instance_pass, traversal_cost_pass
+from tests.meshes import random_triangles, uv_sphere
+import numpy as np
+import pytest
+
+# Default values:
+camera = SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-10]))
+
+triangles = Entity(random_triangles())
+sphere = Sphere(0.5, position=np.array([0.2,-0.1,0.]))
+
+reference = intersection_pass(camera, [triangles, sphere])
+reference_instances = instance_pass(camera, [triangles, sphere])
+
+# Every builder, with or without the optimizers, only changes how fast the scene is traced:
+def test_builders():
+    for builder in ["sweep_sah", "binned_sah", "locally_ordered_clustering", "linear", "spatial_split"]:
+        for optimize in (True, False):
+            options = BuildOptions(builder=builder, optimize=optimize, optimize_layout=optimize, max_leaf_size=4)
+            intersections = intersection_pass(camera, [triangles, sphere], build_options=options)
+            assert(np.allclose(intersections, reference, atol=1e-9))
+
+def test_build_statistics():
+    group = BodyFixedGroup(BodyFixedEntity(random_triangles()), build_options=BuildOptions(builder="binned_sah"))
+    statistics = group.get_build_statistics()
+    assert(statistics["builder"] == "BinnedSahBuilder")
+    assert(statistics["triangle_count"] == 2000)
+    assert(statistics["reference_count"] == 2000)
+    assert(statistics["node_count"] > 1 and statistics["sah_cost"] > 0)
+
+def test_unknown_builder():
+    with pytest.raises(AssertionError):
+        BuildOptions(builder="octree")
+
+# A spatial split build references primitives more than once, so its leaves index past the number of
+# primitives.  Meshes mixed with analytic bodies must trace exactly as they do with any other builder:
+def test_spatial_split_with_ellipsoids():
+    options = BuildOptions(builder="spatial_split", split_factor=1.0)
+    intersections = intersection_pass(camera, [triangles, sphere], build_options=options)
+    instances = instance_pass(camera, [triangles, sphere], build_options=options)
+    assert(np.allclose(intersections, reference, atol=1e-9))
+    assert((instances == reference_instances).all())
+    assert((instances == 2).any() and (instances == 1).any())
+
+# Heightfields are split through the same references as ellipsoids:
+x, y = np.meshgrid(np.linspace(0, 4*np.pi, 65), np.linspace(0, 4*np.pi, 65))
+terrain = Heightfield(0.2*np.sin(x)*np.cos(y), spacing=[2/64,2/64], position=np.array([-1.,-1.,0.5]))
+terrain_reference = intersection_pass(camera, [triangles, terrain])
+
+def test_spatial_split_with_heightfields():
+    options = BuildOptions(builder="spatial_split", split_factor=1.0)
+    intersections = intersection_pass(camera, [triangles, terrain], build_options=options)
+    assert(np.allclose(intersections, terrain_reference, atol=1e-9))
+
+# The cost of every pixel adds up to the node visits and primitive tests counted for the call.  Rays that
+# miss the bounding box of the mesh test none of its triangles, and a second copy of the mesh in the same
+# place makes every ray that reaches it test about twice as many:
+mesh = uv_sphere(radius=2., rings=32, segments=64)
+
+def test_traversal_cost_pass():
+    costs, statistics = traversal_cost_pass(camera, [Entity(mesh)], return_statistics=True)
+    assert(costs.shape == (48,48,2) and costs.dtype == np.uint32)
+    assert(costs[:,:,0].sum() == statistics["node_visits"])
+    assert(costs[:,:,1].sum() == statistics["primitive_tests"])
+
+    hit = instance_pass(camera, [Entity(mesh)]) == 1
+    assert((costs[hit,1] > 0).all())
+    assert((costs[[0,0,-1,-1],[0,-1,0,-1],1] == 0).all())
+
+    overlapping = traversal_cost_pass(camera, [Entity(mesh), Entity(mesh)])
+    assert(overlapping[:,:,1].sum() > 1.5*costs[:,:,1].sum())
+
+    costs, image = traversal_cost_pass(camera, [Entity(mesh)], return_image=True)
+    assert(image.shape == (48,48) and image.max() == 255)
+    assert(np.allclose(image, 255*costs.sum(axis=2)/costs.sum(axis=2).max()))
+
+# Inside a heightfield, the quadtree nodes and cells a ray visits count as nodes and the triangles it tests
+# as primitives, so the cost of a terrain varies with the part of it a pixel sees:
+def test_traversal_cost_pass_heightfield():
+    costs, statistics = traversal_cost_pass(camera, [terrain], return_statistics=True)
+    assert(costs[:,:,0].sum() == statistics["node_visits"])
+    assert(costs[:,:,1].sum() == statistics["primitive_tests"])
+
+    hit = instance_pass(camera, [terrain]) == 1
+    assert(hit.sum() > 100)
+    assert((costs[hit,0] > 1).all() and (costs[hit,1] >= 3).all())
+    assert(len(np.unique(costs[hit,0])) > 1)
+    assert((costs[~hit,1] <= costs[hit,1].min()).all())
+
+# Run the tests
+test_builders()
+test_build_statistics()
+test_unknown_builder()
+test_spatial_split_with_ellipsoids()
+test_spatial_split_with_heightfields()
+test_traversal_cost_pass()
+test_traversal_cost_pass_heightfield()
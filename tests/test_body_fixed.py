@@ -0,0 +1,99 @@
+from crt.body_fixed import BodyFixedEntity, BodyFixedGroup
+from crt.cameras import SimpleCamera
+from crt.lights import PointLight
+from tests.meshes import write_obj
+import numpy as np
+import pytest
+
+# Default values:
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-10]))
+
+# Meshes are loaded in single precision, so vertices are kept to values a float holds exactly:
+def single(vertices):
+    return vertices.astype(np.float32).astype(np.float64)
+
+rng = np.random.default_rng(1)
+vertices = single(rng.uniform(-1, 1, (500, 1, 3)) + 0.2*rng.uniform(-1, 1, (500, 3, 3)))
+faces = np.arange(3*500).reshape(-1, 3)
+position = np.array([0.1,-0.2,0.3])
+
+# A group of a posed entity with the given vertices, and a second entity with the original ones:
+def group_of(moved):
+    path = write_obj(vertices.reshape(-1, 3), faces, "body_fixed.obj")
+    moved_path = write_obj(moved.reshape(-1, 3), faces, "body_fixed.obj")
+    return BodyFixedGroup([BodyFixedEntity(moved_path, position=position), BodyFixedEntity(path)])
+
+# Vertices given in the entity's frame are moved by its pose, and tracing the refitted group must find
+# exactly what a group built from the moved mesh does:
+def test_update_vertices_refit():
+    moved = single(vertices + np.array([0.3,0.,-0.2]))
+    reference = group_of(moved).intersection_pass(new_camera())
+
+    group = group_of(vertices)
+    group.set_rebuild_threshold(1e9)
+    statistics = group.get_build_statistics()
+    group.update_vertices(1, moved)
+    assert(np.allclose(group.intersection_pass(new_camera()), reference, atol=1e-9))
+    assert(group.get_build_statistics() == statistics)
+
+# With a threshold of zero every update rebuilds the group, which must not change what is hit either:
+def test_update_vertices_rebuild():
+    moved = single(0.5*vertices)
+    reference = group_of(moved).intersection_pass(new_camera())
+
+    group = group_of(vertices)
+    group.set_rebuild_threshold(0.)
+    group.update_vertices(1, moved)
+    assert(np.allclose(group.intersection_pass(new_camera()), reference, atol=1e-9))
+
+def test_update_vertices_invalid():
+    group = group_of(vertices)
+    with pytest.raises(ValueError):
+        group.update_vertices(3, vertices)
+    with pytest.raises(ValueError):
+        group.update_vertices(1, vertices[:10])
+
+# Frames traced together in a batch are the images render() gives for each pose on its own.  A point light
+# and one sample per pixel leave nothing to chance, so they are identical:
+square = write_obj([[-2,-2,0],[2,-2,0],[2,2,0],[-2,2,0]], [[0,2,1],[0,3,2]], "square.obj")
+light = PointLight(100, position=np.array([1,-1,-10]))
+positions = np.array([[-1,0,-10],[0,0.5,-10],[1,0,-8]])
+rotations = np.array([[[np.cos(a),-np.sin(a),0],[np.sin(a),np.cos(a),0],[0,0,1]] for a in (0, 0.3, -0.5)])
+
+def test_render_batch():
+    group = BodyFixedGroup(BodyFixedEntity(square))
+    for integrator in ("unidirectional", "mis"):
+        for wavefront in (False, True):
+            references = []
+            for position, rotation in zip(positions, rotations):
+                camera = new_camera()
+                camera.set_pose(position, rotation)
+                references.append(group.render(camera, light, num_bounces=2, integrator=integrator, wavefront=wavefront))
+            images = group.render_batch(new_camera(), light, positions, rotations, num_bounces=2,
+                                        integrator=integrator, wavefront=wavefront)
+            assert(images.shape == (3,48,48,4))
+            assert((images == np.array(references)).all())
+            assert((images[:,:,:,0] > 0).sum() > 300)
+
+    # A list of cameras, one per frame, is the same as one camera moved to each pose:
+    cameras = [new_camera() for _ in positions]
+    for camera, position, rotation in zip(cameras, positions, rotations):
+        camera.set_pose(position, rotation)
+    assert((group.render_batch(cameras, light) == group.render_batch(new_camera(), light, positions, rotations)).all())
+
+def test_render_batch_invalid():
+    group = BodyFixedGroup(BodyFixedEntity(square))
+    with pytest.raises(ValueError):
+        group.render_batch(new_camera(), light)
+    with pytest.raises(ValueError):
+        group.render_batch(new_camera(), light, positions, rotations[:2])
+    with pytest.raises(ValueError):
+        group.render_batch([new_camera(), SimpleCamera(30, [32,32], [20,20], z_positive=True)], light)
+
+# Run the tests
+test_update_vertices_refit()
+test_update_vertices_rebuild()
+test_update_vertices_invalid()
+test_render_batch()
+test_render_batch_invalid()
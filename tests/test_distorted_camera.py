@@ -0,0 +1,55 @@
+from crt import Entity, Sphere
+from crt.cameras import SimpleCamera, DistortedCamera
+from crt.rendering import intersection_pass, instance_pass
+from tests.meshes import write_obj
+import numpy as np
+
+# Default values:
+focal = 30
+resolution = [48,48]
+sensor_size = [20,20]
+radial = [-0.2,0.05,-0.01]
+tangential = [1e-3,-5e-4]
+
+angle = 0.1
+rotation = np.array([[1,0,0],[0,np.cos(angle),-np.sin(angle)],[0,np.sin(angle),np.cos(angle)]])
+position = np.array([0.3,-0.2,-10])
+
+# A plane far behind everything else, covering the field of view of every camera:
+backdrop = Entity(write_obj([[-50,-50,20],[50,-50,20],[50,50,20],[-50,50,20]], [[0,2,1],[0,3,2]], "backdrop.obj"))
+
+# Without distortion the camera is a pinhole camera, and traces the same rays:
+def test_zero_distortion():
+    camera = DistortedCamera(focal, resolution, sensor_size, z_positive=True, position=position, rotation=rotation)
+    reference = SimpleCamera(focal, resolution, sensor_size, z_positive=True, position=position, rotation=rotation)
+    for entities in ([backdrop], [Sphere(3)]):
+        assert(np.allclose(intersection_pass(camera, entities), intersection_pass(reference, entities), atol=1e-9))
+    assert(((instance_pass(camera, [Sphere(3)]) == 1) == (instance_pass(reference, [Sphere(3)]) == 1)).all())
+
+# Distorting the normalized image coordinates of the point each pixel sees, with the model of the
+# calibration tools, projects it back onto that pixel:
+def test_distortion_reprojection():
+    camera = DistortedCamera(focal, resolution, sensor_size, radial, tangential, z_positive=True)
+    points = intersection_pass(camera, [backdrop])
+    x = points[:,:,0]/points[:,:,2]
+    y = -points[:,:,1]/points[:,:,2]
+    r2 = x**2 + y**2
+    factor = 1 + radial[0]*r2 + radial[1]*r2**2 + radial[2]*r2**3
+    xd = x*factor + 2*tangential[0]*x*y + tangential[1]*(r2 + 2*x**2)
+    yd = y*factor + tangential[0]*(r2 + 2*y**2) + 2*tangential[1]*x*y
+    rows, cols = np.meshgrid(np.arange(48), np.arange(48), indexing="ij")
+    assert(np.allclose(xd*focal*48/20 + 24, cols, atol=1e-6))
+    assert(np.allclose(yd*focal*48/20 + 24, rows, atol=1e-6))
+
+# Barrel distortion (negative k1) pulls the edges of the field of view inwards, so the camera sees a
+# wider field than a pinhole camera with the same sensor:
+def test_barrel_distortion():
+    camera = DistortedCamera(focal, resolution, sensor_size, radial, tangential, z_positive=True)
+    reference = SimpleCamera(focal, resolution, sensor_size, z_positive=True)
+    width = np.ptp(intersection_pass(camera, [backdrop])[:,:,0])
+    assert(width > 1.01*np.ptp(intersection_pass(reference, [backdrop])[:,:,0]))
+
+# Run the tests
+test_zero_distortion()
+test_distortion_reprojection()
+test_barrel_distortion()
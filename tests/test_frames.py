@@ -0,0 +1,88 @@
+from crt.frames import write_frame, write_frames, FrameWriter
+import numpy as np
+import os
+import pytest
+import tempfile
+import time
+
+# Default values:
+directory = tempfile.mkdtemp()
+
+rng = np.random.default_rng(0)
+images = [rng.integers(0, 256, (24,32,3)).astype(np.uint8),
+          rng.integers(0, 65536, (24,32)).astype(np.uint16),
+          rng.uniform(0, 1, (24,32,4)).astype(np.float32)]
+
+def path(name):
+    return os.path.join(directory, name)
+
+# Width, height, bit depth and color type from the header of a PNG file:
+def png_header(name):
+    with open(name, "rb") as f:
+        data = f.read(26)
+    assert(data[:8] == b"\x89PNG\r\n\x1a\n")
+    return int.from_bytes(data[16:20], "big"), int.from_bytes(data[20:24], "big"), data[24], data[25]
+
+# Frames written in the background read back exactly, in every format:
+def test_frame_writer():
+    with FrameWriter(threads=3) as writer:
+        for k, image in enumerate(images):
+            writer.write(path("frame_{}.npy".format(k)), image)
+            writer.write(path("frame_{}.raw".format(k)), image)
+        writer.write(path("frame_0.png"), images[0])
+        writer.write(path("frame_1.png"), images[1])
+    for k, image in enumerate(images):
+        loaded = np.load(path("frame_{}.npy".format(k)))
+        assert(loaded.dtype == image.dtype and (loaded == image).all())
+        raw = np.fromfile(path("frame_{}.raw".format(k)), dtype=image.dtype).reshape(image.shape)
+        assert((raw == image).all())
+    assert(png_header(path("frame_0.png")) == (32, 24, 8, 2))
+    assert(png_header(path("frame_1.png")) == (32, 24, 16, 0))
+
+# Errors met on a background thread are raised by the next call to flush() or write(), once, after which
+# the writer carries on:
+def test_frame_writer_errors():
+    writer = FrameWriter()
+    writer.write(path(os.path.join("missing", "frame.npy")), images[0])
+    with pytest.raises(RuntimeError):
+        writer.flush()
+    writer.write(path("after_error.npy"), images[0])
+    writer.flush()
+    assert(os.path.exists(path("after_error.npy")))
+
+    writer.write(path("frame.jpg"), images[0])
+    while writer.pending() > 0:
+        time.sleep(0.01)
+    with pytest.raises(ValueError):
+        writer.write(path("not_written.npy"), images[0])
+    writer.flush()
+    assert(not os.path.exists(path("not_written.npy")))
+
+    writer.write(path("float.png"), images[2])
+    with pytest.raises(ValueError):
+        writer.flush()
+
+    with pytest.raises(RuntimeError):
+        write_frame(path(os.path.join("missing", "frame.png")), images[0])
+
+# Frames waiting to be written never hold more than max_queued_bytes, except for a single larger frame:
+def test_frame_writer_queue():
+    writer = FrameWriter(threads=1, max_queued_bytes=images[0].nbytes)
+    for k in range(20):
+        writer.write(path("queued_{}.png".format(k)), images[0])
+        assert(writer.pending() <= 1)
+    writer.flush()
+    assert(writer.pending() == 0)
+
+def test_write_frames():
+    sequence = np.stack([images[0]]*5)
+    paths = write_frames(sequence, path("sequence_{:02d}.npy"))
+    assert(paths == [path("sequence_{:02d}.npy".format(k)) for k in range(5)])
+    for name in paths:
+        assert((np.load(name) == images[0]).all())
+
+# Run the tests
+test_frame_writer()
+test_frame_writer_errors()
+test_frame_writer_queue()
+test_write_frames()
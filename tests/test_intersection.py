@@ -0,0 +1,49 @@
+from crt import Entity, Sphere
+from crt.cameras import SimpleCamera
+from crt.lights import SunLight
+from crt.rendering import render, instance_pass
+from tests.meshes import write_obj, uv_sphere
+import numpy as np
+
+# Default values:
+def new_camera(distance=10):
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-distance]))
+
+turned_over = np.array([[1,0,0],[0,-1,0],[0,0,-1]])
+
+# Eight triangles about the origin, whose edges lie along the axes and the diagonals of the plane z = 0:
+ring = [[5,0,0],[5,5,0],[0,5,0],[-5,5,0],[-5,0,0],[-5,-5,0],[0,-5,0],[5,-5,0]]
+fan = write_obj([[0,0,0]] + ring, [[0, 1 + k, 1 + (k + 1) % 8] for k in range(8)], "fan.obj")
+
+sphere = uv_sphere(radius=1., rings=32, segments=64)
+
+# The rays of the middle row and column of pixels, and of the diagonals, pass exactly through the edges and
+# the center vertex of the fan, from either side.  Every one of them must hit it:
+def test_shared_edges():
+    for rotation in (np.eye(3), turned_over):
+        instances = instance_pass(new_camera(), [Entity(fan, rotation=rotation)])
+        assert((instances == 1).all())
+
+# A closed mesh has no holes, so it is hit wherever the largest sphere inside it is.  The rays of the
+# middle row and column of pixels run along edges of the mesh, and the middle one through its pole:
+def test_closed_mesh():
+    inside = instance_pass(new_camera(3), [Sphere(0.98)]) == 1
+    instances = instance_pass(new_camera(3), [Entity(sphere)])
+    assert((instances[inside] == 1).all())
+    assert(inside.sum() > 1000)
+
+# Secondary rays are offset from the surface relative to the size of the hit point, so scaling the whole
+# scene up or down must not change what the shadow rays find:
+def test_ray_offset_scale():
+    light = SunLight(1, angular_radius=0., position=np.array([1,1,-1]))
+    reference = render(new_camera(), light, [Entity(sphere, smooth_shading=True)], num_bounces=2, integrator="mis")
+    for scale in (1e-3, 1e4, 1e6):
+        entity = Entity(sphere, smooth_shading=True, scale=scale)
+        image = render(new_camera(10*scale), light, [entity], num_bounces=2, integrator="mis")
+        assert((image == reference).all())
+    assert((reference[:,:,0] > 0).sum() > 100)
+
+# Run the tests
+test_shared_edges()
+test_closed_mesh()
+test_ray_offset_scale()
@@ -0,0 +1,80 @@
+from crt import Entity
+from crt.body_fixed import BodyFixedEntity, BodyFixedGroup
+from crt.cameras import SimpleCamera
+from crt.rendering import intersection_pass, instance_pass
+from tests.meshes import uv_sphere
+import numpy as np
+import os
+import tempfile
+
+# Default values:
+def new_camera(distance=10):
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-distance]))
+
+# A unit sphere of 3968 triangles, and a coarse one of 224.  One pixel spans 1/72 of a radian, so at a
+# distance of 10 an error of up to 0.125 is within a pixel of the nearest point of the sphere:
+full = uv_sphere(radius=1., rings=32, segments=64)
+coarse = uv_sphere(radius=1., rings=8, segments=16)
+
+def passes(entity, camera):
+    return intersection_pass(camera, [entity]), instance_pass(camera, [entity])
+
+def same(a, b):
+    return (a[0] == b[0]).all() and (a[1] == b[1]).all()
+
+# A level added by hand is traced instead of the full mesh only while its error projects to no more
+# than the tolerance, and the full mesh is traced again once the camera comes close:
+def test_add_lod():
+    entity = Entity(full)
+    entity.add_lod(coarse, error=0.1)
+    assert(same(passes(entity, new_camera()), passes(Entity(coarse), new_camera())))
+    assert(not same(passes(entity, new_camera()), passes(Entity(full), new_camera())))
+    assert(same(passes(entity, new_camera(3)), passes(Entity(full), new_camera(3))))
+
+    entity.set_lod_tolerance(0.5)
+    assert(same(passes(entity, new_camera()), passes(Entity(full), new_camera())))
+
+# Generated levels are never traced with a tolerance of zero.  With a large one the coarsest level is,
+# and it still lies close to the sphere:
+def test_generate_lods():
+    entity = Entity(full)
+    entity.generate_lods(min_triangles=100)
+    entity.set_lod_tolerance(0)
+    reference = passes(Entity(full), new_camera())
+    assert(same(passes(entity, new_camera()), reference))
+
+    entity.set_lod_tolerance(1000)
+    points, instances = passes(entity, new_camera())
+    assert(not same((points, instances), reference))
+    radii = np.linalg.norm(points[instances == 1], axis=1)
+    assert(((radii > 0.9) & (radii < 1 + 1e-6)).all())
+    assert((instances == 1).sum() > 100)
+
+# Levels written to a cache are read back by the next entity made from the same mesh:
+def test_lod_cache():
+    cache = os.path.join(tempfile.mkdtemp(), "sphere.crtl")
+    entity = Entity(full)
+    entity.generate_lods(min_triangles=100, cache_path=cache)
+    entity.set_lod_tolerance(1000)
+    assert(os.path.exists(cache))
+
+    cached = Entity(full)
+    cached.generate_lods(min_triangles=100, cache_path=cache)
+    cached.set_lod_tolerance(1000)
+    assert(same(passes(cached, new_camera()), passes(entity, new_camera())))
+
+# A group rebuilds its hierarchy from the level each camera needs:
+def test_body_fixed_lod():
+    entity = BodyFixedEntity(full)
+    entity.add_lod(coarse, error=0.1)
+    group = BodyFixedGroup(entity)
+    group.intersection_pass(new_camera())
+    assert(group.get_build_statistics()["triangle_count"] == 224)
+    group.intersection_pass(new_camera(3))
+    assert(group.get_build_statistics()["triangle_count"] == 3968)
+
+# Run the tests
+test_add_lod()
+test_generate_lods()
+test_lod_cache()
+test_body_fixed_lod()
@@ -0,0 +1,90 @@
+from crt import Entity, Sphere
+from crt.cameras import SimpleCamera
+from crt.rendering import intersection_pass, instance_pass
+from tests.meshes import uv_sphere
+import numpy as np
+import pytest
+
+# Default values:
+def rotation_z(angle):
+    c, s = np.cos(angle), np.sin(angle)
+    return np.array([[c,-s,0],[s,c,0],[0,0,1]])
+
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-10]))
+
+start_position = np.array([-0.6,0.2,0.])
+end_position = np.array([0.6,-0.1,0.5])
+mesh = uv_sphere(radius=0.8)
+
+def pose_at(time):
+    return start_position + time*(end_position - start_position), rotation_z(0.8*time)
+
+# With an exposure and a single sample per pixel, rays are taken at the middle of the exposure, where a
+# moving entity must be exactly where a static one at its middle pose is:
+def test_entity_motion_at_mid_exposure():
+    camera = new_camera()
+    camera.set_shutter(1.)
+    for entity in (Sphere(0.8, position=start_position), Entity(mesh, position=start_position)):
+        entity.set_motion(end_position, rotation_z(0.8))
+        moving = intersection_pass(camera, [entity])
+        entity.set_motion()
+        entity.set_pose(*pose_at(0.5))
+        static = intersection_pass(camera, [entity])
+        assert(np.allclose(moving, static, atol=1e-9, equal_nan=True))
+
+# With a rolling shutter, row v is taken at readout*v/resolution[1]:
+def test_entity_motion_rolling_shutter():
+    camera = new_camera()
+    camera.set_shutter(0., readout=1.)
+    sphere = Sphere(0.8, position=start_position)
+    sphere.set_motion(end_position)
+    moving = instance_pass(camera, [sphere])
+    sphere.set_motion()
+    for row in (0, 12, 24, 36, 47):
+        sphere.set_position(pose_at(row/48)[0])
+        static = instance_pass(camera, [sphere])
+        assert((moving[row] == static[row]).all())
+    assert((moving == 1).any())
+
+# Without an exposure, or once the motion is cleared, an entity stays in its pose:
+def test_entity_motion_without_exposure():
+    camera = new_camera()
+    sphere = Sphere(0.8, position=start_position)
+    static = intersection_pass(camera, [sphere])
+    sphere.set_motion(end_position, rotation_z(0.8))
+    assert(np.allclose(intersection_pass(camera, [sphere]), static, atol=1e-9, equal_nan=True))
+    camera.set_shutter(1.)
+    sphere.set_motion()
+    assert(sphere.end_position is None)
+    assert(np.allclose(intersection_pass(camera, [sphere]), static, atol=1e-9, equal_nan=True))
+
+# A moving camera is at its middle pose at the middle of the exposure too:
+def test_camera_motion_at_mid_exposure():
+    sphere = Sphere(0.8)
+    camera = new_camera()
+    camera.set_motion(np.array([0.5,0.,-10.]))
+    camera.set_shutter(1.)
+    moving = intersection_pass(camera, [sphere])
+    static = intersection_pass(SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0.25,0,-10])), [sphere])
+    assert(np.allclose(moving, static, atol=1e-9, equal_nan=True))
+
+# Motion is only defined up to the end poses, so a shutter must close by then, and a rejected shutter
+# leaves the camera as it was:
+def test_shutter_limits():
+    sphere = Sphere(0.8, position=start_position)
+    sphere.set_motion(end_position)
+    camera = new_camera()
+    camera.set_shutter(0.5, readout=0.5)
+    reference = instance_pass(camera, [sphere])
+    for exposure, readout in ((-0.1, 0.), (0., -0.1), (0.6, 0.5), (1.01, 0.), (np.nan, 0.)):
+        with pytest.raises(ValueError):
+            camera.set_shutter(exposure, readout=readout)
+    assert((instance_pass(camera, [sphere]) == reference).all())
+
+# Run the tests
+test_entity_motion_at_mid_exposure()
+test_entity_motion_rolling_shutter()
+test_entity_motion_without_exposure()
+test_camera_motion_at_mid_exposure()
+test_shutter_limits()
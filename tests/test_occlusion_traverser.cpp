@@ -0,0 +1,269 @@
+// Compares OcclusionTraverser::occluded() with the generic any-hit traversal (SingleRayTraverser with
+// an AnyPrimitiveIntersector) that it replaces, on scenes covering each path of the traverser: leaves of
+// triangles only, a scene whose root is a leaf, heightfield leaves, and leaves mixing triangles with
+// ellipsoids and heightfields (also after a spatial split build, whose leaves reference primitives more
+// than once).
+// Random rays with a finite tmax are traced, as well as rays ending just before and just after the
+// closest surface along them.  The reference tests leaves with the same RobustNodeIntersector, so the
+// two may only differ in how they reach and test leaves.
+//
+// Usage: test_occlusion_traverser (returns a nonzero exit code on failure)
+
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bvh/bvh.hpp"
+#include "bvh/ellipsoid.hpp"
+#include "bvh/node_intersectors.hpp"
+#include "bvh/primitive_intersectors.hpp"
+#include "bvh/single_ray_traverser.hpp"
+#include "bvh/triangle.hpp"
+
+#include "acceleration/build_bvh.hpp"
+#include "acceleration/heightfield.hpp"
+#include "acceleration/occlusion_traverser.hpp"
+#include "acceleration/scene_primitives.hpp"
+
+using Scalar = double;
+using Vector3 = bvh::Vector3<Scalar>;
+using Bvh = bvh::Bvh<Scalar>;
+
+// Any primitive of a scene, by the same index as in the BVH, for the generic intersectors:
+struct ScenePrimitive {
+    struct Intersection {
+        Scalar t;
+
+        Scalar distance() const { return t; }
+    };
+
+    using ScalarType       = Scalar;
+    using IntersectionType = Intersection;
+
+    const bvh::Triangle<Scalar> *triangle = nullptr;
+    const bvh::Ellipsoid<Scalar> *ellipsoid = nullptr;
+    const Heightfield<Scalar> *heightfield = nullptr;
+
+    std::optional<Intersection> intersect(const bvh::Ray<Scalar> &ray) const {
+        if (triangle) {
+            if (auto hit = triangle->intersect(ray)) {
+                return Intersection{hit->t};
+            }
+        }
+        else if (ellipsoid) {
+            if (auto hit = ellipsoid->intersect(ray)) {
+                return Intersection{hit->t};
+            }
+        }
+        else if (auto hit = heightfield->intersect(ray)) {
+            return Intersection{hit->t};
+        }
+        return std::nullopt;
+    }
+};
+
+struct Scene {
+    std::string name;
+    BuildOptions options;
+    std::vector<bvh::Triangle<Scalar>> triangles;
+    std::vector<bvh::Ellipsoid<Scalar>> ellipsoids;
+    std::vector<Heightfield<Scalar>> heightfields;
+};
+
+std::vector<bvh::Triangle<Scalar>> random_triangles(std::mt19937 &eng, size_t count, Scalar size) {
+    std::uniform_real_distribution<Scalar> position(-1, 1);
+    std::uniform_real_distribution<Scalar> offset(-size, size);
+    std::vector<bvh::Triangle<Scalar>> triangles;
+    for (size_t i = 0; i < count; ++i) {
+        Vector3 p0(position(eng), position(eng), position(eng));
+        Vector3 p1 = p0 + Vector3(offset(eng), offset(eng), offset(eng));
+        Vector3 p2 = p0 + Vector3(offset(eng), offset(eng), offset(eng));
+        triangles.emplace_back(p0, p1, p2);
+    }
+    return triangles;
+}
+
+// Rolling terrain of rows x cols posts, covering a square of the given side with its corner at origin:
+Heightfield<Scalar> terrain(size_t rows, size_t cols, Scalar side, const Vector3 &origin) {
+    std::vector<float> heights(rows*cols);
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t col = 0; col < cols; ++col) {
+            heights[row*cols + col] = float(0.1*std::sin(0.7*col)*std::cos(0.5*row));
+        }
+    }
+    Heightfield<Scalar> heightfield(HeightfieldRaster::from_vector(heights, rows, cols, side/(cols - 1), side/(rows - 1)));
+    heightfield.origin = origin;
+    return heightfield;
+}
+
+std::vector<Scene> make_scenes() {
+    std::mt19937 eng(5);
+    std::vector<Scene> scenes;
+
+    Scene triangles{"triangles", BuildOptions()};
+    triangles.triangles = random_triangles(eng, 3000, 0.1);
+    scenes.push_back(triangles);
+
+    // A node costs so much more than a primitive that the builder keeps every primitive in the root:
+    Scene root_leaf{"root_leaf", BuildOptions()};
+    root_leaf.options.traversal_cost = 1e6;
+    root_leaf.options.max_leaf_size = 64;
+    root_leaf.triangles = random_triangles(eng, 8, 0.5);
+    root_leaf.ellipsoids.emplace_back(Vector3(0.2, -0.3, 0.1), Vector3(0.3, 0.2, 0.4));
+    root_leaf.heightfields.push_back(terrain(17, 17, 1.5, Vector3(-0.75, -0.75, -0.2)));
+    scenes.push_back(root_leaf);
+
+    // Two adjacent tiles, so that the root is a node with heightfield leaves:
+    Scene heightfields{"heightfields", BuildOptions()};
+    heightfields.options.max_leaf_size = 1;
+    heightfields.heightfields.push_back(terrain(65, 33, 1, Vector3(-1, -0.5, 0)));
+    heightfields.heightfields.push_back(terrain(33, 65, 1, Vector3(0, -0.5, 0.05)));
+    scenes.push_back(heightfields);
+
+    Scene mixed{"mixed", BuildOptions()};
+    mixed.options.max_leaf_size = 32;
+    mixed.options.traversal_cost = 4;
+    mixed.triangles = random_triangles(eng, 400, 0.1);
+    for (int k = 0; k < 12; ++k) {
+        std::uniform_real_distribution<Scalar> position(-0.9, 0.9), radius(0.02, 0.15);
+        mixed.ellipsoids.emplace_back(Vector3(position(eng), position(eng), position(eng)),
+                                      Vector3(radius(eng), radius(eng), radius(eng)));
+    }
+    mixed.heightfields.push_back(terrain(33, 33, 0.8, Vector3(-0.9, -0.9, -0.5)));
+    mixed.heightfields.push_back(terrain(9, 17, 0.5, Vector3(0.2, 0.3, 0.4)));
+    scenes.push_back(mixed);
+
+    Scene spatial_split = mixed;
+    spatial_split.name = "mixed_spatial_split";
+    spatial_split.options.builder = BuilderType::SpatialSplit;
+    spatial_split.options.split_factor = 1.0;
+    scenes.push_back(spatial_split);
+
+    return scenes;
+}
+
+// True if some leaf holds both triangles and other primitives:
+bool has_mixed_leaf(const Bvh &bvh, size_t triangle_count) {
+    for (size_t i = 0; i < bvh.node_count; ++i) {
+        auto &node = bvh.nodes[i];
+        if (!node.is_leaf()) {
+            continue;
+        }
+        bool triangle = false, other = false;
+        for (size_t j = 0; j < node.primitive_count; ++j) {
+            bool is_triangle = bvh.primitive_indices[node.first_child_or_primitive + j] < triangle_count;
+            triangle |= is_triangle;
+            other |= !is_triangle;
+        }
+        if (triangle && other) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Traces every ray with both traversals, and counts the rays on which they disagree or on which the
+// occlusion traverser disagrees with the expected answer, where one is given:
+size_t compare(const Scene &scene, const std::vector<bvh::Ray<Scalar>> &rays, const std::vector<int> &expected,
+               const OcclusionTraverser<Scalar> &traverser, const bvh::SingleRayTraverser<Bvh, 64, bvh::RobustNodeIntersector<Bvh>> &reference,
+               const bvh::AnyPrimitiveIntersector<Bvh, ScenePrimitive> &any_intersector, size_t &occluded) {
+    size_t failures = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        bool result = traverser.occluded(rays[i]);
+        bool reference_result = reference.traverse(rays[i], any_intersector).has_value();
+        occluded += result;
+        if (result != reference_result || (!expected.empty() && result != bool(expected[i]))) {
+            if (failures < 5) {
+                std::cout << "    " << scene.name << ": ray " << i << " occluded " << result << ", reference " << reference_result;
+                if (!expected.empty()) {
+                    std::cout << ", expected " << expected[i];
+                }
+                std::cout << " (tmax " << rays[i].tmax << ")\n";
+            }
+            failures++;
+        }
+    }
+    return failures;
+}
+
+int main() {
+    size_t failures = 0;
+    for (auto &scene : make_scenes()) {
+        Bvh bvh;
+        build_bvh(bvh, scene.triangles, scene.ellipsoids, scene.heightfields, scene.options);
+        ScenePrimitives<Scalar> primitives(bvh, scene.triangles, scene.ellipsoids, scene.heightfields);
+        OcclusionTraverser<Scalar> traverser(bvh, primitives);
+
+        std::vector<ScenePrimitive> references;
+        for (auto &triangle : scene.triangles) {
+            references.push_back(ScenePrimitive{&triangle, nullptr, nullptr});
+        }
+        for (auto &ellipsoid : scene.ellipsoids) {
+            references.push_back(ScenePrimitive{nullptr, &ellipsoid, nullptr});
+        }
+        for (auto &heightfield : scene.heightfields) {
+            references.push_back(ScenePrimitive{nullptr, nullptr, &heightfield});
+        }
+        bvh::SingleRayTraverser<Bvh, 64, bvh::RobustNodeIntersector<Bvh>> reference(bvh);
+        bvh::AnyPrimitiveIntersector<Bvh, ScenePrimitive> any_intersector(bvh, references.data());
+        bvh::ClosestPrimitiveIntersector<Bvh, ScenePrimitive> closest_intersector(bvh, references.data());
+
+        // Each scene must exercise the path it was made for:
+        bool root_is_leaf = bvh.nodes[0].is_leaf();
+        if ((scene.name == "root_leaf") != root_is_leaf ||
+            (scene.name.rfind("mixed", 0) == 0 && !has_mixed_leaf(bvh, scene.triangles.size()))) {
+            std::cout << "    " << scene.name << ": unexpected hierarchy (root is a leaf: " << root_is_leaf << ")\n";
+            failures++;
+        }
+
+        // Random segments starting around the scene, which end anywhere from right away to beyond it:
+        std::mt19937 eng(11);
+        std::uniform_real_distribution<Scalar> dist(0.0, 1.0);
+        std::vector<bvh::Ray<Scalar>> rays;
+        for (size_t i = 0; i < 20000; ++i) {
+            Vector3 origin(3*dist(eng) - 1.5, 3*dist(eng) - 1.5, 3*dist(eng) - 1.5);
+            Scalar z   = 2*dist(eng) - 1;
+            Scalar phi = 2*M_PI*dist(eng);
+            Scalar r   = std::sqrt(std::max(Scalar(0), 1 - z*z));
+            rays.emplace_back(origin, Vector3(r*std::cos(phi), r*std::sin(phi), z), 0, 4*dist(eng));
+        }
+        size_t occluded = 0;
+        size_t random_failures = compare(scene, rays, {}, traverser, reference, any_intersector, occluded);
+
+        // The same rays, ending just before and just after their closest hit, which the first must
+        // not reach and the second must:
+        std::vector<bvh::Ray<Scalar>> ending_rays;
+        std::vector<int> expected;
+        for (auto ray : rays) {
+            ray.tmax = std::numeric_limits<Scalar>::infinity();
+            auto hit = reference.traverse(ray, closest_intersector);
+            if (!hit || hit->distance() < Scalar(1e-3)) {
+                continue;
+            }
+            ending_rays.emplace_back(ray.origin, ray.direction, 0, hit->distance()*(1 - Scalar(1e-9)));
+            expected.push_back(0);
+            ending_rays.emplace_back(ray.origin, ray.direction, 0, hit->distance()*(1 + Scalar(1e-9)));
+            expected.push_back(1);
+        }
+        size_t ending_occluded = 0;
+        size_t ending_failures = compare(scene, ending_rays, expected, traverser, reference, any_intersector, ending_occluded);
+
+        std::cout << scene.name << ": " << occluded << " of " << rays.size() << " random rays occluded, "
+                  << ending_rays.size() << " rays ending at a surface, "
+                  << random_failures + ending_failures << " mismatches\n";
+        failures += random_failures + ending_failures;
+
+        // Both answers must occur, or the comparison proves little:
+        if (occluded == 0 || occluded == rays.size() || ending_rays.size() < 100) {
+            std::cout << "    " << scene.name << ": too few occluded or unoccluded rays\n";
+            failures++;
+        }
+    }
+
+    std::cout << (failures == 0 ? "All tests passed\n" : "Tests failed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+from crt import Entity, Ellipsoid, Heightfield
+from crt.cameras import SimpleCamera
+from crt.lidars import SimpleLidar
+from crt.rendering import intersection_pass, instance_pass, normal_pass, simulate_lidar
+from tests.meshes import write_obj
+import numpy as np
+
+# Default values:
+camera_position = np.array([0,0,-10])
+
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=camera_position)
+
+def rotation_x(angle):
+    c, s = np.cos(angle), np.sin(angle)
+    return np.array([[1,0,0],[0,c,-s],[0,s,c]])
+
+def rotation_z(angle):
+    c, s = np.cos(angle), np.sin(angle)
+    return np.array([[c,-s,0],[s,c,0],[0,0,1]])
+
+# The direction of the ray of every pixel, found by tracing a plane far behind everything else:
+backdrop = Entity(write_obj([[-50,-50,20],[50,-50,20],[50,50,20],[-50,50,20]], [[0,2,1],[0,3,2]], "backdrop.obj"))
+directions = intersection_pass(new_camera(), [backdrop]) - camera_position
+
+radii = np.array([1.5,1.,0.7])
+rotation = rotation_z(0.4) @ rotation_x(0.3)
+center = np.array([0.2,-0.1,0.5])
+
+# Rays moved into the frame of the ellipsoid, and scaled so that it becomes the unit sphere, hit it where
+# the quadratic |origin + t*direction|^2 = 1 has real roots.  Rays grazing the ellipsoid are left out:
+def test_ellipsoid_intersections():
+    ellipsoid = Ellipsoid(radii, rotation=rotation, position=center)
+    origin = ((camera_position - center) @ rotation)/radii
+    direction = (directions @ rotation)/radii
+    a = np.sum(direction**2, axis=2)
+    b = 2*direction @ origin
+    c = origin @ origin - 1
+    discriminant = b**2 - 4*a*c
+    expected_hit = discriminant > 0
+    clear = np.abs(discriminant) > 0.01*b**2
+
+    hit = instance_pass(new_camera(), [ellipsoid]) == 1
+    assert((hit[clear] == expected_hit[clear]).all())
+    assert(expected_hit.sum() > 100)
+
+    t = (-b - np.sqrt(np.maximum(discriminant, 0)))/(2*a)
+    expected_points = camera_position + t[:,:,None]*directions
+    points = intersection_pass(new_camera(), [ellipsoid])
+    assert(np.allclose(points[hit & expected_hit], expected_points[hit & expected_hit], atol=1e-9))
+
+# Normals are the gradient of the ellipsoid's implicit function, and point into the body as the normals of
+# triangles do:
+def test_ellipsoid_normals():
+    ellipsoid = Ellipsoid(radii, rotation=rotation, position=center)
+    hit = instance_pass(new_camera(), [ellipsoid]) == 1
+    points = intersection_pass(new_camera(), [ellipsoid])[hit]
+    gradient = (((points - center) @ rotation)/radii**2) @ rotation.T
+    expected = -gradient/np.linalg.norm(gradient, axis=1)[:,None]
+    assert(np.allclose(normal_pass(new_camera(), [ellipsoid])[hit], expected, atol=1e-9))
+
+# A lidar finds the ellipsoid as the renderer does:
+def test_ellipsoid_lidar():
+    ellipsoid = Ellipsoid(radii, position=np.array([0.,0.,1.]))
+    lidar = SimpleLidar(z_positive=True, position=np.array([0.3,0.2,-10]))
+    z = 1 - radii[2]*np.sqrt(1 - (0.3/radii[0])**2 - (0.2/radii[1])**2)
+    assert(np.isclose(simulate_lidar(lidar, [ellipsoid]), z + 10, atol=1e-9))
+
+# A raster of heights, and the triangle mesh the heightfield traces without building it (two triangles per
+# cell, split along the diagonal from post (row, col) to post (row + 1, col + 1)):
+rows, cols = np.meshgrid(np.arange(33), np.arange(33), indexing="ij")
+heights = (0.3*np.sin(np.pi*cols/8)*np.cos(np.pi*rows/8)).astype(np.float32)
+corner = np.array([-1.,-1.,0.])
+
+def post(row, col):
+    return 33*row + col
+
+posts = np.stack([cols/16, rows/16, heights], axis=-1).reshape(-1, 3)
+cells = [[[post(r,c), post(r,c+1), post(r+1,c+1)], [post(r,c), post(r+1,c+1), post(r+1,c)]]
+         for r in range(32) for c in range(32)]
+terrain_mesh = write_obj(posts, np.array(cells).reshape(-1, 3), "terrain.obj")
+
+# The heightfield is hit exactly where its mesh is.  Its flat normals are those of the mesh too, except
+# on the edges and diagonals of cells, where either of two triangles may be reported:
+def test_heightfield_matches_mesh():
+    for pose in (np.eye(3), rotation_x(0.5)):
+        terrain = Heightfield(heights, spacing=[1/16,1/16], smooth_shading=False, position=corner, rotation=pose)
+        mesh = Entity(terrain_mesh, position=corner, rotation=pose)
+        hit = instance_pass(new_camera(), [terrain]) == 1
+        assert((hit == (instance_pass(new_camera(), [mesh]) == 1)).all())
+        assert(hit.sum() > 100)
+
+        points = intersection_pass(new_camera(), [terrain])
+        assert(np.allclose(points, intersection_pass(new_camera(), [mesh]), atol=1e-9))
+
+        fraction = (16*(points - corner) @ pose)[:,:,:2] % 1
+        tie = (np.isclose(fraction, 0, atol=1e-9) | np.isclose(fraction, 1, atol=1e-9)).any(axis=2)
+        tie |= np.isclose(fraction[:,:,0], fraction[:,:,1], atol=1e-9)
+        normals = normal_pass(new_camera(), [terrain])
+        assert(np.allclose(normals[~tie], normal_pass(new_camera(), [mesh])[~tie], atol=1e-9))
+
+        lidar = SimpleLidar(z_positive=True, position=np.array([0.1,0.2,-10]))
+        assert(np.isclose(simulate_lidar(lidar, [terrain]), simulate_lidar(lidar, [mesh]), atol=1e-9))
+
+# Run the tests
+test_ellipsoid_intersections()
+test_ellipsoid_normals()
+test_ellipsoid_lidar()
+test_heightfield_matches_mesh()
@@ -0,0 +1,151 @@
+from crt import Entity, Sphere
+from crt.cameras import SimpleCamera
+from crt.lights import PointLight, AreaLight, SunLight
+from crt.rendering import render, intersection_pass, instance_pass, measurement_pass
+from tests.meshes import write_obj
+import numpy as np
+import pytest
+
+# Default values:
+camera_position = np.array([0,0,-10])
+
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=camera_position)
+
+# A white square in the plane z = 0, facing the camera:
+square = Entity(write_obj([[-2,-2,0],[2,-2,0],[2,2,0],[-2,2,0]], [[0,2,1],[0,3,2]], "square.obj"))
+
+hit = instance_pass(new_camera(), [square]) == 1
+distance = np.linalg.norm(intersection_pass(new_camera(), [square]) - camera_position, axis=2)
+cosine = 10/distance
+
+# Pixels of the white square receiving the given irradiance, which reflects a radiance of irradiance/pi,
+# quantized as render() does:
+def expected(irradiance):
+    return np.where(hit, np.minimum(256*irradiance/np.pi, 255), 0).astype(np.uint8)
+
+# Quantization may round a value on the edge between two digital numbers either way:
+def close(image, reference):
+    return (np.abs(image[:,:,:3].astype(int) - reference[:,:,None].astype(int)) <= 1).all()
+
+# Next event estimation with a point light is exact, so a single sample per pixel gives the irradiance
+# intensity*cos/distance^2 at every pixel:
+def test_mis_point_light():
+    image = render(new_camera(), PointLight(100, position=camera_position), [square], integrator="mis")
+    assert(close(image, expected(100*cosine/distance**2)))
+    assert(hit.sum() > 100)
+
+# An area light emits like a lambertian surface, so a small one adds the cosine at the light:
+def test_mis_area_light():
+    light = AreaLight(100, [0.2,0.2], position=camera_position)
+    image = render(new_camera(), light, [square], integrator="mis")
+    assert(close(image, expected(100*cosine**2/distance**2)))
+
+# A single light is selected with probability one, so sampling it is the same as visiting every light:
+def test_light_samples_single_light():
+    light = PointLight(100, position=camera_position)
+    for integrator in ("unidirectional", "mis"):
+        reference = render(new_camera(), light, [square], integrator=integrator)
+        image = render(new_camera(), light, [square], integrator=integrator, light_samples=1)
+        assert((image == reference).all())
+
+# Sampling a few of several lights is unbiased, so with enough samples per pixel it converges to the
+# image lit by all of them:
+def test_light_samples_many_lights():
+    angles = np.pi*np.arange(8)/4
+    lights = [PointLight(2*(i + 1), position=np.array([4*np.cos(angle), 4*np.sin(angle), -6]))
+              for i, angle in enumerate(angles)]
+    reference = render(new_camera(), lights, [square], min_samples=16, max_samples=16, integrator="mis")
+    image = render(new_camera(), lights, [square], min_samples=16, max_samples=16, integrator="mis", light_samples=2)
+    assert(abs(image[:,:,0].mean()/reference[:,:,0].mean() - 1) < 0.01)
+    assert(reference[:,:,0].max() < 255)
+
+# A sun light delivers its intensity as irradiance at normal incidence wherever it is placed along its
+# direction, and the solar disk is too small to change that measurably:
+def test_sun_light_irradiance():
+    for angular_radius in (0., 0.004653):
+        for position, irradiance in (([0,0,-1], 1.), ([0,0,-1000], 1.), ([0,3,-3], np.sqrt(0.5))):
+            light = SunLight(1, angular_radius=angular_radius, position=np.array(position))
+            image = render(new_camera(), light, [square], integrator="mis")
+            assert(close(image, expected(np.full(hit.shape, irradiance))))
+
+# Tracing paths one bounce at a time must not change what each path finds.  With a point light and one
+# sample per pixel nothing is left to chance, so the images are identical:
+def test_wavefront_point_light():
+    light = PointLight(100, position=camera_position)
+    for integrator in ("unidirectional", "mis"):
+        for num_bounces in (1, 2):
+            reference = render(new_camera(), light, [square], num_bounces=num_bounces, integrator=integrator)
+            image = render(new_camera(), light, [square], num_bounces=num_bounces, integrator=integrator, wavefront=True)
+            assert((image == reference).all())
+
+def test_wavefront_area_light():
+    light = AreaLight(100, [0.2,0.2], position=camera_position)
+    image = render(new_camera(), light, [square], integrator="mis", wavefront=True)
+    assert(close(image, expected(100*cosine**2/distance**2)))
+
+# Pixels of a mask with one of its four neighbours in another mask, as (column, row) sorted by row:
+def edge(mask, other):
+    near = np.zeros_like(mask)
+    near[1:] |= other[:-1]
+    near[:-1] |= other[1:]
+    near[:,1:] |= other[:,:-1]
+    near[:,:-1] |= other[:,1:]
+    rows, cols = np.nonzero(mask & near)
+    return np.stack([cols, rows], axis=1)
+
+# Without an image every pixel weighs the same, so the square is measured by its silhouette.  Lit from the
+# camera it has a limb all around and no terminator:
+def test_measurement_pass():
+    measurements = measurement_pass(new_camera(), PointLight(100, position=camera_position), [square])
+    assert(len(measurements) == 1)
+    measurement = measurements[0]
+    rows, cols = np.nonzero(hit)
+    assert(measurement["id"] == 1)
+    assert(measurement["pixel_count"] == hit.sum() and measurement["brightness"] == hit.sum())
+    assert(np.allclose(measurement["centroid"], (cols.mean(), rows.mean())))
+    assert(measurement["bounding_box"] == (cols.min(), rows.min(), cols.max(), rows.max()))
+    assert((measurement["limb"] == edge(hit, ~hit)).all())
+    assert(measurement["terminator"].shape == (0,2))
+
+# A sphere lit from the side is lit where its surface faces the center of the sun, and the terminator
+# is the lit side of that boundary.  Measurements made while rendering find the same pixels, but weigh
+# them by their brightness:
+def test_measurement_terminator():
+    sphere = Sphere(3)
+    sun = np.array([1,0,-0.3])
+    light = SunLight(1, position=sun)
+    covered = instance_pass(new_camera(), [sphere]) == 1
+    lit = covered & (intersection_pass(new_camera(), [sphere]) @ sun > 0)
+    measurement = measurement_pass(new_camera(), light, [sphere])[0]
+    assert((measurement["limb"] == edge(covered, ~covered)).all())
+    assert((measurement["terminator"] == edge(lit, covered & ~lit)).all())
+    assert(len(measurement["terminator"]) > 10)
+
+    image, measurements = render(new_camera(), light, [sphere], integrator="mis", return_measurements=True)
+    rendered = measurements[0]
+    for key in ("id", "pixel_count", "bounding_box"):
+        assert(rendered[key] == measurement[key])
+    for key in ("limb", "terminator"):
+        assert((rendered[key] == measurement[key]).all())
+    weights = image[:,:,:3].mean(axis=2)
+    rows, cols = np.nonzero(weights)
+    centroid = (np.sum(cols*weights[rows,cols]), np.sum(rows*weights[rows,cols]))/weights.sum()
+    assert(np.allclose(rendered["centroid"], centroid, atol=0.2))
+    assert(rendered["centroid"][0] > measurement["centroid"][0] + 5)
+
+def test_unknown_integrator():
+    with pytest.raises(ValueError):
+        render(new_camera(), PointLight(100, position=camera_position), [square], integrator="bidirectional")
+
+# Run the tests
+test_mis_point_light()
+test_mis_area_light()
+test_light_samples_single_light()
+test_light_samples_many_lights()
+test_sun_light_irradiance()
+test_wavefront_point_light()
+test_wavefront_area_light()
+test_measurement_pass()
+test_measurement_terminator()
+test_unknown_integrator()
@@ -0,0 +1,75 @@
+from crt import Entity
+from crt.cameras import SimpleCamera
+from crt.lights import SunLight
+from crt.rendering import render, instance_pass
+from crt.sensors import SensorModel
+from tests.meshes import write_obj
+import numpy as np
+
+# Default values:
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-10]))
+
+# A white square facing a sun behind the camera reflects a radiance of 1/pi wherever it is seen:
+square = Entity(write_obj([[-2,-2,0],[2,-2,0],[2,2,0],[-2,2,0]], [[0,2,1],[0,3,2]], "square.obj"))
+light = SunLight(1, angular_radius=0., position=np.array([0,0,-1]))
+hit = instance_pass(new_camera(), [square]) == 1
+
+def expose(sensor):
+    return render(new_camera(), light, [square], integrator="mis", sensor=sensor).astype(float)
+
+# A normalized gaussian kernel of the given size:
+def gaussian(size, sigma):
+    kernel = np.exp(-0.5*((np.arange(size) - size//2)/sigma)**2)
+    return kernel/kernel.sum()
+
+# Without noise, the radiance is converted to electrons, then to digital numbers by the gain and the bias:
+def test_noiseless_conversion():
+    image = render(new_camera(), light, [square], integrator="mis",
+                   sensor=SensorModel(shot_noise=False, gain=2, bias=10, bits=16))
+    assert(image.dtype == np.uint16 and image.shape == (48,48,3))
+    expected = np.where(hit, 1000/np.pi/2, 0) + 10
+    assert((np.abs(image - np.floor(expected + 0.5)[:,:,None]) <= 1).all())
+    assert(hit.sum() > 100)
+
+# Wells saturate at the full well, the converter at its bit depth, and a monochrome sensor records the
+# mean of the channels:
+def test_saturation():
+    assert((expose(SensorModel(shot_noise=False, full_well=200))[hit] == 200).all())
+    assert((expose(SensorModel(shot_noise=False, bits=8))[hit] == 255).all())
+    monochrome = expose(SensorModel(shot_noise=False, monochrome=True))
+    assert(monochrome.shape == (48,48))
+    assert((np.abs(monochrome - expose(SensorModel(shot_noise=False))[:,:,0]) <= 1).all())
+
+# Shot noise is Poisson, so its mean and variance are both the mean number of electrons.  Read noise adds
+# its variance on top.  The noise depends on the seed alone:
+def test_noise():
+    mean = 1000/np.pi
+    image = expose(SensorModel(bits=16, seed=3))[hit]
+    assert(abs(image.mean() - mean) < 4*np.sqrt(mean/image.size))
+    assert(abs(image.var()/mean - 1) < 0.15)
+
+    image = expose(SensorModel(bits=16, read_noise=20, seed=3))[hit]
+    assert(abs(image.var()/(mean + 400) - 1) < 0.15)
+
+    assert((expose(SensorModel(seed=3)) == expose(SensorModel(seed=3))).all())
+    assert((expose(SensorModel(seed=3)) != expose(SensorModel(seed=4))).any())
+
+# A separable kernel blurs as the full kernel it factors, whether that is applied directly or, when it is
+# large, through FFTs.  Normalized kernels keep the light of the square, which stays inside the image:
+def test_psf():
+    sharp = expose(SensorModel(shot_noise=False, bits=16))
+    for size, sigma in ((5, 1.), (31, 3.)):
+        kernel = gaussian(size, sigma)
+        separable = expose(SensorModel(psf=(kernel, kernel), shot_noise=False, bits=16))
+        full = expose(SensorModel(psf=np.outer(kernel, kernel), shot_noise=False, bits=16))
+        assert((np.abs(separable - full) <= 1).all())
+        assert((separable != sharp).any())
+        assert(np.isclose(separable.sum(), sharp.sum(), rtol=0.01))
+    assert((expose(SensorModel(psf=np.ones((1,1)), shot_noise=False, bits=16)) == sharp).all())
+
+# Run the tests
+test_noiseless_conversion()
+test_saturation()
+test_noise()
+test_psf()
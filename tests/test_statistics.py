@@ -0,0 +1,83 @@
+from crt import Entity, Sphere
+from crt.body_fixed import BodyFixedEntity, BodyFixedGroup
+from crt.cameras import SimpleCamera
+from crt.lidars import SimpleLidar
+from crt.lights import PointLight
+from crt.rendering import render, intersection_pass, instance_pass, simulate_lidar
+from tests.meshes import write_obj, uv_sphere
+import numpy as np
+
+# Default values:
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-10]))
+
+light = PointLight(100, position=np.array([0,0,-10]))
+
+square = write_obj([[-2,-2,0],[2,-2,0],[2,2,0],[-2,2,0]], [[0,2,1],[0,3,2]], "square.obj")
+sphere = uv_sphere(radius=2.)
+hit = instance_pass(new_camera(), [Entity(square)]) == 1
+
+keys = {"build_time", "trace_time", "total_time", "pixels", "samples_per_pixel", "camera_rays", "secondary_rays",
+        "shadow_rays", "lidar_rays", "node_visits", "primitive_tests", "threads", "thread_utilization"}
+
+def check_times(statistics):
+    assert(set(statistics) == keys)
+    assert(statistics["trace_time"] > 0)
+    assert(np.isclose(statistics["total_time"], statistics["build_time"] + statistics["trace_time"]))
+    assert(statistics["threads"] >= 1)
+    assert(0 < statistics["thread_utilization"] <= 1)
+
+# Every pixel of the square shoots a shadow ray to the light, and with two bounces a secondary ray which
+# leaves the scene.  Collecting statistics does not change the image:
+def test_render_statistics():
+    for num_bounces, secondary_rays in ((1, 0), (2, hit.sum())):
+        reference = render(new_camera(), light, [Entity(square)], num_bounces=num_bounces)
+        image, statistics = render(new_camera(), light, [Entity(square)], num_bounces=num_bounces, return_statistics=True)
+        assert((image == reference).all())
+        check_times(statistics)
+        assert(statistics["build_time"] > 0)
+        assert(statistics["pixels"] == 48*48 and statistics["samples_per_pixel"] == 1)
+        assert(statistics["camera_rays"] == 48*48)
+        assert(statistics["secondary_rays"] == secondary_rays)
+        assert(statistics["shadow_rays"] == hit.sum())
+        assert(statistics["lidar_rays"] == 0)
+        assert(statistics["primitive_tests"] > 0)
+
+    image, statistics = render(new_camera(), light, [Entity(square)], min_samples=4, max_samples=4, return_statistics=True)
+    assert(statistics["camera_rays"] == 4*48*48 and statistics["samples_per_pixel"] == 4)
+
+# Passes trace one camera ray per pixel and nothing else, and a larger mesh needs a hierarchy to search:
+def test_pass_statistics():
+    points, statistics = intersection_pass(new_camera(), [Entity(sphere)], return_statistics=True)
+    check_times(statistics)
+    assert(statistics["camera_rays"] == 48*48)
+    assert(statistics["secondary_rays"] == 0 and statistics["shadow_rays"] == 0)
+    assert(statistics["node_visits"] > 0 and statistics["primitive_tests"] > 0)
+    assert((points == intersection_pass(new_camera(), [Entity(sphere)])).all())
+
+    points, image, statistics = intersection_pass(new_camera(), [Entity(sphere)], return_image=True, return_statistics=True)
+    assert(set(statistics) == keys)
+
+# A lidar traces no pixels, and every closest hit query it makes is a lidar ray:
+def test_lidar_statistics():
+    lidar = SimpleLidar(z_positive=True, position=np.array([0,0,-10]))
+    distance, statistics = simulate_lidar(lidar, [Sphere(2)], return_statistics=True)
+    assert(np.isclose(distance, 8, atol=1e-9))
+    assert(statistics["pixels"] == 0 and statistics["camera_rays"] == 0)
+    assert(statistics["lidar_rays"] == 1)
+
+# A group builds its hierarchy once, so later calls spend no time building:
+def test_group_statistics():
+    group = BodyFixedGroup(BodyFixedEntity(sphere))
+    image, statistics = group.render(new_camera(), light, return_statistics=True)
+    check_times(statistics)
+    assert(statistics["build_time"] == 0)
+    assert(statistics["camera_rays"] == 48*48)
+    points, statistics = group.intersection_pass(new_camera(), return_statistics=True)
+    assert(statistics["build_time"] == 0 and statistics["camera_rays"] == 48*48)
+
+# Run the tests
+test_render_statistics()
+test_pass_statistics()
+test_lidar_statistics()
+test_group_statistics()
@@ -0,0 +1,159 @@
+from crt import Entity
+from crt.cameras import SimpleCamera
+from crt.lights import PointLight
+from crt.rendering import render
+from crt.frames import write_frame
+from crt.textures import bake_tiled_texture, bake_raw_tiled_texture, set_tiled_texture_cache_budget, tiled_texture_statistics
+import numpy as np
+import os
+import pytest
+import tempfile
+
+# Default values:
+def new_camera():
+    return SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-10]))
+
+light = PointLight(10, position=np.array([0,0,-10]))
+
+directory = tempfile.mkdtemp()
+
+# A square in the plane z = 0, facing the camera, spanning columns u0 to u1 of the texture:
+def quad(x0, x1, u0, u1, name):
+    path = os.path.join(directory, name)
+    with open(path, "w") as f:
+        for x, y in [(x0,-2), (x1,-2), (x1,2), (x0,2)]:
+            f.write("v {} {} 0\n".format(x, y))
+        for u, v in [(u0,0), (u1,0), (u1,1), (u0,1)]:
+            f.write("vt {} {}\n".format(u, v))
+        f.write("f 1/1 3/3 2/2\nf 1/1 4/4 3/3\n")
+    return path
+
+def texture(left, right, name):
+    image = np.full((64,64,4), 255, dtype=np.uint8)
+    image[:,:32,:3] = left
+    image[:,32:,:3] = right
+    path = os.path.join(directory, name)
+    write_frame(path, image)
+    return path
+
+square = quad(-2, 2, 0, 1, "square.obj")
+half = texture(0, 255, "half.png")
+half_reference = render(new_camera(), light, [Entity(quad(-2, 0, 0, 0.5, "left.obj"), color=[0,0,0]),
+                                              Entity(quad(0, 2, 0.5, 1, "right.obj"), color=[1,1,1])])
+
+# A texture of a single color shades exactly as that color does:
+def test_uniform_texture():
+    image = render(new_camera(), light, [Entity(square, texture_path=texture(128, 128, "gray.png"))])
+    reference = render(new_camera(), light, [Entity(square, color=[128/255,128/255,128/255])])
+    assert((image == reference).all())
+    assert((reference[:,:,0] > 0).sum() > 100)
+
+# Texture coordinates place each half of the texture on its half of the square.  Only the columns on
+# the edge between them, where texels are filtered together, and on the sides of the square, where
+# the filter reaches around to the other side of the repeating texture, may differ:
+def test_texture_coordinates():
+    image = render(new_camera(), light, [Entity(square, texture_path=half)])
+    edge = np.zeros(48, dtype=bool)
+    edge[22:27] = True
+    edge[9:12] = True
+    edge[37:40] = True
+    assert((image[:,~edge] == half_reference[:,~edge]).all())
+    assert((half_reference[:,:,0] > 100).sum() > 100)
+
+# A checkerboard of single texels.  From afar a pixel covers several texels, which a coarser mip level
+# averages to gray, where the full resolution level would land on either color.  Up close the texels
+# are larger than a pixel, and the checkerboard is resolved:
+def test_texture_footprint():
+    image = np.full((256,256,4), 255, dtype=np.uint8)
+    rows, cols = np.indices((256,256))
+    image[:,:,:3] = (255*((rows + cols) % 2))[:,:,None]
+    checker = os.path.join(directory, "checker.png")
+    write_frame(checker, image)
+
+    distant = render(new_camera(), light, [Entity(square, texture_path=checker)]).astype(int)
+    gray = render(new_camera(), light, [Entity(square, color=[0.5,0.5,0.5])]).astype(int)
+    inside = (slice(14,34), slice(14,34))
+    assert((gray[inside][:,:,0] > 0).all())
+    assert(np.abs(distant[inside] - gray[inside]).max() <= 1)
+
+    near_camera = SimpleCamera(30, [48,48], [20,20], z_positive=True, position=np.array([0,0,-0.5]))
+    near = render(near_camera, light, [Entity(square, texture_path=checker)]).astype(int)
+    near_gray = render(near_camera, light, [Entity(square, color=[0.5,0.5,0.5])]).astype(int)
+    assert((near[:,:,0] < near_gray[:,:,0]/2).sum() > 20)
+    assert((near[:,:,0] > 3*near_gray[:,:,0]/2).sum() > 20)
+
+# A tiled texture streamed from disk samples the same texels as the image it was baked from:
+def test_tiled_texture():
+    tiled = os.path.join(directory, "half.crtt")
+    bake_tiled_texture(half, tiled, tile_size=16)
+    reference = render(new_camera(), light, [Entity(square, texture_path=half)])
+    entity = Entity(square, texture_path=tiled)
+    image = render(new_camera(), light, [entity])
+    assert((image == reference).all())
+
+    statistics = tiled_texture_statistics(tiled)
+    assert(statistics["misses"] > 0 and statistics["hits"] > 0)
+    assert(statistics["evictions"] == 0)
+    assert(0 < statistics["resident_tiles"] <= statistics["capacity_tiles"])
+
+# Single channel textures, as used for elevation maps, can be baked from a 16 bit gray PNG or streamed
+# from raw 16 bit or float samples.  The same samples shade the same way however they are stored:
+def test_tiled_texture_formats():
+    rows, cols = np.indices((64,64))
+    elevation = (1000*cols + 7*rows).astype(np.uint16)
+    png = os.path.join(directory, "elevation.png")
+    write_frame(png, elevation)
+    elevation.tofile(os.path.join(directory, "elevation.raw"))
+    (elevation/65535).astype(np.float32).tofile(os.path.join(directory, "elevation_float.raw"))
+
+    bake_tiled_texture(png, os.path.join(directory, "elevation.crtt"), tile_size=16)
+    bake_raw_tiled_texture(os.path.join(directory, "elevation.raw"), os.path.join(directory, "elevation_raw.crtt"),
+                           64, 64, tile_size=16)
+    bake_raw_tiled_texture(os.path.join(directory, "elevation_float.raw"), os.path.join(directory, "elevation_float.crtt"),
+                           64, 64, dtype=np.float32, tile_size=16)
+    with open(os.path.join(directory, "elevation.crtt"), "rb") as f, open(os.path.join(directory, "elevation_raw.crtt"), "rb") as g:
+        assert(f.read() == g.read())
+
+    image = render(new_camera(), light, [Entity(square, texture_path=os.path.join(directory, "elevation_raw.crtt"))]).astype(int)
+    float_image = render(new_camera(), light, [Entity(square, texture_path=os.path.join(directory, "elevation_float.crtt"))]).astype(int)
+    assert(np.abs(image - float_image).max() <= 1)
+    assert((image[:,:,0] == image[:,:,1]).all() and (image[:,:,0] > 0).sum() > 100)
+
+    # Black and white halves as raw 16 bit samples match the 8 bit RGB image:
+    halves = np.where(cols < 32, 0, 65535).astype(np.uint16)
+    halves.tofile(os.path.join(directory, "half.raw"))
+    bake_raw_tiled_texture(os.path.join(directory, "half.raw"), os.path.join(directory, "half_raw.crtt"), 64, 64, tile_size=16)
+    image = render(new_camera(), light, [Entity(square, texture_path=os.path.join(directory, "half_raw.crtt"))])
+    assert((image == render(new_camera(), light, [Entity(square, texture_path=half)])).all())
+
+    with pytest.raises(RuntimeError):
+        bake_raw_tiled_texture(os.path.join(directory, "half.raw"), os.path.join(directory, "short.crtt"), 64, 65)
+    with pytest.raises(ValueError):
+        bake_raw_tiled_texture(os.path.join(directory, "half.raw"), os.path.join(directory, "wide.crtt"), 64, 64, channels=2)
+    with pytest.raises(ValueError):
+        bake_raw_tiled_texture(os.path.join(directory, "half.raw"), os.path.join(directory, "double.crtt"), 64, 64, dtype=np.float64)
+
+# Tiles evicted from a cache that is too small are read again, without changing the image:
+def test_tiled_texture_budget():
+    tiled = os.path.join(directory, "half_small_tiles.crtt")
+    bake_tiled_texture(half, tiled, tile_size=4)
+    reference = render(new_camera(), light, [Entity(square, texture_path=half)])
+    set_tiled_texture_cache_budget(1)
+    try:
+        entity = Entity(square, texture_path=tiled)
+    finally:
+        set_tiled_texture_cache_budget(256*2**20)
+    image = render(new_camera(), light, [entity])
+    assert((image == reference).all())
+
+    statistics = tiled_texture_statistics(tiled)
+    assert(statistics["evictions"] > 0)
+    assert(statistics["resident_tiles"] == statistics["capacity_tiles"])
+
+# Run the tests
+test_uniform_texture()
+test_texture_coordinates()
+test_texture_footprint()
+test_tiled_texture()
+test_tiled_texture_formats()
+test_tiled_texture_budget()